@@ -1,7 +1,39 @@
 #include "App.h"
+#include <atomic>
+#include <ctime>
 
 namespace K9
 {
+// Event type, used to wake an idle loop
+static Uint32 GetRedrawEventType()
+{
+    // SDL_RegisterEvents fails, once all user event types are taken. Any event still wakes the loop.
+    static const Uint32 unEventType = []()
+    {
+        Uint32 unType = SDL_RegisterEvents(1);
+        return unType != static_cast<Uint32>(-1) ? unType : static_cast<Uint32>(SDL_USEREVENT);
+    }();
+    return unEventType;
+}
+
+// Set by RequestRedraw, until the loop starts the next frame
+static std::atomic<bool>& GetRedrawRequested()
+{
+    static std::atomic<bool> bRedrawRequested{ false };
+    return bRedrawRequested;
+}
+
+void App::RequestRedraw()
+{
+    // push a single event, until the loop picks up the request
+    if(!GetRedrawRequested().exchange(true))
+    {
+        SDL_Event event{};
+        event.type = GetRedrawEventType();
+        SDL_PushEvent(&event);
+    }
+}
+
 int App::Run()
 {
     // Initialize SDL with video
@@ -32,9 +64,25 @@ int App::Run()
     SDL_Event event;	 // used to store any events from the OS
     bool running = true; // used to determine if we're running the game
 
+    // register the redraw event before anyone can request it
+    GetRedrawEventType();
+
+    // used to report the load of the loop
+    Uint64 unStartCounter = SDL_GetPerformanceCounter();
+    std::clock_t startCPUTime = std::clock();
+    unsigned int unWakeupCount = 0;
+
     glClearColor(1, 0, 1, 1);
     while(running)
     {
+        // while idle, sleep until there is an event (left in the queue) or the latency elapses
+        bool bRedrawRequested = GetRedrawRequested().exchange(false);
+        if(m_bIdleModeEnabled && !bRedrawRequested)
+        {
+            SDL_WaitEventTimeout(nullptr, static_cast<int>(m_unMaxLatencyMS));
+        }
+        ++unWakeupCount;
+
         // poll for events from SDL
         while(SDL_PollEvent(&event))
         {
@@ -49,6 +97,15 @@ int App::Run()
         SDL_GL_SwapWindow(window);
     }
 
+    // clock() is process CPU time on POSIX, so this is the usage of a single core
+    double dWallTimeS = static_cast<double>(SDL_GetPerformanceCounter() - unStartCounter) / SDL_GetPerformanceFrequency();
+    double dCPUTimeS = static_cast<double>(std::clock() - startCPUTime) / CLOCKS_PER_SEC;
+    if(dWallTimeS > 0.0)
+    {
+        std::cout << "App::Run " << (m_bIdleModeEnabled ? "Idle" : "Busy") << " mode: CPU "
+                  << 100.0 * dCPUTimeS / dWallTimeS << "%, " << unWakeupCount / dWallTimeS << " wakeups/s\n";
+    }
+
 
     // Destroy the context
     SDL_GL_DeleteContext(context);
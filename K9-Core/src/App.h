@@ -19,5 +19,20 @@ public:
 	{
 		std::cout << " testing K9::App!\n";
 	}
+
+	// Block in SDL_WaitEventTimeout instead of redrawing continuously.
+	// The loop wakes on input, on RequestRedraw or after unMaxLatencyMS at the latest.
+	void SetIdleModeEnabled(bool bEnabled, Uint32 unMaxLatencyMS = 250)
+	{
+		m_bIdleModeEnabled = bEnabled;
+		m_unMaxLatencyMS = unMaxLatencyMS;
+	}
+
+	// Wake an idle loop and draw a frame. Can be called from any thread.
+	static void RequestRedraw();
+
+private:
+	bool m_bIdleModeEnabled = false;
+	Uint32 m_unMaxLatencyMS = 250;
 };
 } // namespace K9
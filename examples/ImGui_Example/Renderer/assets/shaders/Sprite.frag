@@ -1,11 +1,16 @@
 // Request GLSL 3.3
 #version 330
 
+// Feature keywords of ShaderVariants. TINT multiplies the texture with u_Color.
+#pragma k9_keywords TINT
+
 // This is used for the texture sampling
 uniform sampler2D u_Texture;
 
+#ifdef TINT
 // Uniform tint color.
 uniform vec4 u_Color;
+#endif
 
 // Tex coord a_put from vertex shader
 in vec2 v_fragTexCoord;
@@ -16,6 +21,9 @@ out vec4 outColor;
 void main()
 {
 	// Sample color from texture
-    outColor = texture(u_Texture, v_fragTexCoord) * u_Color;
+    outColor = texture(u_Texture, v_fragTexCoord);
+#ifdef TINT
+    outColor *= u_Color;
+#endif
 	//outColor = vec4(v_fragTexCoord.x, v_fragTexCoord.y, 1.0, 1.0);
 }
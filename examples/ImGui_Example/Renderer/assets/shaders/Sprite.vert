@@ -1,9 +1,21 @@
 // Request GLSL 3.3
 #version 330
 
-// uniforms for world transform and view-proj
-uniform mat4 u_WorldTransform;
-uniform mat4 u_ViewProj;
+// uniform for world transform
+// The world transform is a 2x3 affine transform: two columns of scale/rotation and the translation.
+uniform mat3x2 u_WorldTransform;
+
+// Per-frame data, shared by all K9 shaders. Matches Renderer2D::SFrameData.
+layout(std140) uniform FrameData
+{
+	mat4 u_ViewProj;
+	vec2 u_ScreenSize;
+	float u_Time;
+	uint u_FrameIndex;
+};
+
+// Source rect in normalized texture coordinates: min u, min v, max u, max v
+uniform vec4 u_UVRect = vec4(0.0, 0.0, 1.0, 1.0);
 
 // Attribute 0 is position, 1 is tex coords.
 layout(location = 0) in vec3 a_Position;
@@ -14,12 +26,10 @@ out vec2 v_fragTexCoord;
 
 void main()
 {
-	// Convert position to homogeneous coordinates
-	vec4 pos = vec4(a_Position, 1.0);
-
 	// Transform to position world space, then clip space
-	gl_Position = u_ViewProj * u_WorldTransform * pos;
+	vec2 worldPos = u_WorldTransform * vec3(a_Position.xy, 1.0);
+	gl_Position = u_ViewProj * vec4(worldPos, a_Position.z, 1.0);
 
-	// Pass along the texture coordinate to frag shader
-	v_fragTexCoord = a_TexCoord;
+	// Map the unit quad texture coordinate into the source rect and pass it to frag shader
+	v_fragTexCoord = mix(u_UVRect.xy, u_UVRect.zw, a_TexCoord);
 }
@@ -0,0 +1,52 @@
+// Request GLSL 3.3
+#version 330
+
+// Feature keywords of ShaderVariants. TINT multiplies the texture with the vertex color.
+#pragma k9_keywords TINT
+
+// Must match TextureSlots::MAX_SLOT_COUNT
+#define MAX_TEXTURE_SLOTS 16
+
+// These are used for the texture sampling. Each one is bound to the texture unit of its slot.
+uniform sampler2D u_Textures[MAX_TEXTURE_SLOTS];
+
+// Tex coord, tint color and texture slot input from vertex shader
+in vec2 v_fragTexCoord;
+in vec4 v_fragColor;
+flat in uint v_fragTextureSlot;
+
+// This corresponds to the output color to the color buffer
+out vec4 outColor;
+
+// GLSL 3.3 only allows indexing sampler arrays with constant expressions
+vec4 SampleTexture(uint unSlot, vec2 texCoord)
+{
+	switch (unSlot)
+	{
+	case 0u: return texture(u_Textures[0], texCoord);
+	case 1u: return texture(u_Textures[1], texCoord);
+	case 2u: return texture(u_Textures[2], texCoord);
+	case 3u: return texture(u_Textures[3], texCoord);
+	case 4u: return texture(u_Textures[4], texCoord);
+	case 5u: return texture(u_Textures[5], texCoord);
+	case 6u: return texture(u_Textures[6], texCoord);
+	case 7u: return texture(u_Textures[7], texCoord);
+	case 8u: return texture(u_Textures[8], texCoord);
+	case 9u: return texture(u_Textures[9], texCoord);
+	case 10u: return texture(u_Textures[10], texCoord);
+	case 11u: return texture(u_Textures[11], texCoord);
+	case 12u: return texture(u_Textures[12], texCoord);
+	case 13u: return texture(u_Textures[13], texCoord);
+	case 14u: return texture(u_Textures[14], texCoord);
+	default: return texture(u_Textures[15], texCoord);
+	}
+}
+
+void main()
+{
+	// Sample color from the texture of this sprite
+	outColor = SampleTexture(v_fragTextureSlot, v_fragTexCoord);
+#ifdef TINT
+	outColor *= v_fragColor;
+#endif
+}
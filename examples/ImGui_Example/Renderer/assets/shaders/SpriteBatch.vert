@@ -0,0 +1,34 @@
+// Request GLSL 3.3
+#version 330
+
+// Batched vertices are already in screen space.
+// Per-frame data, shared by all K9 shaders. Matches Renderer2D::SFrameData.
+layout(std140) uniform FrameData
+{
+	mat4 u_ViewProj;
+	vec2 u_ScreenSize;
+	float u_Time;
+	uint u_FrameIndex;
+};
+
+// Attribute 0 is position, 1 is tex coords, 2 is the tint color, 3 is the texture slot.
+layout(location = 0) in vec2 a_Position;
+layout(location = 1) in vec2 a_TexCoord;
+layout(location = 2) in vec4 a_Color;
+layout(location = 3) in uint a_TextureSlot;
+
+// Any vertex outputs (other than position)
+out vec2 v_fragTexCoord;
+out vec4 v_fragColor;
+flat out uint v_fragTextureSlot;
+
+void main()
+{
+	// Transform the screen space position to clip space
+	gl_Position = u_ViewProj * vec4(a_Position, 0.0, 1.0);
+
+	// Pass along the texture coordinate, color and texture slot to frag shader
+	v_fragTexCoord = a_TexCoord;
+	v_fragColor = a_Color;
+	v_fragTextureSlot = a_TextureSlot;
+}
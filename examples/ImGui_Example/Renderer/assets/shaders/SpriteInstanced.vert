@@ -0,0 +1,61 @@
+// Request GLSL 3.3
+#version 330
+
+// Feature keywords of ShaderVariants. FLIP mirrors the UVs by the flip bits of the flags.
+#pragma k9_keywords FLIP
+
+// Per-frame data, shared by all K9 shaders. Matches Renderer2D::SFrameData.
+layout(std140) uniform FrameData
+{
+	mat4 u_ViewProj;
+	vec2 u_ScreenSize;
+	float u_Time;
+	uint u_FrameIndex;
+};
+
+// Attribute 0 is the unit quad corner, 1 selects the corner of the UV rect.
+layout(location = 0) in vec3 a_Position;
+layout(location = 1) in vec2 a_TexCoord;
+
+// Per-instance attributes: 2x3 affine transform, UV rect, tint color and flags.
+// Flags bits 0-7 are the flip bits, bits 8-15 are the texture slot.
+layout(location = 2) in vec3 a_TransformRow0;
+layout(location = 3) in vec3 a_TransformRow1;
+layout(location = 4) in vec4 a_UVRect;
+layout(location = 5) in vec4 a_Color;
+layout(location = 6) in uint a_Flags;
+
+// Any vertex outputs (other than position)
+out vec2 v_fragTexCoord;
+out vec4 v_fragColor;
+flat out uint v_fragTextureSlot;
+
+// Values of SDL_RendererFlip
+const uint FLIP_HORIZONTAL = 1u;
+const uint FLIP_VERTICAL = 2u;
+
+void main()
+{
+	// Transform the unit quad corner to screen space, then clip space
+	vec3 corner = vec3(a_Position.xy, 1.0);
+	vec2 pos = vec2(dot(a_TransformRow0, corner), dot(a_TransformRow1, corner));
+	gl_Position = u_ViewProj * vec4(pos, 0.0, 1.0);
+
+	// Flipping mirrors the corner inside the UV rect
+	vec2 uvCorner = a_TexCoord;
+#ifdef FLIP
+	if ((a_Flags & FLIP_HORIZONTAL) != 0u)
+	{
+		uvCorner.x = 1.0 - uvCorner.x;
+	}
+	if ((a_Flags & FLIP_VERTICAL) != 0u)
+	{
+		uvCorner.y = 1.0 - uvCorner.y;
+	}
+#endif
+
+	// Pass along the texture coordinate, color and texture slot to frag shader
+	v_fragTexCoord = mix(a_UVRect.xy, a_UVRect.zw, uvCorner);
+	v_fragColor = a_Color;
+	v_fragTextureSlot = (a_Flags >> 8u) & 0xFFu;
+}
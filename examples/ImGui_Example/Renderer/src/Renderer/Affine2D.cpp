@@ -0,0 +1,46 @@
+#include "Affine2D.h"
+#include <cmath>
+
+namespace K9
+{
+	SAffine2D SAffine2D::FromSprite(const SDL_Rect& destRect, SDL_RendererFlip flipFormat,
+		float fAngle, const glm::vec2& origin)
+	{
+		float fWidth = static_cast<float>(destRect.w);
+		float fHeight = static_cast<float>(destRect.h);
+
+		/* Local corner = scale * unit corner + bias, relative to the origin. Flipping negates the scale.
+		 * The flip bits are turned into factors, since random flips mispredict branches. */
+		float fFlipX = static_cast<float>(flipFormat & SDL_RendererFlip::SDL_FLIP_HORIZONTAL);
+		float fFlipY = static_cast<float>((flipFormat & SDL_RendererFlip::SDL_FLIP_VERTICAL) >> 1);
+		float fScaleX = fWidth * (1.0f - 2.0f * fFlipX);
+		float fScaleY = fHeight * (1.0f - 2.0f * fFlipY);
+		float fBiasX = fWidth * fFlipX - origin.x;
+		float fBiasY = fHeight * fFlipY - origin.y;
+
+		float fCos = 1.0f;
+		float fSin = 0.0f;
+		if (fAngle != 0.0f)
+		{
+			float fRadians = glm::radians(fAngle);
+			fCos = std::cos(fRadians);
+			fSin = std::sin(fRadians);
+		}
+
+		float fPivotX = static_cast<float>(destRect.x) + origin.x;
+		float fPivotY = static_cast<float>(destRect.y) + origin.y;
+
+		SAffine2D affine;
+		affine.m_row0 = glm::vec3{ fCos * fScaleX, -fSin * fScaleY, fPivotX + fCos * fBiasX - fSin * fBiasY };
+		affine.m_row1 = glm::vec3{ fSin * fScaleX, fCos * fScaleY, fPivotY + fSin * fBiasX + fCos * fBiasY };
+		return affine;
+	}
+
+	SAffine2D SAffine2D::Translated(const glm::vec2& localOffset) const
+	{
+		SAffine2D affine = *this;
+		affine.m_row0.z += m_row0.x * localOffset.x + m_row0.y * localOffset.y;
+		affine.m_row1.z += m_row1.x * localOffset.x + m_row1.y * localOffset.y;
+		return affine;
+	}
+}
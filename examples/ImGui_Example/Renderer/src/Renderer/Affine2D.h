@@ -0,0 +1,53 @@
+#pragma once
+#include <SDL.h>
+#include <glm/glm.hpp>
+
+namespace K9
+{
+	/// <summary>
+	/// 2x3 affine transform of a sprite. A point (x, y) is mapped to
+	/// (dot(m_row0, {x, y, 1}), dot(m_row1, {x, y, 1})).
+	/// Replaces a full glm::mat4, built with translate and scale, for 2D sprites.
+	/// </summary>
+	struct SAffine2D
+	{
+		/// <summary>
+		/// First row: x scale/rotation, y shear/rotation, x translation.
+		/// </summary>
+		glm::vec3 m_row0{ 1.0f, 0.0f, 0.0f };
+
+		/// <summary>
+		/// Second row: x shear/rotation, y scale/rotation, y translation.
+		/// </summary>
+		glm::vec3 m_row1{ 0.0f, 1.0f, 0.0f };
+
+		/// <summary>
+		/// Build the transform, which maps the unit quad [0, 1] x [0, 1] onto a destination rect.
+		/// </summary>
+		/// <param name="destRect"> Destination rect in screen space. </param>
+		/// <param name="flipFormat"> Flip format. The quad is mirrored around the rect center. </param>
+		/// <param name="fAngle"> Rotation in degrees, clockwise on screen like SDL_RenderCopyEx. </param>
+		/// <param name="origin"> Rotation origin, relative to the top-left of destRect. </param>
+		/// <returns> The sprite transform. </returns>
+		static SAffine2D FromSprite(const SDL_Rect& destRect, SDL_RendererFlip flipFormat,
+			float fAngle = 0.0f, const glm::vec2& origin = { 0.0f, 0.0f });
+
+		/// <summary>
+		/// Apply a translation in local space before this transform.
+		/// </summary>
+		/// <param name="localOffset"> Offset, added to points before they are transformed. </param>
+		/// <returns> The combined transform. </returns>
+		SAffine2D Translated(const glm::vec2& localOffset) const;
+
+		/// <summary>
+		/// Transform a point.
+		/// </summary>
+		/// <param name="point"> Point to be transformed. </param>
+		/// <returns> The transformed point. </returns>
+		glm::vec2 Apply(const glm::vec2& point) const
+		{
+			return glm::vec2{ m_row0.x * point.x + m_row0.y * point.y + m_row0.z,
+				m_row1.x * point.x + m_row1.y * point.y + m_row1.z };
+		}
+	};
+}
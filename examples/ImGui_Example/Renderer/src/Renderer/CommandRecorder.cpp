@@ -0,0 +1,100 @@
+#include "CommandRecorder.h"
+
+#include "Affine2D.h"
+#include "RectCuller.h"
+#include "Shader.h"
+#include "Texture.h"
+#include "VertexArray.h"
+
+namespace K9
+{
+	CommandRecorder::CommandRecorder()
+		: m_queue{}, m_viewportRect{}, m_bCullingEnabled{ true }, m_unLayer{ 0 }, m_unDepth{ 0 },
+		m_ptrShader{ nullptr }, m_unCulledCount{ 0 }
+	{
+	}
+
+	void CommandRecorder::SetViewport(const SDL_Rect& viewportRect, bool bCullingEnabled)
+	{
+		m_viewportRect = viewportRect;
+		m_bCullingEnabled = bCullingEnabled;
+	}
+
+	void CommandRecorder::SetLayer(unsigned int unLayer, unsigned int unDepth)
+	{
+		m_unLayer = unLayer;
+		m_unDepth = unDepth;
+	}
+
+	void CommandRecorder::SetShader(Shader* ptrShader)
+	{
+		m_ptrShader = ptrShader;
+	}
+
+	void CommandRecorder::DrawTexture(const Texture& texture, const SDL_Rect& destRect,
+		const SDL_Color& color, const SDL_RendererFlip& flipFormat)
+	{
+		RecordSprite(texture, destRect, glm::vec2{ 0.0f, 0.0f }, glm::vec2{ 1.0f, 1.0f }, color, flipFormat);
+	}
+
+	void CommandRecorder::DrawTexture(const Texture& texture, const SDL_Rect& srcRect, const SDL_Rect& destRect,
+		const SDL_Color& color, const SDL_RendererFlip& flipFormat)
+	{
+		DrawTexture(texture, srcRect, destRect, 0.0f, SDL_Point{ 0, 0 }, color, flipFormat);
+	}
+
+	void CommandRecorder::DrawTexture(const Texture& texture, const SDL_Rect& srcRect, const SDL_Rect& destRect,
+		float fAngle, const SDL_Point& center, const SDL_Color& color, const SDL_RendererFlip& flipFormat)
+	{
+		float fDestW = static_cast<float>(texture.GetWidth());
+		float fDestH = static_cast<float>(texture.GetHeight());
+
+		VertexArray::SRectParam rectParam;
+		rectParam.m_minUV.x = static_cast<float>(srcRect.x) / fDestW;
+		rectParam.m_minUV.y = static_cast<float>(srcRect.y) / fDestH;
+		rectParam.m_maxUV.x = static_cast<float>(srcRect.x + srcRect.w) / fDestW;
+		rectParam.m_maxUV.y = static_cast<float>(srcRect.y + srcRect.h) / fDestH;
+
+		if (rectParam.CheckUV())
+		{
+			RecordSprite(texture, destRect, rectParam.m_minUV, rectParam.m_maxUV, color, flipFormat,
+				fAngle, glm::vec2{ static_cast<float>(center.x), static_cast<float>(center.y) });
+		}
+	}
+
+	void CommandRecorder::Clear()
+	{
+		m_queue.Clear();
+		m_unCulledCount = 0;
+	}
+
+	void CommandRecorder::Reserve(size_t unCount)
+	{
+		m_queue.Reserve(unCount);
+	}
+
+	/* Private methods. */
+	void CommandRecorder::RecordSprite(const Texture& texture, const SDL_Rect& destRect,
+		const glm::vec2& minUV, const glm::vec2& maxUV,
+		const SDL_Color& color, SDL_RendererFlip flipFormat,
+		float fAngle, const glm::vec2& origin)
+	{
+		if (m_bCullingEnabled)
+		{
+			/* Same test as Renderer2D::DrawSprite. */
+			bool bVisible = fAngle == 0.0f ? RectCuller::IsVisible(destRect, m_viewportRect) :
+				RectCuller::IsVisible(RectCuller::GetBounds(SAffine2D::FromSprite(destRect,
+					SDL_RendererFlip::SDL_FLIP_NONE, fAngle, origin)), m_viewportRect);
+			if (!bVisible)
+			{
+				m_unCulledCount++;
+				return;
+			}
+		}
+
+		/* Only alpha blending is supported, so the blend mode is always 0. */
+		uint32_t unShaderID = m_ptrShader ? m_ptrShader->GetProgramID() : 0;
+		uint64_t unSortKey = RenderQueue::MakeSortKey(m_unLayer, 0, unShaderID, texture.GetTextureID(), m_unDepth);
+		m_queue.Push(unSortKey, { &texture, m_ptrShader, destRect, minUV, maxUV, color, flipFormat, fAngle, origin });
+	}
+}
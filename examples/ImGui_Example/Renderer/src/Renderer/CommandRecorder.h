@@ -0,0 +1,138 @@
+#pragma once
+#include <SDL.h>
+#include <glm/glm.hpp>
+#include "RenderQueue.h"
+
+namespace K9
+{
+	class Shader;
+	class Texture;
+
+	/// <summary>
+	/// Records sprites on a worker thread into its own RenderQueue, so several threads can record a frame without locking.
+	/// Created by Renderer2D::CreateCommandRecorder and submitted with Renderer2D::SubmitCommandRecorders.
+	/// A recorder may only be used by one thread at a time and not while it is submitted.
+	/// Culling and the sort key are done while recording, so that work is spread across the threads too.
+	/// Textures must stay alive until the recorder is submitted, and with the render thread until their frame is drawn.
+	/// </summary>
+	class CommandRecorder
+	{
+	public:
+		CommandRecorder();
+
+		/** Delete the copy constructor, move constructor and assignment operators. */
+		CommandRecorder(const CommandRecorder&) = delete;
+		CommandRecorder(CommandRecorder&&) = delete;
+		CommandRecorder& operator=(const CommandRecorder&) = delete;
+		CommandRecorder& operator=(CommandRecorder&) = delete;
+
+		/// <summary>
+		/// Set the visible area and whether sprites outside of it are culled. Called by Renderer2D.
+		/// </summary>
+		/// <param name="viewportRect"> Visible area in screen space. </param>
+		/// <param name="bCullingEnabled"> True, to cull sprites. </param>
+		void SetViewport(const SDL_Rect& viewportRect, bool bCullingEnabled);
+
+		/// <summary>
+		/// Set the layer and depth of the following sprites. Only used, when the recorders are submitted sorted.
+		/// </summary>
+		/// <param name="unLayer"> Layer in the range [0, 255]. </param>
+		/// <param name="unDepth"> Depth in the range [0, 2^24 - 1]. </param>
+		void SetLayer(unsigned int unLayer, unsigned int unDepth = 0);
+
+		/// <summary>
+		/// Set the shader of the following sprites.
+		/// </summary>
+		/// <param name="ptrShader"> Shader to be set. nullptr for the default sprite shader. </param>
+		void SetShader(Shader* ptrShader);
+
+		/* Draw methods. Same as the ones of Renderer2D. */
+		/// <summary>
+		/// Record a texture with a destination rect and flip format.
+		/// </summary>
+		void DrawTexture(const Texture& texture, const SDL_Rect& destRect,
+			const SDL_Color& color = { 255, 255, 255, 255 },
+			const SDL_RendererFlip& flipFormat = SDL_RendererFlip::SDL_FLIP_NONE);
+
+		/// <summary>
+		/// Record a texture with a source rect, destination rect and flip format.
+		/// </summary>
+		void DrawTexture(const Texture& texture, const SDL_Rect& srcRect, const SDL_Rect& destRect,
+			const SDL_Color& color = { 255, 255, 255, 255 },
+			const SDL_RendererFlip& flipFormat = SDL_RendererFlip::SDL_FLIP_NONE);
+
+		/// <summary>
+		/// Record a texture with a source rect, destination rect, rotation and flip format, like SDL_RenderCopyEx.
+		/// </summary>
+		/// <param name="fAngle"> Rotation in degrees, clockwise on screen. </param>
+		/// <param name="center"> Rotation origin, relative to the top-left of destRect. </param>
+		void DrawTexture(const Texture& texture, const SDL_Rect& srcRect, const SDL_Rect& destRect,
+			float fAngle, const SDL_Point& center,
+			const SDL_Color& color = { 255, 255, 255, 255 },
+			const SDL_RendererFlip& flipFormat = SDL_RendererFlip::SDL_FLIP_NONE);
+
+		/// <summary>
+		/// Remove all recorded sprites and reset the culling count. The memory is kept.
+		/// </summary>
+		void Clear();
+
+		/// <summary>
+		/// Reserve space for sprites, so the first frames don't allocate while recording.
+		/// </summary>
+		/// <param name="unCount"> Number of sprites. </param>
+		void Reserve(size_t unCount);
+
+		/// <summary>
+		/// Retrieve the recorded sprites with their sort keys.
+		/// </summary>
+		/// <returns> m_queue. </returns>
+		const RenderQueue& GetQueue() const { return m_queue; }
+
+		/// <summary>
+		/// Retrieve the number of sprites, culled since the last Clear.
+		/// </summary>
+		/// <returns> m_unCulledCount. </returns>
+		unsigned int GetCulledCount() const { return m_unCulledCount; }
+
+	private:
+		/// <summary>
+		/// Cull and record a textured quad.
+		/// </summary>
+		void RecordSprite(const Texture& texture, const SDL_Rect& destRect,
+			const glm::vec2& minUV, const glm::vec2& maxUV,
+			const SDL_Color& color, SDL_RendererFlip flipFormat,
+			float fAngle = 0.0f, const glm::vec2& origin = { 0.0f, 0.0f });
+
+	private:
+		/// <summary>
+		/// Recorded sprites.
+		/// </summary>
+		RenderQueue m_queue;
+
+		/// <summary>
+		/// Visible area in screen space.
+		/// </summary>
+		SDL_Rect m_viewportRect;
+
+		/// <summary>
+		/// True, if sprites outside of m_viewportRect are culled.
+		/// </summary>
+		bool m_bCullingEnabled;
+
+		/// <summary>
+		/// Layer and depth of the following sprites.
+		/// </summary>
+		unsigned int m_unLayer;
+		unsigned int m_unDepth;
+
+		/// <summary>
+		/// Shader of the following sprites.
+		/// </summary>
+		Shader* m_ptrShader;
+
+		/// <summary>
+		/// Number of sprites, culled since the last Clear.
+		/// </summary>
+		unsigned int m_unCulledCount;
+	};
+}
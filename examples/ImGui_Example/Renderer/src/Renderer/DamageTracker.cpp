@@ -0,0 +1,144 @@
+#include "DamageTracker.h"
+#include <algorithm>
+
+namespace K9
+{
+	/* Smallest rect, which contains both rects. */
+	static SDL_Rect UnionRect(const SDL_Rect& rectA, const SDL_Rect& rectB)
+	{
+		int nMinX = std::min(rectA.x, rectB.x);
+		int nMinY = std::min(rectA.y, rectB.y);
+		int nMaxX = std::max(rectA.x + rectA.w, rectB.x + rectB.w);
+		int nMaxY = std::max(rectA.y + rectA.h, rectB.y + rectB.h);
+		return SDL_Rect{ nMinX, nMinY, nMaxX - nMinX, nMaxY - nMinY };
+	}
+
+	static int64_t GetArea(const SDL_Rect& rect)
+	{
+		return static_cast<int64_t>(rect.w) * rect.h;
+	}
+
+	DamageTracker::DamageTracker()
+		: m_vecPrevDraws{}, m_vecCurrDraws{}, m_vecDamageRects{}, m_bFullDamage{ true }, m_unDamagedPixelCount{ 0 }
+	{
+	}
+
+	void DamageTracker::BeginFrame()
+	{
+		m_vecCurrDraws.clear();
+		m_vecDamageRects.clear();
+	}
+
+	void DamageTracker::AddDraw(const SDL_Rect& bounds, uint64_t unHash)
+	{
+		m_vecCurrDraws.push_back({ bounds, unHash });
+	}
+
+	void DamageTracker::AddDamage(const SDL_Rect& rect)
+	{
+		AddDamageRect(rect);
+	}
+
+	void DamageTracker::InvalidateAll()
+	{
+		m_bFullDamage = true;
+	}
+
+	const std::vector<SDL_Rect>& DamageTracker::EndFrame(const SDL_Rect& viewport)
+	{
+		if (m_bFullDamage)
+		{
+			m_vecDamageRects.assign(1, viewport);
+		}
+		else
+		{
+			/* Draws at the same position in both lists, which are equal, cover the same pixels in the same order. */
+			size_t unCommonCount = std::min(m_vecPrevDraws.size(), m_vecCurrDraws.size());
+			for (size_t unIndex = 0; unIndex < unCommonCount; ++unIndex)
+			{
+				const SDrawRecord& prevDraw = m_vecPrevDraws[unIndex];
+				const SDrawRecord& currDraw = m_vecCurrDraws[unIndex];
+				if (prevDraw.m_unHash != currDraw.m_unHash || !SDL_RectEquals(&prevDraw.m_bounds, &currDraw.m_bounds))
+				{
+					AddDamageRect(prevDraw.m_bounds);
+					AddDamageRect(currDraw.m_bounds);
+				}
+			}
+			for (size_t unIndex = unCommonCount; unIndex < m_vecPrevDraws.size(); ++unIndex)
+			{
+				AddDamageRect(m_vecPrevDraws[unIndex].m_bounds);
+			}
+			for (size_t unIndex = unCommonCount; unIndex < m_vecCurrDraws.size(); ++unIndex)
+			{
+				AddDamageRect(m_vecCurrDraws[unIndex].m_bounds);
+			}
+		}
+
+		/* Clip the damage to the viewport and drop what's outside of it. */
+		m_unDamagedPixelCount = 0;
+		auto itEnd = std::remove_if(m_vecDamageRects.begin(), m_vecDamageRects.end(), [&viewport](SDL_Rect& rect)
+			{
+				SDL_Rect clippedRect;
+				if (!SDL_IntersectRect(&rect, &viewport, &clippedRect))
+				{
+					return true;
+				}
+				rect = clippedRect;
+				return false;
+			});
+		m_vecDamageRects.erase(itEnd, m_vecDamageRects.end());
+		for (const auto& rect : m_vecDamageRects)
+		{
+			m_unDamagedPixelCount += static_cast<unsigned int>(GetArea(rect));
+		}
+
+		m_bFullDamage = false;
+		std::swap(m_vecPrevDraws, m_vecCurrDraws);
+		return m_vecDamageRects;
+	}
+
+	/* Private methods. */
+	void DamageTracker::AddDamageRect(const SDL_Rect& rect)
+	{
+		if (rect.w <= 0 || rect.h <= 0)
+		{
+			return;
+		}
+
+		/* Grow an existing rect, which already overlaps the new one. */
+		for (auto& damageRect : m_vecDamageRects)
+		{
+			if (SDL_HasIntersection(&damageRect, &rect))
+			{
+				damageRect = UnionRect(damageRect, rect);
+				return;
+			}
+		}
+		m_vecDamageRects.push_back(rect);
+
+		/* Merge the pair, which adds the least area, until the limit is met. */
+		while (m_vecDamageRects.size() > MAX_DAMAGE_RECT_COUNT)
+		{
+			size_t unBestA = 0;
+			size_t unBestB = 1;
+			int64_t nBestCost = INT64_MAX;
+			for (size_t unIndexA = 0; unIndexA < m_vecDamageRects.size(); ++unIndexA)
+			{
+				for (size_t unIndexB = unIndexA + 1; unIndexB < m_vecDamageRects.size(); ++unIndexB)
+				{
+					const SDL_Rect& rectA = m_vecDamageRects[unIndexA];
+					const SDL_Rect& rectB = m_vecDamageRects[unIndexB];
+					int64_t nCost = GetArea(UnionRect(rectA, rectB)) - GetArea(rectA) - GetArea(rectB);
+					if (nCost < nBestCost)
+					{
+						nBestCost = nCost;
+						unBestA = unIndexA;
+						unBestB = unIndexB;
+					}
+				}
+			}
+			m_vecDamageRects[unBestA] = UnionRect(m_vecDamageRects[unBestA], m_vecDamageRects[unBestB]);
+			m_vecDamageRects.erase(m_vecDamageRects.begin() + unBestB);
+		}
+	}
+}
@@ -0,0 +1,101 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <SDL.h>
+
+namespace K9
+{
+	/// <summary>
+	/// Finds the screen regions, which changed since the last frame.
+	/// Every draw of a frame is recorded with its bounds and a hash of everything, which affects its pixels.
+	/// The draw lists of two frames are compared in order. A draw, which differs, damages its old and new bounds.
+	/// The damage is merged into at most MAX_DAMAGE_RECT_COUNT rects, so it can be redrawn with a few scissored passes.
+	/// </summary>
+	class DamageTracker
+	{
+	public:
+		/// <summary>
+		/// Maximum number of damage rects per frame. Further rects are merged with their closest neighbour.
+		/// </summary>
+		static constexpr unsigned int MAX_DAMAGE_RECT_COUNT{ 4 };
+
+		DamageTracker();
+
+		/// <summary>
+		/// Start recording the draws of a new frame.
+		/// </summary>
+		void BeginFrame();
+
+		/// <summary>
+		/// Record a draw of the current frame.
+		/// </summary>
+		/// <param name="bounds"> Screen space bounds of the draw. </param>
+		/// <param name="unHash"> Hash of the draw parameters. </param>
+		void AddDraw(const SDL_Rect& bounds, uint64_t unHash);
+
+		/// <summary>
+		/// Damage a region explicitly, e.g. for content, which isn't drawn through the recorded draws.
+		/// </summary>
+		/// <param name="rect"> Damaged region in screen space. </param>
+		void AddDamage(const SDL_Rect& rect);
+
+		/// <summary>
+		/// Damage the whole viewport on the next EndFrame, e.g. after a resize or a background color change.
+		/// </summary>
+		void InvalidateAll();
+
+		/// <summary>
+		/// Compare the draws of the current frame with the last one and compute the damage.
+		/// </summary>
+		/// <param name="viewport"> Visible area. The damage is clipped to it. </param>
+		/// <returns> Damaged rects, clipped to the viewport. Empty, if nothing changed. </returns>
+		const std::vector<SDL_Rect>& EndFrame(const SDL_Rect& viewport);
+
+		/// <summary>
+		/// Retrieve the number of damaged pixels of the last EndFrame.
+		/// </summary>
+		/// <returns> m_unDamagedPixelCount. </returns>
+		unsigned int GetDamagedPixelCount() const { return m_unDamagedPixelCount; }
+
+	private:
+		/// <summary>
+		/// A recorded draw.
+		/// </summary>
+		struct SDrawRecord
+		{
+			SDL_Rect m_bounds;
+			uint64_t m_unHash;
+		};
+
+		/// <summary>
+		/// Add a rect to m_vecDamageRects and merge rects, if there are too many.
+		/// </summary>
+		void AddDamageRect(const SDL_Rect& rect);
+
+	private:
+		/// <summary>
+		/// Draws of the last frame.
+		/// </summary>
+		std::vector<SDrawRecord> m_vecPrevDraws;
+
+		/// <summary>
+		/// Draws of the current frame.
+		/// </summary>
+		std::vector<SDrawRecord> m_vecCurrDraws;
+
+		/// <summary>
+		/// Damaged rects of the current frame.
+		/// </summary>
+		std::vector<SDL_Rect> m_vecDamageRects;
+
+		/// <summary>
+		/// True, if the whole viewport is damaged.
+		/// </summary>
+		bool m_bFullDamage;
+
+		/// <summary>
+		/// Number of damaged pixels of the last EndFrame.
+		/// </summary>
+		unsigned int m_unDamagedPixelCount;
+	};
+}
@@ -0,0 +1,56 @@
+#include "FramePacket.h"
+#include <glad/glad.h>
+
+#include "Texture.h"
+
+namespace K9
+{
+	SFramePacket::SFramePacket()
+		: m_vecCommands{}, m_unImGUICommandIndex{ 0 }, m_vecRetainedTextures{}, m_imguiDrawData{},
+		m_vecImGUIDrawLists{}, m_bgrColor{}, m_fence{ nullptr },
+		m_unSubmittedSpriteCount{ 0 }, m_unCulledSpriteCount{ 0 }, m_fWaitTimeMS{ 0.0f }
+	{
+	}
+
+	SFramePacket::~SFramePacket()
+	{
+		Clear();
+	}
+
+	void SFramePacket::Clear()
+	{
+		m_vecCommands.clear();
+		m_unImGUICommandIndex = 0;
+		m_vecRetainedTextures.clear();
+
+		for (ImDrawList* ptrDrawList : m_vecImGUIDrawLists)
+		{
+			IM_DELETE(ptrDrawList);
+		}
+		m_vecImGUIDrawLists.clear();
+		m_imguiDrawData.Clear();
+
+		if (m_fence)
+		{
+			glDeleteSync(m_fence);
+			m_fence = nullptr;
+		}
+
+		m_unSubmittedSpriteCount = 0;
+		m_unCulledSpriteCount = 0;
+		m_fWaitTimeMS = 0.0f;
+	}
+
+	void SFramePacket::CopyImGUIDrawData(const ImDrawData& drawData)
+	{
+		for (int nIndex = 0; nIndex < drawData.CmdListsCount; ++nIndex)
+		{
+			m_vecImGUIDrawLists.push_back(drawData.CmdLists[nIndex]->CloneOutput());
+		}
+
+		/* Keep the display rect and totals, but point at the clones. */
+		m_imguiDrawData = drawData;
+		m_imguiDrawData.CmdLists = m_vecImGUIDrawLists.data();
+		m_imguiDrawData.CmdListsCount = static_cast<int>(m_vecImGUIDrawLists.size());
+	}
+}
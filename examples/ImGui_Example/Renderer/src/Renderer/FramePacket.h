@@ -0,0 +1,142 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include <SDL.h>
+#include <glm/glm.hpp>
+#include <imgui.h>
+#include "RenderQueue.h"
+
+using GLsync = struct __GLsync*;
+
+namespace K9
+{
+	class Texture;
+
+	/// <summary>
+	/// Blend modes, used by the renderer.
+	/// </summary>
+	enum class EBlendMode
+	{
+		/// <summary>
+		/// Straight alpha blending over the screen.
+		/// </summary>
+		eAlpha,
+
+		/// <summary>
+		/// Straight alpha blending into a transparent target. The target ends up with premultiplied alpha.
+		/// </summary>
+		eAlphaToPremultiplied,
+
+		/// <summary>
+		/// Blending of premultiplied alpha over the screen.
+		/// </summary>
+		ePremultipliedAlpha
+	};
+
+	/// <summary>
+	/// A recorded sprite with the renderer state it was drawn with.
+	/// Used by damage tracking and by the frame packets of the render thread.
+	/// </summary>
+	struct SFrameCommand
+	{
+		/// <summary>
+		/// The sprite and its shader.
+		/// </summary>
+		SSpriteCommand m_command;
+
+		/// <summary>
+		/// Screen space bounds of the sprite.
+		/// </summary>
+		SDL_Rect m_bounds;
+
+		/// <summary>
+		/// Sort layer and depth of the sprite.
+		/// </summary>
+		unsigned int m_unLayer;
+		unsigned int m_unDepth;
+
+		/// <summary>
+		/// Blend mode of the sprite.
+		/// </summary>
+		EBlendMode m_eBlendMode;
+
+		/// <summary>
+		/// True, if sorting was enabled.
+		/// </summary>
+		bool m_bSorted;
+	};
+
+	/// <summary>
+	/// Everything the render thread needs to draw a frame, built by the main thread.
+	/// Packets are reused, so their buffers don't allocate in steady state.
+	/// Must be cleared and destroyed on the main thread, since it owns the ImGUI allocations and the retained textures.
+	/// </summary>
+	struct SFramePacket
+	{
+		SFramePacket();
+		~SFramePacket();
+
+		/** Delete the copy constructor, move constructor and assignment operators. */
+		SFramePacket(const SFramePacket&) = delete;
+		SFramePacket(SFramePacket&&) = delete;
+		SFramePacket& operator=(const SFramePacket&) = delete;
+		SFramePacket& operator=(SFramePacket&) = delete;
+
+		/// <summary>
+		/// Reset the packet for a new frame. Frees the ImGUI copy, releases the retained textures and deletes the fence.
+		/// </summary>
+		void Clear();
+
+		/// <summary>
+		/// Copy the ImGUI draw data of the current frame, since ImGUI overwrites it on the next NewFrame.
+		/// </summary>
+		/// <param name="drawData"> Draw data, returned by ImGui::GetDrawData. </param>
+		void CopyImGUIDrawData(const ImDrawData& drawData);
+
+		/// <summary>
+		/// Sprites of the frame in submission order.
+		/// </summary>
+		std::vector<SFrameCommand> m_vecCommands;
+
+		/// <summary>
+		/// Number of commands, drawn below the ImGUI windows. The rest is drawn above them.
+		/// </summary>
+		size_t m_unImGUICommandIndex;
+
+		/// <summary>
+		/// Textures, drawn through a shared pointer, kept alive until the packet is drawn.
+		/// </summary>
+		std::vector<std::shared_ptr<Texture>> m_vecRetainedTextures;
+
+		/// <summary>
+		/// Copy of the ImGUI draw data. Its CmdLists point into m_vecImGUIDrawLists.
+		/// </summary>
+		ImDrawData m_imguiDrawData;
+
+		/// <summary>
+		/// Clones of the ImGUI draw lists, owned by the packet.
+		/// </summary>
+		std::vector<ImDrawList*> m_vecImGUIDrawLists;
+
+		/// <summary>
+		/// Background color of the frame.
+		/// </summary>
+		glm::vec4 m_bgrColor;
+
+		/// <summary>
+		/// Fence after the resource uploads of the main thread. The render thread waits on it before drawing.
+		/// </summary>
+		GLsync m_fence;
+
+		/// <summary>
+		/// Culling statistics of the main thread.
+		/// </summary>
+		unsigned int m_unSubmittedSpriteCount;
+		unsigned int m_unCulledSpriteCount;
+
+		/// <summary>
+		/// Time, the main thread waited for this packet to become free, in milliseconds.
+		/// </summary>
+		float m_fWaitTimeMS;
+	};
+}
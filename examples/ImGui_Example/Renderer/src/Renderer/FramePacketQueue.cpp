@@ -0,0 +1,69 @@
+#include "FramePacketQueue.h"
+#include <algorithm>
+#include <chrono>
+
+namespace K9
+{
+	FramePacketQueue::FramePacketQueue(unsigned int unPacketCount)
+		: m_vecPackets{}, m_unWriteIndex{ 0 }, m_unReadIndex{ 0 }, m_unPendingCount{ 0 }, m_bStopped{ false },
+		m_mutex{}, m_freeCondition{}, m_writtenCondition{}
+	{
+		unPacketCount = std::min(std::max(unPacketCount, MIN_PACKET_COUNT), MAX_PACKET_COUNT);
+		for (unsigned int unIndex = 0; unIndex < unPacketCount; ++unIndex)
+		{
+			m_vecPackets.emplace_back(new SFramePacket());
+		}
+	}
+
+	SFramePacket& FramePacketQueue::BeginWrite(float& fOutWaitTimeMS)
+	{
+		auto start = std::chrono::steady_clock::now();
+		{
+			/* Every pending packet may still be read, so one of them must be returned first. */
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_freeCondition.wait(lock, [this] { return m_unPendingCount < m_vecPackets.size(); });
+		}
+		fOutWaitTimeMS = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+		return *m_vecPackets[m_unWriteIndex];
+	}
+
+	void FramePacketQueue::EndWrite()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_unWriteIndex = (m_unWriteIndex + 1) % m_vecPackets.size();
+			m_unPendingCount++;
+		}
+		m_writtenCondition.notify_one();
+	}
+
+	SFramePacket* FramePacketQueue::BeginRead()
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_writtenCondition.wait(lock, [this] { return m_unPendingCount > 0 || m_bStopped; });
+		if (m_unPendingCount == 0)
+		{
+			return nullptr;
+		}
+		return m_vecPackets[m_unReadIndex].get();
+	}
+
+	void FramePacketQueue::EndRead()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_unReadIndex = (m_unReadIndex + 1) % m_vecPackets.size();
+			m_unPendingCount--;
+		}
+		m_freeCondition.notify_one();
+	}
+
+	void FramePacketQueue::Stop()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_bStopped = true;
+		}
+		m_writtenCondition.notify_one();
+	}
+}
@@ -0,0 +1,112 @@
+#pragma once
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "FramePacket.h"
+
+namespace K9
+{
+	/// <summary>
+	/// Fixed ring of frame packets, handed from the main thread to the render thread in order.
+	/// The main thread writes one packet, while the render thread draws the previous ones,
+	/// so up to the packet count frames are in flight. Writing blocks only when all packets are in flight.
+	/// </summary>
+	class FramePacketQueue
+	{
+	public:
+		/// <summary>
+		/// Range of the number of packets. Two overlap one frame of simulation with one frame of drawing.
+		/// </summary>
+		static constexpr unsigned int MIN_PACKET_COUNT{ 2 };
+		static constexpr unsigned int MAX_PACKET_COUNT{ 3 };
+
+		/// <summary>
+		/// Create the packets.
+		/// </summary>
+		/// <param name="unPacketCount"> Number of packets, clamped to [MIN_PACKET_COUNT, MAX_PACKET_COUNT]. </param>
+		explicit FramePacketQueue(unsigned int unPacketCount);
+
+		/** Delete the copy constructor, move constructor and assignment operators. */
+		FramePacketQueue(const FramePacketQueue&) = delete;
+		FramePacketQueue(FramePacketQueue&&) = delete;
+		FramePacketQueue& operator=(const FramePacketQueue&) = delete;
+		FramePacketQueue& operator=(FramePacketQueue&) = delete;
+
+		/// <summary>
+		/// Retrieve the next packet for writing. Blocks, while all packets are in flight. Called by the main thread.
+		/// </summary>
+		/// <param name="fOutWaitTimeMS"> Time, spent waiting for the packet, in milliseconds. </param>
+		/// <returns> The packet, not cleared yet. </returns>
+		SFramePacket& BeginWrite(float& fOutWaitTimeMS);
+
+		/// <summary>
+		/// Hand the packet from BeginWrite to the render thread.
+		/// </summary>
+		void EndWrite();
+
+		/// <summary>
+		/// Retrieve the oldest written packet. Blocks, until a packet is written or the queue is stopped.
+		/// Called by the render thread.
+		/// </summary>
+		/// <returns> The packet or nullptr, if the queue is stopped and all packets are drawn. </returns>
+		SFramePacket* BeginRead();
+
+		/// <summary>
+		/// Return the packet from BeginRead to the main thread.
+		/// </summary>
+		void EndRead();
+
+		/// <summary>
+		/// Let BeginRead return nullptr, once the written packets are drawn.
+		/// </summary>
+		void Stop();
+
+		/// <summary>
+		/// Retrieve the number of packets.
+		/// </summary>
+		/// <returns> Size of m_vecPackets. </returns>
+		unsigned int GetPacketCount() const { return static_cast<unsigned int>(m_vecPackets.size()); }
+
+	private:
+		/// <summary>
+		/// The ring of packets.
+		/// </summary>
+		std::vector<std::unique_ptr<SFramePacket>> m_vecPackets;
+
+		/// <summary>
+		/// Index of the next packet to write.
+		/// </summary>
+		unsigned int m_unWriteIndex;
+
+		/// <summary>
+		/// Index of the next packet to read.
+		/// </summary>
+		unsigned int m_unReadIndex;
+
+		/// <summary>
+		/// Number of written packets, which weren't returned by EndRead yet.
+		/// </summary>
+		unsigned int m_unPendingCount;
+
+		/// <summary>
+		/// True, after Stop.
+		/// </summary>
+		bool m_bStopped;
+
+		/// <summary>
+		/// Guards the indices, m_unPendingCount and m_bStopped.
+		/// </summary>
+		std::mutex m_mutex;
+
+		/// <summary>
+		/// Signaled, when a packet is returned by EndRead.
+		/// </summary>
+		std::condition_variable m_freeCondition;
+
+		/// <summary>
+		/// Signaled, when a packet is written or the queue is stopped.
+		/// </summary>
+		std::condition_variable m_writtenCondition;
+	};
+}
@@ -0,0 +1,227 @@
+#include "GLStateCache.h"
+#include <glad/glad.h>
+
+namespace K9
+{
+	/* Value of a cached state, which is unknown and must be issued on the next call. */
+	static constexpr GLuint UNKNOWN_STATE{ 0xFFFFFFFF };
+
+	GLStateCache& GLStateCache::Ref()
+	{
+		/* Each thread has its own current context, so each gets its own shadow. */
+		static thread_local GLStateCache ref;
+		return ref;
+	}
+
+	void GLStateCache::UseProgram(GLuint unProgramID)
+	{
+		if (Update(m_unProgramID, unProgramID))
+		{
+			glUseProgram(unProgramID);
+		}
+	}
+
+	void GLStateCache::BindVertexArray(GLuint unVertexArrayID)
+	{
+		if (Update(m_unVertexArrayID, unVertexArrayID))
+		{
+			glBindVertexArray(unVertexArrayID);
+		}
+	}
+
+	void GLStateCache::BindArrayBuffer(GLuint unBufferID)
+	{
+		if (Update(m_unArrayBufferID, unBufferID))
+		{
+			glBindBuffer(GL_ARRAY_BUFFER, unBufferID);
+		}
+	}
+
+	void GLStateCache::BindTexture(unsigned int unUnit, GLuint unTextureID)
+	{
+		if (unUnit >= MAX_TRACKED_TEXTURE_UNITS)
+		{
+			ActiveTexture(unUnit);
+			glBindTexture(GL_TEXTURE_2D, unTextureID);
+			m_stats.m_unIssuedCount++;
+			return;
+		}
+
+		if (m_arrTextureIDs[unUnit] == unTextureID)
+		{
+			m_stats.m_unSkippedCount++;
+			return;
+		}
+
+		ActiveTexture(unUnit);
+		Update(m_arrTextureIDs[unUnit], unTextureID);
+		glBindTexture(GL_TEXTURE_2D, unTextureID);
+	}
+
+	void GLStateCache::BindFramebuffer(GLuint unFramebufferID)
+	{
+		if (Update(m_unFramebufferID, unFramebufferID))
+		{
+			glBindFramebuffer(GL_FRAMEBUFFER, unFramebufferID);
+		}
+	}
+
+	void GLStateCache::SetBlendEnabled(bool bEnabled)
+	{
+		if (Update(m_unBlendEnabled, bEnabled ? GL_TRUE : GL_FALSE))
+		{
+			if (bEnabled)
+			{
+				glEnable(GL_BLEND);
+			}
+			else
+			{
+				glDisable(GL_BLEND);
+			}
+		}
+	}
+
+	void GLStateCache::SetBlendMode(GLenum eEquationRGB, GLenum eEquationAlpha,
+		GLenum eSrcRGB, GLenum eDstRGB, GLenum eSrcAlpha, GLenum eDstAlpha)
+	{
+		std::array<GLuint, 6> arrBlendMode{ eEquationRGB, eEquationAlpha, eSrcRGB, eDstRGB, eSrcAlpha, eDstAlpha };
+		if (arrBlendMode == m_arrBlendMode)
+		{
+			m_stats.m_unSkippedCount++;
+			return;
+		}
+
+		m_arrBlendMode = arrBlendMode;
+		glBlendEquationSeparate(eEquationRGB, eEquationAlpha);
+		glBlendFuncSeparate(eSrcRGB, eDstRGB, eSrcAlpha, eDstAlpha);
+		m_stats.m_unIssuedCount += 2;
+	}
+
+	void GLStateCache::OnProgramDeleted(GLuint unProgramID)
+	{
+		/* A deleted program stays in use until another one is set, but its ID may be reused. */
+		if (m_unProgramID == unProgramID)
+		{
+			m_unProgramID = UNKNOWN_STATE;
+		}
+	}
+
+	void GLStateCache::OnVertexArrayDeleted(GLuint unVertexArrayID)
+	{
+		/* Deleting a bound vertex array reverts the binding to 0. */
+		if (m_unVertexArrayID == unVertexArrayID)
+		{
+			m_unVertexArrayID = 0;
+		}
+	}
+
+	void GLStateCache::OnBufferDeleted(GLuint unBufferID)
+	{
+		/* Deleting a bound buffer reverts the binding to 0. */
+		if (m_unArrayBufferID == unBufferID)
+		{
+			m_unArrayBufferID = 0;
+		}
+	}
+
+	void GLStateCache::OnTextureDeleted(GLuint unTextureID)
+	{
+		/* Deleting a bound texture reverts the binding to 0. */
+		for (auto& unBoundTextureID : m_arrTextureIDs)
+		{
+			if (unBoundTextureID == unTextureID)
+			{
+				unBoundTextureID = 0;
+			}
+		}
+	}
+
+	void GLStateCache::OnFramebufferDeleted(GLuint unFramebufferID)
+	{
+		/* Deleting a bound framebuffer reverts the binding to the default framebuffer. */
+		if (m_unFramebufferID == unFramebufferID)
+		{
+			m_unFramebufferID = 0;
+		}
+	}
+
+	void GLStateCache::Invalidate()
+	{
+		m_unProgramID = UNKNOWN_STATE;
+		m_unVertexArrayID = UNKNOWN_STATE;
+		m_unArrayBufferID = UNKNOWN_STATE;
+		m_unActiveTextureUnit = UNKNOWN_STATE;
+		m_arrTextureIDs.fill(UNKNOWN_STATE);
+		m_unFramebufferID = UNKNOWN_STATE;
+		m_unBlendEnabled = UNKNOWN_STATE;
+		m_arrBlendMode.fill(UNKNOWN_STATE);
+	}
+
+	void GLStateCache::SyncAfterImGUI()
+	{
+		/* The backend restores everything it changes, but secondary viewports switch contexts.
+		 * Reading back the bindings is cheap and doesn't wait for the GPU. */
+		GLint nValue = 0;
+		glGetIntegerv(GL_CURRENT_PROGRAM, &nValue);
+		m_unProgramID = static_cast<GLuint>(nValue);
+		glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &nValue);
+		m_unVertexArrayID = static_cast<GLuint>(nValue);
+		glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &nValue);
+		m_unArrayBufferID = static_cast<GLuint>(nValue);
+		glGetIntegerv(GL_ACTIVE_TEXTURE, &nValue);
+		m_unActiveTextureUnit = static_cast<GLuint>(nValue - GL_TEXTURE0);
+		glGetIntegerv(GL_FRAMEBUFFER_BINDING, &nValue);
+		m_unFramebufferID = static_cast<GLuint>(nValue);
+
+		/* ImGUI binds its font texture to unit 0. */
+		m_arrTextureIDs[0] = UNKNOWN_STATE;
+
+		m_unBlendEnabled = glIsEnabled(GL_BLEND);
+		GLint arrBlendMode[6];
+		glGetIntegerv(GL_BLEND_EQUATION_RGB, &arrBlendMode[0]);
+		glGetIntegerv(GL_BLEND_EQUATION_ALPHA, &arrBlendMode[1]);
+		glGetIntegerv(GL_BLEND_SRC_RGB, &arrBlendMode[2]);
+		glGetIntegerv(GL_BLEND_DST_RGB, &arrBlendMode[3]);
+		glGetIntegerv(GL_BLEND_SRC_ALPHA, &arrBlendMode[4]);
+		glGetIntegerv(GL_BLEND_DST_ALPHA, &arrBlendMode[5]);
+		for (unsigned int unIndex = 0; unIndex < m_arrBlendMode.size(); ++unIndex)
+		{
+			m_arrBlendMode[unIndex] = static_cast<GLuint>(arrBlendMode[unIndex]);
+		}
+	}
+
+	void GLStateCache::ResetStats()
+	{
+		m_stats = SStats{};
+	}
+
+	/* Private methods. */
+	GLStateCache::GLStateCache()
+		: m_unProgramID{ UNKNOWN_STATE }, m_unVertexArrayID{ UNKNOWN_STATE },
+		m_unArrayBufferID{ UNKNOWN_STATE }, m_unActiveTextureUnit{ UNKNOWN_STATE },
+		m_arrTextureIDs{}, m_unFramebufferID{ UNKNOWN_STATE }, m_unBlendEnabled{ UNKNOWN_STATE }, m_arrBlendMode{}, m_stats{}
+	{
+		Invalidate();
+	}
+
+	void GLStateCache::ActiveTexture(unsigned int unUnit)
+	{
+		if (Update(m_unActiveTextureUnit, unUnit))
+		{
+			glActiveTexture(GL_TEXTURE0 + unUnit);
+		}
+	}
+
+	bool GLStateCache::Update(GLuint& unCached, GLuint unValue)
+	{
+		if (unCached == unValue)
+		{
+			m_stats.m_unSkippedCount++;
+			return false;
+		}
+
+		unCached = unValue;
+		m_stats.m_unIssuedCount++;
+		return true;
+	}
+}
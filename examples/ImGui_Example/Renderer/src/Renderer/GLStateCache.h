@@ -0,0 +1,208 @@
+#pragma once
+#include <array>
+
+using GLenum = unsigned int;
+using GLuint = unsigned int;
+
+namespace K9
+{
+	/// <summary>
+	/// Singleton shadow of the OpenGL state, used by Renderer2D, Shader, Texture and VertexArray.
+	/// Binds and enables go through it, so redundant calls are skipped.
+	/// Objects must notify the cache when they're deleted, since OpenGL may reuse their IDs.
+	/// There is one instance per thread, which shadows the context, current on that thread.
+	/// Deletions are only seen by the cache of the deleting thread, so other threads must Invalidate.
+	/// </summary>
+	class GLStateCache
+	{
+	public:
+		/// <summary>
+		/// Number of texture units, whose bindings are tracked.
+		/// Bindings on higher units are always issued.
+		/// </summary>
+		static constexpr unsigned int MAX_TRACKED_TEXTURE_UNITS{ 32 };
+
+		/// <summary>
+		/// Counts of state changes since the last ResetStats.
+		/// </summary>
+		struct SStats
+		{
+			/// <summary>
+			/// Number of state changes, sent to OpenGL.
+			/// </summary>
+			unsigned int m_unIssuedCount = 0;
+
+			/// <summary>
+			/// Number of redundant state changes, which were skipped.
+			/// </summary>
+			unsigned int m_unSkippedCount = 0;
+		};
+
+		/** Delete the copy constructor, move constructor and assignment operators. */
+		GLStateCache(const GLStateCache&) = delete;
+		GLStateCache(GLStateCache&&) = delete;
+		GLStateCache& operator=(const GLStateCache&) = delete;
+		GLStateCache& operator=(GLStateCache&) = delete;
+
+		/// <summary>
+		/// Return a static reference to the instance of the calling thread.
+		/// </summary>
+		/// <returns> A thread local instance. </returns>
+		static GLStateCache& Ref();
+
+		/// <summary>
+		/// Set the active shader program.
+		/// </summary>
+		/// <param name="unProgramID"> OpenGL ID of the program. </param>
+		void UseProgram(GLuint unProgramID);
+
+		/// <summary>
+		/// Bind a vertex array object.
+		/// </summary>
+		/// <param name="unVertexArrayID"> OpenGL ID of the vertex array. </param>
+		void BindVertexArray(GLuint unVertexArrayID);
+
+		/// <summary>
+		/// Bind a buffer to GL_ARRAY_BUFFER.
+		/// Other targets are part of the vertex array state or unused and are not cached.
+		/// </summary>
+		/// <param name="unBufferID"> OpenGL ID of the buffer. </param>
+		void BindArrayBuffer(GLuint unBufferID);
+
+		/// <summary>
+		/// Bind a 2D texture to a texture unit.
+		/// </summary>
+		/// <param name="unUnit"> Index of the texture unit. </param>
+		/// <param name="unTextureID"> OpenGL ID of the texture. </param>
+		void BindTexture(unsigned int unUnit, GLuint unTextureID);
+
+		/// <summary>
+		/// Bind a framebuffer to GL_FRAMEBUFFER.
+		/// </summary>
+		/// <param name="unFramebufferID"> OpenGL ID of the framebuffer. 0 for the default framebuffer. </param>
+		void BindFramebuffer(GLuint unFramebufferID);
+
+		/// <summary>
+		/// Enable or disable blending.
+		/// </summary>
+		/// <param name="bEnabled"> True, to enable blending. </param>
+		void SetBlendEnabled(bool bEnabled);
+
+		/// <summary>
+		/// Set the blend equation and function for color and alpha.
+		/// </summary>
+		void SetBlendMode(GLenum eEquationRGB, GLenum eEquationAlpha,
+			GLenum eSrcRGB, GLenum eDstRGB, GLenum eSrcAlpha, GLenum eDstAlpha);
+
+		/// <summary>
+		/// Forget a deleted program.
+		/// </summary>
+		void OnProgramDeleted(GLuint unProgramID);
+
+		/// <summary>
+		/// Forget a deleted vertex array.
+		/// </summary>
+		void OnVertexArrayDeleted(GLuint unVertexArrayID);
+
+		/// <summary>
+		/// Forget a deleted buffer.
+		/// </summary>
+		void OnBufferDeleted(GLuint unBufferID);
+
+		/// <summary>
+		/// Forget a deleted texture.
+		/// </summary>
+		void OnTextureDeleted(GLuint unTextureID);
+
+		/// <summary>
+		/// Forget a deleted framebuffer.
+		/// </summary>
+		void OnFramebufferDeleted(GLuint unFramebufferID);
+
+		/// <summary>
+		/// Forget all cached state. The next call of every setter is issued.
+		/// </summary>
+		void Invalidate();
+
+		/// <summary>
+		/// Read back the state, which the ImGUI OpenGL backend touches,
+		/// so the cache matches OpenGL again after ImGUI has rendered.
+		/// </summary>
+		void SyncAfterImGUI();
+
+		/// <summary>
+		/// Retrieve the state change counts since the last ResetStats.
+		/// </summary>
+		/// <returns> m_stats. </returns>
+		const SStats& GetStats() const { return m_stats; }
+
+		/// <summary>
+		/// Reset the state change counts.
+		/// </summary>
+		void ResetStats();
+
+	private:
+		GLStateCache();
+		~GLStateCache() = default;
+
+		/// <summary>
+		/// Set the active texture unit.
+		/// </summary>
+		/// <param name="unUnit"> Index of the texture unit. </param>
+		void ActiveTexture(unsigned int unUnit);
+
+		/// <summary>
+		/// Update a cached value and count the change.
+		/// </summary>
+		/// <param name="unCached"> Cached value. </param>
+		/// <param name="unValue"> New value. </param>
+		/// <returns> True, if the value changed and the call must be issued. </returns>
+		bool Update(GLuint& unCached, GLuint unValue);
+
+	private:
+		/// <summary>
+		/// Active shader program.
+		/// </summary>
+		GLuint m_unProgramID;
+
+		/// <summary>
+		/// Bound vertex array.
+		/// </summary>
+		GLuint m_unVertexArrayID;
+
+		/// <summary>
+		/// Buffer, bound to GL_ARRAY_BUFFER.
+		/// </summary>
+		GLuint m_unArrayBufferID;
+
+		/// <summary>
+		/// Active texture unit.
+		/// </summary>
+		GLuint m_unActiveTextureUnit;
+
+		/// <summary>
+		/// Textures, bound to each tracked texture unit.
+		/// </summary>
+		std::array<GLuint, MAX_TRACKED_TEXTURE_UNITS> m_arrTextureIDs;
+
+		/// <summary>
+		/// Framebuffer, bound to GL_FRAMEBUFFER.
+		/// </summary>
+		GLuint m_unFramebufferID;
+
+		/// <summary>
+		/// GL_TRUE, if blending is enabled.
+		/// </summary>
+		GLuint m_unBlendEnabled;
+
+		/// <summary>
+		/// Blend equations and functions: RGB equation, alpha equation, src RGB, dst RGB, src alpha, dst alpha.
+		/// </summary>
+		std::array<GLuint, 6> m_arrBlendMode;
+
+		/// <summary>
+		/// State change counts.
+		/// </summary>
+		SStats m_stats;
+	};
+}
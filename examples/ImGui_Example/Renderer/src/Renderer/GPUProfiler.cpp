@@ -0,0 +1,250 @@
+#include "GPUProfiler.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <glad/glad.h>
+
+namespace K9
+{
+	GPUProfiler::GPUProfiler()
+		: m_arrSlots{}, m_unWriteSlot{ 0 }, m_unReadSlot{ 0 }, m_bRecording{ false }, m_vecOpenScopes{},
+		m_bSupported{ false }, m_bEnabled{ true }, m_unSkippedFrameCount{ 0 }, m_vecHistories{}, m_historyMutex{}
+	{
+	}
+
+	GPUProfiler::~GPUProfiler()
+	{
+		/* The queries are deleted by Destroy, since the context may already be gone. */
+	}
+
+	bool GPUProfiler::Init()
+	{
+		/* A counter without bits can't measure anything. */
+		GLint nBits = 0;
+		glGetQueryiv(GL_TIMESTAMP, GL_QUERY_COUNTER_BITS, &nBits);
+		m_bSupported = nBits > 0;
+		if (!m_bSupported)
+		{
+			std::cerr << "GPUProfiler::Init Timestamp queries aren't supported!\n";
+		}
+		return m_bSupported;
+	}
+
+	void GPUProfiler::Destroy()
+	{
+		for (auto& slot : m_arrSlots)
+		{
+			if (!slot.m_vecQueries.empty())
+			{
+				glDeleteQueries(static_cast<GLsizei>(slot.m_vecQueries.size()), slot.m_vecQueries.data());
+			}
+			slot = SFrameSlot{};
+		}
+		m_unWriteSlot = 0;
+		m_unReadSlot = 0;
+		m_bRecording = false;
+		m_vecOpenScopes.clear();
+		m_bSupported = false;
+
+		std::lock_guard<std::mutex> lock(m_historyMutex);
+		m_vecHistories.clear();
+	}
+
+	void GPUProfiler::SetEnabled(bool bEnabled)
+	{
+		m_bEnabled = bEnabled;
+	}
+
+	void GPUProfiler::BeginFrame()
+	{
+		if (!m_bSupported)
+		{
+			return;
+		}
+
+		ReadBack();
+
+		m_bRecording = false;
+		if (!m_bEnabled)
+		{
+			return;
+		}
+
+		/* The oldest frame is still in flight. Waiting for it would stall the pipeline. */
+		SFrameSlot& slot = m_arrSlots[m_unWriteSlot];
+		if (slot.m_bPending)
+		{
+			m_unSkippedFrameCount++;
+			return;
+		}
+
+		slot.m_unQueryCount = 0;
+		slot.m_vecScopes.clear();
+		m_vecOpenScopes.clear();
+		m_bRecording = true;
+	}
+
+	void GPUProfiler::EndFrame()
+	{
+		if (!m_bRecording)
+		{
+			return;
+		}
+
+		while (!m_vecOpenScopes.empty())
+		{
+			EndScope();
+		}
+		m_bRecording = false;
+
+		SFrameSlot& slot = m_arrSlots[m_unWriteSlot];
+		if (slot.m_vecScopes.empty())
+		{
+			return;
+		}
+		slot.m_bPending = true;
+		m_unWriteSlot = (m_unWriteSlot + 1) % FRAME_LATENCY;
+	}
+
+	void GPUProfiler::BeginScope(const char* ptrName)
+	{
+		if (!m_bRecording)
+		{
+			return;
+		}
+
+		/* An ignored scope is still pushed, so its EndScope doesn't close the enclosing one. */
+		SFrameSlot& slot = m_arrSlots[m_unWriteSlot];
+		if (slot.m_vecScopes.size() >= MAX_SCOPES_PER_FRAME)
+		{
+			m_vecOpenScopes.push_back(IGNORED_SCOPE);
+			return;
+		}
+
+		unsigned int unDepth = static_cast<unsigned int>(m_vecOpenScopes.size());
+		m_vecOpenScopes.push_back(static_cast<unsigned int>(slot.m_vecScopes.size()));
+		slot.m_vecScopes.push_back({ ptrName, unDepth, IssueTimestamp(), 0 });
+	}
+
+	void GPUProfiler::EndScope()
+	{
+		if (!m_bRecording || m_vecOpenScopes.empty())
+		{
+			return;
+		}
+
+		unsigned int unScope = m_vecOpenScopes.back();
+		m_vecOpenScopes.pop_back();
+		if (unScope != IGNORED_SCOPE)
+		{
+			m_arrSlots[m_unWriteSlot].m_vecScopes[unScope].m_unEndQuery = IssueTimestamp();
+		}
+	}
+
+	std::vector<GPUProfiler::SScopeStats> GPUProfiler::GetScopeStats() const
+	{
+		std::lock_guard<std::mutex> lock(m_historyMutex);
+		std::vector<SScopeStats> vecStats;
+		vecStats.reserve(m_vecHistories.size());
+		for (const auto& history : m_vecHistories)
+		{
+			vecStats.push_back(history.m_stats);
+		}
+		return vecStats;
+	}
+
+	/* Private methods. */
+	unsigned int GPUProfiler::IssueTimestamp()
+	{
+		SFrameSlot& slot = m_arrSlots[m_unWriteSlot];
+		if (slot.m_unQueryCount == slot.m_vecQueries.size())
+		{
+			GLuint unQuery = 0;
+			glGenQueries(1, &unQuery);
+			slot.m_vecQueries.push_back(unQuery);
+		}
+
+		unsigned int unIndex = slot.m_unQueryCount++;
+		glQueryCounter(slot.m_vecQueries[unIndex], GL_TIMESTAMP);
+		return unIndex;
+	}
+
+	void GPUProfiler::ReadBack()
+	{
+		while (m_arrSlots[m_unReadSlot].m_bPending)
+		{
+			SFrameSlot& slot = m_arrSlots[m_unReadSlot];
+
+			/* Queries finish in order, so the last one being available means the whole frame is. */
+			GLint nAvailable = GL_FALSE;
+			glGetQueryObjectiv(slot.m_vecQueries[slot.m_unQueryCount - 1], GL_QUERY_RESULT_AVAILABLE, &nAvailable);
+			if (nAvailable == GL_FALSE)
+			{
+				return;
+			}
+
+			std::array<GLuint64, MAX_SCOPES_PER_FRAME * 2> arrTimestamps;
+			for (unsigned int unIndex = 0; unIndex < slot.m_unQueryCount; ++unIndex)
+			{
+				glGetQueryObjectui64v(slot.m_vecQueries[unIndex], GL_QUERY_RESULT, &arrTimestamps[unIndex]);
+			}
+
+			/* Scopes with the same name, e.g. sprites before and after ImGUI, count as one. */
+			for (size_t unScope = 0; unScope < slot.m_vecScopes.size(); ++unScope)
+			{
+				const SScopeRecord& record = slot.m_vecScopes[unScope];
+				auto itFirst = std::find_if(slot.m_vecScopes.begin(), slot.m_vecScopes.begin() + unScope,
+					[&record](const SScopeRecord& other) { return std::strcmp(other.m_ptrName, record.m_ptrName) == 0; });
+				if (itFirst != slot.m_vecScopes.begin() + unScope)
+				{
+					continue;
+				}
+
+				GLuint64 unTotalNS = 0;
+				for (size_t unOther = unScope; unOther < slot.m_vecScopes.size(); ++unOther)
+				{
+					const SScopeRecord& other = slot.m_vecScopes[unOther];
+					if (std::strcmp(other.m_ptrName, record.m_ptrName) == 0 &&
+						arrTimestamps[other.m_unEndQuery] > arrTimestamps[other.m_unBeginQuery])
+					{
+						unTotalNS += arrTimestamps[other.m_unEndQuery] - arrTimestamps[other.m_unBeginQuery];
+					}
+				}
+				AddSample(record, static_cast<float>(static_cast<double>(unTotalNS) / 1000000.0));
+			}
+
+			slot.m_bPending = false;
+			m_unReadSlot = (m_unReadSlot + 1) % FRAME_LATENCY;
+		}
+	}
+
+	void GPUProfiler::AddSample(const SScopeRecord& record, float fTimeMS)
+	{
+		std::lock_guard<std::mutex> lock(m_historyMutex);
+		auto it = std::find_if(m_vecHistories.begin(), m_vecHistories.end(),
+			[&record](const SScopeHistory& history) { return history.m_stats.m_strName == record.m_ptrName; });
+		if (it == m_vecHistories.end())
+		{
+			SScopeHistory history{};
+			history.m_stats.m_strName = record.m_ptrName;
+			history.m_stats.m_unDepth = record.m_unDepth;
+			it = m_vecHistories.insert(m_vecHistories.end(), history);
+		}
+
+		SScopeHistory& history = *it;
+		history.m_arrSamples[history.m_unNextSample] = fTimeMS;
+		history.m_unNextSample = (history.m_unNextSample + 1) % FRAME_HISTORY_SIZE;
+		history.m_unSampleCount = std::min(history.m_unSampleCount + 1, FRAME_HISTORY_SIZE);
+
+		float fSumMS = 0.0f;
+		float fMaxMS = 0.0f;
+		for (unsigned int unIndex = 0; unIndex < history.m_unSampleCount; ++unIndex)
+		{
+			fSumMS += history.m_arrSamples[unIndex];
+			fMaxMS = std::max(fMaxMS, history.m_arrSamples[unIndex]);
+		}
+		history.m_stats.m_fLastMS = fTimeMS;
+		history.m_stats.m_fAverageMS = fSumMS / static_cast<float>(history.m_unSampleCount);
+		history.m_stats.m_fMaxMS = fMaxMS;
+	}
+}
@@ -0,0 +1,247 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace K9
+{
+	/// <summary>
+	/// Measures the GPU time of named scopes with GL_TIMESTAMP queries.
+	/// Every frame writes its queries into one of FRAME_LATENCY slots, which are read back several frames later,
+	/// once the GPU reports them available, so the CPU never waits for a result.
+	/// If all slots are still in flight, the frame isn't measured instead of stalling.
+	/// Timestamps allow nested scopes, unlike GL_TIME_ELAPSED, of which only one may be active.
+	/// Must be used on the thread, where the context is current.
+	/// </summary>
+	class GPUProfiler
+	{
+	public:
+		/// <summary>
+		/// Number of frames, whose queries may be in flight.
+		/// </summary>
+		static constexpr unsigned int FRAME_LATENCY{ 4 };
+
+		/// <summary>
+		/// Number of measured frames, over which the statistics are computed.
+		/// </summary>
+		static constexpr unsigned int FRAME_HISTORY_SIZE{ 60 };
+
+		/// <summary>
+		/// Maximum number of scopes per frame. Further scopes are ignored.
+		/// </summary>
+		static constexpr unsigned int MAX_SCOPES_PER_FRAME{ 64 };
+
+		/// <summary>
+		/// GPU time of a scope. Scopes with the same name are summed per frame.
+		/// </summary>
+		struct SScopeStats
+		{
+			/// <summary>
+			/// Name of the scope.
+			/// </summary>
+			std::string m_strName;
+
+			/// <summary>
+			/// Number of enclosing scopes, when the scope was first measured.
+			/// </summary>
+			unsigned int m_unDepth = 0;
+
+			/// <summary>
+			/// GPU time of the last measured frame in milliseconds.
+			/// </summary>
+			float m_fLastMS = 0.0f;
+
+			/// <summary>
+			/// Average and longest GPU time over the last FRAME_HISTORY_SIZE measured frames in milliseconds.
+			/// </summary>
+			float m_fAverageMS = 0.0f;
+			float m_fMaxMS = 0.0f;
+		};
+
+		GPUProfiler();
+		~GPUProfiler();
+
+		/** Delete the copy constructor, move constructor and assignment operators. */
+		GPUProfiler(const GPUProfiler&) = delete;
+		GPUProfiler(GPUProfiler&&) = delete;
+		GPUProfiler& operator=(const GPUProfiler&) = delete;
+		GPUProfiler& operator=(GPUProfiler&) = delete;
+
+		/// <summary>
+		/// Check for timestamp support. Requires a current OpenGL context.
+		/// </summary>
+		/// <returns> True, if the timestamps have any bits. The profiler stays disabled otherwise. </returns>
+		bool Init();
+
+		/// <summary>
+		/// Delete the queries and forget the statistics. Requires the context of Init to be current.
+		/// </summary>
+		void Destroy();
+
+		/// <summary>
+		/// Enable or disable the measurement. Queries in flight are still read back. Can be called from any thread.
+		/// </summary>
+		/// <param name="bEnabled"> True, to measure the following frames. </param>
+		void SetEnabled(bool bEnabled);
+
+		/// <summary>
+		/// Retrieve, whether the frames are measured.
+		/// </summary>
+		/// <returns> m_bEnabled. </returns>
+		bool IsEnabled() const { return m_bEnabled; }
+
+		/// <summary>
+		/// Read back the finished frames and start measuring a new one, if a slot is free.
+		/// </summary>
+		void BeginFrame();
+
+		/// <summary>
+		/// Close the scopes, which are still open, and submit the frame for read back.
+		/// </summary>
+		void EndFrame();
+
+		/// <summary>
+		/// Open a scope. Ignored outside of BeginFrame and EndFrame.
+		/// </summary>
+		/// <param name="ptrName"> Name of the scope. Must stay alive until the frame is read back, e.g. a string literal. </param>
+		void BeginScope(const char* ptrName);
+
+		/// <summary>
+		/// Close the innermost open scope.
+		/// </summary>
+		void EndScope();
+
+		/// <summary>
+		/// Retrieve the statistics of all scopes, in the order they were first measured. Can be called from any thread.
+		/// </summary>
+		/// <returns> Copy of the statistics. </returns>
+		std::vector<SScopeStats> GetScopeStats() const;
+
+		/// <summary>
+		/// Retrieve the number of frames, which weren't measured, since all slots were in flight.
+		/// </summary>
+		/// <returns> m_unSkippedFrameCount. </returns>
+		unsigned int GetSkippedFrameCount() const { return m_unSkippedFrameCount; }
+
+	private:
+		/// <summary>
+		/// Entry of m_vecOpenScopes for a scope, which was ignored.
+		/// </summary>
+		static constexpr unsigned int IGNORED_SCOPE{ 0xFFFFFFFF };
+
+		/// <summary>
+		/// Scope of a frame with the indices of its queries in the slot.
+		/// </summary>
+		struct SScopeRecord
+		{
+			const char* m_ptrName;
+			unsigned int m_unDepth;
+			unsigned int m_unBeginQuery;
+			unsigned int m_unEndQuery;
+		};
+
+		/// <summary>
+		/// Queries and scopes of one frame.
+		/// </summary>
+		struct SFrameSlot
+		{
+			/// <summary>
+			/// Query objects. Grown on demand and reused by later frames.
+			/// </summary>
+			std::vector<unsigned int> m_vecQueries;
+
+			/// <summary>
+			/// Number of queries, issued by the frame.
+			/// </summary>
+			unsigned int m_unQueryCount = 0;
+
+			/// <summary>
+			/// Scopes of the frame.
+			/// </summary>
+			std::vector<SScopeRecord> m_vecScopes;
+
+			/// <summary>
+			/// True, if the frame was submitted and isn't read back yet.
+			/// </summary>
+			bool m_bPending = false;
+		};
+
+		/// <summary>
+		/// Recent GPU times of a scope.
+		/// </summary>
+		struct SScopeHistory
+		{
+			SScopeStats m_stats;
+			std::array<float, FRAME_HISTORY_SIZE> m_arrSamples;
+			unsigned int m_unSampleCount;
+			unsigned int m_unNextSample;
+		};
+
+		/// <summary>
+		/// Issue a timestamp query in the current slot.
+		/// </summary>
+		/// <returns> Index of the query in the slot. </returns>
+		unsigned int IssueTimestamp();
+
+		/// <summary>
+		/// Read back the pending slots, whose queries are available, oldest first.
+		/// </summary>
+		void ReadBack();
+
+		/// <summary>
+		/// Add the GPU time of a scope in a read back frame to its history.
+		/// </summary>
+		/// <param name="record"> Scope of the frame. </param>
+		/// <param name="fTimeMS"> Summed GPU time of all scopes with the name of record. </param>
+		void AddSample(const SScopeRecord& record, float fTimeMS);
+
+	private:
+		/// <summary>
+		/// Ring of frame slots.
+		/// </summary>
+		std::array<SFrameSlot, FRAME_LATENCY> m_arrSlots;
+
+		/// <summary>
+		/// Slot of the next measured frame and oldest pending slot.
+		/// </summary>
+		unsigned int m_unWriteSlot;
+		unsigned int m_unReadSlot;
+
+		/// <summary>
+		/// True, between BeginFrame and EndFrame of a measured frame.
+		/// </summary>
+		bool m_bRecording;
+
+		/// <summary>
+		/// Indices of the open scopes in the current slot, innermost last.
+		/// </summary>
+		std::vector<unsigned int> m_vecOpenScopes;
+
+		/// <summary>
+		/// True, if the context supports timestamps.
+		/// </summary>
+		bool m_bSupported;
+
+		/// <summary>
+		/// True, if the following frames are measured.
+		/// </summary>
+		std::atomic<bool> m_bEnabled;
+
+		/// <summary>
+		/// Number of frames, which weren't measured, since all slots were in flight.
+		/// </summary>
+		std::atomic<unsigned int> m_unSkippedFrameCount;
+
+		/// <summary>
+		/// Histories of all measured scopes, in the order they were first measured.
+		/// </summary>
+		std::vector<SScopeHistory> m_vecHistories;
+
+		/// <summary>
+		/// Guards m_vecHistories, since it is read by the UI while the render thread may update it.
+		/// </summary>
+		mutable std::mutex m_historyMutex;
+	};
+}
@@ -0,0 +1,119 @@
+#pragma once
+#include <cstddef>
+#include <SDL.h>
+#include <glm/glm.hpp>
+#include "RenderQueue.h"
+#include "StreamBuffer.h"
+
+namespace K9
+{
+	class Shader;
+	class ShaderVariants;
+	class Texture;
+	class ThreadPool;
+
+	/// <summary>
+	/// Interface of the sprite submission paths, used by Renderer2D.
+	/// Implementations gather sprites and draw them on Flush.
+	/// </summary>
+	class ISpriteBatch
+	{
+	public:
+		/// <summary>
+		/// Default number of quads, which fit in a single draw call.
+		/// </summary>
+		static constexpr unsigned int DEFAULT_MAX_QUAD_COUNT{ 10000 };
+
+		virtual ~ISpriteBatch() = default;
+
+		/// <summary>
+		/// Check, if a tint color leaves the texture unchanged, so the sprite doesn't need the TINT variant.
+		/// </summary>
+		/// <param name="color"> Tint color. </param>
+		/// <returns> True, if all channels are 255. </returns>
+		static bool IsWhite(const SDL_Color& color)
+		{
+			return (color.r & color.g & color.b & color.a) == 255;
+		}
+
+		/// <summary>
+		/// Load shaders and create the geometry.
+		/// </summary>
+		/// <param name="unMaxQuadCount"> Maximum number of quads per draw call. </param>
+		/// <param name="bAsyncShader"> True, to only submit the variants of the default shader. They must be polled until they're ready, before drawing. </param>
+		/// <returns> True, if the initialization was successful. </returns>
+		virtual bool Init(unsigned int unMaxQuadCount, bool bAsyncShader) = 0;
+
+		/// <summary>
+		/// Retrieve the variants of the shader, used for sprites without their own.
+		/// Each batch is drawn with the variant, which has only the features of its sprites.
+		/// </summary>
+		virtual ShaderVariants& GetDefaultShaders() = 0;
+
+		/// <summary>
+		/// Start gathering quads for a new frame.
+		/// The view-projection matrix comes from the FrameData uniform block.
+		/// </summary>
+		virtual void Begin() = 0;
+
+		/// <summary>
+		/// Add a textured quad to the batch.
+		/// </summary>
+		/// <param name="texture"> Texture of the quad. </param>
+		/// <param name="destRect"> Destination rect in screen space. </param>
+		/// <param name="minUV"> Normalized min UV texture coordinate. </param>
+		/// <param name="maxUV"> Normalized max UV texture coordinate. </param>
+		/// <param name="color"> Tint color. </param>
+		/// <param name="flipFormat"> Flip format. </param>
+		/// <param name="fAngle"> Rotation in degrees, clockwise on screen. </param>
+		/// <param name="origin"> Rotation origin, relative to the top-left of destRect. </param>
+		virtual void Draw(const Texture& texture, const SDL_Rect& destRect,
+			const glm::vec2& minUV, const glm::vec2& maxUV,
+			const SDL_Color& color, SDL_RendererFlip flipFormat,
+			float fAngle, const glm::vec2& origin) = 0;
+
+		/// <summary>
+		/// Set the shader, used to draw the following quads.
+		/// </summary>
+		/// <param name="ptrShader"> Shader to be set. nullptr or a shader, which isn't ready yet, selects the default shader. </param>
+		virtual void SetShader(Shader* ptrShader) = 0;
+
+		/// <summary>
+		/// Add many sprites at once, in order, each with its own shader.
+		/// Implementations may expand the sprites on the threads of the pool. By default they're added one by one.
+		/// </summary>
+		/// <param name="arrCommands"> The sprites. </param>
+		/// <param name="unCount"> Number of sprites. </param>
+		/// <param name="threadPool"> Threads, which may be used for the expansion. </param>
+		virtual void DrawCommands(const SSpriteCommand* const* arrCommands, size_t unCount, ThreadPool& /*threadPool*/)
+		{
+			for (size_t unIndex = 0; unIndex < unCount; ++unIndex)
+			{
+				const SSpriteCommand& command = *arrCommands[unIndex];
+				SetShader(command.m_ptrShader);
+				Draw(*command.m_ptrTexture, command.m_destRect, command.m_minUV, command.m_maxUV,
+					command.m_color, command.m_flipFormat, command.m_fAngle, command.m_origin);
+			}
+		}
+
+		/// <summary>
+		/// Draw all gathered quads.
+		/// </summary>
+		virtual void Flush() = 0;
+
+		/// <summary>
+		/// Retrieve the number of draw calls since Begin.
+		/// </summary>
+		virtual unsigned int GetDrawCallCount() const = 0;
+
+		/// <summary>
+		/// Retrieve the number of quads drawn since Begin.
+		/// </summary>
+		virtual unsigned int GetQuadCount() const = 0;
+
+		/// <summary>
+		/// Retrieve the synchronization statistics of the streamed geometry and reset them.
+		/// </summary>
+		virtual StreamBuffer::SStats PopStreamStats() = 0;
+	};
+}
@@ -0,0 +1,275 @@
+#include "ProgramBinaryCache.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <SDL.h>
+#include <glad/glad.h>
+
+namespace K9
+{
+	/* Header of an entry file, followed by the binary. */
+	struct SEntryHeader
+	{
+		char m_arrMagic[4];
+		uint32_t m_unFormatVersion;
+		uint64_t m_unDriverHash;
+		uint64_t m_unSourceHash;
+		uint64_t m_unChecksum;
+		uint32_t m_unBinaryFormat;
+		uint32_t m_unBinaryLength;
+	};
+
+	static constexpr char ENTRY_MAGIC[4] = { 'K', '9', 'P', 'B' };
+
+	/* Increase, whenever SEntryHeader changes. */
+	static constexpr uint32_t ENTRY_FORMAT_VERSION = 1;
+
+	static constexpr uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+	static constexpr uint64_t FNV_PRIME = 1099511628211ull;
+
+	static uint64_t HashBytes(const void* ptrData, size_t unSize, uint64_t unHash = FNV_OFFSET_BASIS)
+	{
+		const unsigned char* ptrBytes = static_cast<const unsigned char*>(ptrData);
+		for (size_t unIndex = 0; unIndex < unSize; ++unIndex)
+		{
+			unHash ^= ptrBytes[unIndex];
+			unHash *= FNV_PRIME;
+		}
+		return unHash;
+	}
+
+	static uint64_t HashGLString(GLenum eName, uint64_t unHash)
+	{
+		const char* cstrValue = reinterpret_cast<const char*>(glGetString(eName));
+		if (cstrValue == nullptr)
+		{
+			return unHash;
+		}
+
+		/* The terminator separates the strings, so "ab" + "c" differs from "a" + "bc". */
+		return HashBytes(cstrValue, std::strlen(cstrValue) + 1, unHash);
+	}
+
+	ProgramBinaryCache& ProgramBinaryCache::Ref()
+	{
+		static ProgramBinaryCache ref;
+		return ref;
+	}
+
+	ProgramBinaryCache::ProgramBinaryCache()
+		: m_strDirectory{}, m_bEnabled{ true }, m_bDriverQueried{ false }, m_bSupported{ false }, m_unDriverHash{ 0 }, m_stats{}
+	{
+	}
+
+	void ProgramBinaryCache::SetDirectory(const std::string& strDirectory)
+	{
+		m_strDirectory = strDirectory;
+	}
+
+	void ProgramBinaryCache::SetEnabled(bool bEnabled)
+	{
+		m_bEnabled = bEnabled;
+	}
+
+	bool ProgramBinaryCache::IsActive()
+	{
+		if (!m_bEnabled || m_strDirectory.empty())
+		{
+			return false;
+		}
+
+		if (!m_bDriverQueried)
+		{
+			QueryDriver();
+		}
+		return m_bSupported;
+	}
+
+	uint64_t ProgramBinaryCache::HashSources(const std::string& strVertexSource, const std::string& strFragmentSource)
+	{
+		uint64_t unHash = HashBytes(strVertexSource.c_str(), strVertexSource.size() + 1);
+		return HashBytes(strFragmentSource.c_str(), strFragmentSource.size() + 1, unHash);
+	}
+
+	void ProgramBinaryCache::PrepareForStore(GLuint unProgramID)
+	{
+		if (IsActive())
+		{
+			glProgramParameteri(unProgramID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+		}
+	}
+
+	bool ProgramBinaryCache::Load(uint64_t unSourceHash, GLuint unProgramID)
+	{
+		if (!IsActive())
+		{
+			m_stats.m_unMissCount++;
+			return false;
+		}
+
+		std::string strPath = GetEntryPath(unSourceHash);
+		std::ifstream entryFile(strPath, std::ios::binary);
+		if (!entryFile.is_open())
+		{
+			m_stats.m_unMissCount++;
+			return false;
+		}
+
+		/* Read and validate the entry. Anything unexpected is treated as stale and compiled again. */
+		SEntryHeader header{};
+		std::vector<char> vecBinary;
+		bool bValid = static_cast<bool>(entryFile.read(reinterpret_cast<char*>(&header), sizeof(header))) &&
+			std::memcmp(header.m_arrMagic, ENTRY_MAGIC, sizeof(ENTRY_MAGIC)) == 0 &&
+			header.m_unFormatVersion == ENTRY_FORMAT_VERSION &&
+			header.m_unDriverHash == m_unDriverHash &&
+			header.m_unSourceHash == unSourceHash &&
+			header.m_unBinaryLength > 0;
+		if (bValid)
+		{
+			vecBinary.resize(header.m_unBinaryLength);
+			bValid = static_cast<bool>(entryFile.read(vecBinary.data(), static_cast<std::streamsize>(vecBinary.size()))) &&
+				entryFile.peek() == std::ifstream::traits_type::eof() &&
+				HashBytes(vecBinary.data(), vecBinary.size()) == header.m_unChecksum;
+		}
+		entryFile.close();
+
+		/* The driver may still reject a binary, e.g. after an update, which didn't change its strings. */
+		if (bValid)
+		{
+			glProgramBinary(unProgramID, header.m_unBinaryFormat, vecBinary.data(), static_cast<GLsizei>(vecBinary.size()));
+			GLint nStatus = GL_FALSE;
+			glGetProgramiv(unProgramID, GL_LINK_STATUS, &nStatus);
+			bValid = nStatus == GL_TRUE;
+		}
+
+		if (!bValid)
+		{
+			std::cerr << "ProgramBinaryCache::Load Discarding the stale entry " << strPath << "\n";
+			std::remove(strPath.c_str());
+			m_stats.m_unRejectedCount++;
+			return false;
+		}
+
+		m_stats.m_unHitCount++;
+		return true;
+	}
+
+	void ProgramBinaryCache::Store(uint64_t unSourceHash, GLuint unProgramID)
+	{
+		if (!IsActive())
+		{
+			return;
+		}
+
+		GLint nLength = 0;
+		glGetProgramiv(unProgramID, GL_PROGRAM_BINARY_LENGTH, &nLength);
+		if (nLength <= 0)
+		{
+			return;
+		}
+
+		std::vector<char> vecBinary(static_cast<size_t>(nLength));
+		GLsizei nWritten = 0;
+		GLenum eFormat = 0;
+		glGetProgramBinary(unProgramID, nLength, &nWritten, &eFormat, vecBinary.data());
+		if (nWritten <= 0)
+		{
+			return;
+		}
+		vecBinary.resize(static_cast<size_t>(nWritten));
+
+		SEntryHeader header{};
+		std::memcpy(header.m_arrMagic, ENTRY_MAGIC, sizeof(ENTRY_MAGIC));
+		header.m_unFormatVersion = ENTRY_FORMAT_VERSION;
+		header.m_unDriverHash = m_unDriverHash;
+		header.m_unSourceHash = unSourceHash;
+		header.m_unChecksum = HashBytes(vecBinary.data(), vecBinary.size());
+		header.m_unBinaryFormat = eFormat;
+		header.m_unBinaryLength = static_cast<uint32_t>(vecBinary.size());
+
+		/* Write a temporary file first, so a crash never leaves a truncated entry behind. */
+		std::string strPath = GetEntryPath(unSourceHash);
+		std::string strTempPath = strPath + ".tmp";
+		{
+			std::ofstream entryFile(strTempPath, std::ios::binary | std::ios::trunc);
+			if (!entryFile.is_open() ||
+				!entryFile.write(reinterpret_cast<const char*>(&header), sizeof(header)) ||
+				!entryFile.write(vecBinary.data(), static_cast<std::streamsize>(vecBinary.size())))
+			{
+				std::cerr << "ProgramBinaryCache::Store Failed to write " << strTempPath << "\n";
+				return;
+			}
+		}
+
+		/* rename doesn't replace an existing file on every platform. */
+		std::remove(strPath.c_str());
+		if (std::rename(strTempPath.c_str(), strPath.c_str()) != 0)
+		{
+			std::cerr << "ProgramBinaryCache::Store Failed to rename " << strTempPath << "\n";
+			std::remove(strTempPath.c_str());
+			return;
+		}
+		m_stats.m_unStoreCount++;
+	}
+
+	void ProgramBinaryCache::ResetStats()
+	{
+		m_stats = SStats{};
+	}
+
+	/* Private methods. */
+	void ProgramBinaryCache::QueryDriver()
+	{
+		m_bDriverQueried = true;
+		m_bSupported = false;
+
+		/* glad only loads the functions of the context version, so load the extension entry points. */
+		if (!GLAD_GL_VERSION_4_1)
+		{
+			if (SDL_GL_ExtensionSupported("GL_ARB_get_program_binary") == SDL_FALSE)
+			{
+				return;
+			}
+
+			if (glad_glGetProgramBinary == nullptr)
+			{
+				glad_glGetProgramBinary = reinterpret_cast<PFNGLGETPROGRAMBINARYPROC>(SDL_GL_GetProcAddress("glGetProgramBinary"));
+			}
+			if (glad_glProgramBinary == nullptr)
+			{
+				glad_glProgramBinary = reinterpret_cast<PFNGLPROGRAMBINARYPROC>(SDL_GL_GetProcAddress("glProgramBinary"));
+			}
+			if (glad_glProgramParameteri == nullptr)
+			{
+				glad_glProgramParameteri = reinterpret_cast<PFNGLPROGRAMPARAMETERIPROC>(SDL_GL_GetProcAddress("glProgramParameteri"));
+			}
+		}
+
+		if (glad_glGetProgramBinary == nullptr || glad_glProgramBinary == nullptr || glad_glProgramParameteri == nullptr)
+		{
+			return;
+		}
+
+		/* Drivers may support the functions without offering a single format. */
+		GLint nFormatCount = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &nFormatCount);
+		if (nFormatCount <= 0)
+		{
+			return;
+		}
+
+		m_unDriverHash = HashGLString(GL_VENDOR, FNV_OFFSET_BASIS);
+		m_unDriverHash = HashGLString(GL_RENDERER, m_unDriverHash);
+		m_unDriverHash = HashGLString(GL_VERSION, m_unDriverHash);
+		m_bSupported = true;
+	}
+
+	std::string ProgramBinaryCache::GetEntryPath(uint64_t unSourceHash) const
+	{
+		char arrName[32];
+		std::snprintf(arrName, sizeof(arrName), "%016llx.bin", static_cast<unsigned long long>(unSourceHash));
+		return m_strDirectory + arrName;
+	}
+}
@@ -0,0 +1,163 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+using GLuint = unsigned int;
+
+namespace K9
+{
+	/// <summary>
+	/// Singleton on-disk cache of linked shader programs, so later launches skip compiling and linking.
+	/// Programs are stored with glGetProgramBinary and restored with glProgramBinary.
+	/// An entry is keyed on a hash of the shader sources and validated against the GL vendor, renderer and version,
+	/// so a driver update or changed source misses the cache. Corrupt entries and binaries, which the driver rejects,
+	/// fall back to compiling, after which the entry is written again.
+	/// Requires OpenGL 4.1 or GL_ARB_get_program_binary and at least one binary format. The cache is inactive otherwise.
+	/// </summary>
+	class ProgramBinaryCache
+	{
+	public:
+		/// <summary>
+		/// Counts since the last ResetStats.
+		/// </summary>
+		struct SStats
+		{
+			/// <summary>
+			/// Number of programs, restored from the cache.
+			/// </summary>
+			unsigned int m_unHitCount = 0;
+
+			/// <summary>
+			/// Number of programs without an entry or loaded, while the cache was inactive.
+			/// </summary>
+			unsigned int m_unMissCount = 0;
+
+			/// <summary>
+			/// Number of entries, which were stale, corrupt or rejected by the driver.
+			/// </summary>
+			unsigned int m_unRejectedCount = 0;
+
+			/// <summary>
+			/// Number of entries, written after compiling.
+			/// </summary>
+			unsigned int m_unStoreCount = 0;
+		};
+
+		/** Delete the copy constructor, move constructor and assignment operators. */
+		ProgramBinaryCache(const ProgramBinaryCache&) = delete;
+		ProgramBinaryCache(ProgramBinaryCache&&) = delete;
+		ProgramBinaryCache& operator=(const ProgramBinaryCache&) = delete;
+		ProgramBinaryCache& operator=(ProgramBinaryCache&) = delete;
+
+		/// <summary>
+		/// Return a static reference to this class.
+		/// </summary>
+		/// <returns> A singleton instance. </returns>
+		static ProgramBinaryCache& Ref();
+
+		/// <summary>
+		/// Set the directory of the entries. The cache is inactive without one.
+		/// </summary>
+		/// <param name="strDirectory"> Existing directory, ending with a path separator, e.g. from SDL_GetPrefPath. </param>
+		void SetDirectory(const std::string& strDirectory);
+
+		/// <summary>
+		/// Enable or disable the cache, e.g. to measure cold loads.
+		/// </summary>
+		/// <param name="bEnabled"> True, to read and write entries. </param>
+		void SetEnabled(bool bEnabled);
+
+		/// <summary>
+		/// Check, if programs are cached. Requires a current OpenGL context on the first call.
+		/// </summary>
+		/// <returns> True, if the cache is enabled, has a directory and the driver supports program binaries. </returns>
+		bool IsActive();
+
+		/// <summary>
+		/// Hash shader sources into a cache key.
+		/// </summary>
+		/// <param name="strVertexSource"> Source of the vertex shader. </param>
+		/// <param name="strFragmentSource"> Source of the fragment shader. </param>
+		/// <returns> 64 bit FNV-1a hash of both sources. </returns>
+		static uint64_t HashSources(const std::string& strVertexSource, const std::string& strFragmentSource);
+
+		/// <summary>
+		/// Mark a program as retrievable. Must be called before it is linked.
+		/// </summary>
+		/// <param name="unProgramID"> OpenGL ID of the program. </param>
+		void PrepareForStore(GLuint unProgramID);
+
+		/// <summary>
+		/// Restore a program from its entry.
+		/// </summary>
+		/// <param name="unSourceHash"> Key from HashSources. </param>
+		/// <param name="unProgramID"> OpenGL ID of a program without shaders. </param>
+		/// <returns> True, if the program was restored and linked successfully. </returns>
+		bool Load(uint64_t unSourceHash, GLuint unProgramID);
+
+		/// <summary>
+		/// Write the entry of a linked program, which was prepared with PrepareForStore.
+		/// </summary>
+		/// <param name="unSourceHash"> Key from HashSources. </param>
+		/// <param name="unProgramID"> OpenGL ID of the linked program. </param>
+		void Store(uint64_t unSourceHash, GLuint unProgramID);
+
+		/// <summary>
+		/// Retrieve the counts since the last ResetStats.
+		/// </summary>
+		/// <returns> m_stats. </returns>
+		const SStats& GetStats() const { return m_stats; }
+
+		/// <summary>
+		/// Reset the counts.
+		/// </summary>
+		void ResetStats();
+
+	private:
+		ProgramBinaryCache();
+		~ProgramBinaryCache() = default;
+
+		/// <summary>
+		/// Check the driver for program binaries and hash its strings. Done once, on the first call of IsActive.
+		/// </summary>
+		void QueryDriver();
+
+		/// <summary>
+		/// Build the path of an entry.
+		/// </summary>
+		/// <param name="unSourceHash"> Key from HashSources. </param>
+		/// <returns> Path of the entry file. </returns>
+		std::string GetEntryPath(uint64_t unSourceHash) const;
+
+	private:
+		/// <summary>
+		/// Directory of the entries, ending with a path separator.
+		/// </summary>
+		std::string m_strDirectory;
+
+		/// <summary>
+		/// True, if entries are read and written.
+		/// </summary>
+		bool m_bEnabled;
+
+		/// <summary>
+		/// True, after QueryDriver was called.
+		/// </summary>
+		bool m_bDriverQueried;
+
+		/// <summary>
+		/// True, if the driver supports program binaries.
+		/// </summary>
+		bool m_bSupported;
+
+		/// <summary>
+		/// Hash of the GL vendor, renderer and version strings.
+		/// </summary>
+		uint64_t m_unDriverHash;
+
+		/// <summary>
+		/// Counts since the last ResetStats.
+		/// </summary>
+		SStats m_stats;
+	};
+}
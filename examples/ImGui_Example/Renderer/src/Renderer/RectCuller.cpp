@@ -0,0 +1,102 @@
+#include "RectCuller.h"
+#include <algorithm>
+#include <cmath>
+#include "Affine2D.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define K9_RECT_CULLER_SSE
+#include <emmintrin.h>
+#endif
+
+namespace K9
+{
+	unsigned int RectCuller::CullRects(const SDL_Rect* arrRects, unsigned int unCount,
+		const SDL_Rect& viewport, uint32_t* arrOutIndices)
+	{
+		unsigned int unVisibleCount = 0;
+		unsigned int unIndex = 0;
+		if (viewport.w <= 0 || viewport.h <= 0)
+		{
+			return 0;
+		}
+
+#ifdef K9_RECT_CULLER_SSE
+		static_assert(sizeof(SDL_Rect) == 4 * sizeof(int), "SDL_Rect must be 4 packed ints");
+		const __m128i left = _mm_set1_epi32(viewport.x);
+		const __m128i top = _mm_set1_epi32(viewport.y);
+		const __m128i right = _mm_set1_epi32(viewport.x + viewport.w);
+		const __m128i bottom = _mm_set1_epi32(viewport.y + viewport.h);
+		const __m128i zero = _mm_setzero_si128();
+
+		for (; unIndex + 4 <= unCount; unIndex += 4)
+		{
+			/* Transpose 4 rects of x, y, w, h into x, y, w, h of 4 rects. */
+			__m128i rect0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&arrRects[unIndex]));
+			__m128i rect1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&arrRects[unIndex + 1]));
+			__m128i rect2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&arrRects[unIndex + 2]));
+			__m128i rect3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&arrRects[unIndex + 3]));
+			__m128i xy01 = _mm_unpacklo_epi32(rect0, rect1);
+			__m128i xy23 = _mm_unpacklo_epi32(rect2, rect3);
+			__m128i wh01 = _mm_unpackhi_epi32(rect0, rect1);
+			__m128i wh23 = _mm_unpackhi_epi32(rect2, rect3);
+			__m128i x = _mm_unpacklo_epi64(xy01, xy23);
+			__m128i y = _mm_unpackhi_epi64(xy01, xy23);
+			__m128i w = _mm_unpacklo_epi64(wh01, wh23);
+			__m128i h = _mm_unpackhi_epi64(wh01, wh23);
+
+			__m128i visible = _mm_and_si128(_mm_cmpgt_epi32(w, zero), _mm_cmpgt_epi32(h, zero));
+			visible = _mm_and_si128(visible, _mm_cmplt_epi32(x, right));
+			visible = _mm_and_si128(visible, _mm_cmpgt_epi32(_mm_add_epi32(x, w), left));
+			visible = _mm_and_si128(visible, _mm_cmplt_epi32(y, bottom));
+			visible = _mm_and_si128(visible, _mm_cmpgt_epi32(_mm_add_epi32(y, h), top));
+
+			int nMask = _mm_movemask_ps(_mm_castsi128_ps(visible));
+			while (nMask != 0)
+			{
+				/* Lowest set bit first, so the indices stay in ascending order. */
+				unsigned int unLane = 0;
+				while ((nMask & (1 << unLane)) == 0)
+				{
+					++unLane;
+				}
+				arrOutIndices[unVisibleCount++] = unIndex + unLane;
+				nMask &= nMask - 1;
+			}
+		}
+#endif
+
+		for (; unIndex < unCount; ++unIndex)
+		{
+			if (IsVisible(arrRects[unIndex], viewport))
+			{
+				arrOutIndices[unVisibleCount++] = unIndex;
+			}
+		}
+		return unVisibleCount;
+	}
+
+	SDL_Rect RectCuller::GetBounds(const SAffine2D& affine)
+	{
+		glm::vec2 arrCorners[4] =
+		{
+			affine.Apply({ 0.0f, 0.0f }),
+			affine.Apply({ 1.0f, 0.0f }),
+			affine.Apply({ 1.0f, 1.0f }),
+			affine.Apply({ 0.0f, 1.0f })
+		};
+
+		glm::vec2 minPos = arrCorners[0];
+		glm::vec2 maxPos = arrCorners[0];
+		for (const auto& corner : arrCorners)
+		{
+			minPos = glm::min(minPos, corner);
+			maxPos = glm::max(maxPos, corner);
+		}
+
+		int nMinX = static_cast<int>(std::floor(minPos.x));
+		int nMinY = static_cast<int>(std::floor(minPos.y));
+		int nMaxX = static_cast<int>(std::ceil(maxPos.x));
+		int nMaxY = static_cast<int>(std::ceil(maxPos.y));
+		return SDL_Rect{ nMinX, nMinY, nMaxX - nMinX, nMaxY - nMinY };
+	}
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include <SDL.h>
+
+namespace K9
+{
+	struct SAffine2D;
+
+	/// <summary>
+	/// Tests screen space rects against a viewport, so sprites outside of it aren't submitted.
+	/// A rect is visible if it overlaps the viewport with a non-zero area. Nothing is visible in an empty viewport.
+	/// </summary>
+	class RectCuller
+	{
+	public:
+		/// <summary>
+		/// Test a single rect.
+		/// </summary>
+		/// <param name="rect"> Rect to be tested. </param>
+		/// <param name="viewport"> Visible area. </param>
+		/// <returns> True, if the rect overlaps the viewport. </returns>
+		static bool IsVisible(const SDL_Rect& rect, const SDL_Rect& viewport)
+		{
+			return rect.w > 0 && rect.h > 0 && viewport.w > 0 && viewport.h > 0 &&
+				rect.x < viewport.x + viewport.w && rect.x + rect.w > viewport.x &&
+				rect.y < viewport.y + viewport.h && rect.y + rect.h > viewport.y;
+		}
+
+		/// <summary>
+		/// Test an array of rects, 4 at a time with SSE, if the target supports it.
+		/// </summary>
+		/// <param name="arrRects"> Rects to be tested. </param>
+		/// <param name="unCount"> Number of rects. </param>
+		/// <param name="viewport"> Visible area. </param>
+		/// <param name="arrOutIndices"> Receives the indices of the visible rects in ascending order. Holds unCount indices. </param>
+		/// <returns> Number of visible rects. </returns>
+		static unsigned int CullRects(const SDL_Rect* arrRects, unsigned int unCount,
+			const SDL_Rect& viewport, uint32_t* arrOutIndices);
+
+		/// <summary>
+		/// Compute the bounding rect of the unit quad, transformed by an affine transform.
+		/// Used to cull rotated sprites.
+		/// </summary>
+		/// <param name="affine"> Transform of the sprite. </param>
+		/// <returns> The smallest rect, which contains the transformed quad. </returns>
+		static SDL_Rect GetBounds(const SAffine2D& affine);
+	};
+}
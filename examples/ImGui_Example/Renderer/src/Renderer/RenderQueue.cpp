@@ -0,0 +1,125 @@
+#include "RenderQueue.h"
+#include <array>
+#include <utility>
+
+namespace K9
+{
+	/* Keep only the lowest unBits bits of unValue. */
+	static uint64_t MaskBits(uint32_t unValue, unsigned int unBits)
+	{
+		return static_cast<uint64_t>(unValue) & ((uint64_t{ 1 } << unBits) - 1);
+	}
+
+	RenderQueue::RenderQueue()
+		: m_vecCommands{}, m_vecEntries{}, m_vecScratch{}
+	{
+	}
+
+	uint64_t RenderQueue::MakeSortKey(uint32_t unLayer, uint32_t unBlendMode, uint32_t unShaderID,
+		uint32_t unTextureID, uint32_t unDepth)
+	{
+		static_assert(LAYER_BITS + BLEND_MODE_BITS + SHADER_BITS + TEXTURE_BITS + DEPTH_BITS == 64,
+			"The sort key fields must fill 64 bits!");
+
+		uint64_t unKey = MaskBits(unLayer, LAYER_BITS);
+		unKey = (unKey << BLEND_MODE_BITS) | MaskBits(unBlendMode, BLEND_MODE_BITS);
+		unKey = (unKey << SHADER_BITS) | MaskBits(unShaderID, SHADER_BITS);
+		unKey = (unKey << TEXTURE_BITS) | MaskBits(unTextureID, TEXTURE_BITS);
+		unKey = (unKey << DEPTH_BITS) | MaskBits(unDepth, DEPTH_BITS);
+		return unKey;
+	}
+
+	void RenderQueue::Reserve(size_t unCount)
+	{
+		m_vecCommands.reserve(unCount);
+		m_vecEntries.reserve(unCount);
+		m_vecScratch.reserve(unCount);
+	}
+
+	void RenderQueue::Push(uint64_t unSortKey, const SSpriteCommand& command)
+	{
+		m_vecEntries.push_back({ unSortKey, static_cast<uint32_t>(m_vecCommands.size()) });
+		m_vecCommands.push_back(command);
+	}
+
+	void RenderQueue::Append(const RenderQueue& other)
+	{
+		/* The entries of the other queue index its own commands, which now start after ours. */
+		uint32_t unOffset = static_cast<uint32_t>(m_vecCommands.size());
+		m_vecCommands.insert(m_vecCommands.end(), other.m_vecCommands.begin(), other.m_vecCommands.end());
+		for (const auto& entry : other.m_vecEntries)
+		{
+			m_vecEntries.push_back({ entry.m_unKey, entry.m_unIndex + unOffset });
+		}
+	}
+
+	void RenderQueue::Sort()
+	{
+		const size_t unCount = m_vecEntries.size();
+		if (unCount < 2)
+		{
+			return;
+		}
+
+		/* resize only allocates when the queue outgrows all previous frames. */
+		m_vecScratch.resize(unCount);
+
+		/* Build the histograms of all 8 bytes in a single pass. */
+		constexpr unsigned int unPassCount = 8;
+		std::array<std::array<uint32_t, 256>, unPassCount> arrHistograms{};
+		for (const auto& entry : m_vecEntries)
+		{
+			for (unsigned int unPass = 0; unPass < unPassCount; ++unPass)
+			{
+				arrHistograms[unPass][(entry.m_unKey >> (unPass * 8)) & 0xFF]++;
+			}
+		}
+
+		SSortEntry* ptrSrc = m_vecEntries.data();
+		SSortEntry* ptrDst = m_vecScratch.data();
+		for (unsigned int unPass = 0; unPass < unPassCount; ++unPass)
+		{
+			auto& arrHistogram = arrHistograms[unPass];
+			unsigned int unShift = unPass * 8;
+
+			/* Every key has the same byte, so this pass wouldn't move anything. */
+			if (arrHistogram[(ptrSrc[0].m_unKey >> unShift) & 0xFF] == unCount)
+			{
+				continue;
+			}
+
+			/* Turn the counts into starting offsets. */
+			uint32_t unOffset = 0;
+			for (auto& unBucket : arrHistogram)
+			{
+				uint32_t unBucketCount = unBucket;
+				unBucket = unOffset;
+				unOffset += unBucketCount;
+			}
+
+			for (size_t unIndex = 0; unIndex < unCount; ++unIndex)
+			{
+				const SSortEntry& entry = ptrSrc[unIndex];
+				ptrDst[arrHistogram[(entry.m_unKey >> unShift) & 0xFF]++] = entry;
+			}
+			std::swap(ptrSrc, ptrDst);
+		}
+
+		/* An odd number of passes leaves the result in the scratch buffer. */
+		if (ptrSrc != m_vecEntries.data())
+		{
+			m_vecEntries.swap(m_vecScratch);
+		}
+	}
+
+	void RenderQueue::Clear()
+	{
+		m_vecCommands.clear();
+		m_vecEntries.clear();
+	}
+
+	const SSpriteCommand& RenderQueue::GetSorted(size_t unIndex) const
+	{
+		return m_vecCommands[m_vecEntries[unIndex].m_unIndex];
+	}
+}
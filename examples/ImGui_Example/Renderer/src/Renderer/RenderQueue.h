@@ -0,0 +1,168 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <SDL.h>
+#include <glm/glm.hpp>
+
+namespace K9
+{
+	class Shader;
+	class Texture;
+
+	/// <summary>
+	/// A deferred sprite draw, submitted to a sprite batch after sorting.
+	/// </summary>
+	struct SSpriteCommand
+	{
+		/// <summary>
+		/// Texture of the sprite. Must stay alive until the queue is submitted.
+		/// </summary>
+		const Texture* m_ptrTexture;
+
+		/// <summary>
+		/// Shader of the sprite. nullptr for the default shader of the batch.
+		/// </summary>
+		Shader* m_ptrShader;
+
+		/// <summary>
+		/// Destination rect in screen space.
+		/// </summary>
+		SDL_Rect m_destRect;
+
+		/// <summary>
+		/// Normalized min UV texture coordinate.
+		/// </summary>
+		glm::vec2 m_minUV;
+
+		/// <summary>
+		/// Normalized max UV texture coordinate.
+		/// </summary>
+		glm::vec2 m_maxUV;
+
+		/// <summary>
+		/// Tint color.
+		/// </summary>
+		SDL_Color m_color;
+
+		/// <summary>
+		/// Flip format.
+		/// </summary>
+		SDL_RendererFlip m_flipFormat;
+
+		/// <summary>
+		/// Rotation in degrees, clockwise on screen.
+		/// </summary>
+		float m_fAngle;
+
+		/// <summary>
+		/// Rotation origin, relative to the top-left of m_destRect.
+		/// </summary>
+		glm::vec2 m_origin;
+	};
+
+	/// <summary>
+	/// Gathers sprite commands with a 64-bit sort key and radix sorts them before submission.
+	/// The sort is stable, so commands with equal keys keep their submission order.
+	/// All buffers are reused between frames, so no allocations happen in steady state.
+	/// </summary>
+	class RenderQueue
+	{
+	public:
+		/* Bit widths of the sort key fields, from the most to the least significant. */
+		static constexpr unsigned int LAYER_BITS{ 8 };
+		static constexpr unsigned int BLEND_MODE_BITS{ 4 };
+		static constexpr unsigned int SHADER_BITS{ 12 };
+		static constexpr unsigned int TEXTURE_BITS{ 16 };
+		static constexpr unsigned int DEPTH_BITS{ 24 };
+
+		RenderQueue();
+
+		/// <summary>
+		/// Build a sort key. Values wider than their field are truncated.
+		/// Layout: layer(8) | blend mode(4) | shader(12) | texture(16) | depth(24).
+		/// </summary>
+		/// <param name="unLayer"> Layer, drawn in ascending order. </param>
+		/// <param name="unBlendMode"> Blend mode. </param>
+		/// <param name="unShaderID"> OpenGL ID of the shader program. </param>
+		/// <param name="unTextureID"> OpenGL ID of the texture. </param>
+		/// <param name="unDepth"> Depth inside the layer, drawn in ascending order. </param>
+		/// <returns> The sort key. </returns>
+		static uint64_t MakeSortKey(uint32_t unLayer, uint32_t unBlendMode, uint32_t unShaderID,
+			uint32_t unTextureID, uint32_t unDepth);
+
+		/// <summary>
+		/// Reserve space for commands, so the first frames don't allocate while pushing.
+		/// </summary>
+		/// <param name="unCount"> Number of commands. </param>
+		void Reserve(size_t unCount);
+
+		/// <summary>
+		/// Add a command to the queue.
+		/// </summary>
+		/// <param name="unSortKey"> Sort key, created with MakeSortKey. </param>
+		/// <param name="command"> Command to be added. </param>
+		void Push(uint64_t unSortKey, const SSpriteCommand& command);
+
+		/// <summary>
+		/// Add all commands of another queue with their sort keys, after the commands of this one.
+		/// </summary>
+		/// <param name="other"> Queue to be appended. Its sort order is ignored. </param>
+		void Append(const RenderQueue& other);
+
+		/// <summary>
+		/// Sort the commands by their keys with an LSD radix sort.
+		/// Passes where every key has the same byte are skipped.
+		/// </summary>
+		void Sort();
+
+		/// <summary>
+		/// Remove all commands. The capacity of the buffers is kept.
+		/// </summary>
+		void Clear();
+
+		/// <summary>
+		/// Retrieve the number of commands.
+		/// </summary>
+		/// <returns> Number of commands. </returns>
+		size_t GetCount() const { return m_vecCommands.size(); }
+
+		/// <summary>
+		/// Retrieve a command in sorted order. Only valid after Sort.
+		/// </summary>
+		/// <param name="unIndex"> Index in sorted order. </param>
+		/// <returns> The command. </returns>
+		const SSpriteCommand& GetSorted(size_t unIndex) const;
+
+		/// <summary>
+		/// Retrieve a command in submission order.
+		/// </summary>
+		/// <param name="unIndex"> Index in submission order. </param>
+		/// <returns> The command. </returns>
+		const SSpriteCommand& GetCommand(size_t unIndex) const { return m_vecCommands[unIndex]; }
+
+	private:
+		/// <summary>
+		/// Sort key with the index of its command.
+		/// </summary>
+		struct SSortEntry
+		{
+			uint64_t m_unKey;
+			uint32_t m_unIndex;
+		};
+
+		/// <summary>
+		/// Commands in submission order.
+		/// </summary>
+		std::vector<SSpriteCommand> m_vecCommands;
+
+		/// <summary>
+		/// Sort entries. Sorted after Sort.
+		/// </summary>
+		std::vector<SSortEntry> m_vecEntries;
+
+		/// <summary>
+		/// Scratch buffer for the radix sort passes.
+		/// </summary>
+		std::vector<SSortEntry> m_vecScratch;
+	};
+}
@@ -0,0 +1,77 @@
+#include "RenderTarget.h"
+#include <iostream>
+#include <glad/glad.h>
+#include "GLStateCache.h"
+
+namespace K9
+{
+	RenderTarget::RenderTarget()
+		: m_unFramebufferID{ 0 }, m_texture{}
+	{
+	}
+
+	RenderTarget::~RenderTarget()
+	{
+		Destroy();
+	}
+
+	bool RenderTarget::Create(int nWidth, int nHeight)
+	{
+		Destroy();
+		if (nWidth <= 0 || nHeight <= 0)
+		{
+			std::cerr << "RenderTarget::Create Invalid size " << nWidth << "x" << nHeight << "!\n";
+			return false;
+		}
+
+		m_texture.CreateForRendering(nWidth, nHeight, GL_RGBA8);
+
+		GLStateCache& stateCache = GLStateCache::Ref();
+		glGenFramebuffers(1, &m_unFramebufferID);
+		stateCache.BindFramebuffer(m_unFramebufferID);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_texture.GetTextureID(), 0);
+
+		GLenum eStatus = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+		stateCache.BindFramebuffer(0);
+		if (eStatus != GL_FRAMEBUFFER_COMPLETE)
+		{
+			std::cerr << "RenderTarget::Create Framebuffer is incomplete. Status: 0x" << std::hex << eStatus << std::dec << "\n";
+			Destroy();
+			return false;
+		}
+		return true;
+	}
+
+	void RenderTarget::Destroy()
+	{
+		if (m_unFramebufferID != 0)
+		{
+			glDeleteFramebuffers(1, &m_unFramebufferID);
+			GLStateCache::Ref().OnFramebufferDeleted(m_unFramebufferID);
+			m_unFramebufferID = 0;
+		}
+		m_texture.Unload();
+	}
+
+	bool RenderTarget::Resize(int nWidth, int nHeight)
+	{
+		if (m_unFramebufferID != 0 && nWidth == GetWidth() && nHeight == GetHeight())
+		{
+			return true;
+		}
+		return Create(nWidth, nHeight);
+	}
+
+	void RenderTarget::Bind() const
+	{
+		GLStateCache::Ref().BindFramebuffer(m_unFramebufferID);
+		glViewport(0, 0, GetWidth(), GetHeight());
+	}
+
+	void RenderTarget::Clear() const
+	{
+		/* Clear the attachment directly, so the clear color of the screen stays untouched. */
+		const GLfloat arrTransparent[4]{ 0.0f, 0.0f, 0.0f, 0.0f };
+		glClearBufferfv(GL_COLOR, 0, arrTransparent);
+	}
+}
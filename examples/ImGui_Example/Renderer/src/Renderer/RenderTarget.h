@@ -0,0 +1,77 @@
+#pragma once
+#include "Texture.h"
+
+using GLuint = unsigned int;
+
+namespace K9
+{
+	/// <summary>
+	/// An offscreen color target: a framebuffer object with an RGBA texture attachment.
+	/// Its texture can be drawn like any other texture. Row 0 of the texture is the bottom of the target,
+	/// so a target, rendered with the screen projection, is drawn with flipped V coordinates.
+	/// </summary>
+	class RenderTarget
+	{
+	public:
+		RenderTarget();
+		~RenderTarget();
+
+		/** Delete the copy constructor, move constructor and assignment operators. */
+		RenderTarget(const RenderTarget&) = delete;
+		RenderTarget(RenderTarget&&) = delete;
+		RenderTarget& operator=(const RenderTarget&) = delete;
+		RenderTarget& operator=(RenderTarget&) = delete;
+
+		/// <summary>
+		/// Create the framebuffer and its texture. Recreates them, if the target already exists.
+		/// </summary>
+		/// <param name="nWidth"> Width in pixels. </param>
+		/// <param name="nHeight"> Height in pixels. </param>
+		/// <returns> True, if the framebuffer is complete. </returns>
+		bool Create(int nWidth, int nHeight);
+
+		/// <summary>
+		/// Delete the framebuffer and its texture.
+		/// </summary>
+		void Destroy();
+
+		/// <summary>
+		/// Recreate the target, if its size differs. The contents are lost.
+		/// </summary>
+		/// <param name="nWidth"> Width in pixels. </param>
+		/// <param name="nHeight"> Height in pixels. </param>
+		/// <returns> True, if the target has the requested size. </returns>
+		bool Resize(int nWidth, int nHeight);
+
+		/// <summary>
+		/// Bind the framebuffer and set the viewport to cover it.
+		/// </summary>
+		void Bind() const;
+
+		/// <summary>
+		/// Clear the target to transparent black. The target must be bound.
+		/// </summary>
+		void Clear() const;
+
+		/// <summary>
+		/// Retrieve the color texture.
+		/// </summary>
+		/// <returns> m_texture. </returns>
+		const Texture& GetTexture() const { return m_texture; }
+
+		int GetWidth() const { return m_texture.GetWidth(); }
+		int GetHeight() const { return m_texture.GetHeight(); }
+		GLuint GetFramebufferID() const { return m_unFramebufferID; }
+
+	private:
+		/// <summary>
+		/// OpenGL ID of the framebuffer.
+		/// </summary>
+		GLuint m_unFramebufferID;
+
+		/// <summary>
+		/// Color attachment.
+		/// </summary>
+		Texture m_texture;
+	};
+}
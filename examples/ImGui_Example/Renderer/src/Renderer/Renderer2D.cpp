@@ -2,15 +2,23 @@
 #include "Renderer2D.h"
 #include "Renderer2D.h"
 #include <array>
+#include <cstring>
 #include <iostream>
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
 #include <glad/glad.h>
 #include <SDL_ttf.h>
 
+#include "Affine2D.h"
+#include "GLStateCache.h"
+#include "ProgramBinaryCache.h"
+#include "RectCuller.h"
 #include "Texture.h"
+#include <Timing/IdleLoop.h>
 
 #define IMGUI_IMPL_OPENGL_LOADER_GLAD
 #include <imgui.h>
+#include <imgui_internal.h>
 #include <examples/imgui_impl_sdl.h>
 #include <examples/imgui_impl_opengl3.h>
 
@@ -19,14 +27,35 @@
 
 namespace K9
 {
+	/* Uniforms of the immediate sprite shader. */
+	static constexpr UniformID WORLD_TRANSFORM_UNIFORM{ "u_WorldTransform" };
+	static constexpr UniformID COLOR_UNIFORM{ "u_Color" };
+	static constexpr UniformID UV_RECT_UNIFORM{ "u_UVRect" };
+
+	/* FNV-1a hash of a value, chained onto unHash. */
+	template<typename T>
+	static uint64_t HashValue(uint64_t unHash, const T& value)
+	{
+		const auto* ptrBytes = reinterpret_cast<const uint8_t*>(&value);
+		for (size_t unIndex = 0; unIndex < sizeof(T); ++unIndex)
+		{
+			unHash ^= ptrBytes[unIndex];
+			unHash *= 0x100000001B3ull;
+		}
+		return unHash;
+	}
+
 	Renderer2D& Renderer2D::Ref()
 	{
 		static Renderer2D ref;
 		return ref;
 	}
 
-	bool Renderer2D::Init(const std::string& strTitle, int nWidth, int nHeight)
+	bool Renderer2D::Init(const std::string& strTitle, int nWidth, int nHeight, ERenderMode eRenderMode, bool bHeadless)
 	{
+		m_eRenderMode = eRenderMode;
+		m_bHeadless = bHeadless;
+
 		if (!InitSDL())
 		{
 			std::cerr << "Renderer2D::Init Failed to init SDL!\n";
@@ -44,261 +73,1497 @@ namespace K9
 			return false;
 		}
 
-		if (!InitWindow(strTitle, nWidth, nHeight))
+		if (!InitWindow(strTitle, nWidth, nHeight))
+		{
+			std::cerr << "Renderer2D::Init Failed to create Window!\n";
+			return false;
+		}
+
+		/* Create OPENGL Context.*/
+		if (!CreateOpenGLContext())
+		{
+			std::cerr << "Renderer2D::Init Failed to create OpenGLContext!\n";
+			return false;
+		}
+
+		/* The passes are only measured, if the driver has timestamps. */
+		m_gpuProfiler.Init();
+
+		/* Without the extension, the shaders are still submitted, but finishing one waits for the driver. */
+		if (m_bAsyncShaderLoading && !Shader::EnableParallelCompile())
+		{
+			std::cout << "Renderer2D::Init GL_KHR_parallel_shader_compile isn't supported. Shaders are finished on the first frame.\n";
+		}
+
+		if (!CreateImGUI())
+		{
+			std::cerr << "Renderer2D::Init Failed to create ImGUI!\n";
+			return false;
+		}
+
+		/* Linked programs are cached per user, so later launches skip compiling them. */
+		if (char* cstrCachePath = SDL_GetPrefPath("K9", "ShaderCache"))
+		{
+			ProgramBinaryCache::Ref().SetDirectory(cstrCachePath);
+			SDL_free(cstrCachePath);
+		}
+
+		/* Compare the time of a cold launch with a warm one, which loads the programs from the cache. */
+		ProgramBinaryCache::Ref().ResetStats();
+		Uint64 unLoadStart = SDL_GetPerformanceCounter();
+		if (!LoadResources())
+		{
+			std::cerr << "Renderer2D::Init Failed to load resources!\n";
+		}
+		const ProgramBinaryCache::SStats& cacheStats = ProgramBinaryCache::Ref().GetStats();
+		std::cout << "Renderer2D::LoadResources took "
+			<< static_cast<double>(SDL_GetPerformanceCounter() - unLoadStart) * 1000.0 / SDL_GetPerformanceFrequency()
+			<< " ms (" << cacheStats.m_unHitCount << " programs from the binary cache, "
+			<< cacheStats.m_unMissCount + cacheStats.m_unRejectedCount << " compiled)\n";
+
+		SetScreenSize({ 0, 0, nWidth, nHeight });
+
+		return true;
+	}
+
+	void Renderer2D::Shutdown()
+	{
+		/* Draw the remaining frame packets and take the context back. */
+		StopRenderThread();
+		m_threadPool.Shutdown();
+		m_vecPendingShaders.clear();
+
+		/* Release the frame data, cached layers, queries and upload buffers while the context is still alive. */
+		m_ptrFrameDataBuffer.reset();
+		m_gpuProfiler.Destroy();
+		m_textureStreamer.Shutdown();
+		DestroyCachedLayers();
+		m_ptrSceneTarget.reset();
+
+		/* Destroy the window. */
+		DestroyWindow();
+
+		/* Destroy the context. */
+		DestroyOpenGLContext();
+
+		/* Destroy ImGUI. */
+		DestroyImGUI();
+
+		/* Destroy SDL. */
+		DestroySDL();
+
+		/* Destroy SDL image. */
+		DestroySDLImage();
+
+		/* Destroy SDL ttf. */
+		DestroySDLttf();
+	}
+
+	SDL_GLContext Renderer2D::GetContext()
+	{
+		return m_ptrContext;
+	}
+
+	SDL_Window* Renderer2D::GetWindow()
+	{
+		return m_ptrWindow;
+	}
+
+	bool Renderer2D::IsHeadless() const
+	{
+		return m_bHeadless;
+	}
+
+	void Renderer2D::CaptureNextFrame(const std::string& strPath)
+	{
+		if (m_ptrPacketQueue)
+		{
+			std::cerr << "Renderer2D::CaptureNextFrame Not available with the render thread!\n";
+			return;
+		}
+		m_strCapturePath = strPath;
+	}
+
+	void Renderer2D::SetAsyncShaderLoading(bool bAsync)
+	{
+		if (m_ptrShader)
+		{
+			std::cerr << "Renderer2D::SetAsyncShaderLoading Must be called before Init!\n";
+			return;
+		}
+		m_bAsyncShaderLoading = bAsync;
+	}
+
+	bool Renderer2D::IsLoadingShaders() const
+	{
+		return !m_vecPendingShaders.empty();
+	}
+
+	void Renderer2D::BeginFrame()
+	{
+		/* The main thread uploads, so the fence of the frame packet covers the streamed rows too. */
+		m_textureStreamer.Update();
+
+		/* Placeholders are replaced over several frames, which an idle loop must draw without input. */
+		if (m_textureStreamer.HasPendingWork())
+		{
+			IdleLoop::RequestRedraw();
+		}
+
+		if (m_ptrPacketQueue)
+		{
+			BeginFramePacket();
+			return;
+		}
+
+		/* The render thread is only started, once the shaders are ready. */
+		UpdatePendingShaders(false);
+
+		/* Sprites are dropped, until the shaders are ready, so an idle loop must not wait for input to show them. */
+		if (IsLoadingShaders())
+		{
+			IdleLoop::RequestRedraw();
+		}
+
+		if (m_bDamageTrackingEnabled)
+		{
+			/* The scene target covers the screen on ResolveDamage, so there is nothing to clear. */
+			m_damageTracker.BeginFrame();
+			m_vecFrameCommands.clear();
+			m_bFrameResolved = false;
+		}
+		else
+		{
+			/* Clear the screen with the background color. */
+			glClear(GL_COLOR_BUFFER_BIT);
+		}
+		BeginSubmission();
+	}
+
+	void Renderer2D::EndFrame()
+	{
+		if (m_ptrPacketQueue)
+		{
+			EndFramePacket();
+			return;
+		}
+
+		/* Draw any remaining sprites. */
+		ResolveDamage();
+		EndSubmission();
+	}
+
+	void Renderer2D::Flush()
+	{
+		/* The recorded sprites are replayed and flushed by the render thread. */
+		if (m_ptrPacketQueue)
+		{
+			return;
+		}
+		FlushSprites();
+	}
+
+	Renderer2D::ERenderMode Renderer2D::GetRenderMode() const
+	{
+		return m_eRenderMode;
+	}
+
+	Renderer2D::SStats Renderer2D::GetStats() const
+	{
+		std::lock_guard<std::mutex> lock(m_statsMutex);
+		return m_stats;
+	}
+
+	bool Renderer2D::StartRenderThread(unsigned int unPacketCount)
+	{
+		if (m_ptrPacketQueue)
+		{
+			return true;
+		}
+		if (m_bDamageTrackingEnabled || m_unRecordingCachedLayerID != INVALID_CACHED_LAYER)
+		{
+			std::cerr << "Renderer2D::StartRenderThread Damage tracking and cached layers aren't available with the render thread!\n";
+			return false;
+		}
+
+		/* The shaders are finished on this thread, before it gives the context away. */
+		UpdatePendingShaders(true);
+
+		/* ImGUI creates its shaders and font texture on its first frame. Do it while the context is still current here. */
+		ImGui_ImplOpenGL3_NewFrame();
+
+		/* Platform windows are drawn with their own contexts on the main thread, so they're merged into the main window. */
+		ImGuiIO& io = ImGui::GetIO();
+		m_bRestoreImGUIViewports = (io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable) != 0;
+		if (m_bRestoreImGUIViewports)
+		{
+			ImGuiPlatformIO& platformIO = ImGui::GetPlatformIO();
+			for (int nIndex = 1; nIndex < platformIO.Viewports.Size; ++nIndex)
+			{
+				ImGui::DestroyPlatformWindow(static_cast<ImGuiViewportP*>(platformIO.Viewports[nIndex]));
+			}
+			io.ConfigFlags &= ~ImGuiConfigFlags_ViewportsEnable;
+		}
+
+		/* SDL makes the new context current, which releases m_ptrContext for the render thread. */
+		SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT, 1);
+		m_ptrResourceContext = SDL_GL_CreateContext(m_ptrWindow);
+		SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT, 0);
+		if (!m_ptrResourceContext)
+		{
+			std::cerr << "Renderer2D::StartRenderThread Failed to create the resource context! SDL error: " << SDL_GetError() << "\n";
+			if (m_bRestoreImGUIViewports)
+			{
+				io.ConfigFlags |= ImGuiConfigFlags_ViewportsEnable;
+			}
+			return false;
+		}
+		GLStateCache::Ref().Invalidate();
+
+		m_ptrPacketQueue.reset(new FramePacketQueue(unPacketCount));
+		m_fRenderFrameTimeMS = 0.0f;
+		m_renderThread = std::thread(&Renderer2D::RenderThreadMain, this);
+		return true;
+	}
+
+	void Renderer2D::StopRenderThread()
+	{
+		if (!m_ptrPacketQueue)
+		{
+			return;
+		}
+		if (m_ptrRecordingPacket)
+		{
+			std::cerr << "Renderer2D::StopRenderThread Must be called between frames!\n";
+			return;
+		}
+
+		m_ptrPacketQueue->Stop();
+		m_renderThread.join();
+
+		int nStatus = SDL_GL_MakeCurrent(m_ptrWindow, m_ptrContext);
+		if (nStatus != 0)
+		{
+			std::cerr << "Renderer2D::StopRenderThread Failed to make this context current. SDL error: "
+				<< SDL_GetError() << "\n";
+		}
+		GLStateCache::Ref().Invalidate();
+		glClearColor(m_bgrColor.r, m_bgrColor.g, m_bgrColor.b, m_bgrColor.a);
+
+		/* The packets release their textures, while a context is current. Shared objects outlive the resource context. */
+		m_ptrPacketQueue.reset();
+		SDL_GL_DeleteContext(m_ptrResourceContext);
+		m_ptrResourceContext = nullptr;
+
+		if (m_bRestoreImGUIViewports)
+		{
+			ImGui::GetIO().ConfigFlags |= ImGuiConfigFlags_ViewportsEnable;
+		}
+	}
+
+	bool Renderer2D::IsRenderThreadRunning() const
+	{
+		return m_ptrPacketQueue != nullptr;
+	}
+
+	void Renderer2D::SetPacketHandoffCheckEnabled(bool bEnabled)
+	{
+		m_bPacketHandoffCheckEnabled = bEnabled;
+		m_unPacketHandoffViolationCount = 0;
+	}
+
+	unsigned int Renderer2D::GetPacketHandoffViolationCount() const
+	{
+		return m_unPacketHandoffViolationCount;
+	}
+
+	void Renderer2D::BeginImGUIFrame()
+	{
+		/* Feeds input to dear imgui, starts new frame */
+		ImGui_ImplOpenGL3_NewFrame();
+		ImGui_ImplSDL2_NewFrame(m_ptrWindow);
+		ImGui::NewFrame();
+	}
+
+	void Renderer2D::EndImGUIFrame()
+	{
+		if (m_ptrPacketQueue)
+		{
+			/* The render thread draws a copy, between the sprites recorded before and after this call. */
+			ImGui::Render();
+			if (m_ptrRecordingPacket)
+			{
+				m_ptrRecordingPacket->m_unImGUICommandIndex = m_ptrRecordingPacket->m_vecCommands.size();
+				m_ptrRecordingPacket->CopyImGUIDrawData(*ImGui::GetDrawData());
+			}
+			ImGui::GetIO().DisplaySize = ImVec2(m_screenSize.w, m_screenSize.h);
+			return;
+		}
+
+		/* Sprites, gathered so far, must be drawn below the ImGUI windows. */
+		ResolveDamage();
+		Flush();
+		m_gpuProfiler.EndScope();
+
+		/* Render dear imgui into screen */
+		ImGui::Render();
+		m_gpuProfiler.BeginScope("ImGUI");
+		ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+		m_gpuProfiler.EndScope();
+
+		ImGuiIO& io = ImGui::GetIO();
+		const auto& screenSize = Renderer2D::Ref().GetScreenSize();
+		io.DisplaySize = ImVec2(screenSize.w, screenSize.h);
+
+		if (io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable)
+		{
+			/* The platform windows draw with their own contexts. The timestamps of this context only enclose them,
+			 * as long as the driver runs the contexts in submission order, so this scope is approximate. */
+			auto* currContext = m_ptrContext;
+			m_gpuProfiler.BeginScope("Platform Windows");
+			ImGui::UpdatePlatformWindows();
+			ImGui::RenderPlatformWindowsDefault();
+
+			/* Make this context the current one*/
+			int nStatus = SDL_GL_MakeCurrent(m_ptrWindow, currContext);
+			if (nStatus != 0)
+			{
+				std::cerr << "Renderer2D::EndImGUIFrame Failed to make this context curret. SDL error: "
+					<< SDL_GetError() << "\n";
+			}
+			m_gpuProfiler.EndScope();
+		}
+
+		/* ImGUI binds its own program, buffers and font texture. */
+		GLStateCache::Ref().SyncAfterImGUI();
+
+		/* Sprites, drawn after ImGUI, are added to the same scope. */
+		m_gpuProfiler.BeginScope("Sprites");
+	}
+
+	void Renderer2D::HandleEvent(const SDL_Event& event)
+	{
+		ImGui_ImplSDL2_ProcessEvent(&event);
+	}
+
+	void Renderer2D::SetScreenSize(const SDL_Rect& screenSize)
+	{
+		if (m_ptrPacketQueue)
+		{
+			std::cerr << "Renderer2D::SetScreenSize Not available with the render thread!\n";
+			return;
+		}
+
+		m_screenSize = screenSize;
+		glViewport(m_screenSize.x, m_screenSize.y, m_screenSize.w, m_screenSize.h);
+		m_projectionMatrix = glm::ortho(static_cast<float>(m_screenSize.x),
+			static_cast<float>(m_screenSize.w),
+			static_cast<float>(m_screenSize.h),
+			static_cast<float>(m_screenSize.y),
+			-1.0f,
+			1.0f);
+
+		/* The projection spans [x, w] and [y, h]. */
+		m_viewportRect = { m_screenSize.x, m_screenSize.y, m_screenSize.w - m_screenSize.x, m_screenSize.h - m_screenSize.y };
+		for (auto& ptrRecorder : m_vecCommandRecorders)
+		{
+			ptrRecorder->SetViewport(m_viewportRect, m_bCullingEnabled);
+		}
+
+		m_frameData.m_viewProj = m_projectionMatrix;
+		m_frameData.m_screenSize = glm::vec2{ static_cast<float>(m_screenSize.w), static_cast<float>(m_screenSize.h) };
+		UploadFrameData();
+
+		/* Cached layers cover the viewport, so their contents must be redrawn at the new size. */
+		auto resizeTarget = [this](RenderTarget& target)
+		{
+			if (!target.Resize(m_viewportRect.w, m_viewportRect.h))
+			{
+				std::cerr << "Renderer2D::SetScreenSize Failed to resize a cached layer target!\n";
+			}
+		};
+		for (auto& cachedLayer : m_vecCachedLayers)
+		{
+			if (cachedLayer.m_ptrTarget)
+			{
+				resizeTarget(*cachedLayer.m_ptrTarget);
+				cachedLayer.m_bDirty = true;
+			}
+		}
+		for (auto& ptrTarget : m_vecCachedLayerTargetPool)
+		{
+			resizeTarget(*ptrTarget);
+		}
+		if (m_ptrSceneTarget)
+		{
+			resizeTarget(*m_ptrSceneTarget);
+		}
+		m_damageTracker.InvalidateAll();
+	}
+
+	const SDL_Rect& Renderer2D::GetScreenSize() const
+	{
+		return m_screenSize;
+	}
+
+	const SDL_Rect& Renderer2D::GetViewportRect() const
+	{
+		return m_viewportRect;
+	}
+
+	void Renderer2D::SetBackgroundColor(const glm::vec4& bgrColor)
+	{
+		m_bgrColor = bgrColor;
+		if (!m_ptrPacketQueue)
+		{
+			/* Otherwise the color is sent with the next frame packet. */
+			glClearColor(m_bgrColor.r, m_bgrColor.g, m_bgrColor.b, m_bgrColor.a);
+		}
+		m_damageTracker.InvalidateAll();
+	}
+
+	void Renderer2D::SetSortingEnabled(bool bEnabled)
+	{
+		/* Draw anything queued so far, before the mode changes. */
+		Flush();
+		m_bSortingEnabled = bEnabled;
+	}
+
+	void Renderer2D::SetLayer(unsigned int unLayer, unsigned int unDepth)
+	{
+		m_unLayer = unLayer;
+		m_unDepth = unDepth;
+	}
+
+	void Renderer2D::SetCullingEnabled(bool bEnabled)
+	{
+		m_bCullingEnabled = bEnabled;
+		for (auto& ptrRecorder : m_vecCommandRecorders)
+		{
+			ptrRecorder->SetViewport(m_viewportRect, m_bCullingEnabled);
+		}
+	}
+
+	void Renderer2D::SetDamageTrackingEnabled(bool bEnabled)
+	{
+		if (bEnabled == m_bDamageTrackingEnabled)
+		{
+			return;
+		}
+
+		if (bEnabled && m_ptrPacketQueue)
+		{
+			std::cerr << "Renderer2D::SetDamageTrackingEnabled Not available with the render thread!\n";
+			return;
+		}
+
+		Flush();
+		if (bEnabled)
+		{
+			m_ptrSceneTarget.reset(new RenderTarget());
+			if (!m_ptrSceneTarget->Create(m_viewportRect.w, m_viewportRect.h))
+			{
+				std::cerr << "Renderer2D::SetDamageTrackingEnabled Failed to create the scene target!\n";
+				m_ptrSceneTarget.reset();
+				return;
+			}
+			m_damageTracker.InvalidateAll();
+		}
+		else
+		{
+			m_ptrSceneTarget.reset();
+			m_vecFrameCommands.clear();
+		}
+		m_bDamageTrackingEnabled = bEnabled;
+	}
+
+	void Renderer2D::SetShader(Shader* ptrShader)
+	{
+		/* Every sprite carries its shader, so the batch switches on submission. */
+		m_ptrSpriteShader = ptrShader;
+	}
+
+	void Renderer2D::DrawTexture(const Texture& texture,
+								const SDL_Rect& destRect,
+								const SDL_Color& color,
+								const SDL_RendererFlip& flipFormat)
+	{
+		DrawSprite(texture, destRect, glm::vec2{ 0.0f, 0.0f }, glm::vec2{ 1.0f, 1.0f }, color, flipFormat);
+	}
+
+	void Renderer2D::DrawTexture(const std::shared_ptr<Texture>& texture,
+		const SDL_Rect& destRect,
+		const SDL_Color& color,
+		const SDL_RendererFlip& flipFormat)
+	{
+		if (texture)
+		{
+			RetainTexture(texture);
+			DrawTexture(*texture, destRect, color, flipFormat);
+		}
+		else
+		{
+			std::cerr << "Renderer2D::DrawTexture error! texture is nullptr!\n";
+		}
+	}
+
+	void Renderer2D::DrawTexture(const Texture& texture,
+								const SDL_Rect& srcRect,
+								const SDL_Rect& destRect,
+								const SDL_Color& color,
+								const SDL_RendererFlip& flipFormat)
+	{
+		DrawTexture(texture, srcRect, destRect, 0.0f, SDL_Point{ 0, 0 }, color, flipFormat);
+	}
+
+	CommandRecorder& Renderer2D::CreateCommandRecorder()
+	{
+		m_vecCommandRecorders.emplace_back(new CommandRecorder());
+		CommandRecorder& recorder = *m_vecCommandRecorders.back();
+		recorder.SetViewport(m_viewportRect, m_bCullingEnabled);
+		return recorder;
+	}
+
+	void Renderer2D::SubmitCommandRecorders(bool bSort)
+	{
+		/* Nothing can be drawn, until the shaders are ready. */
+		if (IsLoadingShaders())
+		{
+			for (auto& ptrRecorder : m_vecCommandRecorders)
+			{
+				ptrRecorder->Clear();
+			}
+			return;
+		}
+
+		/* Gather the sprites in drawing order. The recorders keep them alive until they're cleared. */
+		unsigned int unCulledCount = 0;
+		if (bSort)
+		{
+			m_mergedQueue.Clear();
+			for (const auto& ptrRecorder : m_vecCommandRecorders)
+			{
+				m_mergedQueue.Append(ptrRecorder->GetQueue());
+			}
+			m_mergedQueue.Sort();
+			for (size_t unIndex = 0; unIndex < m_mergedQueue.GetCount(); ++unIndex)
+			{
+				m_vecBulkCommands.push_back(&m_mergedQueue.GetSorted(unIndex));
+			}
+		}
+		else
+		{
+			for (const auto& ptrRecorder : m_vecCommandRecorders)
+			{
+				const RenderQueue& queue = ptrRecorder->GetQueue();
+				for (size_t unIndex = 0; unIndex < queue.GetCount(); ++unIndex)
+				{
+					m_vecBulkCommands.push_back(&queue.GetCommand(unIndex));
+				}
+			}
+		}
+		for (const auto& ptrRecorder : m_vecCommandRecorders)
+		{
+			unCulledCount += ptrRecorder->GetCulledCount();
+		}
+		unsigned int unSubmittedCount = static_cast<unsigned int>(m_vecBulkCommands.size());
+
+		if (m_ptrPacketQueue)
+		{
+			if (m_ptrRecordingPacket)
+			{
+				/* Already in order, so the render thread replays them as unsorted. */
+				m_ptrRecordingPacket->m_unSubmittedSpriteCount += unSubmittedCount;
+				m_ptrRecordingPacket->m_unCulledSpriteCount += unCulledCount;
+				for (const SSpriteCommand* ptrCommand : m_vecBulkCommands)
+				{
+					m_ptrRecordingPacket->m_vecCommands.push_back({ *ptrCommand, ptrCommand->m_destRect, 0, 0,
+						EBlendMode::eAlpha, false });
+				}
+			}
+			else
+			{
+				std::cerr << "Renderer2D::SubmitCommandRecorders Sprites must be submitted between BeginFrame and EndFrame!\n";
+			}
+			m_vecBulkCommands.clear();
+		}
+		else
+		{
+			m_currStats.m_unSubmittedSpriteCount += unSubmittedCount;
+			m_currStats.m_unCulledSpriteCount += unCulledCount;
+			if (IsRecordingFrame())
+			{
+				for (const SSpriteCommand* ptrCommand : m_vecBulkCommands)
+				{
+					RecordFrameCommand(*ptrCommand, EBlendMode::eAlpha, 0, false);
+				}
+				m_vecBulkCommands.clear();
+			}
+			else
+			{
+				/* Sprites, drawn before, come first. */
+				FlushSprites();
+				SubmitBulkCommands();
+			}
+		}
+
+		for (auto& ptrRecorder : m_vecCommandRecorders)
+		{
+			ptrRecorder->Clear();
+		}
+		m_mergedQueue.Clear();
+	}
+
+	void Renderer2D::SetWorkerThreadCount(unsigned int unWorkerCount)
+	{
+		if (m_ptrPacketQueue)
+		{
+			std::cerr << "Renderer2D::SetWorkerThreadCount Not available with the render thread!\n";
+			return;
+		}
+		m_threadPool.Init(unWorkerCount);
+	}
+
+	unsigned int Renderer2D::GetWorkerThreadCount() const
+	{
+		return m_threadPool.GetWorkerCount();
+	}
+
+	ThreadPool& Renderer2D::GetThreadPool()
+	{
+		return m_threadPool;
+	}
+
+	GPUProfiler& Renderer2D::GetGPUProfiler()
+	{
+		return m_gpuProfiler;
+	}
+
+	TextureStreamer& Renderer2D::GetTextureStreamer()
+	{
+		return m_textureStreamer;
+	}
+
+	unsigned int Renderer2D::CreateCachedLayer()
+	{
+		/* Framebuffers aren't shared between contexts. */
+		if (m_ptrPacketQueue)
+		{
+			std::cerr << "Renderer2D::CreateCachedLayer Not available with the render thread!\n";
+			return INVALID_CACHED_LAYER;
+		}
+
+		std::unique_ptr<RenderTarget> ptrTarget;
+		if (!m_vecCachedLayerTargetPool.empty())
+		{
+			ptrTarget = std::move(m_vecCachedLayerTargetPool.back());
+			m_vecCachedLayerTargetPool.pop_back();
+		}
+		else
+		{
+			ptrTarget.reset(new RenderTarget());
+		}
+
+		if (!ptrTarget->Resize(m_viewportRect.w, m_viewportRect.h))
+		{
+			std::cerr << "Renderer2D::CreateCachedLayer Failed to create the layer target!\n";
+			return INVALID_CACHED_LAYER;
+		}
+
+		/* Reuse the ID of a destroyed layer. */
+		unsigned int unLayerID = 0;
+		while (unLayerID < m_vecCachedLayers.size() && m_vecCachedLayers[unLayerID].m_ptrTarget)
+		{
+			++unLayerID;
+		}
+		if (unLayerID == m_vecCachedLayers.size())
+		{
+			m_vecCachedLayers.emplace_back();
+		}
+
+		SCachedLayer& cachedLayer = m_vecCachedLayers[unLayerID];
+		cachedLayer.m_ptrTarget = std::move(ptrTarget);
+		cachedLayer.m_bDirty = true;
+		return unLayerID;
+	}
+
+	void Renderer2D::DestroyCachedLayer(unsigned int unLayerID)
+	{
+		SCachedLayer* ptrCachedLayer = GetCachedLayer(unLayerID);
+		if (!ptrCachedLayer)
+		{
+			return;
+		}
+		if (m_ptrPacketQueue)
+		{
+			std::cerr << "Renderer2D::DestroyCachedLayer Not available with the render thread!\n";
+			return;
+		}
+
+		if (m_unRecordingCachedLayerID == unLayerID)
+		{
+			EndCachedLayer();
+		}
+		m_vecCachedLayerTargetPool.push_back(std::move(ptrCachedLayer->m_ptrTarget));
+	}
+
+	void Renderer2D::MarkCachedLayerDirty(unsigned int unLayerID)
+	{
+		SCachedLayer* ptrCachedLayer = GetCachedLayer(unLayerID);
+		if (ptrCachedLayer)
+		{
+			ptrCachedLayer->m_bDirty = true;
+		}
+	}
+
+	bool Renderer2D::IsCachedLayerDirty(unsigned int unLayerID) const
+	{
+		const SCachedLayer* ptrCachedLayer = GetCachedLayer(unLayerID);
+		return ptrCachedLayer && ptrCachedLayer->m_bDirty;
+	}
+
+	bool Renderer2D::BeginCachedLayer(unsigned int unLayerID)
+	{
+		SCachedLayer* ptrCachedLayer = GetCachedLayer(unLayerID);
+		if (!ptrCachedLayer || !ptrCachedLayer->m_bDirty)
+		{
+			return false;
+		}
+		if (m_ptrPacketQueue)
+		{
+			std::cerr << "Renderer2D::BeginCachedLayer Not available with the render thread!\n";
+			return false;
+		}
+		if (m_unRecordingCachedLayerID != INVALID_CACHED_LAYER)
+		{
+			std::cerr << "Renderer2D::BeginCachedLayer Layer " << m_unRecordingCachedLayerID << " is still recording!\n";
+			return false;
+		}
+
+		/* The layer stays dirty, so it is recorded, once the shaders are ready. */
+		if (IsLoadingShaders())
+		{
+			return false;
+		}
+
+		/* Sprites, gathered so far, belong to the screen. */
+		Flush();
+
+		ptrCachedLayer->m_ptrTarget->Bind();
+		ptrCachedLayer->m_ptrTarget->Clear();
+		SetBlendMode(EBlendMode::eAlphaToPremultiplied);
+		m_unRecordingCachedLayerID = unLayerID;
+		return true;
+	}
+
+	void Renderer2D::EndCachedLayer()
+	{
+		SCachedLayer* ptrCachedLayer = GetCachedLayer(m_unRecordingCachedLayerID);
+		if (!ptrCachedLayer)
+		{
+			return;
+		}
+
+		Flush();
+
+		GLStateCache::Ref().BindFramebuffer(0);
+		glViewport(m_screenSize.x, m_screenSize.y, m_screenSize.w, m_screenSize.h);
+		SetBlendMode(EBlendMode::eAlpha);
+
+		ptrCachedLayer->m_bDirty = false;
+		ptrCachedLayer->m_unVersion++;
+		m_unRecordingCachedLayerID = INVALID_CACHED_LAYER;
+		m_currStats.m_unCachedLayerRedrawCount++;
+	}
+
+	void Renderer2D::DrawCachedLayer(unsigned int unLayerID, const SDL_Color& color)
+	{
+		const SCachedLayer* ptrCachedLayer = GetCachedLayer(unLayerID);
+		if (!ptrCachedLayer || unLayerID == m_unRecordingCachedLayerID || IsLoadingShaders())
+		{
+			return;
+		}
+		if (m_ptrPacketQueue)
+		{
+			std::cerr << "Renderer2D::DrawCachedLayer Not available with the render thread!\n";
+			return;
+		}
+
+		/* The layer holds premultiplied alpha, so the tint must be premultiplied as well. */
+		float fAlpha = color.a / 255.0f;
+		SDL_Color premultipliedColor{ static_cast<Uint8>(color.r * fAlpha + 0.5f), static_cast<Uint8>(color.g * fAlpha + 0.5f),
+			static_cast<Uint8>(color.b * fAlpha + 0.5f), color.a };
+
+		/* Row 0 of the target is the bottom of the screen. */
+		SSpriteCommand command{ &ptrCachedLayer->m_ptrTarget->GetTexture(), m_ptrSpriteShader, m_viewportRect,
+			glm::vec2{ 0.0f, 1.0f }, glm::vec2{ 1.0f, 0.0f }, premultipliedColor,
+			SDL_RendererFlip::SDL_FLIP_NONE, 0.0f, glm::vec2{ 0.0f, 0.0f } };
+		if (IsRecordingFrame())
+		{
+			RecordFrameCommand(command, EBlendMode::ePremultipliedAlpha, ptrCachedLayer->m_unVersion, m_bSortingEnabled);
+			return;
+		}
+
+		/* The blend mode applies to the whole batch, so the layer is drawn on its own. */
+		Flush();
+		SetBlendMode(EBlendMode::ePremultipliedAlpha);
+
+		SubmitSprite(command, m_unLayer, m_unDepth, m_bSortingEnabled);
+
+		Flush();
+		SetBlendMode(m_unRecordingCachedLayerID != INVALID_CACHED_LAYER ? EBlendMode::eAlphaToPremultiplied : EBlendMode::eAlpha);
+	}
+
+	void Renderer2D::DrawTexture(const std::shared_ptr<Texture>& texture,
+								const SDL_Rect& srcRect,
+								const SDL_Rect& destRect,
+								const SDL_Color& color,
+								const SDL_RendererFlip& flipFormat)
+	{
+		if (texture)
+		{
+			RetainTexture(texture);
+			DrawTexture(*texture, srcRect, destRect, color, flipFormat);
+		}
+		else
+		{
+			std::cerr << "Renderer2D::DrawTexture error! texture is nullptr!\n";
+		}
+	}
+
+	void Renderer2D::DrawTexture(const Texture& texture,
+								const SDL_Rect& srcRect,
+								const SDL_Rect& destRect,
+								float fAngle,
+								const SDL_Point& center,
+								const SDL_Color& color,
+								const SDL_RendererFlip& flipFormat)
+	{
+		float fDestW = static_cast<float>(texture.GetWidth());
+		float fDestH = static_cast<float>(texture.GetHeight());
+		float fSrcMinX = static_cast<float>(srcRect.x);
+		float fSrcMinY = static_cast<float>(srcRect.y);
+		float fSrcMaxX = static_cast<float>(srcRect.x + srcRect.w);
+		float fSrcMaxY = static_cast<float>(srcRect.y + srcRect.h);
+
+		VertexArray::SRectParam rectParam;
+		rectParam.m_minUV.x = fSrcMinX / fDestW;
+		rectParam.m_minUV.y = fSrcMinY / fDestH;
+		rectParam.m_maxUV.x = fSrcMaxX / fDestW;
+		rectParam.m_maxUV.y = fSrcMaxY / fDestH;
+
+		if (rectParam.CheckUV())
+		{
+			DrawSprite(texture, destRect, rectParam.m_minUV, rectParam.m_maxUV, color, flipFormat,
+				fAngle, glm::vec2{ static_cast<float>(center.x), static_cast<float>(center.y) });
+		}
+	}
+
+	/* Private methods. */
+	void Renderer2D::UploadFrameData()
+	{
+		if (m_ptrFrameDataBuffer)
+		{
+			m_ptrFrameDataBuffer->SetData(&m_frameData, sizeof(SFrameData));
+		}
+	}
+
+	void Renderer2D::BeginSubmission()
+	{
+		/* Closed by EndImGUIFrame and EndSubmission. */
+		m_gpuProfiler.BeginFrame();
+		m_gpuProfiler.BeginScope("Frame");
+		m_gpuProfiler.BeginScope("Sprites");
+
+		/* Enable Blending. */
+		GLStateCache::Ref().SetBlendEnabled(true);
+		SetBlendMode(EBlendMode::eAlpha);
+
+		m_currStats = SStats{};
+
+		/* Upload the view-projection, time and frame index once for all draws of this frame. */
+		m_frameData.m_fTime = static_cast<float>(SDL_GetTicks()) / 1000.0f;
+		UploadFrameData();
+
+		if (m_eRenderMode != ERenderMode::eImmediate)
+		{
+			/* Sprites are gathered and the shader and geometry are bound on flush. */
+			m_ptrSpriteBatch->Begin();
+		}
+		else
+		{
+			/* Bind the geometry for drawing sprites. The shader variant is bound per sprite. */
+			m_ptrVertexArray->SetActive();
+		}
+	}
+
+	void Renderer2D::EndSubmission()
+	{
+		/* Draw any remaining sprites. */
+		FlushSprites();
+		m_gpuProfiler.EndScope();
+		m_gpuProfiler.EndScope();
+		m_gpuProfiler.EndFrame();
+
+		if (m_eRenderMode != ERenderMode::eImmediate)
+		{
+			m_currStats.m_unDrawCallCount = m_ptrSpriteBatch->GetDrawCallCount();
+			m_currStats.m_unSpriteCount = m_ptrSpriteBatch->GetQuadCount();
+
+			StreamBuffer::SStats streamStats = m_ptrSpriteBatch->PopStreamStats();
+			m_currStats.m_unStreamStallCount = streamStats.m_unStallCount;
+			m_currStats.m_fStreamWaitTimeMS = streamStats.m_fWaitTimeMS;
+		}
+		GLStateCache& stateCache = GLStateCache::Ref();
+		m_currStats.m_unStateChangeCount = stateCache.GetStats().m_unIssuedCount;
+		m_currStats.m_unSkippedStateChangeCount = stateCache.GetStats().m_unSkippedCount;
+		stateCache.ResetStats();
+		{
+			std::lock_guard<std::mutex> lock(m_statsMutex);
+			m_stats = m_currStats;
+		}
+		m_frameData.m_unFrameIndex++;
+
+		if (!m_strCapturePath.empty())
+		{
+			SaveBackBuffer(m_strCapturePath);
+			m_strCapturePath.clear();
+		}
+
+		/* Swap OpenGL buffers. */
+		SDL_GL_SwapWindow(m_ptrWindow);
+	}
+
+	bool Renderer2D::SaveBackBuffer(const std::string& strPath)
+	{
+		int nWidth = 0;
+		int nHeight = 0;
+		SDL_GL_GetDrawableSize(m_ptrWindow, &nWidth, &nHeight);
+		SDL_Surface* ptrSurface = SDL_CreateRGBSurfaceWithFormat(0, nWidth, nHeight, 32, SDL_PIXELFORMAT_RGBA32);
+		if (!ptrSurface)
+		{
+			std::cerr << "Renderer2D::SaveBackBuffer Failed to create a surface! SDL error: " << SDL_GetError() << "\n";
+			return false;
+		}
+
+		std::vector<uint8_t> vecPixels(static_cast<size_t>(nWidth) * nHeight * 4);
+		GLStateCache::Ref().BindFramebuffer(0);
+		glReadBuffer(GL_BACK);
+		glPixelStorei(GL_PACK_ALIGNMENT, 1);
+		glReadPixels(0, 0, nWidth, nHeight, GL_RGBA, GL_UNSIGNED_BYTE, vecPixels.data());
+
+		/* OpenGL starts at the bottom row, the surface at the top one. */
+		size_t unRowSize = static_cast<size_t>(nWidth) * 4;
+		for (int nRow = 0; nRow < nHeight; ++nRow)
+		{
+			std::memcpy(static_cast<uint8_t*>(ptrSurface->pixels) + static_cast<size_t>(nRow) * ptrSurface->pitch,
+				vecPixels.data() + static_cast<size_t>(nHeight - 1 - nRow) * unRowSize, unRowSize);
+		}
+
+		bool bSaved = SDL_SaveBMP(ptrSurface, strPath.c_str()) == 0;
+		if (!bSaved)
 		{
-			std::cerr << "Renderer2D::Init Failed to create Window!\n";
-			return false;
+			std::cerr << "Renderer2D::SaveBackBuffer Failed to save " << strPath << "! SDL error: " << SDL_GetError() << "\n";
 		}
+		SDL_FreeSurface(ptrSurface);
+		return bSaved;
+	}
 
-		/* Create OPENGL Context.*/
-		if (!CreateOpenGLContext())
+	void Renderer2D::FlushSprites()
+	{
+		if (m_ptrSpriteBatch)
 		{
-			std::cerr << "Renderer2D::Init Failed to create OpenGLContext!\n";
-			return false;
+			SubmitRenderQueue();
+			m_ptrSpriteBatch->Flush();
 		}
+	}
 
-		if (!CreateImGUI())
+	void Renderer2D::UpdatePendingShaders(bool bWait)
+	{
+		if (m_vecPendingShaders.empty())
 		{
-			std::cerr << "Renderer2D::Init Failed to create ImGUI!\n";
-			return false;
+			return;
 		}
 
-		if (!LoadResources())
+		for (size_t unIndex = 0; unIndex < m_vecPendingShaders.size();)
 		{
-			std::cerr << "Renderer2D::Init Failed to load resources!\n";
+			ShaderVariants* ptrShaders = m_vecPendingShaders[unIndex];
+			Shader::EStatus eStatus = bWait ? ptrShaders->Wait() : ptrShaders->Poll();
+			if (eStatus == Shader::EStatus::eCompiling)
+			{
+				++unIndex;
+				continue;
+			}
+
+			if (eStatus == Shader::EStatus::eFailed)
+			{
+				if (m_ptrSpriteBatch && ptrShaders == &m_ptrSpriteBatch->GetDefaultShaders())
+				{
+					std::cerr << "Renderer2D::UpdatePendingShaders Failed to load the batch shader! Falling back to immediate mode.\n";
+					m_ptrSpriteBatch.reset();
+					m_eRenderMode = ERenderMode::eImmediate;
+				}
+				else
+				{
+					std::cerr << "Renderer2D::UpdatePendingShaders Failed to load the sprite shader!\n";
+				}
+			}
+			m_vecPendingShaders.erase(m_vecPendingShaders.begin() + unIndex);
 		}
 
-		SetScreenSize({ 0, 0, nWidth, nHeight });
+		if (m_vecPendingShaders.empty())
+		{
+			std::cout << "Renderer2D::UpdatePendingShaders Shaders ready after "
+				<< static_cast<double>(SDL_GetPerformanceCounter() - m_unShaderLoadStart) * 1000.0 / SDL_GetPerformanceFrequency()
+				<< " ms\n";
 
-		return true;
+			/* The frames so far have no sprites, so the whole scene must be drawn. */
+			if (m_bDamageTrackingEnabled)
+			{
+				m_damageTracker.InvalidateAll();
+			}
+		}
 	}
 
-	void Renderer2D::Shutdown()
+	void Renderer2D::RenderThreadMain()
 	{
+		int nStatus = SDL_GL_MakeCurrent(m_ptrWindow, m_ptrContext);
+		if (nStatus != 0)
+		{
+			std::cerr << "Renderer2D::RenderThreadMain Failed to make the context current. SDL error: "
+				<< SDL_GetError() << "\n";
+		}
 
-		/* Destroy the window. */
-		DestroyWindow();
+		/* Packets are still returned without a context, so the main thread never blocks for good. */
+		SFramePacket* ptrPacket = nullptr;
+		while ((ptrPacket = m_ptrPacketQueue->BeginRead()) != nullptr)
+		{
+			Uint64 unStart = SDL_GetPerformanceCounter();
+			RenderFramePacket(*ptrPacket);
+			m_fRenderFrameTimeMS = static_cast<float>(
+				static_cast<double>(SDL_GetPerformanceCounter() - unStart) * 1000.0 / SDL_GetPerformanceFrequency());
+			m_ptrPacketQueue->EndRead();
+		}
 
-		/* Destroy the context. */
-		DestroyOpenGLContext();
+		/* Release the context, so the main thread can take it back. */
+		SDL_GL_MakeCurrent(m_ptrWindow, nullptr);
+	}
 
-		/* Destroy ImGUI. */
-		DestroyImGUI();
+	void Renderer2D::RenderFramePacket(SFramePacket& packet)
+	{
+		/* The GPU waits for the uploads of the main thread, the CPU carries on. */
+		if (packet.m_fence)
+		{
+			glWaitSync(packet.m_fence, 0, GL_TIMEOUT_IGNORED);
+		}
 
-		/* Destroy SDL. */
-		DestroySDL();
+		/* The main thread may have deleted textures, whose IDs were reused since. */
+		GLStateCache::Ref().Invalidate();
 
-		/* Destroy SDL image. */
-		DestroySDLImage();
+		glClearColor(packet.m_bgrColor.r, packet.m_bgrColor.g, packet.m_bgrColor.b, packet.m_bgrColor.a);
+		glClear(GL_COLOR_BUFFER_BIT);
+		BeginSubmission();
 
-		/* Destroy SDL ttf. */
-		DestroySDLttf();
-	}
+		ReplayFrameCommands(packet.m_vecCommands, 0, packet.m_unImGUICommandIndex, nullptr);
+		if (packet.m_imguiDrawData.Valid)
+		{
+			m_gpuProfiler.EndScope();
+			m_gpuProfiler.BeginScope("ImGUI");
+			ImGui_ImplOpenGL3_RenderDrawData(&packet.m_imguiDrawData);
+			m_gpuProfiler.EndScope();
+			m_gpuProfiler.BeginScope("Sprites");
+			GLStateCache::Ref().SyncAfterImGUI();
+		}
+		ReplayFrameCommands(packet.m_vecCommands, packet.m_unImGUICommandIndex, packet.m_vecCommands.size(), nullptr);
 
-	SDL_GLContext Renderer2D::GetContext()
-	{
-		return m_ptrContext;
+		m_currStats.m_unSubmittedSpriteCount = packet.m_unSubmittedSpriteCount;
+		m_currStats.m_unCulledSpriteCount = packet.m_unCulledSpriteCount;
+		m_currStats.m_fPacketWaitTimeMS = packet.m_fWaitTimeMS;
+		EndSubmission();
 	}
 
-	SDL_Window* Renderer2D::GetWindow()
+	void Renderer2D::BeginFramePacket()
 	{
-		return m_ptrWindow;
+		float fWaitTimeMS = 0.0f;
+		SFramePacket& packet = m_ptrPacketQueue->BeginWrite(fWaitTimeMS);
+		packet.Clear();
+		packet.m_bgrColor = m_bgrColor;
+		packet.m_fWaitTimeMS = fWaitTimeMS;
+		m_ptrRecordingPacket = &packet;
+
+		/* With a free packet in the ring, the main thread only ever waits for the frame, which is being drawn. */
+		if (m_bPacketHandoffCheckEnabled)
+		{
+			float fFrameTimeMS = m_fRenderFrameTimeMS;
+			if (fWaitTimeMS > fFrameTimeMS + PACKET_HANDOFF_TOLERANCE_MS)
+			{
+				m_unPacketHandoffViolationCount++;
+				std::cerr << "Renderer2D::BeginFrame Waited " << fWaitTimeMS << " ms for a frame packet, but the last frame took "
+					<< fFrameTimeMS << " ms!\n";
+			}
+		}
 	}
 
-	void Renderer2D::BeginFrame()
+	void Renderer2D::EndFramePacket()
 	{
-		/* Clear the screen with the background color. */
-		glClear(GL_COLOR_BUFFER_BIT);
+		if (!m_ptrRecordingPacket)
+		{
+			return;
+		}
 
-		/* Enable Blending. */
-		glEnable(GL_BLEND);
-		glBlendEquationSeparate(GL_FUNC_ADD, GL_FUNC_ADD);
-		glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ZERO);
+		/* Textures, uploaded by the main thread, must be complete before the render thread samples them.
+		 * The fence is flushed, so the other context can wait on it. */
+		m_ptrRecordingPacket->m_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		glFlush();
 
-		/* Bind shader and geometry for drawing sprites. */
-		m_ptrShader->SetActive();
-		m_ptrVertexArray->SetActive();
+		m_ptrRecordingPacket = nullptr;
+		m_ptrPacketQueue->EndWrite();
 	}
 
-	void Renderer2D::EndFrame()
+	void Renderer2D::RetainTexture(const std::shared_ptr<Texture>& ptrTexture)
 	{
-		/* Swap OpenGL buffers. */
-		SDL_GL_SwapWindow(m_ptrWindow);
+		/* The caller may release the texture, before the render thread draws it. */
+		if (m_ptrRecordingPacket)
+		{
+			m_ptrRecordingPacket->m_vecRetainedTextures.push_back(ptrTexture);
+		}
 	}
 
-	void Renderer2D::BeginImGUIFrame()
+	void Renderer2D::SetBlendMode(EBlendMode eBlendMode)
 	{
-		/* Feeds input to dear imgui, starts new frame */
-		ImGui_ImplOpenGL3_NewFrame();
-		ImGui_ImplSDL2_NewFrame(m_ptrWindow);
-		ImGui::NewFrame();
+		GLStateCache& stateCache = GLStateCache::Ref();
+		switch (eBlendMode)
+		{
+		case EBlendMode::eAlpha:
+			stateCache.SetBlendMode(GL_FUNC_ADD, GL_FUNC_ADD, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ZERO);
+			break;
+		case EBlendMode::eAlphaToPremultiplied:
+			stateCache.SetBlendMode(GL_FUNC_ADD, GL_FUNC_ADD, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+			break;
+		case EBlendMode::ePremultipliedAlpha:
+			stateCache.SetBlendMode(GL_FUNC_ADD, GL_FUNC_ADD, GL_ONE, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+			break;
+		}
 	}
 
-	void Renderer2D::EndImGUIFrame()
+	Renderer2D::SCachedLayer* Renderer2D::GetCachedLayer(unsigned int unLayerID)
 	{
-		/* Render dear imgui into screen */
-		ImGui::Render();
-		ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
-
-		ImGuiIO& io = ImGui::GetIO();
-		const auto& screenSize = Renderer2D::Ref().GetScreenSize();
-		io.DisplaySize = ImVec2(screenSize.w, screenSize.h);
-
-		if (io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable)
+		if (unLayerID >= m_vecCachedLayers.size() || !m_vecCachedLayers[unLayerID].m_ptrTarget)
 		{
-			auto* currContext = m_ptrContext;
-			ImGui::UpdatePlatformWindows();
-			ImGui::RenderPlatformWindowsDefault();
-
-			/* Make this context the current one*/
-			int nStatus = SDL_GL_MakeCurrent(m_ptrWindow, currContext);
-			if (nStatus != 0)
-			{
-				std::cerr << "Renderer2D::EndImGUIFrame Failed to make this context curret. SDL error: "
-					<< SDL_GetError() << "\n";
-			}
+			return nullptr;
 		}
+		return &m_vecCachedLayers[unLayerID];
 	}
 
-	void Renderer2D::HandleEvent(const SDL_Event& event)
+	const Renderer2D::SCachedLayer* Renderer2D::GetCachedLayer(unsigned int unLayerID) const
 	{
-		ImGui_ImplSDL2_ProcessEvent(&event);
+		return const_cast<Renderer2D*>(this)->GetCachedLayer(unLayerID);
 	}
 
-	void Renderer2D::SetScreenSize(const SDL_Rect& screenSize)
+	void Renderer2D::DestroyCachedLayers()
 	{
-		m_screenSize = screenSize;
-		glViewport(m_screenSize.x, m_screenSize.y, m_screenSize.w, m_screenSize.h);
-		m_projectionMatrix = glm::ortho(static_cast<float>(m_screenSize.x),
-			static_cast<float>(m_screenSize.w),
-			static_cast<float>(m_screenSize.h),
-			static_cast<float>(m_screenSize.y),
-			-1.0f,
-			1.0f);
+		m_vecCachedLayers.clear();
+		m_vecCachedLayerTargetPool.clear();
+		m_unRecordingCachedLayerID = INVALID_CACHED_LAYER;
 	}
 
-	const SDL_Rect& Renderer2D::GetScreenSize() const
+	bool Renderer2D::IsRecordingFrame() const
 	{
-		return m_screenSize;
+		return m_bDamageTrackingEnabled && !m_bFrameResolved && m_unRecordingCachedLayerID == INVALID_CACHED_LAYER;
 	}
 
-	void Renderer2D::SetBackgroundColor(const glm::vec4& bgrColor)
+	void Renderer2D::RecordFrameCommand(const SSpriteCommand& command, EBlendMode eBlendMode, uint32_t unContentVersion,
+		bool bSorted)
 	{
-		m_bgrColor = bgrColor;
-		glClearColor(m_bgrColor.r, m_bgrColor.g, m_bgrColor.b, m_bgrColor.a);
+		SFrameCommand frameCommand{ command, command.m_destRect, m_unLayer, m_unDepth, eBlendMode, bSorted };
+		if (command.m_fAngle != 0.0f)
+		{
+			frameCommand.m_bounds = RectCuller::GetBounds(SAffine2D::FromSprite(command.m_destRect,
+				SDL_RendererFlip::SDL_FLIP_NONE, command.m_fAngle, command.m_origin));
+		}
+
+		/* Everything, which affects the pixels of the sprite or its order. */
+		uint64_t unHash = 0xCBF29CE484222325ull;
+		unHash = HashValue(unHash, command.m_ptrTexture->GetContentVersion());
+		unHash = HashValue(unHash, unContentVersion);
+		unHash = HashValue(unHash, command.m_ptrShader);
+		unHash = HashValue(unHash, command.m_minUV);
+		unHash = HashValue(unHash, command.m_maxUV);
+		unHash = HashValue(unHash, command.m_color);
+		unHash = HashValue(unHash, command.m_flipFormat);
+		unHash = HashValue(unHash, command.m_fAngle);
+		unHash = HashValue(unHash, command.m_origin);
+		unHash = HashValue(unHash, frameCommand.m_unLayer);
+		unHash = HashValue(unHash, frameCommand.m_unDepth);
+		unHash = HashValue(unHash, eBlendMode);
+		unHash = HashValue(unHash, frameCommand.m_bSorted);
+
+		m_damageTracker.AddDraw(frameCommand.m_bounds, unHash);
+		m_vecFrameCommands.push_back(frameCommand);
 	}
 
-	void Renderer2D::DrawTexture(const Texture& texture,
-								const SDL_Rect& destRect,
-								const SDL_Color& color,
-								const SDL_RendererFlip& flipFormat)
+	void Renderer2D::ResolveDamage()
 	{
-		/* Set identity matrix. */
-		auto trans = glm::mat4(1.0f);
+		if (!m_bDamageTrackingEnabled || m_bFrameResolved)
+		{
+			return;
+		}
+		m_bFrameResolved = true;
 
-		/* Translate to top-left x, y. */
-		glm::vec3 pos(destRect.x + texture.GetWidth() * 0.5f, destRect.y + texture.GetHeight() * 0.5f, 0.0f);
-		trans = glm::translate(trans, pos);
-		
-		/* Translate to scaled top-left x, y. */
-		glm::vec3 posScaled((texture.GetWidth() - destRect.w) / -2.0f, (texture.GetHeight() - destRect.h) / -2.0f, 0.0f);
-		trans = glm::translate(trans, posScaled);
+		const std::vector<SDL_Rect>& vecDamageRects = m_damageTracker.EndFrame(m_viewportRect);
+		m_currStats.m_unDamageRectCount = static_cast<unsigned int>(vecDamageRects.size());
+		m_currStats.m_unDamagedPixelCount = m_damageTracker.GetDamagedPixelCount();
 
-		/* Scale by w, y */
-		glm::vec3 scale(destRect.w, destRect.h, 1.0f);
-		
-		/* Set flip format. */
-		switch (flipFormat)
+		if (!vecDamageRects.empty())
 		{
-		case SDL_RendererFlip::SDL_FLIP_HORIZONTAL: scale.x *= -1; break;
-		case SDL_RendererFlip::SDL_FLIP_VERTICAL: scale.y *= -1; break;
-		default: break;
+			m_ptrSceneTarget->Bind();
+			glEnable(GL_SCISSOR_TEST);
+			for (const auto& damageRect : vecDamageRects)
+			{
+				/* The scissor box is relative to the bottom-left of the target. */
+				glScissor(damageRect.x - m_viewportRect.x,
+					m_viewportRect.h - (damageRect.y - m_viewportRect.y) - damageRect.h,
+					damageRect.w, damageRect.h);
+				glClearBufferfv(GL_COLOR, 0, glm::value_ptr(m_bgrColor));
+				ReplayFrameCommands(m_vecFrameCommands, 0, m_vecFrameCommands.size(), &damageRect);
+			}
+			glDisable(GL_SCISSOR_TEST);
+			SetBlendMode(EBlendMode::eAlpha);
 		}
-		trans = glm::scale(trans, scale);
+		m_vecFrameCommands.clear();
 
-		 /* Set world transform */
-		m_ptrShader->SetMatrixUniform("u_WorldTransform", trans);
-		m_ptrShader->SetMatrixUniform("u_ViewProj", m_projectionMatrix);
+		/* Copy the scene to the screen. The read binding isn't tracked, so it is restored right away. */
+		GLStateCache::Ref().BindFramebuffer(0);
+		glViewport(m_screenSize.x, m_screenSize.y, m_screenSize.w, m_screenSize.h);
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, m_ptrSceneTarget->GetFramebufferID());
+		glBlitFramebuffer(0, 0, m_ptrSceneTarget->GetWidth(), m_ptrSceneTarget->GetHeight(),
+			m_screenSize.x, m_screenSize.y, m_screenSize.x + m_screenSize.w, m_screenSize.y + m_screenSize.h,
+			GL_COLOR_BUFFER_BIT, GL_NEAREST);
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+	}
 
-		/* Set color. */
-		glm::vec4 normalizedColor{ color.r / 255.0f, color.g / 255.0f, color.b / 255.0f, color.a / 255.0f };
-		m_ptrShader->SetVectorUniform("u_Color", normalizedColor);
+	void Renderer2D::ReplayFrameCommands(const std::vector<SFrameCommand>& vecFrameCommands, size_t unBegin, size_t unEnd,
+		const SDL_Rect* ptrClipRect)
+	{
+		EBlendMode eBlendMode = EBlendMode::eAlpha;
+		bool bSorted = false;
+		SetBlendMode(eBlendMode);
 
-		/* Set current texture */
-		texture.SetActive();
+		for (size_t unIndex = unBegin; unIndex < unEnd; ++unIndex)
+		{
+			const SFrameCommand& frameCommand = vecFrameCommands[unIndex];
+			if (ptrClipRect && !SDL_HasIntersection(&frameCommand.m_bounds, ptrClipRect))
+			{
+				continue;
+			}
 
-		/* Draw quad */
-		glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
+			/* Blend mode and sorting apply to everything, which is flushed together. */
+			if (frameCommand.m_eBlendMode != eBlendMode || frameCommand.m_bSorted != bSorted)
+			{
+				SubmitBulkCommands();
+				FlushSprites();
+				eBlendMode = frameCommand.m_eBlendMode;
+				SetBlendMode(eBlendMode);
+				bSorted = frameCommand.m_bSorted;
+			}
+
+			if (frameCommand.m_bSorted)
+			{
+				SubmitSprite(frameCommand.m_command, frameCommand.m_unLayer, frameCommand.m_unDepth, true);
+			}
+			else
+			{
+				/* Unsorted runs keep their order, so they're submitted in one go and expanded in parallel. */
+				m_vecBulkCommands.push_back(&frameCommand.m_command);
+			}
+		}
+
+		/* The scissor box or the ImGUI windows follow. */
+		SubmitBulkCommands();
+		FlushSprites();
 	}
 
-	void Renderer2D::DrawTexture(const std::shared_ptr<Texture>& texture,
-		const SDL_Rect& destRect,
-		const SDL_Color& color,
-		const SDL_RendererFlip& flipFormat)
+	void Renderer2D::SubmitRenderQueue()
 	{
-		if (texture)
+		if (m_renderQueue.GetCount() == 0)
 		{
-			DrawTexture(*texture, destRect, color, flipFormat);
+			return;
+		}
+
+		m_renderQueue.Sort();
+		for (size_t unIndex = 0; unIndex < m_renderQueue.GetCount(); ++unIndex)
+		{
+			const SSpriteCommand& command = m_renderQueue.GetSorted(unIndex);
+			m_ptrSpriteBatch->SetShader(command.m_ptrShader);
+			m_ptrSpriteBatch->Draw(*command.m_ptrTexture, command.m_destRect,
+				command.m_minUV, command.m_maxUV, command.m_color, command.m_flipFormat,
+				command.m_fAngle, command.m_origin);
+		}
+		m_renderQueue.Clear();
+	}
+
+	void Renderer2D::SubmitBulkCommands()
+	{
+		if (m_vecBulkCommands.empty())
+		{
+			return;
+		}
+
+		if (m_eRenderMode != ERenderMode::eImmediate)
+		{
+			m_ptrSpriteBatch->DrawCommands(m_vecBulkCommands.data(), m_vecBulkCommands.size(), m_threadPool);
 		}
 		else
 		{
-			std::cerr << "Renderer2D::DrawTexture error! texture is nullptr!\n";
+			for (const SSpriteCommand* ptrCommand : m_vecBulkCommands)
+			{
+				SubmitSprite(*ptrCommand, 0, 0, false);
+			}
 		}
+		m_vecBulkCommands.clear();
 	}
 
-	void Renderer2D::DrawTexture(const Texture& texture,
-								const SDL_Rect& srcRect,
-								const SDL_Rect& destRect,
-								const SDL_Color& color,
-								const SDL_RendererFlip& flipFormat)
+	void Renderer2D::DrawSprite(const Texture& texture, const SDL_Rect& destRect,
+		const glm::vec2& minUV, const glm::vec2& maxUV,
+		const SDL_Color& color, SDL_RendererFlip flipFormat,
+		float fAngle, const glm::vec2& origin)
 	{
-		float fDestW = static_cast<float>(texture.GetWidth());
-		float fDestH = static_cast<float>(texture.GetHeight());
-		float fSrcMinX = static_cast<float>(srcRect.x);
-		float fSrcMinY = static_cast<float>(srcRect.y);
-		float fSrcMaxX = static_cast<float>(srcRect.x + srcRect.w);
-		float fSrcMaxY = static_cast<float>(srcRect.y + srcRect.h);
+		/* Nothing can be drawn, until the shaders are ready. */
+		if (IsLoadingShaders())
+		{
+			return;
+		}
 
-		VertexArray::SRectParam rectParam;
-		rectParam.m_minUV.x = fSrcMinX / fDestW;
-		rectParam.m_minUV.y = fSrcMinY / fDestH;
-		rectParam.m_maxUV.x = fSrcMaxX / fDestW;
-		rectParam.m_maxUV.y = fSrcMaxY / fDestH;
+		if (m_bCullingEnabled)
+		{
+			/* Rotated sprites are tested with the bounds of their rotated quad. */
+			bool bVisible = fAngle == 0.0f ? RectCuller::IsVisible(destRect, m_viewportRect) :
+				RectCuller::IsVisible(RectCuller::GetBounds(SAffine2D::FromSprite(destRect,
+					SDL_RendererFlip::SDL_FLIP_NONE, fAngle, origin)), m_viewportRect);
+			if (!bVisible)
+			{
+				if (m_ptrRecordingPacket)
+				{
+					m_ptrRecordingPacket->m_unCulledSpriteCount++;
+				}
+				else
+				{
+					m_currStats.m_unCulledSpriteCount++;
+				}
+				return;
+			}
+		}
 
-		if (rectParam.CheckUV())
+		SSpriteCommand command{ &texture, m_ptrSpriteShader, destRect, minUV, maxUV, color, flipFormat, fAngle, origin };
+		if (m_ptrPacketQueue)
+		{
+			if (!m_ptrRecordingPacket)
+			{
+				std::cerr << "Renderer2D::DrawSprite Sprites must be drawn between BeginFrame and EndFrame!\n";
+				return;
+			}
+
+			/* The render thread replays the sprite with the state of this call. */
+			m_ptrRecordingPacket->m_unSubmittedSpriteCount++;
+			m_ptrRecordingPacket->m_vecCommands.push_back({ command, destRect, m_unLayer, m_unDepth,
+				EBlendMode::eAlpha, m_bSortingEnabled });
+			return;
+		}
+		m_currStats.m_unSubmittedSpriteCount++;
+
+		if (IsRecordingFrame())
 		{
-			VertexArray va(rectParam);
-			va.SetActive();
-			DrawTexture(texture, destRect, color, flipFormat);
+			RecordFrameCommand(command, EBlendMode::eAlpha, 0, m_bSortingEnabled);
+			return;
 		}
+		SubmitSprite(command, m_unLayer, m_unDepth, m_bSortingEnabled);
 	}
 
-	void Renderer2D::DrawTexture(const std::shared_ptr<Texture>& texture,
-								const SDL_Rect& srcRect,
-								const SDL_Rect& destRect,
-								const SDL_Color& color,
-								const SDL_RendererFlip& flipFormat)
+	void Renderer2D::SubmitSprite(const SSpriteCommand& command, unsigned int unLayer, unsigned int unDepth, bool bSorted)
 	{
-		if (texture)
+		const Texture& texture = *command.m_ptrTexture;
+		if (m_eRenderMode != ERenderMode::eImmediate)
 		{
-			DrawTexture(*texture, srcRect, destRect, color, flipFormat);
+			if (bSorted)
+			{
+				/* Only alpha blending is supported, so the blend mode is always 0. */
+				uint32_t unShaderID = command.m_ptrShader ? command.m_ptrShader->GetProgramID() : 0;
+				uint64_t unSortKey = RenderQueue::MakeSortKey(unLayer, 0, unShaderID,
+					texture.GetTextureID(), unDepth);
+				m_renderQueue.Push(unSortKey, command);
+			}
+			else
+			{
+				m_ptrSpriteBatch->SetShader(command.m_ptrShader);
+				m_ptrSpriteBatch->Draw(texture, command.m_destRect, command.m_minUV, command.m_maxUV,
+					command.m_color, command.m_flipFormat, command.m_fAngle, command.m_origin);
+			}
+			return;
 		}
-		else
+
+		/* Only tinted sprites pay for the tint. The state cache skips binding the same variant again. */
+		const SDL_Color& color = command.m_color;
+		bool bTinted = !ISpriteBatch::IsWhite(color);
+		Shader* ptrShader = m_ptrShader->Get(bTinted ? m_unTintMask : 0);
+		if (!ptrShader)
 		{
-			std::cerr << "Renderer2D::DrawTexture error! texture is nullptr!\n";
+			return;
+		}
+		ptrShader->SetActive();
+
+		/* Map the centered unit quad onto the rect. */
+		SAffine2D affine = SAffine2D::FromSprite(command.m_destRect, command.m_flipFormat, command.m_fAngle,
+			command.m_origin).Translated(glm::vec2{ 0.5f, 0.5f });
+
+		 /* Set world transform */
+		ptrShader->SetAffineUniform(WORLD_TRANSFORM_UNIFORM, affine);
+
+		/* Set color. */
+		if (bTinted)
+		{
+			glm::vec4 normalizedColor{ color.r / 255.0f, color.g / 255.0f, color.b / 255.0f, color.a / 255.0f };
+			ptrShader->SetVectorUniform(COLOR_UNIFORM, normalizedColor);
 		}
+
+		/* Set the source rect. The shared unit quad stays untouched. */
+		ptrShader->SetVectorUniform(UV_RECT_UNIFORM, glm::vec4{ command.m_minUV.x, command.m_minUV.y,
+			command.m_maxUV.x, command.m_maxUV.y });
+
+		/* Set current texture */
+		texture.SetActive();
+
+		/* Draw quad */
+		glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
+		m_currStats.m_unDrawCallCount++;
+		m_currStats.m_unSpriteCount++;
 	}
 
-	/* Private methods. */
 	Renderer2D::Renderer2D()
-		: m_ptrWindow{ nullptr }, m_ptrContext{ nullptr }, m_screenSize{},
-		m_bgrColor{}, m_projectionMatrix{1.0f}, m_ptrShader{nullptr}, 
-		m_ptrVertexArray{nullptr}
+		: m_ptrWindow{ nullptr }, m_ptrContext{ nullptr }, m_screenSize{}, m_viewportRect{},
+		m_bgrColor{}, m_projectionMatrix{1.0f}, m_ptrShader{nullptr}, m_unTintMask{ 0 },
+		m_ptrVertexArray{nullptr}, m_ptrSpriteBatch{ nullptr },
+		m_eRenderMode{ ERenderMode::eBatched }, m_renderQueue{}, m_bSortingEnabled{ false }, m_bCullingEnabled{ true },
+		m_unLayer{ 0 }, m_unDepth{ 0 }, m_ptrSpriteShader{ nullptr }, m_currStats{}, m_stats{},
+		m_frameData{}, m_ptrFrameDataBuffer{ nullptr }, m_vecCachedLayers{}, m_vecCachedLayerTargetPool{},
+		m_unRecordingCachedLayerID{ INVALID_CACHED_LAYER }, m_bDamageTrackingEnabled{ false }, m_bFrameResolved{ false },
+		m_damageTracker{}, m_vecFrameCommands{}, m_ptrSceneTarget{ nullptr }, m_statsMutex{},
+		m_ptrPacketQueue{ nullptr }, m_ptrRecordingPacket{ nullptr }, m_renderThread{}, m_ptrResourceContext{ nullptr },
+		m_bRestoreImGUIViewports{ false }, m_fRenderFrameTimeMS{ 0.0f }, m_bPacketHandoffCheckEnabled{ false },
+		m_unPacketHandoffViolationCount{ 0 }, m_vecCommandRecorders{}, m_mergedQueue{}, m_vecBulkCommands{}, m_threadPool{},
+		m_gpuProfiler{}, m_textureStreamer{}, m_bHeadless{ false }, m_strCapturePath{}, m_bAsyncShaderLoading{ false }, m_vecPendingShaders{},
+		m_unShaderLoadStart{ 0 }
 	{
 	}
 
 	bool Renderer2D::InitSDL()
 	{
+		/* Prefer drivers, which need neither a display nor an audio device. */
+		if (m_bHeadless)
+		{
+			SDL_setenv("SDL_VIDEODRIVER", "offscreen", 0);
+			SDL_setenv("SDL_AUDIODRIVER", "dummy", 0);
+		}
+
 		/* Initialize SDL with video. */
 		int nStatus = SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO);
 		if (nStatus != 0)
@@ -352,7 +1617,8 @@ namespace K9
 
 	bool Renderer2D::InitWindow(const std::string& strTitle, int nWidth, int nHeight)
 	{
-		m_ptrWindow = SDL_CreateWindow(strTitle.c_str(), SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, nWidth, nHeight, SDL_WINDOW_OPENGL);
+		Uint32 unFlags = m_bHeadless ? SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN : SDL_WINDOW_OPENGL;
+		m_ptrWindow = SDL_CreateWindow(strTitle.c_str(), SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, nWidth, nHeight, unFlags);
 		if (!m_ptrWindow)
 		{
 			std::cerr << "Error failed to create window!\n";
@@ -432,7 +1698,10 @@ namespace K9
 		ImGuiIO& io = ImGui::GetIO();
 		io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;       // Enable Keyboard Controls
 		io.ConfigFlags |= ImGuiConfigFlags_DockingEnable;           // Enable Docking
-		io.ConfigFlags |= ImGuiConfigFlags_ViewportsEnable;         // Enable Multi-Viewport / Platform Windows
+		if (!m_bHeadless)
+		{
+			io.ConfigFlags |= ImGuiConfigFlags_ViewportsEnable;     // Enable Multi-Viewport / Platform Windows
+		}
 
 		/* Setup Dear ImGui style */
 		ImGui::StyleColorsDark();
@@ -462,14 +1731,63 @@ namespace K9
 
 	bool Renderer2D::LoadResources()
 	{
-		m_ptrShader.reset(new Shader());
+		/* The frame data block must be registered before any shader is loaded. */
+		static_assert(sizeof(SFrameData) == 80, "SFrameData must match the std140 layout of the FrameData block");
+		m_ptrFrameDataBuffer.reset(new UniformBuffer());
+		if (!m_ptrFrameDataBuffer->Create(sizeof(SFrameData), FRAME_DATA_BINDING))
+		{
+			m_ptrFrameDataBuffer.reset();
+			return false;
+		}
+		Shader::RegisterUniformBlock(FRAME_DATA_BLOCK_NAME, FRAME_DATA_BINDING);
+
+		/* Asynchronous shaders are only submitted here and finished by UpdatePendingShaders. */
+		m_vecPendingShaders.clear();
+		m_unShaderLoadStart = SDL_GetPerformanceCounter();
+		m_ptrShader.reset(new ShaderVariants());
 		if (!m_ptrShader->Load("assets/shaders/Sprite.vert", "assets/shaders/Sprite.frag"))
 		{
 			return false;
 		}
+		m_unTintMask = m_ptrShader->GetKeywordMask("TINT");
+
+		/* Every variant is submitted at once, so the driver can compile them in parallel. */
+		m_ptrShader->Prewarm();
+		if (m_bAsyncShaderLoading)
+		{
+			m_vecPendingShaders.push_back(m_ptrShader.get());
+		}
+		else if (m_ptrShader->Wait() != Shader::EStatus::eReady)
+		{
+			return false;
+		}
 
 		VertexArray::SRectParam rectParam{};
 		m_ptrVertexArray.reset(new VertexArray(rectParam));
+
+		if (m_eRenderMode == ERenderMode::eBatched)
+		{
+			m_ptrSpriteBatch.reset(new SpriteBatch());
+		}
+		else if (m_eRenderMode == ERenderMode::eInstanced)
+		{
+			m_ptrSpriteBatch.reset(new SpriteInstanceBatch());
+		}
+
+		if (m_ptrSpriteBatch)
+		{
+			m_renderQueue.Reserve(ISpriteBatch::DEFAULT_MAX_QUAD_COUNT);
+			if (!m_ptrSpriteBatch->Init(ISpriteBatch::DEFAULT_MAX_QUAD_COUNT, m_bAsyncShaderLoading))
+			{
+				std::cerr << "Renderer2D::LoadResources Failed to init the sprite batch! Falling back to immediate mode.\n";
+				m_ptrSpriteBatch.reset();
+				m_eRenderMode = ERenderMode::eImmediate;
+			}
+			else if (m_bAsyncShaderLoading)
+			{
+				m_vecPendingShaders.push_back(&m_ptrSpriteBatch->GetDefaultShaders());
+			}
+		}
 		return true;
 	}
 }
\ No newline at end of file
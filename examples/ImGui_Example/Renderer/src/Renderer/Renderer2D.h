@@ -1,6 +1,23 @@
 #pragma once
+#include <atomic>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <Threading/ThreadPool.h>
+#include "CommandRecorder.h"
+#include "DamageTracker.h"
+#include "FramePacket.h"
+#include "FramePacketQueue.h"
+#include "GPUProfiler.h"
+#include "RenderQueue.h"
+#include "RenderTarget.h"
 #include "Shader.h"
+#include "ShaderVariants.h"
+#include "SpriteBatch.h"
+#include "SpriteInstanceBatch.h"
+#include "TextureStreamer.h"
+#include "UniformBuffer.h"
 #include "VertexArray.h"
 #include <SDL.h>
 #include <SDL_image.h>
@@ -15,6 +32,133 @@ namespace K9
 	class Renderer2D
 	{
 	public:
+		/// <summary>
+		/// Supported ways of submitting sprites to OpenGL.
+		/// </summary>
+		enum class ERenderMode
+		{
+			/* One draw call per sprite. */
+			eImmediate,
+			/* Sprites are gathered into a dynamic vertex buffer and drawn in batches. */
+			eBatched,
+			/* A static unit quad is drawn instanced with one SSpriteInstance per sprite. */
+			eInstanced,
+		};
+
+		/// <summary>
+		/// Per-frame data, shared by all shaders through the FrameData uniform block.
+		/// Matches the std140 layout of the block:
+		/// layout(std140) uniform FrameData { mat4 u_ViewProj; vec2 u_ScreenSize; float u_Time; uint u_FrameIndex; };
+		/// </summary>
+		struct SFrameData
+		{
+			/// <summary>
+			/// View-projection matrix.
+			/// </summary>
+			glm::mat4 m_viewProj{ 1.0f };
+
+			/// <summary>
+			/// Screen size in pixels.
+			/// </summary>
+			glm::vec2 m_screenSize{ 0.0f, 0.0f };
+
+			/// <summary>
+			/// Seconds since SDL was initialized.
+			/// </summary>
+			float m_fTime = 0.0f;
+
+			/// <summary>
+			/// Index of the current frame.
+			/// </summary>
+			uint32_t m_unFrameIndex = 0;
+		};
+
+		/// <summary>
+		/// Name of the uniform block, which holds SFrameData.
+		/// </summary>
+		static constexpr const char* FRAME_DATA_BLOCK_NAME{ "FrameData" };
+
+		/// <summary>
+		/// Uniform buffer binding point of SFrameData.
+		/// </summary>
+		static constexpr unsigned int FRAME_DATA_BINDING{ 0 };
+
+		/// <summary>
+		/// ID, which never refers to a cached layer.
+		/// </summary>
+		static constexpr unsigned int INVALID_CACHED_LAYER{ 0xFFFFFFFF };
+
+		/// <summary>
+		/// Slack in milliseconds, granted to the packet handoff check for waking up the main thread.
+		/// </summary>
+		static constexpr float PACKET_HANDOFF_TOLERANCE_MS{ 2.0f };
+
+		/// <summary>
+		/// Per-frame rendering statistics.
+		/// </summary>
+		struct SStats
+		{
+			/// <summary>
+			/// Number of sprite draw calls.
+			/// </summary>
+			unsigned int m_unDrawCallCount = 0;
+
+			/// <summary>
+			/// Number of drawn sprites.
+			/// </summary>
+			unsigned int m_unSpriteCount = 0;
+
+			/// <summary>
+			/// Number of GL state changes, sent to the driver.
+			/// </summary>
+			unsigned int m_unStateChangeCount = 0;
+
+			/// <summary>
+			/// Number of redundant GL state changes, skipped by the GLStateCache.
+			/// </summary>
+			unsigned int m_unSkippedStateChangeCount = 0;
+
+			/// <summary>
+			/// Number of times the CPU waited for the GPU to release streamed geometry.
+			/// </summary>
+			unsigned int m_unStreamStallCount = 0;
+
+			/// <summary>
+			/// Time, spent waiting for streamed geometry in milliseconds.
+			/// </summary>
+			float m_fStreamWaitTimeMS = 0.0f;
+
+			/// <summary>
+			/// Number of sprites, which passed culling and were submitted.
+			/// </summary>
+			unsigned int m_unSubmittedSpriteCount = 0;
+
+			/// <summary>
+			/// Number of sprites, which were skipped, since they were outside of the viewport.
+			/// </summary>
+			unsigned int m_unCulledSpriteCount = 0;
+
+			/// <summary>
+			/// Number of cached layers, which were redrawn into their target.
+			/// </summary>
+			unsigned int m_unCachedLayerRedrawCount = 0;
+
+			/// <summary>
+			/// Number of scissored passes, used to redraw the damaged regions. Only set with damage tracking.
+			/// </summary>
+			unsigned int m_unDamageRectCount = 0;
+
+			/// <summary>
+			/// Number of redrawn pixels. Only set with damage tracking.
+			/// </summary>
+			unsigned int m_unDamagedPixelCount = 0;
+
+			/// <summary>
+			/// Time, the main thread waited for a free frame packet, in milliseconds. Only set with the render thread.
+			/// </summary>
+			float m_fPacketWaitTimeMS = 0.0f;
+		};
+
 		/** Delete the copy constructor, move constructor and assignment operators. */
 		Renderer2D(const Renderer2D&) = delete;
 		Renderer2D(Renderer2D&&) = delete;
@@ -30,9 +174,17 @@ namespace K9
 		/// <summary>
 		/// Init the renderer.
 		/// </summary>
-		/// <param name="window"> Window reference </param>
+		/// <param name="strTitle"> Title of the window. </param>
+		/// <param name="nWidth"> Width of the window in pixels. </param>
+		/// <param name="nHeight"> Height of the window in pixels. </param>
+		/// <param name="eRenderMode"> How sprites are submitted to OpenGL. </param>
+		/// <param name="bHeadless"> True, to render without a visible window, e.g. for benchmarks and CI.
+		/// Unless SDL_VIDEODRIVER is set, SDL's offscreen video driver is used, which renders into an EGL pbuffer,
+		/// so Mesa's llvmpipe works on machines without a GPU or display. Audio uses the dummy driver,
+		/// unless SDL_AUDIODRIVER is set. ImGUI platform windows are disabled. </param>
 		/// <returns> True, if the initialization was successful. </returns>
-		bool Init(const std::string& strTitle, int nWidth, int nHeight);
+		bool Init(const std::string& strTitle, int nWidth, int nHeight,
+			ERenderMode eRenderMode = ERenderMode::eBatched, bool bHeadless = false);
 
 		/// <summary>
 		/// Free up resources.
@@ -51,16 +203,106 @@ namespace K9
 		/// <returns> m_ptrWindow </returns>
 		SDL_Window* GetWindow();
 
+		/// <summary>
+		/// Check, if the renderer was initialized without a visible window.
+		/// </summary>
+		/// <returns> m_bHeadless. </returns>
+		bool IsHeadless() const;
+
+		/// <summary>
+		/// Save the next finished frame, including ImGUI, as a BMP file, right before the buffers are swapped.
+		/// Not available with the render thread.
+		/// </summary>
+		/// <param name="strPath"> Path of the BMP file. </param>
+		void CaptureNextFrame(const std::string& strPath);
+
+		/// <summary>
+		/// Compile the sprite shaders in the background. Must be called before Init.
+		/// Init only submits them, so the caller can load its assets, while the driver compiles.
+		/// Sprites are dropped until the shaders are ready, so only ImGUI is drawn, e.g. a loading screen.
+		/// </summary>
+		/// <param name="bAsync"> True, to load the shaders asynchronously. </param>
+		void SetAsyncShaderLoading(bool bAsync);
+
+		/// <summary>
+		/// Check, if the sprite shaders are still compiling. They're polled by BeginFrame,
+		/// which requests a redraw from IdleLoop, while they are, so the first sprites show up without input.
+		/// </summary>
+		/// <returns> True, if sprites are dropped. </returns>
+		bool IsLoadingShaders() const;
+
 		/// <summary>
 		/// Must be called at the start of the draw loop.
+		/// With the render thread, waits for a free frame packet and starts recording into it.
 		/// </summary>
 		void BeginFrame();
 
 		/// <summary>
 		/// Must be called at the end of the draw loop.
+		/// With the render thread, hands the frame packet over instead of drawing and swapping.
 		/// </summary>
 		void EndFrame();
 
+		/// <summary>
+		/// Draw all sprites, gathered since the last flush.
+		/// Has no effect in ERenderMode::eImmediate and with the render thread, which flushes on its own.
+		/// </summary>
+		void Flush();
+
+		/// <summary>
+		/// Retrieve the render mode.
+		/// </summary>
+		/// <returns> m_eRenderMode. </returns>
+		ERenderMode GetRenderMode() const;
+
+		/// <summary>
+		/// Retrieve the statistics of the last finished frame.
+		/// With the render thread, this is the last frame drawn, which may lag behind the recorded one.
+		/// </summary>
+		/// <returns> A copy of m_stats. </returns>
+		SStats GetStats() const;
+
+		/* Render thread. */
+		/// <summary>
+		/// Move drawing to a dedicated render thread. Must be called between frames.
+		/// The main thread records sprites and a copy of the ImGUI draw data into a frame packet,
+		/// while the render thread, which owns the GL context, draws and swaps the previous packets.
+		/// The main thread keeps a shared context, so textures and shaders can still be loaded there.
+		/// While the render thread runs, damage tracking, cached layers, SetScreenSize and
+		/// ImGUI platform windows are unavailable, and the swap interval of the context is kept.
+		/// Textures must stay alive until their packet is drawn, unless they're drawn through a shared pointer.
+		/// </summary>
+		/// <param name="unPacketCount"> Number of frame packets in flight, clamped to [2, 3]. </param>
+		/// <returns> True, if the render thread is running. </returns>
+		bool StartRenderThread(unsigned int unPacketCount = FramePacketQueue::MIN_PACKET_COUNT);
+
+		/// <summary>
+		/// Draw the remaining frame packets, join the render thread and draw on the main thread again.
+		/// Must be called between frames.
+		/// </summary>
+		void StopRenderThread();
+
+		/// <summary>
+		/// Check, if drawing happens on the render thread.
+		/// </summary>
+		/// <returns> True, if the render thread is running. </returns>
+		bool IsRenderThreadRunning() const;
+
+		/// <summary>
+		/// Enable or disable the packet handoff check, used to test the render thread.
+		/// When enabled, every wait of BeginFrame for a free packet is compared with the duration
+		/// of the last frame of the render thread. A longer wait is reported as a violation,
+		/// since the main thread should never wait for more than the frame, which is being drawn.
+		/// </summary>
+		/// <param name="bEnabled"> True, to check the handoff. </param>
+		void SetPacketHandoffCheckEnabled(bool bEnabled);
+
+		/// <summary>
+		/// Retrieve the number of waits, which took longer than a frame, since the check was enabled.
+		/// </summary>
+		/// <returns> m_unPacketHandoffViolationCount. </returns>
+		unsigned int GetPacketHandoffViolationCount() const;
+
 		/// <summary>
 		/// Begin an ImGUI frame.
 		/// </summary>
@@ -89,12 +331,61 @@ namespace K9
 		/// <returns> m_screenSize. </returns>
 		const SDL_Rect& GetScreenSize() const;
 
+		/// <summary>
+		/// Retrieve the visible area in screen space, covered by the projection.
+		/// Can be used to query a SpatialGrid of static sprites.
+		/// </summary>
+		/// <returns> m_viewportRect. </returns>
+		const SDL_Rect& GetViewportRect() const;
+
 		/// <summary>
 		/// Set the window background color.
 		/// </summary>
 		/// <param name="bgrColor"> Background color to be set. </param>
 		void SetBackgroundColor(const glm::vec4& bgrColor);
 
+		/// <summary>
+		/// Enable or disable sorting of sprites before submission.
+		/// When enabled, draws are queued and sorted by layer, blend mode, shader, texture and depth,
+		/// so the draw order of the caller doesn't affect batching.
+		/// Has no effect in ERenderMode::eImmediate.
+		/// </summary>
+		/// <param name="bEnabled"> True, to sort sprites. </param>
+		void SetSortingEnabled(bool bEnabled);
+
+		/// <summary>
+		/// Set the layer and depth of the following sprites. Only used when sorting is enabled.
+		/// Lower layers are drawn first. Inside a layer and shader/texture group, lower depths are drawn first.
+		/// </summary>
+		/// <param name="unLayer"> Layer in the range [0, 255]. </param>
+		/// <param name="unDepth"> Depth in the range [0, 2^24 - 1]. </param>
+		void SetLayer(unsigned int unLayer, unsigned int unDepth = 0);
+
+		/// <summary>
+		/// Enable or disable culling of sprites, which are outside of the viewport.
+		/// Culled sprites aren't queued, batched or drawn. Enabled by default.
+		/// </summary>
+		/// <param name="bEnabled"> True, to cull sprites. </param>
+		void SetCullingEnabled(bool bEnabled);
+
+		/// <summary>
+		/// Enable or disable damage tracking. Should be called between frames.
+		/// When enabled, the sprites of a frame are recorded instead of drawn and compared with the last frame.
+		/// Only the changed regions of a persistent scene target are cleared and redrawn with scissoring,
+		/// then the target is copied to the screen. A static screen costs a single copy instead of a full redraw.
+		/// Sprites, drawn after EndImGUIFrame, are drawn directly and aren't tracked.
+		/// </summary>
+		/// <param name="bEnabled"> True, to track damage. </param>
+		void SetDamageTrackingEnabled(bool bEnabled);
+
+		/// <summary>
+		/// Set the shader of the following sprites.
+		/// Has no effect in ERenderMode::eImmediate.
+		/// The shader gets the view-projection matrix from the FrameData uniform block.
+		/// </summary>
+		/// <param name="ptrShader"> Shader to be set. nullptr restores the default sprite shader. </param>
+		void SetShader(Shader* ptrShader);
+
 		/* Draw methods. */
 		/// <summary>
 		/// Draw a texture with a destination rect and flip format.
@@ -119,7 +410,143 @@ namespace K9
 			const SDL_Color& color = { 255, 255, 255, 255 },
 			const SDL_RendererFlip& flipFormat = SDL_RendererFlip::SDL_FLIP_NONE);
 
+		/// <summary>
+		/// Draw a texture with a source rect, destination rect, rotation and flip format, like SDL_RenderCopyEx.
+		/// </summary>
+		/// <param name="fAngle"> Rotation in degrees, clockwise on screen. </param>
+		/// <param name="center"> Rotation origin, relative to the top-left of destRect. </param>
+		void DrawTexture(const Texture& texture, const SDL_Rect& srcRect, const SDL_Rect& destRect,
+			float fAngle, const SDL_Point& center,
+			const SDL_Color& color = { 255, 255, 255, 255 },
+			const SDL_RendererFlip& flipFormat = SDL_RendererFlip::SDL_FLIP_NONE);
+
+		/* Command recorders. */
+		/// <summary>
+		/// Create a recorder, which lets a worker thread record sprites for SubmitCommandRecorders.
+		/// The recorder lives as long as the renderer and follows its viewport and culling state.
+		/// Must be called on the main thread, while no recorder is in use.
+		/// </summary>
+		/// <returns> The recorder. </returns>
+		CommandRecorder& CreateCommandRecorder();
+
+		/// <summary>
+		/// Draw the sprites of all recorders and clear them. Must be called on the main thread between BeginFrame and EndFrame,
+		/// once the worker threads are done recording. The sprites follow everything, which was drawn before,
+		/// and are submitted in one go, so their vertices are written by the worker threads straight into the vertex buffer.
+		/// </summary>
+		/// <param name="bSort"> True, to sort all sprites by layer, shader, texture and depth.
+		/// Otherwise they're drawn recorder by recorder in creation order. </param>
+		void SubmitCommandRecorders(bool bSort);
+
+		/// <summary>
+		/// Set the number of worker threads, which write sprite vertices. Must be called between frames,
+		/// while the render thread isn't running. The thread, which submits the sprites, works too.
+		/// </summary>
+		/// <param name="unWorkerCount"> Number of worker threads. 0 writes every vertex on the submitting thread. </param>
+		void SetWorkerThreadCount(unsigned int unWorkerCount);
+
+		/// <summary>
+		/// Retrieve the number of worker threads.
+		/// </summary>
+		/// <returns> Number of workers of m_threadPool. </returns>
+		unsigned int GetWorkerThreadCount() const;
+
+		/// <summary>
+		/// Retrieve the worker threads of the renderer. Can be used to fill the command recorders,
+		/// e.g. with a ParallelFor over the recorders. Loops of the renderer and the caller take turns.
+		/// </summary>
+		/// <returns> m_threadPool. </returns>
+		ThreadPool& GetThreadPool();
+
+		/* GPU profiling. */
+		/// <summary>
+		/// Retrieve the GPU profiler, which measures the sprite, ImGUI and platform window passes of every frame.
+		/// Scopes may be added between BeginFrame and EndFrame on the thread, which owns the context,
+		/// so not from the main thread while the render thread runs. Its statistics can be read from any thread.
+		/// </summary>
+		/// <returns> m_gpuProfiler. </returns>
+		GPUProfiler& GetGPUProfiler();
+
+		/* Texture streaming. */
+		/// <summary>
+		/// Retrieve the texture streamer, which decodes images on worker threads of its own and uploads them
+		/// within a byte budget per frame. BeginFrame updates it on the main thread, so its textures are uploaded
+		/// through the shared context, while the render thread runs. Its threads and buffers are created by the first Load.
+		/// While it has pending work, BeginFrame requests a redraw from IdleLoop.
+		/// </summary>
+		/// <returns> m_textureStreamer. </returns>
+		TextureStreamer& GetTextureStreamer();
+
+		/* Cached layers. */
+		/// <summary>
+		/// Create a cached layer: draws, recorded into an offscreen target of the screen size,
+		/// which is redrawn only when it is dirty and composited with a single quad every frame.
+		/// The targets are pooled and resized with the screen. A new layer is dirty.
+		/// </summary>
+		/// <returns> ID of the layer or INVALID_CACHED_LAYER, if its target couldn't be created. </returns>
+		unsigned int CreateCachedLayer();
+
+		/// <summary>
+		/// Destroy a cached layer. Its target is returned to the pool.
+		/// </summary>
+		/// <param name="unLayerID"> ID of the layer. </param>
+		void DestroyCachedLayer(unsigned int unLayerID);
+
+		/// <summary>
+		/// Request a redraw of a cached layer, since its contents have changed.
+		/// </summary>
+		/// <param name="unLayerID"> ID of the layer. </param>
+		void MarkCachedLayerDirty(unsigned int unLayerID);
+
+		/// <summary>
+		/// Check, if a cached layer must be redrawn.
+		/// </summary>
+		/// <param name="unLayerID"> ID of the layer. </param>
+		/// <returns> True, if the layer is dirty. </returns>
+		bool IsCachedLayerDirty(unsigned int unLayerID) const;
+
+		/// <summary>
+		/// Start recording a cached layer, if it is dirty.
+		/// The following draws go into the layer until EndCachedLayer is called.
+		/// </summary>
+		/// <param name="unLayerID"> ID of the layer. </param>
+		/// <returns> True, if the layer is recording and its contents must be drawn, followed by EndCachedLayer. </returns>
+		bool BeginCachedLayer(unsigned int unLayerID);
+
+		/// <summary>
+		/// Finish recording the current cached layer and draw to the screen again.
+		/// </summary>
+		void EndCachedLayer();
+
+		/// <summary>
+		/// Composite a cached layer over the screen with a single quad.
+		/// </summary>
+		/// <param name="unLayerID"> ID of the layer. </param>
+		/// <param name="color"> Tint color. </param>
+		void DrawCachedLayer(unsigned int unLayerID, const SDL_Color& color = { 255, 255, 255, 255 });
+
 	private:
+		/// <summary>
+		/// A cached layer and its offscreen target.
+		/// </summary>
+		struct SCachedLayer
+		{
+			/// <summary>
+			/// Target with the recorded draws. nullptr, if the layer was destroyed.
+			/// </summary>
+			std::unique_ptr<RenderTarget> m_ptrTarget;
+
+			/// <summary>
+			/// True, if the layer must be redrawn.
+			/// </summary>
+			bool m_bDirty = true;
+
+			/// <summary>
+			/// Incremented on every redraw, so damage tracking sees the new contents.
+			/// </summary>
+			uint32_t m_unVersion = 0;
+		};
+
 		Renderer2D();
 		virtual ~Renderer2D() = default;
 
@@ -197,6 +624,154 @@ namespace K9
 		/// <returns> True, if the resources were loaded successfully. </returns>
 		bool LoadResources();
 
+		/// <summary>
+		/// Upload m_frameData to the uniform buffer.
+		/// </summary>
+		void UploadFrameData();
+
+		/// <summary>
+		/// Reset the blend state, the statistics and the frame data, and prepare the sprite batch.
+		/// Called at the start of a frame on the thread, which draws.
+		/// </summary>
+		void BeginSubmission();
+
+		/// <summary>
+		/// Draw the remaining sprites, publish the statistics and swap the buffers.
+		/// Called at the end of a frame on the thread, which draws.
+		/// </summary>
+		void EndSubmission();
+
+		/// <summary>
+		/// Read the back buffer of the window and save it as a BMP file.
+		/// </summary>
+		/// <param name="strPath"> Path of the BMP file. </param>
+		/// <returns> True, if the file was written. </returns>
+		bool SaveBackBuffer(const std::string& strPath);
+
+		/// <summary>
+		/// Draw all sprites, gathered since the last flush, on the thread, which draws.
+		/// </summary>
+		void FlushSprites();
+
+		/// <summary>
+		/// Poll the shaders, submitted by LoadResources, and finish the ones the driver is done with.
+		/// A failed batch shader falls back to immediate mode.
+		/// </summary>
+		/// <param name="bWait"> True, to wait for all of them. </param>
+		void UpdatePendingShaders(bool bWait);
+
+		/// <summary>
+		/// Body of the render thread: draws frame packets, until the queue is stopped.
+		/// </summary>
+		void RenderThreadMain();
+
+		/// <summary>
+		/// Draw and swap a frame packet on the render thread.
+		/// </summary>
+		/// <param name="packet"> Packet to be drawn. </param>
+		void RenderFramePacket(SFramePacket& packet);
+
+		/// <summary>
+		/// Wait for the next frame packet and start recording into it.
+		/// </summary>
+		void BeginFramePacket();
+
+		/// <summary>
+		/// Hand the recorded frame packet to the render thread.
+		/// </summary>
+		void EndFramePacket();
+
+		/// <summary>
+		/// Keep a texture alive, until the frame packet, which is being recorded, is drawn.
+		/// </summary>
+		/// <param name="ptrTexture"> Texture to be kept. </param>
+		void RetainTexture(const std::shared_ptr<Texture>& ptrTexture);
+
+		/// <summary>
+		/// Set the blend equation and functions of a blend mode.
+		/// </summary>
+		/// <param name="eBlendMode"> Blend mode to be set. </param>
+		void SetBlendMode(EBlendMode eBlendMode);
+
+		/// <summary>
+		/// Retrieve a live cached layer.
+		/// </summary>
+		/// <param name="unLayerID"> ID of the layer. </param>
+		/// <returns> The layer or nullptr, if the ID doesn't refer to a live layer. </returns>
+		SCachedLayer* GetCachedLayer(unsigned int unLayerID);
+		const SCachedLayer* GetCachedLayer(unsigned int unLayerID) const;
+
+		/// <summary>
+		/// Destroy all cached layers and their pooled targets.
+		/// </summary>
+		void DestroyCachedLayers();
+
+		/// <summary>
+		/// Check, if screen sprites must be recorded for damage tracking instead of drawn.
+		/// </summary>
+		/// <returns> True, if damage tracking is enabled, no cached layer is recording and the frame isn't resolved yet. </returns>
+		bool IsRecordingFrame() const;
+
+		/// <summary>
+		/// Record a screen sprite for damage tracking.
+		/// </summary>
+		/// <param name="command"> The sprite. </param>
+		/// <param name="eBlendMode"> Blend mode of the sprite. </param>
+		/// <param name="unContentVersion"> Version of the texture contents, which aren't covered by Texture::GetContentVersion, e.g. of a cached layer. </param>
+		/// <param name="bSorted"> True, if the sprite is sorted on replay. </param>
+		void RecordFrameCommand(const SSpriteCommand& command, EBlendMode eBlendMode, uint32_t unContentVersion, bool bSorted);
+
+		/// <summary>
+		/// Redraw the damaged regions of the scene target and copy it to the screen. Done once per frame.
+		/// </summary>
+		void ResolveDamage();
+
+		/// <summary>
+		/// Draw a range of recorded sprites with the state they were recorded with.
+		/// </summary>
+		/// <param name="vecFrameCommands"> The recorded sprites. </param>
+		/// <param name="unBegin"> Index of the first sprite. </param>
+		/// <param name="unEnd"> Index after the last sprite. </param>
+		/// <param name="ptrClipRect"> Only sprites, which overlap this rect, are drawn. nullptr to draw all. </param>
+		void ReplayFrameCommands(const std::vector<SFrameCommand>& vecFrameCommands, size_t unBegin, size_t unEnd,
+			const SDL_Rect* ptrClipRect);
+
+		/// <summary>
+		/// Send a visible sprite to the queue, the batch or OpenGL, depending on the render mode.
+		/// </summary>
+		/// <param name="command"> The sprite and its shader. </param>
+		/// <param name="unLayer"> Sort layer of the sprite. </param>
+		/// <param name="unDepth"> Sort depth of the sprite. </param>
+		/// <param name="bSorted"> True, to queue the sprite for sorting. </param>
+		void SubmitSprite(const SSpriteCommand& command, unsigned int unLayer, unsigned int unDepth, bool bSorted);
+
+		/// <summary>
+		/// Sort the render queue and submit it to the sprite batch.
+		/// </summary>
+		void SubmitRenderQueue();
+
+		/// <summary>
+		/// Submit the sprites of m_vecBulkCommands in one go and clear it.
+		/// The batch writes their vertices on the worker threads.
+		/// </summary>
+		void SubmitBulkCommands();
+
+		/// <summary>
+		/// Draw a textured quad with the current render mode.
+		/// </summary>
+		/// <param name="texture"> Texture of the quad. </param>
+		/// <param name="destRect"> Destination rect in screen space. </param>
+		/// <param name="minUV"> Normalized min UV texture coordinate. </param>
+		/// <param name="maxUV"> Normalized max UV texture coordinate. </param>
+		/// <param name="color"> Tint color. </param>
+		/// <param name="flipFormat"> Flip format. </param>
+		/// <param name="fAngle"> Rotation in degrees, clockwise on screen. </param>
+		/// <param name="origin"> Rotation origin, relative to the top-left of destRect. </param>
+		void DrawSprite(const Texture& texture, const SDL_Rect& destRect,
+			const glm::vec2& minUV, const glm::vec2& maxUV,
+			const SDL_Color& color, SDL_RendererFlip flipFormat,
+			float fAngle = 0.0f, const glm::vec2& origin = { 0.0f, 0.0f });
+
 	private:
 		/// <summary>
 		/// Main rendering window.
@@ -213,6 +788,11 @@ namespace K9
 		/// </summary>
 		SDL_Rect m_screenSize;
 
+		/// <summary>
+		/// Visible area in screen space, used to cull sprites.
+		/// </summary>
+		SDL_Rect m_viewportRect;
+
 		/// <summary>
 		/// Background color.
 		/// </summary>
@@ -224,13 +804,218 @@ namespace K9
 		glm::mat4 m_projectionMatrix;
 
 		/// <summary>
-		/// Shader class, used to draw a texture.
+		/// Variants of the shader, used to draw a texture.
+		/// </summary>
+		std::unique_ptr<ShaderVariants> m_ptrShader;
+
+		/// <summary>
+		/// Keyword bit of the variant of m_ptrShader, which tints the texture.
 		/// </summary>
-		std::unique_ptr<Shader> m_ptrShader;
+		uint32_t m_unTintMask;
 
 		/// <summary>
 		/// Texture geometry.
 		/// </summary>
 		std::unique_ptr<VertexArray> m_ptrVertexArray;
+
+		/// <summary>
+		/// Gathers sprites in ERenderMode::eBatched and ERenderMode::eInstanced.
+		/// </summary>
+		std::unique_ptr<ISpriteBatch> m_ptrSpriteBatch;
+
+		/// <summary>
+		/// How sprites are submitted to OpenGL.
+		/// </summary>
+		ERenderMode m_eRenderMode;
+
+		/// <summary>
+		/// Sorts sprites before they're submitted to m_ptrSpriteBatch.
+		/// </summary>
+		RenderQueue m_renderQueue;
+
+		/// <summary>
+		/// True, if sprites are sorted before submission.
+		/// </summary>
+		bool m_bSortingEnabled;
+
+		/// <summary>
+		/// True, if sprites outside of m_viewportRect are skipped.
+		/// </summary>
+		bool m_bCullingEnabled;
+
+		/// <summary>
+		/// Layer of the following sprites.
+		/// </summary>
+		unsigned int m_unLayer;
+
+		/// <summary>
+		/// Depth of the following sprites.
+		/// </summary>
+		unsigned int m_unDepth;
+
+		/// <summary>
+		/// Shader of the following sprites. nullptr for the default sprite shader.
+		/// </summary>
+		Shader* m_ptrSpriteShader;
+
+		/// <summary>
+		/// Statistics of the current frame.
+		/// </summary>
+		SStats m_currStats;
+
+		/// <summary>
+		/// Statistics of the last finished frame.
+		/// </summary>
+		SStats m_stats;
+
+		/// <summary>
+		/// Per-frame data, uploaded to m_ptrFrameDataBuffer.
+		/// </summary>
+		SFrameData m_frameData;
+
+		/// <summary>
+		/// Uniform buffer, which holds m_frameData.
+		/// </summary>
+		std::unique_ptr<UniformBuffer> m_ptrFrameDataBuffer;
+
+		/// <summary>
+		/// Cached layers by their ID.
+		/// </summary>
+		std::vector<SCachedLayer> m_vecCachedLayers;
+
+		/// <summary>
+		/// Targets of destroyed cached layers, reused by new ones.
+		/// </summary>
+		std::vector<std::unique_ptr<RenderTarget>> m_vecCachedLayerTargetPool;
+
+		/// <summary>
+		/// ID of the cached layer, which is recording, or INVALID_CACHED_LAYER.
+		/// </summary>
+		unsigned int m_unRecordingCachedLayerID;
+
+		/// <summary>
+		/// True, if screen sprites are recorded and only damaged regions are redrawn.
+		/// </summary>
+		bool m_bDamageTrackingEnabled;
+
+		/// <summary>
+		/// True, if the damage of the current frame was already redrawn.
+		/// </summary>
+		bool m_bFrameResolved;
+
+		/// <summary>
+		/// Compares the recorded sprites of consecutive frames.
+		/// </summary>
+		DamageTracker m_damageTracker;
+
+		/// <summary>
+		/// Recorded screen sprites of the current frame.
+		/// </summary>
+		std::vector<SFrameCommand> m_vecFrameCommands;
+
+		/// <summary>
+		/// Persistent target, which keeps the screen contents between frames with damage tracking.
+		/// </summary>
+		std::unique_ptr<RenderTarget> m_ptrSceneTarget;
+
+		/// <summary>
+		/// Guards m_stats, which is written by the render thread.
+		/// </summary>
+		mutable std::mutex m_statsMutex;
+
+		/// <summary>
+		/// Frame packets, in flight between the main thread and the render thread. nullptr without the render thread.
+		/// </summary>
+		std::unique_ptr<FramePacketQueue> m_ptrPacketQueue;
+
+		/// <summary>
+		/// Packet, which is being recorded by the main thread, or nullptr.
+		/// </summary>
+		SFramePacket* m_ptrRecordingPacket;
+
+		/// <summary>
+		/// Draws the frame packets.
+		/// </summary>
+		std::thread m_renderThread;
+
+		/// <summary>
+		/// Context of the main thread, shared with m_ptrContext, while the render thread runs.
+		/// </summary>
+		SDL_GLContext m_ptrResourceContext;
+
+		/// <summary>
+		/// True, if ImGUI platform windows were enabled before the render thread was started.
+		/// </summary>
+		bool m_bRestoreImGUIViewports;
+
+		/// <summary>
+		/// Duration of the last frame of the render thread in milliseconds.
+		/// </summary>
+		std::atomic<float> m_fRenderFrameTimeMS;
+
+		/// <summary>
+		/// True, if the packet handoff is checked.
+		/// </summary>
+		bool m_bPacketHandoffCheckEnabled;
+
+		/// <summary>
+		/// Number of packet waits, which took longer than a frame.
+		/// </summary>
+		unsigned int m_unPacketHandoffViolationCount;
+
+		/// <summary>
+		/// Recorders, created by CreateCommandRecorder.
+		/// </summary>
+		std::vector<std::unique_ptr<CommandRecorder>> m_vecCommandRecorders;
+
+		/// <summary>
+		/// Sprites of all recorders, merged for sorting.
+		/// </summary>
+		RenderQueue m_mergedQueue;
+
+		/// <summary>
+		/// Unsorted sprites, gathered to be submitted in one go.
+		/// </summary>
+		std::vector<const SSpriteCommand*> m_vecBulkCommands;
+
+		/// <summary>
+		/// Worker threads, used to write sprite vertices.
+		/// </summary>
+		ThreadPool m_threadPool;
+
+		/// <summary>
+		/// Measures the GPU time of the passes.
+		/// </summary>
+		GPUProfiler m_gpuProfiler;
+
+		/// <summary>
+		/// Loads textures in the background.
+		/// </summary>
+		TextureStreamer m_textureStreamer;
+
+		/// <summary>
+		/// True, if there is no visible window.
+		/// </summary>
+		bool m_bHeadless;
+
+		/// <summary>
+		/// Path, the next frame is saved to. Empty, if no capture is requested.
+		/// </summary>
+		std::string m_strCapturePath;
+
+		/// <summary>
+		/// True, if LoadResources only submits the shaders.
+		/// </summary>
+		bool m_bAsyncShaderLoading;
+
+		/// <summary>
+		/// Shaders of LoadResources, which are still compiling.
+		/// </summary>
+		std::vector<ShaderVariants*> m_vecPendingShaders;
+
+		/// <summary>
+		/// Performance counter, when the pending shaders were submitted.
+		/// </summary>
+		Uint64 m_unShaderLoadStart;
 	};
 }
\ No newline at end of file
@@ -1,43 +1,196 @@
 #include "Shader.h"
 #include "Texture.h"
+#include "Affine2D.h"
+#include <algorithm>
+#include <cstring>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <glm/gtc/type_ptr.hpp>
+#include <SDL.h>
 #include <glad/glad.h>
+#include "GLStateCache.h"
+#include "ProgramBinaryCache.h"
+
+/* GL_KHR_parallel_shader_compile isn't part of the generated loader */
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+typedef void (APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
 
 namespace K9
 {
+	/* True, if a uniform of type eActual can be set with the setter for eExpected. */
+	static bool IsUniformTypeCompatible(GLenum eExpected, GLenum eActual)
+	{
+		if (eExpected == eActual)
+		{
+			return true;
+		}
+		if (eExpected != GL_INT)
+		{
+			return false;
+		}
+
+		/* Booleans and samplers are set as integers. */
+		switch (eActual)
+		{
+		case GL_BOOL:
+		case GL_SAMPLER_1D:
+		case GL_SAMPLER_2D:
+		case GL_SAMPLER_3D:
+		case GL_SAMPLER_CUBE:
+		case GL_SAMPLER_2D_SHADOW:
+		case GL_SAMPLER_1D_ARRAY:
+		case GL_SAMPLER_2D_ARRAY:
+		case GL_SAMPLER_2D_RECT:
+		case GL_SAMPLER_BUFFER:
+		case GL_SAMPLER_2D_MULTISAMPLE:
+		case GL_INT_SAMPLER_2D:
+		case GL_INT_SAMPLER_2D_ARRAY:
+		case GL_UNSIGNED_INT_SAMPLER_2D:
+		case GL_UNSIGNED_INT_SAMPLER_2D_ARRAY:
+			return true;
+		default:
+			return false;
+		}
+	}
+
 	Shader::Shader()
-		: m_unShaderProgramID(0),
-		m_unVertexShaderID(0),
-		m_unFragShaderID(0)
+		: m_unVertexShaderID(0),
+		m_unFragShaderID(0),
+		m_unShaderProgramID(0),
+		m_vecUniforms{},
+		m_vecUniformBlocks{},
+		m_vecReportedUniforms{},
+		m_bFromBinaryCache(false),
+		m_eStatus(EStatus::eUnloaded),
+		m_strVertexName{},
+		m_strFragName{},
+		m_unSourceHash(0)
 	{
 
 	}
 
 	bool Shader::Load(const std::string& strVertexName, const std::string& strFragmentName)
 	{
-		/* Compile vertex and pixel shaders */
-		if (!CompileShader(strVertexName, GL_VERTEX_SHADER, m_unVertexShaderID) ||
-			!CompileShader(strFragmentName, GL_FRAGMENT_SHADER, m_unFragShaderID))
+		/* Submit and wait for the driver right away */
+		if (!LoadAsync(strVertexName, strFragmentName))
 		{
 			return false;
 		}
+		return FinishLoad() == EStatus::eReady;
+	}
 
-		/* Now create a shader program that
-		 * links together the vertex/frag shaders */
+	bool Shader::LoadAsync(const std::string& strVertexName, const std::string& strFragmentName)
+	{
+		/* Read the sources first, they're the key of the binary cache */
+		std::string strVertexSource;
+		std::string strFragmentSource;
+		if (!ReadShaderFile(strVertexName, strVertexSource) || !ReadShaderFile(strFragmentName, strFragmentSource))
+		{
+			m_eStatus = EStatus::eFailed;
+			return false;
+		}
+		return LoadSourcesAsync(strVertexSource, strFragmentSource, strVertexName, strFragmentName);
+	}
+
+	bool Shader::LoadSources(const std::string& strVertexSource, const std::string& strFragmentSource,
+		const std::string& strVertexName, const std::string& strFragmentName)
+	{
+		/* Submit and wait for the driver right away */
+		if (!LoadSourcesAsync(strVertexSource, strFragmentSource, strVertexName, strFragmentName))
+		{
+			return false;
+		}
+		return FinishLoad() == EStatus::eReady;
+	}
+
+	bool Shader::LoadSourcesAsync(const std::string& strVertexSource, const std::string& strFragmentSource,
+		const std::string& strVertexName, const std::string& strFragmentName)
+	{
+		m_strVertexName = strVertexName;
+		m_strFragName = strFragmentName;
+
+		/* Restore the linked program from the binary cache, if a previous run stored it */
+		ProgramBinaryCache& binaryCache = ProgramBinaryCache::Ref();
+		m_unSourceHash = ProgramBinaryCache::HashSources(strVertexSource, strFragmentSource);
 		m_unShaderProgramID = glCreateProgram();
-		glAttachShader(m_unShaderProgramID, m_unVertexShaderID);
-		glAttachShader(m_unShaderProgramID, m_unFragShaderID);
-		glLinkProgram(m_unShaderProgramID);
+		m_bFromBinaryCache = binaryCache.Load(m_unSourceHash, m_unShaderProgramID);
+		if (!m_bFromBinaryCache)
+		{
+			/* Start over with a fresh program, a rejected binary may leave state behind */
+			glDeleteProgram(m_unShaderProgramID);
+
+			/* Compile vertex and pixel shaders. Their status is checked by FinishLoad,
+			 * since asking for it now would wait for the driver */
+			CompileShader(strVertexSource, GL_VERTEX_SHADER, m_unVertexShaderID);
+			CompileShader(strFragmentSource, GL_FRAGMENT_SHADER, m_unFragShaderID);
+
+			/* Now create a shader program that
+			 * links together the vertex/frag shaders */
+			m_unShaderProgramID = glCreateProgram();
+			binaryCache.PrepareForStore(m_unShaderProgramID);
+			glAttachShader(m_unShaderProgramID, m_unVertexShaderID);
+			glAttachShader(m_unShaderProgramID, m_unFragShaderID);
+			glLinkProgram(m_unShaderProgramID);
+		}
+
+		m_eStatus = EStatus::eCompiling;
+		return true;
+	}
+
+	Shader::EStatus Shader::Poll()
+	{
+		if (m_eStatus != EStatus::eCompiling)
+		{
+			return m_eStatus;
+		}
+
+		/* The link status includes the compile status of the attached shaders */
+		if (!m_bFromBinaryCache && IsParallelCompileEnabled())
+		{
+			GLint nCompleted = GL_FALSE;
+			glGetProgramiv(m_unShaderProgramID, GL_COMPLETION_STATUS_KHR, &nCompleted);
+			if (nCompleted == GL_FALSE)
+			{
+				return m_eStatus;
+			}
+		}
+		return FinishLoad();
+	}
+
+	Shader::EStatus Shader::Wait()
+	{
+		return FinishLoad();
+	}
 
-		/* Verify that the program linked successfully */
-		if (!IsValidProgram())
+	bool Shader::EnableParallelCompile()
+	{
+		IsParallelCompileEnabled() = false;
+
+		/* The ARB extension has the same token and an entry point with another suffix */
+		const char* cstrFunction = nullptr;
+		if (SDL_GL_ExtensionSupported("GL_KHR_parallel_shader_compile") == SDL_TRUE)
+		{
+			cstrFunction = "glMaxShaderCompilerThreadsKHR";
+		}
+		else if (SDL_GL_ExtensionSupported("GL_ARB_parallel_shader_compile") == SDL_TRUE)
+		{
+			cstrFunction = "glMaxShaderCompilerThreadsARB";
+		}
+		else
 		{
 			return false;
 		}
 
+		/* Some drivers only compile in parallel, once the thread count is set. 0xFFFFFFFF lets them choose */
+		if (auto ptrMaxShaderCompilerThreads = reinterpret_cast<PFNGLMAXSHADERCOMPILERTHREADSKHRPROC>(
+			SDL_GL_GetProcAddress(cstrFunction)))
+		{
+			ptrMaxShaderCompilerThreads(0xFFFFFFFFu);
+		}
+		IsParallelCompileEnabled() = true;
 		return true;
 	}
 
@@ -45,99 +198,343 @@ namespace K9
 	{
 		/* Delete the program/shaders */
 		glDeleteProgram(m_unShaderProgramID);
+		GLStateCache::Ref().OnProgramDeleted(m_unShaderProgramID);
 		glDeleteShader(m_unVertexShaderID);
 		glDeleteShader(m_unFragShaderID);
+		m_unShaderProgramID = 0;
+		m_unVertexShaderID = 0;
+		m_unFragShaderID = 0;
+		m_bFromBinaryCache = false;
+		m_eStatus = EStatus::eUnloaded;
+		m_vecUniforms.clear();
+		m_vecUniformBlocks.clear();
+		m_vecReportedUniforms.clear();
 	}
 
 	void Shader::SetActive()
 	{
 		/* Set this program as the active one */
-		glUseProgram(m_unShaderProgramID);
+		GLStateCache::Ref().UseProgram(m_unShaderProgramID);
 	}
 
-	void Shader::SetMatrixUniform(const char* cstrName, const glm::mat4& mat4Value)
+	void Shader::SetMatrixUniform(UniformID id, const glm::mat4& mat4Value)
 	{
 		/* Find the uniform by this name */
-		GLuint loc = glGetUniformLocation(m_unShaderProgramID, cstrName);
-		/* Send the matrix data to the uniform */
-		glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(mat4Value));
+		if (const SUniformInfo* ptrUniform = FindUniform(id, GL_FLOAT_MAT4))
+		{
+			/* Send the matrix data to the uniform */
+			glUniformMatrix4fv(ptrUniform->m_nLocation, 1, GL_FALSE, glm::value_ptr(mat4Value));
+		}
 	}
 
-	void Shader::SetMatrixUniforms(const char* cstrName, glm::mat4* arrMatrices, unsigned int unMatrixCount)
+	void Shader::SetAffineUniform(UniformID id, const SAffine2D& affine)
 	{
 		/* Find the uniform by this name */
-		GLuint loc = glGetUniformLocation(m_unShaderProgramID, cstrName);
-		glUniformMatrix4fv(loc, unMatrixCount, GL_FALSE, glm::value_ptr(arrMatrices[0]));
+		const SUniformInfo* ptrUniform = FindUniform(id, GL_FLOAT_MAT3x2);
+		if (!ptrUniform)
+		{
+			return;
+		}
+
+		/* mat3x2 is column-major: the columns are the linear part and the translation */
+		const float arrValues[6] =
+		{
+			affine.m_row0.x, affine.m_row1.x,
+			affine.m_row0.y, affine.m_row1.y,
+			affine.m_row0.z, affine.m_row1.z
+		};
+		glUniformMatrix3x2fv(ptrUniform->m_nLocation, 1, GL_FALSE, arrValues);
 	}
 
-	void Shader::SetVectorUniform(const char* cstrName, const glm::vec4& vec4DValue)
+	void Shader::SetMatrixUniforms(UniformID id, glm::mat4* arrMatrices, unsigned int unMatrixCount)
 	{
-		GLuint loc = glGetUniformLocation(m_unShaderProgramID, cstrName);
-		/* Send the vector data */
-		glUniform4fv(loc, 1, glm::value_ptr(vec4DValue));
+		/* Find the uniform by this name */
+		if (const SUniformInfo* ptrUniform = FindUniform(id, GL_FLOAT_MAT4, unMatrixCount))
+		{
+			glUniformMatrix4fv(ptrUniform->m_nLocation, unMatrixCount, GL_FALSE, glm::value_ptr(arrMatrices[0]));
+		}
 	}
 
-	void Shader::SetVectorUniform(const char* cstrName, const glm::vec3& vec3DValue)
+	void Shader::SetVectorUniform(UniformID id, const glm::vec4& vec4DValue)
 	{
-		GLuint loc = glGetUniformLocation(m_unShaderProgramID, cstrName);
-		/* Send the vector data */
-		glUniform3fv(loc, 1, glm::value_ptr(vec3DValue));
+		if (const SUniformInfo* ptrUniform = FindUniform(id, GL_FLOAT_VEC4))
+		{
+			/* Send the vector data */
+			glUniform4fv(ptrUniform->m_nLocation, 1, glm::value_ptr(vec4DValue));
+		}
 	}
 
-	void Shader::SetVector2DUniform(const char* cstrName, const glm::vec2& vec2DValue)
+	void Shader::SetVectorUniform(UniformID id, const glm::vec3& vec3DValue)
 	{
-		GLuint loc = glGetUniformLocation(m_unShaderProgramID, cstrName);
-		/* Send the vector data */
-		glUniform2fv(loc, 1, glm::value_ptr(vec2DValue));
+		if (const SUniformInfo* ptrUniform = FindUniform(id, GL_FLOAT_VEC3))
+		{
+			/* Send the vector data */
+			glUniform3fv(ptrUniform->m_nLocation, 1, glm::value_ptr(vec3DValue));
+		}
 	}
 
-	void Shader::SetFloatUniform(const char* cstrName, float fValue)
+	void Shader::SetVector2DUniform(UniformID id, const glm::vec2& vec2DValue)
 	{
-		GLuint loc = glGetUniformLocation(m_unShaderProgramID, cstrName);
-		/* Send the float data */
-		glUniform1f(loc, fValue);
+		if (const SUniformInfo* ptrUniform = FindUniform(id, GL_FLOAT_VEC2))
+		{
+			/* Send the vector data */
+			glUniform2fv(ptrUniform->m_nLocation, 1, glm::value_ptr(vec2DValue));
+		}
 	}
 
-	void Shader::SetIntUniform(const char* cstrName, int nValue)
+	void Shader::SetFloatUniform(UniformID id, float fValue)
 	{
-		GLuint loc = glGetUniformLocation(m_unShaderProgramID, cstrName);
-		/* Send the integer data */
-		glUniform1i(loc, nValue);
+		if (const SUniformInfo* ptrUniform = FindUniform(id, GL_FLOAT))
+		{
+			/* Send the float data */
+			glUniform1f(ptrUniform->m_nLocation, fValue);
+		}
 	}
 
-	bool Shader::CompileShader(const std::string& strFileName, GLenum eShaderType, GLuint& nOutShader)
+	void Shader::SetIntUniform(UniformID id, int nValue)
 	{
-		/* Open file */
-		std::ifstream shaderFile(strFileName);
-		if (shaderFile.is_open())
+		if (const SUniformInfo* ptrUniform = FindUniform(id, GL_INT))
 		{
-			/* Read all the text into a string */
-			std::stringstream strStream;
-			strStream << shaderFile.rdbuf();
-			std::string strContents = strStream.str();
-			const char* cstrContents = strContents.c_str();
+			/* Send the integer data */
+			glUniform1i(ptrUniform->m_nLocation, nValue);
+		}
+	}
+
+	void Shader::SetIntUniforms(UniformID id, const int* arrValues, unsigned int unValueCount)
+	{
+		if (const SUniformInfo* ptrUniform = FindUniform(id, GL_INT, unValueCount))
+		{
+			/* Send the integer array data */
+			glUniform1iv(ptrUniform->m_nLocation, unValueCount, arrValues);
+		}
+	}
 
-			/* Create a shader of the specified type */
-			nOutShader = glCreateShader(eShaderType);
-			/* Set the source characters and try to compile */
-			glShaderSource(nOutShader, 1, &(cstrContents), nullptr);
-			glCompileShader(nOutShader);
+	int Shader::GetUniformLocation(UniformID id) const
+	{
+		auto it = std::lower_bound(m_vecUniforms.begin(), m_vecUniforms.end(), id.m_unHash,
+			[](const SUniformInfo& uniform, uint32_t unHash) { return uniform.m_unHash < unHash; });
+		return it != m_vecUniforms.end() && it->m_unHash == id.m_unHash ? it->m_nLocation : -1;
+	}
 
-			if (!IsCompiled(nOutShader))
+	bool Shader::BindUniformBlock(UniformID blockID, unsigned int unBindingPoint)
+	{
+		auto it = std::lower_bound(m_vecUniformBlocks.begin(), m_vecUniformBlocks.end(), blockID.m_unHash,
+			[](const SUniformBlockInfo& block, uint32_t unHash) { return block.m_unHash < unHash; });
+		if (it == m_vecUniformBlocks.end() || it->m_unHash != blockID.m_unHash || it->m_strName != blockID.m_cstrName)
+		{
+			return false;
+		}
+
+		glUniformBlockBinding(m_unShaderProgramID, it->m_unIndex, unBindingPoint);
+		return true;
+	}
+
+	void Shader::RegisterUniformBlock(const std::string& strBlockName, unsigned int unBindingPoint)
+	{
+		auto& vecBlocks = GetRegisteredUniformBlocks();
+		for (auto& block : vecBlocks)
+		{
+			if (block.first == strBlockName)
 			{
-				std::cerr << "Failed to compile shader " << strFileName;
-				return false;
+				block.second = unBindingPoint;
+				return;
 			}
 		}
-		else
+		vecBlocks.emplace_back(strBlockName, unBindingPoint);
+	}
+
+	std::vector<std::pair<std::string, unsigned int>>& Shader::GetRegisteredUniformBlocks()
+	{
+		static std::vector<std::pair<std::string, unsigned int>> vecBlocks;
+		return vecBlocks;
+	}
+
+	void Shader::ReflectProgram()
+	{
+		m_vecUniforms.clear();
+		m_vecUniformBlocks.clear();
+		m_vecReportedUniforms.clear();
+
+		GLint nMaxNameLength = 0;
+		glGetProgramiv(m_unShaderProgramID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &nMaxNameLength);
+		GLint nBlockMaxNameLength = 0;
+		glGetProgramiv(m_unShaderProgramID, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &nBlockMaxNameLength);
+		std::vector<char> vecName(static_cast<size_t>(std::max(std::max(nMaxNameLength, nBlockMaxNameLength), 1)));
+
+		GLint nUniformCount = 0;
+		glGetProgramiv(m_unShaderProgramID, GL_ACTIVE_UNIFORMS, &nUniformCount);
+		for (GLint nIndex = 0; nIndex < nUniformCount; ++nIndex)
+		{
+			GLsizei nLength = 0;
+			GLint nArraySize = 0;
+			GLenum eType = 0;
+			glGetActiveUniform(m_unShaderProgramID, static_cast<GLuint>(nIndex), static_cast<GLsizei>(vecName.size()),
+				&nLength, &nArraySize, &eType, vecName.data());
+
+			/* Members of uniform blocks have no location. They're set through their buffer */
+			GLint nLocation = glGetUniformLocation(m_unShaderProgramID, vecName.data());
+			if (nLocation == -1)
+			{
+				continue;
+			}
+
+			/* Arrays are reported as name[0], but looked up without the index */
+			std::string strName(vecName.data(), static_cast<size_t>(nLength));
+			if (strName.size() > 3 && strName.compare(strName.size() - 3, 3, "[0]") == 0)
+			{
+				strName.resize(strName.size() - 3);
+			}
+			m_vecUniforms.push_back({ UniformID::Hash(strName.c_str()), nLocation, eType, nArraySize, strName });
+		}
+
+		GLint nBlockCount = 0;
+		glGetProgramiv(m_unShaderProgramID, GL_ACTIVE_UNIFORM_BLOCKS, &nBlockCount);
+		for (GLint nIndex = 0; nIndex < nBlockCount; ++nIndex)
+		{
+			GLsizei nLength = 0;
+			glGetActiveUniformBlockName(m_unShaderProgramID, static_cast<GLuint>(nIndex), static_cast<GLsizei>(vecName.size()),
+				&nLength, vecName.data());
+			std::string strName(vecName.data(), static_cast<size_t>(nLength));
+			m_vecUniformBlocks.push_back({ UniformID::Hash(strName.c_str()), static_cast<GLuint>(nIndex), strName });
+		}
+
+		std::sort(m_vecUniforms.begin(), m_vecUniforms.end(),
+			[](const SUniformInfo& lhs, const SUniformInfo& rhs) { return lhs.m_unHash < rhs.m_unHash; });
+		std::sort(m_vecUniformBlocks.begin(), m_vecUniformBlocks.end(),
+			[](const SUniformBlockInfo& lhs, const SUniformBlockInfo& rhs) { return lhs.m_unHash < rhs.m_unHash; });
+
+		/* Two names with one hash couldn't be told apart */
+		for (size_t unIndex = 1; unIndex < m_vecUniforms.size(); ++unIndex)
+		{
+			if (m_vecUniforms[unIndex].m_unHash == m_vecUniforms[unIndex - 1].m_unHash)
+			{
+				std::cerr << "Shader::ReflectProgram The uniforms " << m_vecUniforms[unIndex - 1].m_strName << " and "
+					<< m_vecUniforms[unIndex].m_strName << " have the same hash!\n";
+			}
+		}
+	}
+
+	const Shader::SUniformInfo* Shader::FindUniform(UniformID id, GLenum eExpectedType, unsigned int unValueCount)
+	{
+		auto it = std::lower_bound(m_vecUniforms.begin(), m_vecUniforms.end(), id.m_unHash,
+			[](const SUniformInfo& uniform, uint32_t unHash) { return uniform.m_unHash < unHash; });
+		const SUniformInfo* ptrUniform = it != m_vecUniforms.end() && it->m_unHash == id.m_unHash ? &*it : nullptr;
+
+#ifndef NDEBUG
+		if (!ptrUniform)
+		{
+			/* Also happens, if the compiler removed an unused uniform */
+			ReportUniform(id, "isn't an active uniform");
+		}
+		else if (ptrUniform->m_strName != id.m_cstrName)
+		{
+			ReportUniform(id, "has the hash of another uniform");
+			return nullptr;
+		}
+		else if (!IsUniformTypeCompatible(eExpectedType, ptrUniform->m_eType))
+		{
+			ReportUniform(id, "is set with a setter of another type");
+			return nullptr;
+		}
+		else if (unValueCount > static_cast<unsigned int>(ptrUniform->m_nArraySize))
+		{
+			ReportUniform(id, "has fewer elements than set");
+			return nullptr;
+		}
+#endif
+		return ptrUniform;
+	}
+
+	void Shader::ReportUniform(UniformID id, const char* cstrMessage)
+	{
+		if (std::find(m_vecReportedUniforms.begin(), m_vecReportedUniforms.end(), id.m_unHash) != m_vecReportedUniforms.end())
+		{
+			return;
+		}
+		m_vecReportedUniforms.push_back(id.m_unHash);
+		std::cerr << "Shader::FindUniform " << id.m_cstrName << " of program " << m_unShaderProgramID << " " << cstrMessage << "!\n";
+	}
+
+	bool Shader::ReadShaderFile(const std::string& strFileName, std::string& strOutSource)
+	{
+		/* Open file */
+		std::ifstream shaderFile(strFileName);
+		if (!shaderFile.is_open())
 		{
 			std::cerr << "Shader file not found: " << strFileName;
 			return false;
 		}
 
+		/* Read all the text into a string */
+		std::stringstream strStream;
+		strStream << shaderFile.rdbuf();
+		strOutSource = strStream.str();
 		return true;
 	}
 
+	void Shader::CompileShader(const std::string& strSource, GLenum eShaderType, GLuint& nOutShader)
+	{
+		const char* cstrContents = strSource.c_str();
+
+		/* Create a shader of the specified type */
+		nOutShader = glCreateShader(eShaderType);
+		/* Set the source characters and try to compile */
+		glShaderSource(nOutShader, 1, &(cstrContents), nullptr);
+		glCompileShader(nOutShader);
+	}
+
+	Shader::EStatus Shader::FinishLoad()
+	{
+		if (m_eStatus != EStatus::eCompiling)
+		{
+			return m_eStatus;
+		}
+
+		/* A restored program was already checked by the cache */
+		if (!m_bFromBinaryCache)
+		{
+			if (!IsCompiled(m_unVertexShaderID))
+			{
+				std::cerr << "Failed to compile shader " << m_strVertexName;
+				m_eStatus = EStatus::eFailed;
+				return m_eStatus;
+			}
+			if (!IsCompiled(m_unFragShaderID))
+			{
+				std::cerr << "Failed to compile shader " << m_strFragName;
+				m_eStatus = EStatus::eFailed;
+				return m_eStatus;
+			}
+
+			/* Verify that the program linked successfully */
+			if (!IsValidProgram())
+			{
+				m_eStatus = EStatus::eFailed;
+				return m_eStatus;
+			}
+
+			ProgramBinaryCache::Ref().Store(m_unSourceHash, m_unShaderProgramID);
+		}
+
+		/* Look the uniforms up once, so setting them does no string work */
+		ReflectProgram();
+
+		/* Bind the shared uniform blocks, this program declares */
+		for (const auto& block : GetRegisteredUniformBlocks())
+		{
+			BindUniformBlock(UniformID{ block.first.c_str() }, block.second);
+		}
+
+		m_eStatus = EStatus::eReady;
+		return m_eStatus;
+	}
+
+	bool& Shader::IsParallelCompileEnabled()
+	{
+		static bool bEnabled = false;
+		return bEnabled;
+	}
+
 	bool Shader::IsCompiled(GLuint unShaderID)
 	{
 		GLint unStatus;
@@ -1,39 +1,122 @@
 #pragma once
 #include <glm/glm.hpp>
 #include <string>
+#include <utility>
+#include <vector>
+#include "UniformID.h"
 
 using GLenum = unsigned int;
 using GLuint = unsigned int;
 
 namespace K9
 {
+	struct SAffine2D;
+
 	class Shader
 	{
 	public:
+		/* Progress of a program, submitted with LoadAsync */
+		enum class EStatus
+		{
+			eUnloaded,
+			eCompiling,
+			eReady,
+			eFailed
+		};
+
 		Shader();
 		~Shader() = default;
 		/* Load the vertex/fragment shaders with the given names */
 		bool Load(const std::string& strVertexName, const std::string& strFragName);
+		/* Submit the vertex/fragment shaders for compiling and linking without waiting for the driver.
+		 * Returns false, if a file is missing. The program can't be used, until Poll returns eReady */
+		bool LoadAsync(const std::string& strVertexName, const std::string& strFragName);
+		/* Like Load and LoadAsync, but with sources, which are already in memory, e.g. from ShaderVariants.
+		 * The names are only used to report errors */
+		bool LoadSources(const std::string& strVertexSource, const std::string& strFragSource,
+			const std::string& strVertexName, const std::string& strFragName);
+		bool LoadSourcesAsync(const std::string& strVertexSource, const std::string& strFragSource,
+			const std::string& strVertexName, const std::string& strFragName);
+		/* Finish the program, if the driver is done with it. With GL_KHR_parallel_shader_compile this never blocks,
+		 * without it the first call waits for the driver */
+		EStatus Poll();
+		/* Wait for the driver and finish the program */
+		EStatus Wait();
+		/* Retrieve the progress, without asking the driver */
+		EStatus GetStatus() const { return m_eStatus; }
+		/* True, if the program is linked and reflected */
+		bool IsReady() const { return m_eStatus == EStatus::eReady; }
+		/* Let the driver compile on its own threads, if it supports GL_KHR_parallel_shader_compile.
+		 * Call once per context, before loading. Returns true, if Poll won't block */
+		static bool EnableParallelCompile();
 		void Unload();
 		/* Set this as the active shader program */
 		void SetActive();
+		/* Retrieve the OpenGL ID of the shader program */
+		GLuint GetProgramID() const { return m_unShaderProgramID; }
+		/* True, if Load restored the program from the ProgramBinaryCache instead of compiling it */
+		bool IsFromBinaryCache() const { return m_bFromBinaryCache; }
+		/* The setters look the uniform up in the table, reflected by Load, instead of calling glGetUniformLocation.
+		 * Uniforms, which the program doesn't have, are ignored like location -1. Debug builds report them once,
+		 * as well as uniforms of another type. */
 		/* Sets a Matrix uniform */
-		void SetMatrixUniform(const char* cstrName, const glm::mat4& mat4Value);
+		void SetMatrixUniform(UniformID id, const glm::mat4& mat4Value);
+		/* Sets a 2x3 affine transform as a mat3x2 uniform */
+		void SetAffineUniform(UniformID id, const SAffine2D& affine);
 		/* Set an array of matrix uniforms */
-		void SetMatrixUniforms(const char* cstrName, glm::mat4* arrMatrices, unsigned int unMatrixCount);
+		void SetMatrixUniforms(UniformID id, glm::mat4* arrMatrices, unsigned int unMatrixCount);
 		/* Sets a Vector4D uniform */
-		void SetVectorUniform(const char* cstrName, const glm::vec4& vec4DValue);
+		void SetVectorUniform(UniformID id, const glm::vec4& vec4DValue);
 		/* Sets a Vector3D uniform */
-		void SetVectorUniform(const char* cstrName, const glm::vec3& vec3DValue);
+		void SetVectorUniform(UniformID id, const glm::vec3& vec3DValue);
 		/* Sets a Vector2D uniform */
-		void SetVector2DUniform(const char* cstrName, const glm::vec2& vec2DValue);
+		void SetVector2DUniform(UniformID id, const glm::vec2& vec2DValue);
 		/* Sets a float uniform */
-		void SetFloatUniform(const char* cstrName, float fValue);
-		/* Sets an integer uniform */
-		void SetIntUniform(const char* cstrName, int nValue);
+		void SetFloatUniform(UniformID id, float fValue);
+		/* Sets an integer or sampler uniform */
+		void SetIntUniform(UniformID id, int nValue);
+		/* Set an array of integer or sampler uniforms */
+		void SetIntUniforms(UniformID id, const int* arrValues, unsigned int unValueCount);
+		/* Retrieve the location of a uniform. -1, if the program doesn't have it */
+		int GetUniformLocation(UniformID id) const;
+		/* Bind the uniform block to a binding point. Returns false, if the program doesn't have it */
+		bool BindUniformBlock(UniformID blockID, unsigned int unBindingPoint);
+		/* Register a uniform block, which every shader, loaded afterwards, binds automatically, if it declares it */
+		static void RegisterUniformBlock(const std::string& strBlockName, unsigned int unBindingPoint);
+		/* Reads the source of the specified shader */
+		static bool ReadShaderFile(const std::string& strFileName, std::string& strOutSource);
 	private:
-		/* Tries to compile the specified shader */
-		bool CompileShader(const std::string& strFileName, GLenum eShaderType, GLuint& nOutShader);
+		/* An active uniform of the program */
+		struct SUniformInfo
+		{
+			uint32_t m_unHash;
+			int m_nLocation;
+			GLenum m_eType;
+			int m_nArraySize;
+			std::string m_strName;
+		};
+		/* An active uniform block of the program */
+		struct SUniformBlockInfo
+		{
+			uint32_t m_unHash;
+			GLuint m_unIndex;
+			std::string m_strName;
+		};
+
+		/* Walk the active uniforms and uniform blocks of the linked program into the tables, sorted by hash */
+		void ReflectProgram();
+		/* Find the uniform in the table. Debug builds report a missing name, a hash collision or a type mismatch once */
+		const SUniformInfo* FindUniform(UniformID id, GLenum eExpectedType, unsigned int unValueCount = 1);
+		/* Report a mismatch of the uniform once */
+		void ReportUniform(UniformID id, const char* cstrMessage);
+		/* Retrieve the registered uniform blocks and their binding points */
+		static std::vector<std::pair<std::string, unsigned int>>& GetRegisteredUniformBlocks();
+		/* Submits the source of the specified shader for compiling */
+		void CompileShader(const std::string& strSource, GLenum eShaderType, GLuint& nOutShader);
+		/* Checks the submitted shaders and program, stores the binary and reflects the uniforms */
+		EStatus FinishLoad();
+		/* True, if EnableParallelCompile found the extension on the current context */
+		static bool& IsParallelCompileEnabled();
 
 		/* Tests whether shader compiled successfully */
 		bool IsCompiled(GLuint unShaderID);
@@ -44,5 +127,21 @@ namespace K9
 		GLuint m_unVertexShaderID;
 		GLuint m_unFragShaderID;
 		GLuint m_unShaderProgramID;
+
+		/* Reflected uniforms and uniform blocks, sorted by hash */
+		std::vector<SUniformInfo> m_vecUniforms;
+		std::vector<SUniformBlockInfo> m_vecUniformBlocks;
+
+		/* Hashes of the uniforms, which were already reported */
+		std::vector<uint32_t> m_vecReportedUniforms;
+
+		/* True, if the program was restored from the binary cache. It has no shader objects then */
+		bool m_bFromBinaryCache;
+
+		/* Progress of the program and what FinishLoad needs to report and store it */
+		EStatus m_eStatus;
+		std::string m_strVertexName;
+		std::string m_strFragName;
+		uint64_t m_unSourceHash;
 	};
 }
\ No newline at end of file
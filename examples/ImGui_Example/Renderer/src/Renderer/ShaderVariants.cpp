@@ -0,0 +1,189 @@
+#include "ShaderVariants.h"
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+
+namespace K9
+{
+	/* Pragma, which declares the keywords of a source. */
+	static constexpr const char* KEYWORDS_PRAGMA = "k9_keywords";
+
+	ShaderVariants::ShaderVariants()
+		: m_strVertexName{}, m_strFragName{}, m_strVertexSource{}, m_strFragSource{}, m_vecKeywords{}, m_vecVariants{}
+	{
+	}
+
+	bool ShaderVariants::Load(const std::string& strVertexName, const std::string& strFragName)
+	{
+		Unload();
+		if (!Shader::ReadShaderFile(strVertexName, m_strVertexSource) || !Shader::ReadShaderFile(strFragName, m_strFragSource))
+		{
+			return false;
+		}
+		m_strVertexName = strVertexName;
+		m_strFragName = strFragName;
+
+		/* Both stages share the mask, so a keyword, declared by both, is one bit. */
+		ParseKeywords(m_strVertexSource);
+		ParseKeywords(m_strFragSource);
+		if (m_vecKeywords.size() > MAX_KEYWORD_COUNT)
+		{
+			std::cerr << "ShaderVariants::Load " << strVertexName << " and " << strFragName << " declare "
+				<< m_vecKeywords.size() << " keywords, but only " << MAX_KEYWORD_COUNT << " are supported!\n";
+			m_vecKeywords.clear();
+			return false;
+		}
+
+		m_vecVariants.resize(static_cast<size_t>(1) << m_vecKeywords.size());
+		return true;
+	}
+
+	void ShaderVariants::Unload()
+	{
+		for (auto& ptrVariant : m_vecVariants)
+		{
+			if (ptrVariant)
+			{
+				ptrVariant->Unload();
+			}
+		}
+		m_vecVariants.clear();
+		m_vecKeywords.clear();
+		m_strVertexSource.clear();
+		m_strFragSource.clear();
+	}
+
+	uint32_t ShaderVariants::GetKeywordMask(const std::string& strKeyword) const
+	{
+		auto it = std::find(m_vecKeywords.begin(), m_vecKeywords.end(), strKeyword);
+		return it != m_vecKeywords.end() ? 1u << static_cast<uint32_t>(it - m_vecKeywords.begin()) : 0u;
+	}
+
+	Shader* ShaderVariants::Get(uint32_t unMask)
+	{
+		if (m_vecVariants.empty())
+		{
+			return nullptr;
+		}
+
+		unMask &= static_cast<uint32_t>(m_vecVariants.size() - 1);
+		if (!m_vecVariants[unMask])
+		{
+			Submit(unMask);
+		}
+
+		Shader* ptrVariant = m_vecVariants[unMask].get();
+		return ptrVariant->Wait() == Shader::EStatus::eReady ? ptrVariant : nullptr;
+	}
+
+	void ShaderVariants::Prewarm()
+	{
+		for (uint32_t unMask = 0; unMask < m_vecVariants.size(); ++unMask)
+		{
+			if (!m_vecVariants[unMask])
+			{
+				Submit(unMask);
+			}
+		}
+	}
+
+	Shader::EStatus ShaderVariants::Poll()
+	{
+		Shader::EStatus eResult = Shader::EStatus::eReady;
+		for (auto& ptrVariant : m_vecVariants)
+		{
+			if (!ptrVariant)
+			{
+				continue;
+			}
+
+			Shader::EStatus eStatus = ptrVariant->Poll();
+			if (eStatus == Shader::EStatus::eCompiling)
+			{
+				eResult = eStatus;
+			}
+			else if (eStatus == Shader::EStatus::eFailed && eResult != Shader::EStatus::eCompiling)
+			{
+				eResult = eStatus;
+			}
+		}
+		return eResult;
+	}
+
+	Shader::EStatus ShaderVariants::Wait()
+	{
+		Shader::EStatus eResult = Shader::EStatus::eReady;
+		for (auto& ptrVariant : m_vecVariants)
+		{
+			if (ptrVariant && ptrVariant->Wait() == Shader::EStatus::eFailed)
+			{
+				eResult = Shader::EStatus::eFailed;
+			}
+		}
+		return eResult;
+	}
+
+	/* Private methods. */
+	void ShaderVariants::ParseKeywords(const std::string& strSource)
+	{
+		std::istringstream sourceStream(strSource);
+		std::string strLine;
+		while (std::getline(sourceStream, strLine))
+		{
+			std::istringstream lineStream(strLine);
+			std::string strDirective;
+			std::string strPragma;
+			if (!(lineStream >> strDirective >> strPragma) || strDirective != "#pragma" || strPragma != KEYWORDS_PRAGMA)
+			{
+				continue;
+			}
+
+			std::string strKeyword;
+			while (lineStream >> strKeyword)
+			{
+				if (std::find(m_vecKeywords.begin(), m_vecKeywords.end(), strKeyword) == m_vecKeywords.end())
+				{
+					m_vecKeywords.push_back(strKeyword);
+				}
+			}
+		}
+	}
+
+	std::string ShaderVariants::InjectDefines(const std::string& strSource, uint32_t unMask) const
+	{
+		std::string strDefines;
+		for (size_t unBit = 0; unBit < m_vecKeywords.size(); ++unBit)
+		{
+			if ((unMask & (1u << unBit)) != 0)
+			{
+				strDefines += "#define " + m_vecKeywords[unBit] + " 1\n";
+			}
+		}
+
+		/* #version must stay the first directive. Without one, the defines go first. */
+		size_t unInsertAt = 0;
+		size_t unVersion = strSource.find("#version");
+		if (unVersion != std::string::npos)
+		{
+			size_t unLineEnd = strSource.find('\n', unVersion);
+			unInsertAt = unLineEnd != std::string::npos ? unLineEnd + 1 : strSource.size();
+			if (unLineEnd == std::string::npos)
+			{
+				strDefines.insert(0, "\n");
+			}
+		}
+
+		std::string strVariant = strSource;
+		strVariant.insert(unInsertAt, strDefines);
+		return strVariant;
+	}
+
+	void ShaderVariants::Submit(uint32_t unMask)
+	{
+		/* Compile errors are reported, once the variant is finished by Get, Poll or Wait. */
+		std::unique_ptr<Shader>& ptrVariant = m_vecVariants[unMask];
+		ptrVariant.reset(new Shader());
+		ptrVariant->LoadSourcesAsync(InjectDefines(m_strVertexSource, unMask), InjectDefines(m_strFragSource, unMask),
+			m_strVertexName, m_strFragName);
+	}
+}
@@ -0,0 +1,130 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Shader.h"
+
+namespace K9
+{
+	/// <summary>
+	/// Set of programs, compiled from one vertex/fragment pair with different features enabled.
+	/// The sources declare their feature keywords after #version, e.g. "#pragma k9_keywords TINT FLIP".
+	/// GLSL compilers ignore unknown pragmas, so the files still compile on their own.
+	/// Every keyword is a bit of the variant mask, in the order of declaration, vertex shader first.
+	/// A variant is compiled with "#define KEYWORD 1" injected after #version for each of its bits,
+	/// so the sources use #ifdef instead of branches. Variants are compiled lazily by Get or all at once by Prewarm.
+	/// </summary>
+	class ShaderVariants
+	{
+	public:
+		/// <summary>
+		/// Maximum number of keywords. Every combination gets a slot, so the lookup is an index.
+		/// </summary>
+		static constexpr unsigned int MAX_KEYWORD_COUNT{ 8 };
+
+		ShaderVariants();
+		~ShaderVariants() = default;
+
+		/** Delete the copy constructor, move constructor and assignment operators. */
+		ShaderVariants(const ShaderVariants&) = delete;
+		ShaderVariants(ShaderVariants&&) = delete;
+		ShaderVariants& operator=(const ShaderVariants&) = delete;
+		ShaderVariants& operator=(ShaderVariants&) = delete;
+
+		/// <summary>
+		/// Read the sources and their keywords. Nothing is compiled yet.
+		/// </summary>
+		/// <param name="strVertexName"> Path of the vertex shader. </param>
+		/// <param name="strFragName"> Path of the fragment shader. </param>
+		/// <returns> True, if both files were read and declare at most MAX_KEYWORD_COUNT keywords. </returns>
+		bool Load(const std::string& strVertexName, const std::string& strFragName);
+
+		/// <summary>
+		/// Delete all variants.
+		/// </summary>
+		void Unload();
+
+		/// <summary>
+		/// Retrieve the bit of a keyword, to build variant masks once instead of per draw.
+		/// </summary>
+		/// <param name="strKeyword"> Declared keyword. </param>
+		/// <returns> The bit of the keyword. 0, if the sources don't declare it, so it selects nothing. </returns>
+		uint32_t GetKeywordMask(const std::string& strKeyword) const;
+
+		/// <summary>
+		/// Retrieve a variant in O(1). An unloaded variant is compiled now, one, which is still compiling, is waited for.
+		/// </summary>
+		/// <param name="unMask"> Bits of the enabled keywords. Undeclared bits are ignored. </param>
+		/// <returns> The ready variant. nullptr, if it failed to compile. </returns>
+		Shader* Get(uint32_t unMask);
+
+		/// <summary>
+		/// Submit every variant, which isn't loaded yet, without waiting for the driver.
+		/// With GL_KHR_parallel_shader_compile they compile in parallel. Finish them with Poll or Wait.
+		/// </summary>
+		void Prewarm();
+
+		/// <summary>
+		/// Finish the submitted variants, the driver is done with.
+		/// </summary>
+		/// <returns> eCompiling, while any variant compiles, eFailed, if any failed, eReady otherwise. </returns>
+		Shader::EStatus Poll();
+
+		/// <summary>
+		/// Wait for the submitted variants.
+		/// </summary>
+		/// <returns> eFailed, if any failed, eReady otherwise. </returns>
+		Shader::EStatus Wait();
+
+		/// <summary>
+		/// Retrieve the number of declared keywords.
+		/// </summary>
+		/// <returns> Size of m_vecKeywords. </returns>
+		unsigned int GetKeywordCount() const { return static_cast<unsigned int>(m_vecKeywords.size()); }
+
+	private:
+		/// <summary>
+		/// Append the keywords, a source declares, to m_vecKeywords.
+		/// </summary>
+		/// <param name="strSource"> Source of a shader. </param>
+		void ParseKeywords(const std::string& strSource);
+
+		/// <summary>
+		/// Insert the defines of a variant after the #version line.
+		/// </summary>
+		/// <param name="strSource"> Source of a shader. </param>
+		/// <param name="unMask"> Bits of the enabled keywords. </param>
+		/// <returns> The source of the variant. </returns>
+		std::string InjectDefines(const std::string& strSource, uint32_t unMask) const;
+
+		/// <summary>
+		/// Create the variant of a mask and submit it.
+		/// </summary>
+		/// <param name="unMask"> Bits of the enabled keywords. </param>
+		void Submit(uint32_t unMask);
+
+	private:
+		/// <summary>
+		/// Paths of the sources, used to report errors.
+		/// </summary>
+		std::string m_strVertexName;
+		std::string m_strFragName;
+
+		/// <summary>
+		/// Sources, as read from the files.
+		/// </summary>
+		std::string m_strVertexSource;
+		std::string m_strFragSource;
+
+		/// <summary>
+		/// Declared keywords. The index is the bit of the keyword.
+		/// </summary>
+		std::vector<std::string> m_vecKeywords;
+
+		/// <summary>
+		/// Variants, indexed by their mask. nullptr, until a variant is submitted.
+		/// </summary>
+		std::vector<std::unique_ptr<Shader>> m_vecVariants;
+	};
+}
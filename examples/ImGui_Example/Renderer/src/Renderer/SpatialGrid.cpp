@@ -0,0 +1,133 @@
+#include "SpatialGrid.h"
+#include <algorithm>
+#include "RectCuller.h"
+
+namespace K9
+{
+	SpatialGrid::SpatialGrid(int nCellSize)
+		: m_nCellSize{ std::max(1, nCellSize) }, m_mapCells{}, m_vecRects{}, m_vecQueryStamps{},
+		m_unQueryStamp{ 0 }, m_vecVisibleIndices{}, m_queryStats{}
+	{
+	}
+
+	uint32_t SpatialGrid::Insert(const SDL_Rect& rect)
+	{
+		uint32_t unID = static_cast<uint32_t>(m_vecRects.size());
+		m_vecRects.push_back(rect);
+		m_vecQueryStamps.push_back(m_unQueryStamp);
+
+		int nMinCellX = ToCell(rect.x);
+		int nMinCellY = ToCell(rect.y);
+		int nMaxCellX = ToCell(rect.x + std::max(rect.w, 1) - 1);
+		int nMaxCellY = ToCell(rect.y + std::max(rect.h, 1) - 1);
+		for (int nCellY = nMinCellY; nCellY <= nMaxCellY; ++nCellY)
+		{
+			for (int nCellX = nMinCellX; nCellX <= nMaxCellX; ++nCellX)
+			{
+				SCell& cell = m_mapCells[MakeCellKey(nCellX, nCellY)];
+				cell.m_vecRects.push_back(rect);
+				cell.m_vecIDs.push_back(unID);
+			}
+		}
+		return unID;
+	}
+
+	void SpatialGrid::Clear()
+	{
+		m_mapCells.clear();
+		m_vecRects.clear();
+		m_vecQueryStamps.clear();
+		m_unQueryStamp = 0;
+		m_queryStats = SQueryStats{};
+	}
+
+	void SpatialGrid::Query(const SDL_Rect& viewport, std::vector<uint32_t>& vecOutIDs)
+	{
+		vecOutIDs.clear();
+		m_queryStats = SQueryStats{};
+		if (viewport.w <= 0 || viewport.h <= 0)
+		{
+			return;
+		}
+
+		/* A new stamp marks every rect as not reported yet. Reset all stamps, once it wraps. */
+		if (++m_unQueryStamp == 0)
+		{
+			std::fill(m_vecQueryStamps.begin(), m_vecQueryStamps.end(), 0);
+			m_unQueryStamp = 1;
+		}
+
+		int nMinCellX = ToCell(viewport.x);
+		int nMinCellY = ToCell(viewport.y);
+		int nMaxCellX = ToCell(viewport.x + viewport.w - 1);
+		int nMaxCellY = ToCell(viewport.y + viewport.h - 1);
+		uint64_t unRangeCellCount = static_cast<uint64_t>(nMaxCellX - nMinCellX + 1) * (nMaxCellY - nMinCellY + 1);
+
+		if (unRangeCellCount > m_mapCells.size())
+		{
+			/* The viewport covers more cells than there are, so walk the existing ones. */
+			for (const auto& cell : m_mapCells)
+			{
+				QueryCell(cell.second, viewport, vecOutIDs);
+			}
+		}
+		else
+		{
+			for (int nCellY = nMinCellY; nCellY <= nMaxCellY; ++nCellY)
+			{
+				for (int nCellX = nMinCellX; nCellX <= nMaxCellX; ++nCellX)
+				{
+					auto itCell = m_mapCells.find(MakeCellKey(nCellX, nCellY));
+					if (itCell != m_mapCells.end())
+					{
+						QueryCell(itCell->second, viewport, vecOutIDs);
+					}
+				}
+			}
+		}
+
+		/* Draw in insertion order, like the sprites were submitted without the grid. */
+		std::sort(vecOutIDs.begin(), vecOutIDs.end());
+		m_queryStats.m_unVisibleCount = static_cast<unsigned int>(vecOutIDs.size());
+	}
+
+	/* Private methods. */
+	int SpatialGrid::ToCell(int nCoord) const
+	{
+		int nCell = nCoord / m_nCellSize;
+		if (nCoord < 0 && nCell * m_nCellSize != nCoord)
+		{
+			--nCell;
+		}
+		return nCell;
+	}
+
+	uint64_t SpatialGrid::MakeCellKey(int nCellX, int nCellY)
+	{
+		return (static_cast<uint64_t>(static_cast<uint32_t>(nCellX)) << 32) | static_cast<uint32_t>(nCellY);
+	}
+
+	void SpatialGrid::QueryCell(const SCell& cell, const SDL_Rect& viewport, std::vector<uint32_t>& vecOutIDs)
+	{
+		unsigned int unCount = static_cast<unsigned int>(cell.m_vecRects.size());
+		if (m_vecVisibleIndices.size() < unCount)
+		{
+			m_vecVisibleIndices.resize(unCount);
+		}
+
+		unsigned int unVisibleCount = RectCuller::CullRects(cell.m_vecRects.data(), unCount, viewport,
+			m_vecVisibleIndices.data());
+		for (unsigned int unIndex = 0; unIndex < unVisibleCount; ++unIndex)
+		{
+			uint32_t unID = cell.m_vecIDs[m_vecVisibleIndices[unIndex]];
+			if (m_vecQueryStamps[unID] != m_unQueryStamp)
+			{
+				m_vecQueryStamps[unID] = m_unQueryStamp;
+				vecOutIDs.push_back(unID);
+			}
+		}
+
+		m_queryStats.m_unCellCount++;
+		m_queryStats.m_unTestedCount += unCount;
+	}
+}
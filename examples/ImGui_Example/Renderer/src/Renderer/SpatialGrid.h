@@ -0,0 +1,149 @@
+#pragma once
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <SDL.h>
+
+namespace K9
+{
+	/// <summary>
+	/// Uniform grid over static sprite rects in screen space.
+	/// A query only walks the cells, which overlap the viewport, and culls their rects with RectCuller,
+	/// so the cost depends on what is on screen instead of the size of the world.
+	/// Rects, which span several cells, are stored in each of them and reported once.
+	/// </summary>
+	class SpatialGrid
+	{
+	public:
+		/// <summary>
+		/// Default width and height of a cell in pixels.
+		/// </summary>
+		static constexpr int DEFAULT_CELL_SIZE{ 256 };
+
+		/// <summary>
+		/// Statistics of the last query.
+		/// </summary>
+		struct SQueryStats
+		{
+			/// <summary>
+			/// Number of walked cells.
+			/// </summary>
+			unsigned int m_unCellCount = 0;
+
+			/// <summary>
+			/// Number of rects, tested against the viewport.
+			/// </summary>
+			unsigned int m_unTestedCount = 0;
+
+			/// <summary>
+			/// Number of visible rects.
+			/// </summary>
+			unsigned int m_unVisibleCount = 0;
+		};
+
+		/// <summary>
+		/// Create an empty grid.
+		/// </summary>
+		/// <param name="nCellSize"> Width and height of a cell in pixels. </param>
+		explicit SpatialGrid(int nCellSize = DEFAULT_CELL_SIZE);
+
+		/// <summary>
+		/// Add a rect.
+		/// </summary>
+		/// <param name="rect"> Rect in screen space. </param>
+		/// <returns> ID of the rect. IDs are consecutive and start at 0. </returns>
+		uint32_t Insert(const SDL_Rect& rect);
+
+		/// <summary>
+		/// Remove all rects.
+		/// </summary>
+		void Clear();
+
+		/// <summary>
+		/// Retrieve the number of rects.
+		/// </summary>
+		/// <returns> Number of rects. </returns>
+		size_t GetCount() const { return m_vecRects.size(); }
+
+		/// <summary>
+		/// Retrieve a rect by its ID.
+		/// </summary>
+		/// <param name="unID"> ID, returned by Insert. </param>
+		/// <returns> The rect. </returns>
+		const SDL_Rect& GetRect(uint32_t unID) const { return m_vecRects[unID]; }
+
+		/// <summary>
+		/// Find the rects, which overlap the viewport.
+		/// </summary>
+		/// <param name="viewport"> Visible area. </param>
+		/// <param name="vecOutIDs"> Receives the IDs of the visible rects in insertion order. </param>
+		void Query(const SDL_Rect& viewport, std::vector<uint32_t>& vecOutIDs);
+
+		/// <summary>
+		/// Retrieve the statistics of the last query.
+		/// </summary>
+		/// <returns> m_queryStats. </returns>
+		const SQueryStats& GetQueryStats() const { return m_queryStats; }
+
+	private:
+		/// <summary>
+		/// Rects of a single cell. The rects are stored by value, so they can be culled as a contiguous array.
+		/// </summary>
+		struct SCell
+		{
+			std::vector<SDL_Rect> m_vecRects;
+			std::vector<uint32_t> m_vecIDs;
+		};
+
+		/// <summary>
+		/// Convert a coordinate in pixels to a cell coordinate, rounding towards negative infinity.
+		/// </summary>
+		int ToCell(int nCoord) const;
+
+		/// <summary>
+		/// Build the key of a cell in m_mapCells.
+		/// </summary>
+		static uint64_t MakeCellKey(int nCellX, int nCellY);
+
+		/// <summary>
+		/// Cull the rects of a cell and append the newly found visible IDs.
+		/// </summary>
+		void QueryCell(const SCell& cell, const SDL_Rect& viewport, std::vector<uint32_t>& vecOutIDs);
+
+	private:
+		/// <summary>
+		/// Width and height of a cell in pixels.
+		/// </summary>
+		int m_nCellSize;
+
+		/// <summary>
+		/// Non-empty cells by their key.
+		/// </summary>
+		std::unordered_map<uint64_t, SCell> m_mapCells;
+
+		/// <summary>
+		/// All rects by their ID.
+		/// </summary>
+		std::vector<SDL_Rect> m_vecRects;
+
+		/// <summary>
+		/// Stamp of the last query, which reported each rect. Used to report rects in several cells once.
+		/// </summary>
+		std::vector<uint32_t> m_vecQueryStamps;
+
+		/// <summary>
+		/// Stamp of the current query.
+		/// </summary>
+		uint32_t m_unQueryStamp;
+
+		/// <summary>
+		/// Indices of the visible rects inside a cell. Reused between queries.
+		/// </summary>
+		std::vector<uint32_t> m_vecVisibleIndices;
+
+		/// <summary>
+		/// Statistics of the last query.
+		/// </summary>
+		SQueryStats m_queryStats;
+	};
+}
@@ -0,0 +1,237 @@
+#include "SpriteBatch.h"
+#include <iostream>
+#include <glad/glad.h>
+
+#include <Threading/ThreadPool.h>
+#include "Affine2D.h"
+#include "Texture.h"
+
+namespace K9
+{
+	SpriteBatch::SpriteBatch()
+		: m_defaultShaders{}, m_ptrShader{ nullptr }, m_unVariantMask{ 0 }, m_unTintMask{ 0 }, m_textureSlots{},
+		m_ptrVertexArray{ nullptr }, m_vecVertices{}, m_spriteRects{}, m_vecCommandSlots{},
+		m_unMaxQuadCount{ 0 }, m_unDrawCallCount{ 0 }, m_unQuadCount{ 0 }
+	{
+	}
+
+	bool SpriteBatch::Init(unsigned int unMaxQuadCount, bool bAsyncShader)
+	{
+		/* Every variant is submitted at once, so the driver can compile them in parallel. */
+		if (!m_defaultShaders.Load("assets/shaders/SpriteBatch.vert", "assets/shaders/SpriteBatch.frag"))
+		{
+			std::cerr << "SpriteBatch::Init Failed to load the batch shader!\n";
+			return false;
+		}
+		m_defaultShaders.Prewarm();
+		if (!bAsyncShader && m_defaultShaders.Wait() != Shader::EStatus::eReady)
+		{
+			std::cerr << "SpriteBatch::Init Failed to compile the batch shader!\n";
+			return false;
+		}
+		m_ptrShader = nullptr;
+		m_unVariantMask = 0;
+		m_unTintMask = m_defaultShaders.GetKeywordMask("TINT");
+		m_textureSlots.Init();
+
+		/* Every quad uses the same index pattern, offset by 4 vertices. */
+		m_unMaxQuadCount = unMaxQuadCount;
+		std::vector<unsigned int> vecIndices;
+		vecIndices.reserve(static_cast<size_t>(m_unMaxQuadCount) * 6);
+		for (unsigned int unQuad = 0; unQuad < m_unMaxQuadCount; ++unQuad)
+		{
+			unsigned int unOffset = unQuad * 4;
+			vecIndices.push_back(unOffset + 0);
+			vecIndices.push_back(unOffset + 1);
+			vecIndices.push_back(unOffset + 2);
+			vecIndices.push_back(unOffset + 2);
+			vecIndices.push_back(unOffset + 3);
+			vecIndices.push_back(unOffset + 0);
+		}
+
+		m_ptrVertexArray.reset(new VertexArray(m_unMaxQuadCount * 4, VertexArray::ELayout::ePosTexColorSlot,
+			vecIndices.data(), static_cast<unsigned int>(vecIndices.size())));
+
+		m_vecVertices.reserve(static_cast<size_t>(m_unMaxQuadCount) * 4);
+		m_spriteRects.Reserve(m_unMaxQuadCount);
+		m_vecCommandSlots.reserve(m_unMaxQuadCount);
+		return true;
+	}
+
+	void SpriteBatch::Begin()
+	{
+		m_ptrVertexArray->BeginFrame();
+		m_vecVertices.clear();
+		m_spriteRects.Clear();
+		m_textureSlots.Clear();
+		m_unVariantMask = 0;
+		m_unDrawCallCount = 0;
+		m_unQuadCount = 0;
+	}
+
+	void SpriteBatch::Draw(const Texture& texture, const SDL_Rect& destRect,
+		const glm::vec2& minUV, const glm::vec2& maxUV,
+		const SDL_Color& color, SDL_RendererFlip flipFormat,
+		float fAngle, const glm::vec2& origin)
+	{
+		/* Flush when the vertex buffer is full. */
+		if (m_vecVertices.size() >= static_cast<size_t>(m_unMaxQuadCount) * 4)
+		{
+			Flush();
+		}
+
+		/* Flush when the texture slots are full. */
+		int nSlot = m_textureSlots.GetSlot(texture);
+		if (nSlot < 0)
+		{
+			Flush();
+			nSlot = m_textureSlots.GetSlot(texture);
+		}
+		uint32_t unSlot = static_cast<uint32_t>(nSlot);
+
+		/* The positions are expanded for the whole batch on Flush. Flipping mirrors the corners there. */
+		m_spriteRects.Push(destRect, flipFormat, fAngle, origin);
+		if (!IsWhite(color))
+		{
+			m_unVariantMask |= m_unTintMask;
+		}
+
+		glm::vec2 pos{ 0.0f, 0.0f };
+		m_vecVertices.push_back({ pos, { minUV.x, minUV.y }, color, unSlot });	/* Top-Left */
+		m_vecVertices.push_back({ pos, { maxUV.x, minUV.y }, color, unSlot });	/* Top-Right */
+		m_vecVertices.push_back({ pos, { maxUV.x, maxUV.y }, color, unSlot });	/* Bottom-Right */
+		m_vecVertices.push_back({ pos, { minUV.x, maxUV.y }, color, unSlot });	/* Bottom-Left */
+	}
+
+	void SpriteBatch::SetShader(Shader* ptrShader)
+	{
+		/* A shader, which is still compiling, is replaced by the default one, until it is ready. */
+		Shader* ptrNewShader = ptrShader && ptrShader->IsReady() ? ptrShader : nullptr;
+		if (ptrNewShader != m_ptrShader)
+		{
+			Flush();
+			m_ptrShader = ptrNewShader;
+		}
+	}
+
+	void SpriteBatch::Flush()
+	{
+		if (m_vecVertices.empty())
+		{
+			return;
+		}
+
+		unsigned int unVertexCount = static_cast<unsigned int>(m_vecVertices.size());
+		unsigned int unQuadCount = unVertexCount / 4;
+		m_spriteRects.TransformQuads(m_vecVertices.data(), sizeof(SSpriteVertex));
+
+		/* Bind shader, textures and geometry. They may have been changed by ImGUI since the last flush. */
+		if (Shader* ptrShader = m_ptrShader ? m_ptrShader : m_defaultShaders.Get(m_unVariantMask))
+		{
+			ptrShader->SetActive();
+			ptrShader->SetIntUniforms(TextureSlots::SAMPLERS_UNIFORM, TextureSlots::GetSamplerUnits(), TextureSlots::MAX_SLOT_COUNT);
+			m_textureSlots.Bind();
+			m_ptrVertexArray->SetActive();
+			m_ptrVertexArray->SetVertexData(m_vecVertices.data(), unVertexCount);
+
+			glDrawElements(GL_TRIANGLES, unQuadCount * 6, GL_UNSIGNED_INT, nullptr);
+
+			m_unDrawCallCount++;
+			m_unQuadCount += unQuadCount;
+		}
+		m_unVariantMask = 0;
+		m_vecVertices.clear();
+		m_spriteRects.Clear();
+		m_textureSlots.Clear();
+	}
+
+	void SpriteBatch::DrawCommands(const SSpriteCommand* const* arrCommands, size_t unCount, ThreadPool& threadPool)
+	{
+		/* Quads from Draw come first. */
+		Flush();
+
+		size_t unFirst = 0;
+		while (unFirst < unCount)
+		{
+			/* A run ends on shader change, when the texture slots are full or when the vertex buffer is full. */
+			Shader* ptrShader = GetCommandShader(*arrCommands[unFirst]);
+			size_t unLast = unFirst;
+			while (unLast < unCount && unLast - unFirst < m_unMaxQuadCount)
+			{
+				const SSpriteCommand& command = *arrCommands[unLast];
+				if (GetCommandShader(command) != ptrShader)
+				{
+					break;
+				}
+
+				int nSlot = m_textureSlots.GetSlot(*command.m_ptrTexture);
+				if (nSlot < 0)
+				{
+					break;
+				}
+				m_vecCommandSlots.push_back(static_cast<uint32_t>(nSlot));
+				if (!IsWhite(command.m_color))
+				{
+					m_unVariantMask |= m_unTintMask;
+				}
+				++unLast;
+			}
+
+			m_ptrShader = ptrShader;
+			DrawCommandRun(arrCommands + unFirst, unLast - unFirst, threadPool);
+			unFirst = unLast;
+		}
+	}
+
+	void SpriteBatch::WriteQuadVertices(const SSpriteCommand& command, uint32_t unSlot, SSpriteVertex* ptrOutVertices)
+	{
+		SAffine2D affine = SAffine2D::FromSprite(command.m_destRect, command.m_flipFormat, command.m_fAngle, command.m_origin);
+		const glm::vec2& minUV = command.m_minUV;
+		const glm::vec2& maxUV = command.m_maxUV;
+		ptrOutVertices[0] = { affine.Apply({ 0.0f, 0.0f }), { minUV.x, minUV.y }, command.m_color, unSlot };	/* Top-Left */
+		ptrOutVertices[1] = { affine.Apply({ 1.0f, 0.0f }), { maxUV.x, minUV.y }, command.m_color, unSlot };	/* Top-Right */
+		ptrOutVertices[2] = { affine.Apply({ 1.0f, 1.0f }), { maxUV.x, maxUV.y }, command.m_color, unSlot };	/* Bottom-Right */
+		ptrOutVertices[3] = { affine.Apply({ 0.0f, 1.0f }), { minUV.x, maxUV.y }, command.m_color, unSlot };	/* Bottom-Left */
+	}
+
+	/* Private methods. */
+	void SpriteBatch::DrawCommandRun(const SSpriteCommand* const* arrCommands, size_t unCount, ThreadPool& threadPool)
+	{
+		unsigned int unQuadCount = static_cast<unsigned int>(unCount);
+		auto* ptrVertices = static_cast<SSpriteVertex*>(m_ptrVertexArray->MapVertexData(unQuadCount * 4));
+		if (ptrVertices != nullptr)
+		{
+			/* Every sprite owns its 4 vertices, so the threads never write the same memory. */
+			const uint32_t* arrSlots = m_vecCommandSlots.data();
+			threadPool.ParallelFor(unCount, MIN_PARALLEL_BATCH_SIZE, [arrCommands, arrSlots, ptrVertices](size_t unBegin, size_t unEnd)
+			{
+				for (size_t unIndex = unBegin; unIndex < unEnd; ++unIndex)
+				{
+					WriteQuadVertices(*arrCommands[unIndex], arrSlots[unIndex], ptrVertices + unIndex * 4);
+				}
+			});
+			m_ptrVertexArray->UnmapVertexData();
+
+			if (Shader* ptrShader = m_ptrShader ? m_ptrShader : m_defaultShaders.Get(m_unVariantMask))
+			{
+				ptrShader->SetActive();
+				ptrShader->SetIntUniforms(TextureSlots::SAMPLERS_UNIFORM, TextureSlots::GetSamplerUnits(), TextureSlots::MAX_SLOT_COUNT);
+				m_textureSlots.Bind();
+				m_ptrVertexArray->SetActive();
+
+				glDrawElements(GL_TRIANGLES, unQuadCount * 6, GL_UNSIGNED_INT, nullptr);
+
+				m_unDrawCallCount++;
+				m_unQuadCount += unQuadCount;
+			}
+		}
+		m_unVariantMask = 0;
+		m_vecCommandSlots.clear();
+		m_textureSlots.Clear();
+	}
+
+	Shader* SpriteBatch::GetCommandShader(const SSpriteCommand& command)
+	{
+		return command.m_ptrShader && command.m_ptrShader->IsReady() ? command.m_ptrShader : nullptr;
+	}
+}
@@ -0,0 +1,222 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <SDL.h>
+#include <glm/glm.hpp>
+#include "ISpriteBatch.h"
+#include "Shader.h"
+#include "ShaderVariants.h"
+#include "SpriteRects.h"
+#include "TextureSlots.h"
+#include "VertexArray.h"
+
+namespace K9
+{
+	class Texture;
+
+	/// <summary>
+	/// A single vertex of a batched sprite quad, already transformed to screen space.
+	/// Matches VertexArray::ELayout::ePosTexColorSlot.
+	/// </summary>
+	struct SSpriteVertex
+	{
+		/// <summary>
+		/// Position in screen space. Must stay the first member, since SpriteRects writes it.
+		/// </summary>
+		glm::vec2 m_pos;
+
+		/// <summary>
+		/// Texture coordinates.
+		/// </summary>
+		glm::vec2 m_texCoord;
+
+		/// <summary>
+		/// Tint color.
+		/// </summary>
+		SDL_Color m_color;
+
+		/// <summary>
+		/// Index of the texture in the TextureSlots of the batch.
+		/// </summary>
+		uint32_t m_unTextureSlot;
+	};
+
+	/// <summary>
+	/// Gathers sprite quads into a CPU buffer and draws them with as few draw calls as possible.
+	/// Up to TextureSlots::MAX_SLOT_COUNT textures are bound per draw call.
+	/// A batch is flushed when the texture slots are full, on shader change or when the vertex buffer is full.
+	/// Textures must stay alive until the batch is flushed.
+	/// </summary>
+	class SpriteBatch : public ISpriteBatch
+	{
+	public:
+		SpriteBatch();
+		~SpriteBatch() override = default;
+
+		/// <summary>
+		/// Load the batch shader and create the dynamic geometry.
+		/// </summary>
+		/// <param name="unMaxQuadCount"> Maximum number of quads per draw call. </param>
+		/// <param name="bAsyncShader"> True, to only submit the variants of the batch shader. </param>
+		/// <returns> True, if the initialization was successful. </returns>
+		bool Init(unsigned int unMaxQuadCount, bool bAsyncShader) override;
+
+		/// <summary>
+		/// Retrieve the variants of the batch shader.
+		/// </summary>
+		/// <returns> m_defaultShaders. </returns>
+		ShaderVariants& GetDefaultShaders() override { return m_defaultShaders; }
+
+		/// <summary>
+		/// Start gathering quads for a new frame.
+		/// </summary>
+		void Begin() override;
+
+		/// <summary>
+		/// Add a textured quad to the batch.
+		/// </summary>
+		/// <param name="texture"> Texture of the quad. </param>
+		/// <param name="destRect"> Destination rect in screen space. </param>
+		/// <param name="minUV"> Normalized min UV texture coordinate. </param>
+		/// <param name="maxUV"> Normalized max UV texture coordinate. </param>
+		/// <param name="color"> Tint color. </param>
+		/// <param name="flipFormat"> Flip format. </param>
+		/// <param name="fAngle"> Rotation in degrees, clockwise on screen. </param>
+		/// <param name="origin"> Rotation origin, relative to the top-left of destRect. </param>
+		void Draw(const Texture& texture, const SDL_Rect& destRect,
+			const glm::vec2& minUV, const glm::vec2& maxUV,
+			const SDL_Color& color, SDL_RendererFlip flipFormat,
+			float fAngle, const glm::vec2& origin) override;
+
+		/// <summary>
+		/// Set the shader, used to draw the following quads.
+		/// </summary>
+		/// <param name="ptrShader"> Shader to be set. nullptr or a shader, which is still compiling, restores the default batch shader. </param>
+		void SetShader(Shader* ptrShader) override;
+
+		/// <summary>
+		/// Add many sprites at once. The gathered quads are flushed first.
+		/// The sprites are split into draw calls on the calling thread, then the vertices of each draw call
+		/// are written straight into the mapped vertex buffer by the threads of the pool.
+		/// </summary>
+		/// <param name="arrCommands"> The sprites. </param>
+		/// <param name="unCount"> Number of sprites. </param>
+		/// <param name="threadPool"> Threads, used to write the vertices. </param>
+		void DrawCommands(const SSpriteCommand* const* arrCommands, size_t unCount, ThreadPool& threadPool) override;
+
+		/// <summary>
+		/// Draw all gathered quads.
+		/// </summary>
+		void Flush() override;
+
+		/// <summary>
+		/// Retrieve the number of draw calls since Begin.
+		/// </summary>
+		/// <returns> m_unDrawCallCount. </returns>
+		unsigned int GetDrawCallCount() const override { return m_unDrawCallCount; }
+
+		/// <summary>
+		/// Retrieve the number of quads drawn since Begin.
+		/// </summary>
+		/// <returns> m_unQuadCount. </returns>
+		unsigned int GetQuadCount() const override { return m_unQuadCount; }
+
+		/// <summary>
+		/// Retrieve the synchronization statistics of the streamed vertices and reset them.
+		/// </summary>
+		/// <returns> Statistics since the last call. </returns>
+		StreamBuffer::SStats PopStreamStats() override { return m_ptrVertexArray->PopStreamStats(); }
+
+		/// <summary>
+		/// Write the 4 vertices of a sprite in the order top-left, top-right, bottom-right, bottom-left.
+		/// Matches the quads of Draw and only touches the output, so it can run on any thread.
+		/// </summary>
+		/// <param name="command"> The sprite. </param>
+		/// <param name="unSlot"> Texture slot of the sprite. </param>
+		/// <param name="ptrOutVertices"> First of the 4 vertices. </param>
+		static void WriteQuadVertices(const SSpriteCommand& command, uint32_t unSlot, SSpriteVertex* ptrOutVertices);
+
+		/// <summary>
+		/// Minimum number of sprites, written by a thread at once in DrawCommands.
+		/// </summary>
+		static constexpr size_t MIN_PARALLEL_BATCH_SIZE{ 1024 };
+
+	private:
+		/// <summary>
+		/// Draw a run of sprites, which share the shader and fit into the texture slots and the vertex buffer.
+		/// </summary>
+		/// <param name="arrCommands"> The sprites. </param>
+		/// <param name="unCount"> Number of sprites. </param>
+		/// <param name="threadPool"> Threads, used to write the vertices. </param>
+		void DrawCommandRun(const SSpriteCommand* const* arrCommands, size_t unCount, ThreadPool& threadPool);
+
+		/// <summary>
+		/// Select the shader of a sprite, like SetShader.
+		/// </summary>
+		/// <param name="command"> The sprite. </param>
+		/// <returns> The shader of the sprite, if it is ready, nullptr for the default shader otherwise. </returns>
+		static Shader* GetCommandShader(const SSpriteCommand& command);
+
+	private:
+		/// <summary>
+		/// Variants of the default shader, used to draw batched quads.
+		/// </summary>
+		ShaderVariants m_defaultShaders;
+
+		/// <summary>
+		/// Shader of the current batch. nullptr for the variant of m_defaultShaders, which matches m_unVariantMask.
+		/// </summary>
+		Shader* m_ptrShader;
+
+		/// <summary>
+		/// Keyword bits of the features, the quads of the current batch need.
+		/// </summary>
+		uint32_t m_unVariantMask;
+
+		/// <summary>
+		/// Keyword bit of tinted quads.
+		/// </summary>
+		uint32_t m_unTintMask;
+
+		/// <summary>
+		/// Textures of the current batch.
+		/// </summary>
+		TextureSlots m_textureSlots;
+
+		/// <summary>
+		/// Dynamic quad geometry.
+		/// </summary>
+		std::unique_ptr<VertexArray> m_ptrVertexArray;
+
+		/// <summary>
+		/// Vertices of the current batch. Their positions are written from m_spriteRects on Flush.
+		/// </summary>
+		std::vector<SSpriteVertex> m_vecVertices;
+
+		/// <summary>
+		/// Destination rects of the current batch.
+		/// </summary>
+		SpriteRects m_spriteRects;
+
+		/// <summary>
+		/// Texture slots of the sprites of the current DrawCommands run.
+		/// </summary>
+		std::vector<uint32_t> m_vecCommandSlots;
+
+		/// <summary>
+		/// Maximum number of quads per draw call.
+		/// </summary>
+		unsigned int m_unMaxQuadCount;
+
+		/// <summary>
+		/// Number of draw calls since Begin.
+		/// </summary>
+		unsigned int m_unDrawCallCount;
+
+		/// <summary>
+		/// Number of quads drawn since Begin.
+		/// </summary>
+		unsigned int m_unQuadCount;
+	};
+}
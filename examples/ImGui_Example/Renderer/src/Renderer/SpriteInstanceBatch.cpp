@@ -0,0 +1,159 @@
+#include "SpriteInstanceBatch.h"
+#include <iostream>
+#include <glad/glad.h>
+
+#include "Affine2D.h"
+#include "Texture.h"
+
+namespace K9
+{
+	/* Convert a normalized coordinate to an unsigned normalized short. */
+	static uint16_t ToUNorm16(float fValue)
+	{
+		return static_cast<uint16_t>(glm::clamp(fValue, 0.0f, 1.0f) * 65535.0f + 0.5f);
+	}
+
+	SpriteInstanceBatch::SpriteInstanceBatch()
+		: m_defaultShaders{}, m_ptrShader{ nullptr }, m_unVariantMask{ 0 }, m_unTintMask{ 0 }, m_unFlipMask{ 0 }, m_textureSlots{},
+		m_ptrVertexArray{ nullptr }, m_vecInstances{},
+		m_unMaxQuadCount{ 0 }, m_unDrawCallCount{ 0 }, m_unQuadCount{ 0 }
+	{
+	}
+
+	bool SpriteInstanceBatch::Init(unsigned int unMaxQuadCount, bool bAsyncShader)
+	{
+		/* Every variant is submitted at once, so the driver can compile them in parallel. */
+		if (!m_defaultShaders.Load("assets/shaders/SpriteInstanced.vert", "assets/shaders/SpriteBatch.frag"))
+		{
+			std::cerr << "SpriteInstanceBatch::Init Failed to load the instanced shader!\n";
+			return false;
+		}
+		m_defaultShaders.Prewarm();
+		if (!bAsyncShader && m_defaultShaders.Wait() != Shader::EStatus::eReady)
+		{
+			std::cerr << "SpriteInstanceBatch::Init Failed to compile the instanced shader!\n";
+			return false;
+		}
+		m_ptrShader = nullptr;
+		m_unVariantMask = 0;
+		m_unTintMask = m_defaultShaders.GetKeywordMask("TINT");
+		m_unFlipMask = m_defaultShaders.GetKeywordMask("FLIP");
+		m_textureSlots.Init();
+
+		/* Unit quad in screen orientation. The texture coordinates select the corner of the UV rect. */
+		VertexArray::SPointParam pointParam(VertexArray::ELayout::ePosTex,
+			{
+				glm::vec3{ 0.0f, 0.0f, 0.0f },	/* Top-Left */
+				glm::vec3{ 1.0f, 0.0f, 0.0f },	/* Top-Right */
+				glm::vec3{ 1.0f, 1.0f, 0.0f },	/* Bottom-Right */
+				glm::vec3{ 0.0f, 1.0f, 0.0f }	/* Bottom-Left */
+			},
+			{
+				glm::vec2{ 0.0f, 0.0f },	/* Top-Left */
+				glm::vec2{ 1.0f, 0.0f },	/* Top-Right */
+				glm::vec2{ 1.0f, 1.0f },	/* Bottom-Right */
+				glm::vec2{ 0.0f, 1.0f }		/* Bottom-Left */
+			});
+
+		m_unMaxQuadCount = unMaxQuadCount;
+		m_ptrVertexArray.reset(new VertexArray(pointParam));
+		m_ptrVertexArray->CreateInstanceBuffer(m_unMaxQuadCount, VertexArray::ELayout::eSpriteInstance);
+
+		m_vecInstances.reserve(m_unMaxQuadCount);
+		return true;
+	}
+
+	void SpriteInstanceBatch::Begin()
+	{
+		m_ptrVertexArray->BeginFrame();
+		m_vecInstances.clear();
+		m_textureSlots.Clear();
+		m_unVariantMask = 0;
+		m_unDrawCallCount = 0;
+		m_unQuadCount = 0;
+	}
+
+	void SpriteInstanceBatch::Draw(const Texture& texture, const SDL_Rect& destRect,
+		const glm::vec2& minUV, const glm::vec2& maxUV,
+		const SDL_Color& color, SDL_RendererFlip flipFormat,
+		float fAngle, const glm::vec2& origin)
+	{
+		/* Flush when the instance buffer is full. */
+		if (m_vecInstances.size() >= m_unMaxQuadCount)
+		{
+			Flush();
+		}
+
+		/* Flush when the texture slots are full. */
+		int nSlot = m_textureSlots.GetSlot(texture);
+		if (nSlot < 0)
+		{
+			Flush();
+			nSlot = m_textureSlots.GetSlot(texture);
+		}
+
+		/* Map the unit quad onto the rect. Flipping is applied to the UVs in the vertex shader. */
+		SAffine2D affine = SAffine2D::FromSprite(destRect, SDL_RendererFlip::SDL_FLIP_NONE, fAngle, origin);
+
+		SSpriteInstance instance;
+		instance.m_transformRow0 = affine.m_row0;
+		instance.m_transformRow1 = affine.m_row1;
+		instance.m_arrUVRect[0] = ToUNorm16(minUV.x);
+		instance.m_arrUVRect[1] = ToUNorm16(minUV.y);
+		instance.m_arrUVRect[2] = ToUNorm16(maxUV.x);
+		instance.m_arrUVRect[3] = ToUNorm16(maxUV.y);
+		instance.m_color = color;
+		instance.m_unFlags = (static_cast<uint32_t>(flipFormat) & 0xFFu) | (static_cast<uint32_t>(nSlot) << 8);
+		m_vecInstances.push_back(instance);
+
+		/* The batch only pays for the features, one of its sprites needs. */
+		if (!IsWhite(color))
+		{
+			m_unVariantMask |= m_unTintMask;
+		}
+		if (flipFormat != SDL_FLIP_NONE)
+		{
+			m_unVariantMask |= m_unFlipMask;
+		}
+	}
+
+	void SpriteInstanceBatch::SetShader(Shader* ptrShader)
+	{
+		/* A shader, which is still compiling, is replaced by the default one, until it is ready. */
+		Shader* ptrNewShader = ptrShader && ptrShader->IsReady() ? ptrShader : nullptr;
+		if (ptrNewShader != m_ptrShader)
+		{
+			Flush();
+			m_ptrShader = ptrNewShader;
+		}
+	}
+
+	void SpriteInstanceBatch::Flush()
+	{
+		if (m_vecInstances.empty())
+		{
+			return;
+		}
+
+		unsigned int unInstanceCount = static_cast<unsigned int>(m_vecInstances.size());
+
+		/* Bind shader, textures and geometry. They may have been changed by ImGUI since the last flush. */
+		if (Shader* ptrShader = m_ptrShader ? m_ptrShader : m_defaultShaders.Get(m_unVariantMask))
+		{
+			ptrShader->SetActive();
+			ptrShader->SetIntUniforms(TextureSlots::SAMPLERS_UNIFORM, TextureSlots::GetSamplerUnits(), TextureSlots::MAX_SLOT_COUNT);
+			m_textureSlots.Bind();
+			m_ptrVertexArray->SetActive();
+			m_ptrVertexArray->SetInstanceData(m_vecInstances.data(), unInstanceCount);
+
+			glDrawElementsInstanced(GL_TRIANGLES, m_ptrVertexArray->GetIndexCount(), GL_UNSIGNED_INT,
+				nullptr, unInstanceCount);
+
+			m_unDrawCallCount++;
+			m_unQuadCount += unInstanceCount;
+		}
+		m_unVariantMask = 0;
+		m_vecInstances.clear();
+		m_textureSlots.Clear();
+	}
+}
@@ -0,0 +1,141 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <SDL.h>
+#include <glm/glm.hpp>
+#include "ISpriteBatch.h"
+#include "Shader.h"
+#include "ShaderVariants.h"
+#include "TextureSlots.h"
+#include "VertexArray.h"
+
+namespace K9
+{
+	/// <summary>
+	/// Per-instance data of a sprite. Matches VertexArray::ELayout::eSpriteInstance.
+	/// The unit quad corner (x, y) in [0, 1] is mapped to screen space by
+	/// screen.x = dot(m_transformRow0, {x, y, 1}), screen.y = dot(m_transformRow1, {x, y, 1}).
+	/// </summary>
+	struct SSpriteInstance
+	{
+		/// <summary>
+		/// First row of the 2x3 affine transform.
+		/// </summary>
+		glm::vec3 m_transformRow0;
+
+		/// <summary>
+		/// Second row of the 2x3 affine transform.
+		/// </summary>
+		glm::vec3 m_transformRow1;
+
+		/// <summary>
+		/// UV rect as normalized shorts: min u, min v, max u, max v.
+		/// </summary>
+		uint16_t m_arrUVRect[4];
+
+		/// <summary>
+		/// Tint color.
+		/// </summary>
+		SDL_Color m_color;
+
+		/// <summary>
+		/// Bits 0-7: SDL_RendererFlip bits, applied in the vertex shader.
+		/// Bits 8-15: index of the texture in the TextureSlots of the batch.
+		/// </summary>
+		uint32_t m_unFlags;
+	};
+
+	/// <summary>
+	/// Draws sprites with glDrawElementsInstanced. The unit quad stays static and
+	/// only one SSpriteInstance per sprite is streamed into a per-instance buffer.
+	/// Up to TextureSlots::MAX_SLOT_COUNT textures are bound per draw call.
+	/// A batch is flushed when the texture slots are full, on shader change or when the instance buffer is full.
+	/// Textures must stay alive until the batch is flushed.
+	/// </summary>
+	class SpriteInstanceBatch : public ISpriteBatch
+	{
+	public:
+		SpriteInstanceBatch();
+		~SpriteInstanceBatch() override = default;
+
+		/// <summary>
+		/// Load the instanced shader and create the unit quad with an instance buffer.
+		/// </summary>
+		/// <param name="unMaxQuadCount"> Maximum number of instances per draw call. </param>
+		/// <param name="bAsyncShader"> True, to only submit the variants of the instanced shader. </param>
+		/// <returns> True, if the initialization was successful. </returns>
+		bool Init(unsigned int unMaxQuadCount, bool bAsyncShader) override;
+
+		ShaderVariants& GetDefaultShaders() override { return m_defaultShaders; }
+
+		void Begin() override;
+
+		void Draw(const Texture& texture, const SDL_Rect& destRect,
+			const glm::vec2& minUV, const glm::vec2& maxUV,
+			const SDL_Color& color, SDL_RendererFlip flipFormat,
+			float fAngle, const glm::vec2& origin) override;
+
+		void SetShader(Shader* ptrShader) override;
+
+		void Flush() override;
+
+		unsigned int GetDrawCallCount() const override { return m_unDrawCallCount; }
+
+		unsigned int GetQuadCount() const override { return m_unQuadCount; }
+
+		StreamBuffer::SStats PopStreamStats() override { return m_ptrVertexArray->PopStreamStats(); }
+
+	private:
+		/// <summary>
+		/// Variants of the default shader, used to draw instanced quads.
+		/// </summary>
+		ShaderVariants m_defaultShaders;
+
+		/// <summary>
+		/// Shader of the current batch. nullptr for the variant of m_defaultShaders, which matches m_unVariantMask.
+		/// </summary>
+		Shader* m_ptrShader;
+
+		/// <summary>
+		/// Keyword bits of the features, the instances of the current batch need.
+		/// </summary>
+		uint32_t m_unVariantMask;
+
+		/// <summary>
+		/// Keyword bits of tinted and flipped instances.
+		/// </summary>
+		uint32_t m_unTintMask;
+		uint32_t m_unFlipMask;
+
+		/// <summary>
+		/// Textures of the current batch.
+		/// </summary>
+		TextureSlots m_textureSlots;
+
+		/// <summary>
+		/// Static unit quad with a dynamic instance buffer.
+		/// </summary>
+		std::unique_ptr<VertexArray> m_ptrVertexArray;
+
+		/// <summary>
+		/// Instances of the current batch.
+		/// </summary>
+		std::vector<SSpriteInstance> m_vecInstances;
+
+		/// <summary>
+		/// Maximum number of instances per draw call.
+		/// </summary>
+		unsigned int m_unMaxQuadCount;
+
+		/// <summary>
+		/// Number of draw calls since Begin.
+		/// </summary>
+		unsigned int m_unDrawCallCount;
+
+		/// <summary>
+		/// Number of quads drawn since Begin.
+		/// </summary>
+		unsigned int m_unQuadCount;
+	};
+}
@@ -0,0 +1,155 @@
+#include "SpriteRects.h"
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define K9_SPRITE_RECTS_SSE
+#include <emmintrin.h>
+#endif
+
+namespace K9
+{
+	void SpriteRects::Reserve(size_t unCount)
+	{
+		for (auto* ptrVec : { &m_vecPivotX, &m_vecPivotY, &m_vecLeft, &m_vecRight,
+			&m_vecTop, &m_vecBottom, &m_vecCos, &m_vecSin })
+		{
+			ptrVec->reserve(unCount);
+		}
+	}
+
+	void SpriteRects::Clear()
+	{
+		for (auto* ptrVec : { &m_vecPivotX, &m_vecPivotY, &m_vecLeft, &m_vecRight,
+			&m_vecTop, &m_vecBottom, &m_vecCos, &m_vecSin })
+		{
+			ptrVec->clear();
+		}
+	}
+
+	void SpriteRects::Push(const SDL_Rect& destRect, SDL_RendererFlip flipFormat,
+		float fAngle, const glm::vec2& origin)
+	{
+		float fWidth = static_cast<float>(destRect.w);
+		float fHeight = static_cast<float>(destRect.h);
+
+		/* Flipping swaps the left/right or top/bottom corners. Done without branches, since random flips mispredict. */
+		float fFlipX = static_cast<float>(flipFormat & SDL_RendererFlip::SDL_FLIP_HORIZONTAL);
+		float fFlipY = static_cast<float>((flipFormat & SDL_RendererFlip::SDL_FLIP_VERTICAL) >> 1);
+		float fLeft = fWidth * fFlipX - origin.x;
+		float fRight = fWidth * (1.0f - fFlipX) - origin.x;
+		float fTop = fHeight * fFlipY - origin.y;
+		float fBottom = fHeight * (1.0f - fFlipY) - origin.y;
+
+		float fCos = 1.0f;
+		float fSin = 0.0f;
+		if (fAngle != 0.0f)
+		{
+			float fRadians = glm::radians(fAngle);
+			fCos = std::cos(fRadians);
+			fSin = std::sin(fRadians);
+		}
+
+		m_vecPivotX.push_back(static_cast<float>(destRect.x) + origin.x);
+		m_vecPivotY.push_back(static_cast<float>(destRect.y) + origin.y);
+		m_vecLeft.push_back(fLeft);
+		m_vecRight.push_back(fRight);
+		m_vecTop.push_back(fTop);
+		m_vecBottom.push_back(fBottom);
+		m_vecCos.push_back(fCos);
+		m_vecSin.push_back(fSin);
+	}
+
+	void SpriteRects::TransformQuads(void* ptrOutVertices, unsigned int unStride) const
+	{
+		unsigned char* ptrOut = static_cast<unsigned char*>(ptrOutVertices);
+		size_t unCount = GetCount();
+		size_t unIndex = 0;
+
+#ifdef K9_SPRITE_RECTS_SSE
+		for (; unIndex + 4 <= unCount; unIndex += 4)
+		{
+			__m128 pivotX = _mm_loadu_ps(&m_vecPivotX[unIndex]);
+			__m128 pivotY = _mm_loadu_ps(&m_vecPivotY[unIndex]);
+			__m128 left = _mm_loadu_ps(&m_vecLeft[unIndex]);
+			__m128 right = _mm_loadu_ps(&m_vecRight[unIndex]);
+			__m128 top = _mm_loadu_ps(&m_vecTop[unIndex]);
+			__m128 bottom = _mm_loadu_ps(&m_vecBottom[unIndex]);
+			__m128 cos = _mm_loadu_ps(&m_vecCos[unIndex]);
+			__m128 sin = _mm_loadu_ps(&m_vecSin[unIndex]);
+
+			/* x = pivot.x + cos * local.x - sin * local.y, y = pivot.y + sin * local.x + cos * local.y */
+			__m128 cosLeft = _mm_mul_ps(cos, left);
+			__m128 cosRight = _mm_mul_ps(cos, right);
+			__m128 sinLeft = _mm_mul_ps(sin, left);
+			__m128 sinRight = _mm_mul_ps(sin, right);
+			__m128 sinTop = _mm_mul_ps(sin, top);
+			__m128 sinBottom = _mm_mul_ps(sin, bottom);
+			__m128 cosTop = _mm_mul_ps(cos, top);
+			__m128 cosBottom = _mm_mul_ps(cos, bottom);
+
+			__m128 arrCornersX[4] =
+			{
+				_mm_add_ps(pivotX, _mm_sub_ps(cosLeft, sinTop)),		/* Top-Left */
+				_mm_add_ps(pivotX, _mm_sub_ps(cosRight, sinTop)),		/* Top-Right */
+				_mm_add_ps(pivotX, _mm_sub_ps(cosRight, sinBottom)),	/* Bottom-Right */
+				_mm_add_ps(pivotX, _mm_sub_ps(cosLeft, sinBottom))		/* Bottom-Left */
+			};
+			__m128 arrCornersY[4] =
+			{
+				_mm_add_ps(pivotY, _mm_add_ps(sinLeft, cosTop)),
+				_mm_add_ps(pivotY, _mm_add_ps(sinRight, cosTop)),
+				_mm_add_ps(pivotY, _mm_add_ps(sinRight, cosBottom)),
+				_mm_add_ps(pivotY, _mm_add_ps(sinLeft, cosBottom))
+			};
+
+			/* Interleave x and y and scatter the pairs into the vertices of the 4 sprites. */
+			unsigned char* ptrFirstVertex = ptrOut + unIndex * 4 * unStride;
+			size_t unSpriteStride = static_cast<size_t>(unStride) * 4;
+			for (unsigned int unCorner = 0; unCorner < 4; ++unCorner)
+			{
+				__m128 xy01 = _mm_unpacklo_ps(arrCornersX[unCorner], arrCornersY[unCorner]);
+				__m128 xy23 = _mm_unpackhi_ps(arrCornersX[unCorner], arrCornersY[unCorner]);
+				unsigned char* ptrCorner = ptrFirstVertex + unCorner * unStride;
+				_mm_storel_pi(reinterpret_cast<__m64*>(ptrCorner), xy01);
+				_mm_storeh_pi(reinterpret_cast<__m64*>(ptrCorner + unSpriteStride), xy01);
+				_mm_storel_pi(reinterpret_cast<__m64*>(ptrCorner + unSpriteStride * 2), xy23);
+				_mm_storeh_pi(reinterpret_cast<__m64*>(ptrCorner + unSpriteStride * 3), xy23);
+			}
+		}
+#endif
+
+		TransformQuadsScalar(unIndex, unCount, ptrOut, unStride);
+	}
+
+	void SpriteRects::TransformQuadsScalar(void* ptrOutVertices, unsigned int unStride) const
+	{
+		TransformQuadsScalar(0, GetCount(), static_cast<unsigned char*>(ptrOutVertices), unStride);
+	}
+
+	/* Private methods. */
+	void SpriteRects::TransformQuadsScalar(size_t unFirst, size_t unLast, unsigned char* ptrOut, unsigned int unStride) const
+	{
+		for (size_t unIndex = unFirst; unIndex < unLast; ++unIndex)
+		{
+			float fCos = m_vecCos[unIndex];
+			float fSin = m_vecSin[unIndex];
+			glm::vec2 pivot{ m_vecPivotX[unIndex], m_vecPivotY[unIndex] };
+			glm::vec2 arrLocal[4] =
+			{
+				{ m_vecLeft[unIndex], m_vecTop[unIndex] },		/* Top-Left */
+				{ m_vecRight[unIndex], m_vecTop[unIndex] },		/* Top-Right */
+				{ m_vecRight[unIndex], m_vecBottom[unIndex] },	/* Bottom-Right */
+				{ m_vecLeft[unIndex], m_vecBottom[unIndex] }	/* Bottom-Left */
+			};
+
+			unsigned char* ptrVertex = ptrOut + unIndex * 4 * unStride;
+			for (const auto& local : arrLocal)
+			{
+				glm::vec2 pos{ pivot.x + fCos * local.x - fSin * local.y, pivot.y + fSin * local.x + fCos * local.y };
+				std::memcpy(ptrVertex, &pos, sizeof(pos));
+				ptrVertex += unStride;
+			}
+		}
+	}
+}
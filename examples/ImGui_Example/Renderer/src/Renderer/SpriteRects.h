@@ -0,0 +1,89 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include <SDL.h>
+#include <glm/glm.hpp>
+
+namespace K9
+{
+	/// <summary>
+	/// Destination rects of sprites in structure-of-arrays form, expanded into quads in one pass.
+	/// Flipping, rotation and origin are folded into the local corner extents on Push,
+	/// so the expansion only does multiply-adds and runs 4 sprites at a time with SSE.
+	/// </summary>
+	class SpriteRects
+	{
+	public:
+		SpriteRects() = default;
+
+		/// <summary>
+		/// Reserve memory for a number of sprites.
+		/// </summary>
+		/// <param name="unCount"> Number of sprites. </param>
+		void Reserve(size_t unCount);
+
+		/// <summary>
+		/// Remove all sprites. The memory is kept.
+		/// </summary>
+		void Clear();
+
+		/// <summary>
+		/// Retrieve the number of sprites.
+		/// </summary>
+		/// <returns> Number of sprites. </returns>
+		size_t GetCount() const { return m_vecPivotX.size(); }
+
+		/// <summary>
+		/// Add a sprite.
+		/// </summary>
+		/// <param name="destRect"> Destination rect in screen space. </param>
+		/// <param name="flipFormat"> Flip format. The quad is mirrored around the rect center. </param>
+		/// <param name="fAngle"> Rotation in degrees, clockwise on screen like SDL_RenderCopyEx. </param>
+		/// <param name="origin"> Rotation origin, relative to the top-left of destRect. </param>
+		void Push(const SDL_Rect& destRect, SDL_RendererFlip flipFormat,
+			float fAngle = 0.0f, const glm::vec2& origin = { 0.0f, 0.0f });
+
+		/// <summary>
+		/// Write the 4 corners of every sprite as glm::vec2 positions into interleaved vertices.
+		/// The corner order is top-left, top-right, bottom-right, bottom-left.
+		/// Uses SSE, if the target supports it.
+		/// </summary>
+		/// <param name="ptrOutVertices"> First vertex. The position must be at offset 0. Holds 4 vertices per sprite. </param>
+		/// <param name="unStride"> Size of a single vertex in bytes. </param>
+		void TransformQuads(void* ptrOutVertices, unsigned int unStride) const;
+
+		/// <summary>
+		/// Same as TransformQuads, without SIMD. Used as a reference.
+		/// </summary>
+		/// <param name="ptrOutVertices"> First vertex. The position must be at offset 0. Holds 4 vertices per sprite. </param>
+		/// <param name="unStride"> Size of a single vertex in bytes. </param>
+		void TransformQuadsScalar(void* ptrOutVertices, unsigned int unStride) const;
+
+	private:
+		/// <summary>
+		/// Expand the sprites in the range [unFirst, unLast) without SIMD.
+		/// </summary>
+		void TransformQuadsScalar(size_t unFirst, size_t unLast, unsigned char* ptrOut, unsigned int unStride) const;
+
+	private:
+		/// <summary>
+		/// Screen position of the rotation origin.
+		/// </summary>
+		std::vector<float> m_vecPivotX;
+		std::vector<float> m_vecPivotY;
+
+		/// <summary>
+		/// Local x of the left and right corners and local y of the top and bottom corners, relative to the origin.
+		/// </summary>
+		std::vector<float> m_vecLeft;
+		std::vector<float> m_vecRight;
+		std::vector<float> m_vecTop;
+		std::vector<float> m_vecBottom;
+
+		/// <summary>
+		/// Cosine and sine of the rotation.
+		/// </summary>
+		std::vector<float> m_vecCos;
+		std::vector<float> m_vecSin;
+	};
+}
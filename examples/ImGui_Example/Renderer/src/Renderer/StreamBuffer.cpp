@@ -0,0 +1,303 @@
+#include "StreamBuffer.h"
+#include <cstring>
+#include <iostream>
+#include <SDL.h>
+#include <glad/glad.h>
+#include "GLStateCache.h"
+
+namespace K9
+{
+	/* Timeout of a single fence wait in nanoseconds. */
+	static constexpr GLuint64 FENCE_WAIT_TIMEOUT_NS{ 1000000 };
+
+	StreamBuffer::StreamBuffer()
+		: m_unBufferID{ 0 }, m_eMode{ EMode::eMapRange }, m_unSegmentSize{ 0 }, m_unSegment{ 0 },
+		m_unHead{ 0 }, m_ptrMapped{ nullptr }, m_arrFences{},
+		m_unMappedOffset{ 0 }, m_unMappedSize{ 0 }, m_vecStaging{}, m_stats{}
+	{
+	}
+
+	StreamBuffer::~StreamBuffer()
+	{
+		Destroy();
+	}
+
+	bool StreamBuffer::Init(unsigned int unSegmentSize, EMode ePreferredMode)
+	{
+		Destroy();
+
+		/* Keep every segment aligned, so the writes inside it are aligned too. */
+		m_unSegmentSize = (unSegmentSize + WRITE_ALIGNMENT - 1) / WRITE_ALIGNMENT * WRITE_ALIGNMENT;
+		m_eMode = ePreferredMode;
+		if (m_eMode == EMode::ePersistent && !IsPersistentMappingSupported())
+		{
+			m_eMode = EMode::eMapRange;
+		}
+
+		GLsizeiptr nBufferSize = static_cast<GLsizeiptr>(m_unSegmentSize) * SEGMENT_COUNT;
+		glGenBuffers(1, &m_unBufferID);
+		Bind();
+
+		if (m_eMode == EMode::ePersistent)
+		{
+			GLbitfield unFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+			glBufferStorage(GL_ARRAY_BUFFER, nBufferSize, nullptr, unFlags);
+			m_ptrMapped = static_cast<unsigned char*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, nBufferSize, unFlags));
+			if (m_ptrMapped == nullptr)
+			{
+				std::cerr << "StreamBuffer::Init Failed to map the buffer persistently! Falling back to glMapBufferRange.\n";
+				glDeleteBuffers(1, &m_unBufferID);
+				GLStateCache::Ref().OnBufferDeleted(m_unBufferID);
+				m_eMode = EMode::eMapRange;
+				glGenBuffers(1, &m_unBufferID);
+				Bind();
+			}
+		}
+
+		if (m_eMode != EMode::ePersistent)
+		{
+			glBufferData(GL_ARRAY_BUFFER, nBufferSize, nullptr, GL_STREAM_DRAW);
+		}
+
+		m_unSegment = 0;
+		m_unHead = 0;
+		return m_unBufferID != 0;
+	}
+
+	bool StreamBuffer::Write(const void* ptrData, unsigned int unSize, unsigned int& unOutOffset)
+	{
+		if (!Allocate(unSize, unOutOffset))
+		{
+			return false;
+		}
+
+		switch (m_eMode)
+		{
+		case EMode::ePersistent:
+			std::memcpy(m_ptrMapped + unOutOffset, ptrData, unSize);
+			break;
+		case EMode::eMapRange:
+		{
+			/* The fence of the segment was already waited on, so no implicit sync is needed. */
+			Bind();
+			void* ptrMapped = glMapBufferRange(GL_ARRAY_BUFFER, unOutOffset, unSize,
+				GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+			if (ptrMapped == nullptr)
+			{
+				std::cerr << "StreamBuffer::Write Failed to map the buffer range!\n";
+				return false;
+			}
+			std::memcpy(ptrMapped, ptrData, unSize);
+			glUnmapBuffer(GL_ARRAY_BUFFER);
+			break;
+		}
+		case EMode::eOrphan:
+			Bind();
+			glBufferSubData(GL_ARRAY_BUFFER, unOutOffset, unSize, ptrData);
+			break;
+		default: break;
+		}
+		return true;
+	}
+
+	void* StreamBuffer::Map(unsigned int unSize, unsigned int& unOutOffset)
+	{
+		if (!Allocate(unSize, unOutOffset))
+		{
+			return nullptr;
+		}
+
+		void* ptrMapped = nullptr;
+		switch (m_eMode)
+		{
+		case EMode::ePersistent:
+			ptrMapped = m_ptrMapped + unOutOffset;
+			break;
+		case EMode::eMapRange:
+			/* Same as Write, but the range stays mapped until Unmap. */
+			Bind();
+			ptrMapped = glMapBufferRange(GL_ARRAY_BUFFER, unOutOffset, unSize,
+				GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+			if (ptrMapped == nullptr)
+			{
+				std::cerr << "StreamBuffer::Map Failed to map the buffer range!\n";
+				return nullptr;
+			}
+			break;
+		case EMode::eOrphan:
+			/* resize only allocates when the mapping outgrows all previous ones. */
+			m_vecStaging.resize(unSize);
+			ptrMapped = m_vecStaging.data();
+			break;
+		default: break;
+		}
+
+		m_unMappedOffset = unOutOffset;
+		m_unMappedSize = unSize;
+		return ptrMapped;
+	}
+
+	void StreamBuffer::Unmap()
+	{
+		if (m_unMappedSize == 0)
+		{
+			return;
+		}
+
+		switch (m_eMode)
+		{
+		case EMode::eMapRange:
+			Bind();
+			glUnmapBuffer(GL_ARRAY_BUFFER);
+			break;
+		case EMode::eOrphan:
+			Bind();
+			glBufferSubData(GL_ARRAY_BUFFER, m_unMappedOffset, m_unMappedSize, m_vecStaging.data());
+			break;
+		default: break;
+		}
+		m_unMappedSize = 0;
+	}
+
+	void StreamBuffer::NextSegment()
+	{
+		unsigned int unSegmentStart = m_unSegment * m_unSegmentSize;
+		if (m_unHead == unSegmentStart)
+		{
+			/* Nothing was written, the segment can be used again. */
+			return;
+		}
+
+		m_unSegment = (m_unSegment + 1) % SEGMENT_COUNT;
+		m_unHead = m_unSegment * m_unSegmentSize;
+
+		if (m_eMode == EMode::eOrphan)
+		{
+			/* The driver hands out new storage, once the ring wraps. */
+			if (m_unSegment == 0)
+			{
+				Bind();
+				glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(m_unSegmentSize) * SEGMENT_COUNT,
+					nullptr, GL_STREAM_DRAW);
+			}
+			return;
+		}
+
+		/* Fence the previous segment after the draws, which read it. */
+		unsigned int unPrevSegment = (m_unSegment + SEGMENT_COUNT - 1) % SEGMENT_COUNT;
+		m_arrFences[unPrevSegment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		WaitForSegment(m_unSegment);
+	}
+
+	void StreamBuffer::Bind()
+	{
+		GLStateCache::Ref().BindArrayBuffer(m_unBufferID);
+	}
+
+	void StreamBuffer::ResetStats()
+	{
+		m_stats = SStats{};
+	}
+
+	bool StreamBuffer::IsPersistentMappingSupported()
+	{
+		if (GLAD_GL_VERSION_4_4)
+		{
+			return glad_glBufferStorage != nullptr;
+		}
+
+		/* glad only loads the functions of the context version, so load the extension entry point. */
+		if (SDL_GL_ExtensionSupported("GL_ARB_buffer_storage") == SDL_FALSE)
+		{
+			return false;
+		}
+
+		if (glad_glBufferStorage == nullptr)
+		{
+			glad_glBufferStorage = reinterpret_cast<PFNGLBUFFERSTORAGEPROC>(SDL_GL_GetProcAddress("glBufferStorage"));
+		}
+		return glad_glBufferStorage != nullptr;
+	}
+
+	/* Private methods. */
+	void StreamBuffer::WaitForSegment(unsigned int unSegment)
+	{
+		GLsync fence = m_arrFences[unSegment];
+		if (fence == nullptr)
+		{
+			return;
+		}
+
+		/* Poll first, a signaled fence isn't a stall. */
+		GLenum eResult = glClientWaitSync(fence, 0, 0);
+		if (eResult == GL_TIMEOUT_EXPIRED)
+		{
+			m_stats.m_unStallCount++;
+			Uint64 unStart = SDL_GetPerformanceCounter();
+			do
+			{
+				eResult = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_WAIT_TIMEOUT_NS);
+			} while (eResult == GL_TIMEOUT_EXPIRED);
+			Uint64 unEnd = SDL_GetPerformanceCounter();
+			m_stats.m_fWaitTimeMS += static_cast<float>(unEnd - unStart) * 1000.0f
+				/ static_cast<float>(SDL_GetPerformanceFrequency());
+		}
+
+		if (eResult == GL_WAIT_FAILED)
+		{
+			std::cerr << "StreamBuffer::WaitForSegment glClientWaitSync failed!\n";
+		}
+
+		glDeleteSync(fence);
+		m_arrFences[unSegment] = nullptr;
+	}
+
+	bool StreamBuffer::Allocate(unsigned int unSize, unsigned int& unOutOffset)
+	{
+		if (unSize > m_unSegmentSize)
+		{
+			std::cerr << "StreamBuffer::Allocate unSize(" << unSize << ") exceeds the segment size("
+				<< m_unSegmentSize << ")!\n";
+			return false;
+		}
+
+		unsigned int unSegmentEnd = (m_unSegment + 1) * m_unSegmentSize;
+		if (m_unHead + unSize > unSegmentEnd)
+		{
+			NextSegment();
+		}
+
+		unOutOffset = m_unHead;
+		m_unHead += (unSize + WRITE_ALIGNMENT - 1) / WRITE_ALIGNMENT * WRITE_ALIGNMENT;
+		m_stats.m_unBytesWritten += unSize;
+		return true;
+	}
+
+	void StreamBuffer::Destroy()
+	{
+		for (auto& fence : m_arrFences)
+		{
+			if (fence != nullptr)
+			{
+				glDeleteSync(fence);
+				fence = nullptr;
+			}
+		}
+
+		if (m_unBufferID == 0)
+		{
+			return;
+		}
+
+		if (m_ptrMapped != nullptr)
+		{
+			Bind();
+			glUnmapBuffer(GL_ARRAY_BUFFER);
+			m_ptrMapped = nullptr;
+		}
+
+		glDeleteBuffers(1, &m_unBufferID);
+		GLStateCache::Ref().OnBufferDeleted(m_unBufferID);
+		m_unBufferID = 0;
+	}
+}
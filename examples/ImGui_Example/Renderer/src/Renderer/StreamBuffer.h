@@ -0,0 +1,208 @@
+#pragma once
+#include <array>
+#include <vector>
+
+using GLuint = unsigned int;
+using GLsync = struct __GLsync*;
+
+namespace K9
+{
+	/// <summary>
+	/// Ring buffer over a single GL_ARRAY_BUFFER, used to stream dynamic vertex and instance data.
+	/// The buffer is split into SEGMENT_COUNT segments, which are written one after another.
+	/// A fence is placed after a segment is used, and the segment is reused only after the GPU is done with it.
+	/// </summary>
+	class StreamBuffer
+	{
+	public:
+		/// <summary>
+		/// Number of segments, so the CPU can write one frame, while the GPU reads the previous two.
+		/// </summary>
+		static constexpr unsigned int SEGMENT_COUNT{ 3 };
+
+		/// <summary>
+		/// Alignment of every write in bytes.
+		/// </summary>
+		static constexpr unsigned int WRITE_ALIGNMENT{ 16 };
+
+		/* How data is written into the buffer. */
+		enum class EMode
+		{
+			/* Immutable storage via glBufferStorage, mapped once for the whole lifetime. Needs GL 4.4 or ARB_buffer_storage. */
+			ePersistent,
+			/* glMapBufferRange with GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT per write. */
+			eMapRange,
+			/* glBufferSubData per write. The storage is orphaned with glBufferData when the ring wraps. */
+			eOrphan
+		};
+
+		/// <summary>
+		/// Synchronization statistics since the last ResetStats.
+		/// </summary>
+		struct SStats
+		{
+			/// <summary>
+			/// Number of times a segment was still in use by the GPU and the CPU had to wait.
+			/// </summary>
+			unsigned int m_unStallCount = 0;
+
+			/// <summary>
+			/// Time, spent waiting on fences in milliseconds.
+			/// </summary>
+			float m_fWaitTimeMS = 0.0f;
+
+			/// <summary>
+			/// Number of bytes, written into the buffer.
+			/// </summary>
+			unsigned int m_unBytesWritten = 0;
+		};
+
+		StreamBuffer();
+		~StreamBuffer();
+
+		/** Delete the copy constructor, move constructor and assignment operators. */
+		StreamBuffer(const StreamBuffer&) = delete;
+		StreamBuffer(StreamBuffer&&) = delete;
+		StreamBuffer& operator=(const StreamBuffer&) = delete;
+		StreamBuffer& operator=(StreamBuffer&) = delete;
+
+		/// <summary>
+		/// Create the buffer. ePersistent falls back to eMapRange, if it isn't supported by the context.
+		/// </summary>
+		/// <param name="unSegmentSize"> Size of a single segment in bytes. The largest possible write. </param>
+		/// <param name="ePreferredMode"> Mode to be used, if supported. </param>
+		/// <returns> True, if the buffer was created. </returns>
+		bool Init(unsigned int unSegmentSize, EMode ePreferredMode = EMode::ePersistent);
+
+		/// <summary>
+		/// Copy data into the current segment. Moves to the next segment, if the current one is full.
+		/// </summary>
+		/// <param name="ptrData"> Data to be written. </param>
+		/// <param name="unSize"> Size of the data in bytes. Must not exceed the segment size. </param>
+		/// <param name="unOutOffset"> Byte offset of the written data in the buffer. </param>
+		/// <returns> True, if the data was written. </returns>
+		bool Write(const void* ptrData, unsigned int unSize, unsigned int& unOutOffset);
+
+		/// <summary>
+		/// Reserve space in the current segment and return a pointer to fill it directly, instead of copying.
+		/// The pointer may be written from other threads, but must be unmapped on this one before drawing.
+		/// In EMode::eOrphan it points into a staging buffer, which is uploaded on Unmap.
+		/// </summary>
+		/// <param name="unSize"> Size of the data in bytes. Must not exceed the segment size. </param>
+		/// <param name="unOutOffset"> Byte offset of the reserved space in the buffer. </param>
+		/// <returns> Pointer to the reserved space or nullptr, if it couldn't be mapped. </returns>
+		void* Map(unsigned int unSize, unsigned int& unOutOffset);
+
+		/// <summary>
+		/// Finish writing the space, returned by Map.
+		/// </summary>
+		void Unmap();
+
+		/// <summary>
+		/// Fence the current segment, if anything was written into it, and move to the next one.
+		/// Called once per frame, so a segment holds the data of a single frame.
+		/// </summary>
+		void NextSegment();
+
+		/// <summary>
+		/// Bind the buffer to GL_ARRAY_BUFFER.
+		/// </summary>
+		void Bind();
+
+		/// <summary>
+		/// Retrieve the mode, used by the buffer.
+		/// </summary>
+		/// <returns> m_eMode. </returns>
+		EMode GetMode() const { return m_eMode; }
+
+		/// <summary>
+		/// Retrieve the synchronization statistics since the last ResetStats.
+		/// </summary>
+		/// <returns> m_stats. </returns>
+		const SStats& GetStats() const { return m_stats; }
+
+		/// <summary>
+		/// Reset the synchronization statistics.
+		/// </summary>
+		void ResetStats();
+
+		/// <summary>
+		/// Check if persistently mapped buffers are supported by the current context.
+		/// Loads glBufferStorage from ARB_buffer_storage, if the context version is lower than 4.4.
+		/// </summary>
+		/// <returns> True, if glBufferStorage is available. </returns>
+		static bool IsPersistentMappingSupported();
+
+	private:
+		/// <summary>
+		/// Wait until the GPU is done with a segment.
+		/// </summary>
+		/// <param name="unSegment"> Index of the segment. </param>
+		void WaitForSegment(unsigned int unSegment);
+
+		/// <summary>
+		/// Reserve space in the current segment. Moves to the next segment, if the current one is full.
+		/// </summary>
+		/// <param name="unSize"> Size of the data in bytes. </param>
+		/// <param name="unOutOffset"> Byte offset of the reserved space in the buffer. </param>
+		/// <returns> True, if the size fits in a segment. </returns>
+		bool Allocate(unsigned int unSize, unsigned int& unOutOffset);
+
+		/// <summary>
+		/// Unmap and delete the buffer and its fences.
+		/// </summary>
+		void Destroy();
+
+	private:
+		/// <summary>
+		/// OpenGL ID of the buffer.
+		/// </summary>
+		GLuint m_unBufferID;
+
+		/// <summary>
+		/// Mode, used to write into the buffer.
+		/// </summary>
+		EMode m_eMode;
+
+		/// <summary>
+		/// Size of a single segment in bytes.
+		/// </summary>
+		unsigned int m_unSegmentSize;
+
+		/// <summary>
+		/// Index of the segment, which is currently written.
+		/// </summary>
+		unsigned int m_unSegment;
+
+		/// <summary>
+		/// Byte offset of the next write.
+		/// </summary>
+		unsigned int m_unHead;
+
+		/// <summary>
+		/// Start of the mapped buffer. Only valid in EMode::ePersistent.
+		/// </summary>
+		unsigned char* m_ptrMapped;
+
+		/// <summary>
+		/// Fences, placed after the GPU commands, reading each segment.
+		/// </summary>
+		std::array<GLsync, SEGMENT_COUNT> m_arrFences;
+
+		/// <summary>
+		/// Byte offset and size of the space, returned by Map. m_unMappedSize is 0, while nothing is mapped.
+		/// </summary>
+		unsigned int m_unMappedOffset;
+		unsigned int m_unMappedSize;
+
+		/// <summary>
+		/// Data, written through Map in EMode::eOrphan.
+		/// </summary>
+		std::vector<unsigned char> m_vecStaging;
+
+		/// <summary>
+		/// Synchronization statistics.
+		/// </summary>
+		SStats m_stats;
+	};
+}
@@ -1,7 +1,9 @@
 #include "Texture.h"
 
 #include <glad/glad.h>
+#include "GLStateCache.h"
 #include <SDL_image.h>
+#include <atomic>
 #include <iostream>
 
 namespace K9
@@ -11,8 +13,10 @@ namespace K9
 		m_nWidth(0),
 		m_nHeight(0),
 		m_eImageInternalFormat(GL_ZERO),
-		m_eImageDataFormat(GL_ZERO)
+		m_eImageDataFormat(GL_ZERO),
+		m_unContentVersion(0)
 	{
+		BumpContentVersion();
 	}
 
 	Texture::~Texture()
@@ -45,10 +49,11 @@ namespace K9
 
 
 		glGenTextures(1, &m_unTextureID);
-		glBindTexture(GL_TEXTURE_2D, m_unTextureID);
+		GLStateCache::Ref().BindTexture(0, m_unTextureID);
 
 		glTexImage2D(GL_TEXTURE_2D, 0, nFormat, m_nWidth, m_nHeight, 0, nFormat,
 			GL_UNSIGNED_BYTE, surface->pixels);
+		BumpContentVersion();
 
 		std::cout << " Loading texture: " << m_strFileName << ", width: " << m_nWidth << ", height: " << m_nHeight
 			<< ", nFormat: " << nFormat
@@ -59,16 +64,7 @@ namespace K9
 
 		/* Generate mipmaps for texture */
 		glGenerateMipmap(GL_TEXTURE_2D);
-		/* Enable bilinear filtering */
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-		/* Enable anisotropic filtering, if supported */
-		/* Get the maximum anisotropy value */
-		GLfloat fMaxAnisotropyValue;
-		glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY, &fMaxAnisotropyValue);
-		/* Enable anisotropy */
-		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY, fMaxAnisotropyValue);
+		SetMipmapFiltering();
 
 		return true;
 	}
@@ -76,6 +72,9 @@ namespace K9
 	void Texture::Unload()
 	{
 		glDeleteTextures(1, &m_unTextureID);
+		GLStateCache::Ref().OnTextureDeleted(m_unTextureID);
+		m_unTextureID = 0;
+		BumpContentVersion();
 	}
 
 	void Texture::CreateFromSurface(SDL_Surface* ptrSurface)
@@ -85,9 +84,10 @@ namespace K9
 
 		/* Generate a GL Texture */
 		glGenTextures(1, &m_unTextureID);
-		glBindTexture(GL_TEXTURE_2D, m_unTextureID);
+		GLStateCache::Ref().BindTexture(0, m_unTextureID);
 		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, m_nWidth, m_nHeight, 0, GL_RGBA,
 			GL_UNSIGNED_BYTE, ptrSurface->pixels);
+		BumpContentVersion();
 		/* Use linear filtering */
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -99,20 +99,50 @@ namespace K9
 		m_nHeight = nHeight;
 		/* Create the texture ID */
 		glGenTextures(1, &m_unTextureID);
-		glBindTexture(GL_TEXTURE_2D, m_unTextureID);
+		GLStateCache::Ref().BindTexture(0, m_unTextureID);
 		/* Set the image width/height with nullptr initial data */
 		glTexImage2D(GL_TEXTURE_2D, 0, nFormat, m_nWidth, m_nHeight, 0, GL_RGB,
 			GL_FLOAT, nullptr);
+		BumpContentVersion();
 
 		/* For a texture we'll render to, just use nearest neighbor */
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	}
+
+	void Texture::CreateForStreaming(const std::string& strFileName, int nWidth, int nHeight)
+	{
+		m_strFileName = strFileName;
+		m_nWidth = nWidth;
+		m_nHeight = nHeight;
+
+		glGenTextures(1, &m_unTextureID);
+		GLStateCache::Ref().BindTexture(0, m_unTextureID);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, m_nWidth, m_nHeight, 0, GL_RGBA,
+			GL_UNSIGNED_BYTE, nullptr);
+		BumpContentVersion();
+		SetMipmapFiltering();
+	}
+
+	void Texture::UpdateRows(int nFirstRow, int nRowCount, const void* ptrPixels)
+	{
+		GLStateCache::Ref().BindTexture(0, m_unTextureID);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, nFirstRow, m_nWidth, nRowCount, GL_RGBA,
+			GL_UNSIGNED_BYTE, ptrPixels);
+		BumpContentVersion();
+	}
+
+	void Texture::FinishStreaming()
+	{
+		GLStateCache::Ref().BindTexture(0, m_unTextureID);
+		glGenerateMipmap(GL_TEXTURE_2D);
 	}
 
 	void Texture::SetActive(int nIndex /*= 0 */) const
 	{
-		glActiveTexture(GL_TEXTURE0 + nIndex);
-		glBindTexture(GL_TEXTURE_2D, m_unTextureID);
+		GLStateCache::Ref().BindTexture(static_cast<unsigned int>(nIndex), m_unTextureID);
 	}
 
 	bool Texture::GetFormat(SDL_Surface* ptrSurface, int& nChannelCount, int& nFormat)
@@ -151,6 +181,27 @@ namespace K9
 		return true;
 	}
 
+	void Texture::SetMipmapFiltering()
+	{
+		/* Enable bilinear filtering */
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+		/* Enable anisotropic filtering, if supported */
+		/* Get the maximum anisotropy value */
+		GLfloat fMaxAnisotropyValue;
+		glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY, &fMaxAnisotropyValue);
+		/* Enable anisotropy */
+		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY, fMaxAnisotropyValue);
+	}
+
+	void Texture::BumpContentVersion()
+	{
+		/* A process-wide counter, so a reused GL name or Texture object never repeats a version. */
+		static std::atomic<uint64_t> unNextVersion{ 1 };
+		m_unContentVersion = unNextVersion.fetch_add(1);
+	}
+
 	void Texture::FlipSurface(SDL_Surface* surface)
 	{
 		SDL_LockSurface(surface);
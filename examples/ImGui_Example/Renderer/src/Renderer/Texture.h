@@ -1,4 +1,5 @@
 #pragma once
+#include <cstdint>
 #include <string>
 
 using GLenum = unsigned int;
@@ -16,14 +17,25 @@ namespace K9
 		void CreateFromSurface(SDL_Surface* ptrSurface);
 		void CreateForRendering(int nWidth, int nHeight, int nFormat);
 
+		/* Allocate RGBA storage, which is filled by UpdateRows, e.g. over several frames. */
+		void CreateForStreaming(const std::string& strFileName, int nWidth, int nHeight);
+		/* Upload tightly packed RGBA rows. ptrPixels is an offset, while a pixel unpack buffer is bound. */
+		void UpdateRows(int nFirstRow, int nRowCount, const void* ptrPixels);
+		/* Generate the mipmaps, once every row is uploaded. */
+		void FinishStreaming();
+
 		void SetActive(int nIndex = 0) const;
 
 		int GetWidth() const { return m_nWidth; }
 		int GetHeight() const { return m_nHeight; }
 		unsigned int GetTextureID() const { return m_unTextureID; }
 		const std::string& GetFileName() const { return m_strFileName; }
+		/* Changes on every upload and Unload, unlike the GL name, which the driver may reuse */
+		uint64_t GetContentVersion() const { return m_unContentVersion; }
 	private:
 		bool GetFormat(SDL_Surface* ptrSurface, int& nChannelCount, int& nFormat);
+		void SetMipmapFiltering();
+		void BumpContentVersion();
 		void FlipSurface(SDL_Surface* surface);
 	private:
 		/* File name of this texture */
@@ -37,5 +49,8 @@ namespace K9
 		int m_nHeight;
 		GLenum m_eImageInternalFormat;
 		GLenum m_eImageDataFormat;
+
+		/* Unique across all textures, so damage tracking notices new contents */
+		uint64_t m_unContentVersion;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,68 @@
+#include "TextureSlots.h"
+#include <algorithm>
+#include <glad/glad.h>
+
+#include "Texture.h"
+
+namespace K9
+{
+	TextureSlots::TextureSlots()
+		: m_arrTextures{}, m_unCount{ 0 }, m_unMaxCount{ 1 }
+	{
+	}
+
+	void TextureSlots::Init()
+	{
+		GLint nMaxUnits = 0;
+		glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &nMaxUnits);
+		m_unMaxCount = std::max(1u, std::min(static_cast<unsigned int>(nMaxUnits), MAX_SLOT_COUNT));
+		Clear();
+	}
+
+	int TextureSlots::GetSlot(const Texture& texture)
+	{
+		for (unsigned int unSlot = 0; unSlot < m_unCount; ++unSlot)
+		{
+			if (m_arrTextures[unSlot]->GetTextureID() == texture.GetTextureID())
+			{
+				return static_cast<int>(unSlot);
+			}
+		}
+
+		if (m_unCount >= m_unMaxCount)
+		{
+			return -1;
+		}
+
+		m_arrTextures[m_unCount] = &texture;
+		return static_cast<int>(m_unCount++);
+	}
+
+	void TextureSlots::Bind() const
+	{
+		for (unsigned int unSlot = 0; unSlot < m_unCount; ++unSlot)
+		{
+			m_arrTextures[unSlot]->SetActive(static_cast<int>(unSlot));
+		}
+	}
+
+	void TextureSlots::Clear()
+	{
+		m_arrTextures.fill(nullptr);
+		m_unCount = 0;
+	}
+
+	const int* TextureSlots::GetSamplerUnits()
+	{
+		static const std::array<int, MAX_SLOT_COUNT> arrUnits = []()
+		{
+			std::array<int, MAX_SLOT_COUNT> arrResult{};
+			for (unsigned int unSlot = 0; unSlot < MAX_SLOT_COUNT; ++unSlot)
+			{
+				arrResult[unSlot] = static_cast<int>(unSlot);
+			}
+			return arrResult;
+		}();
+		return arrUnits.data();
+	}
+}
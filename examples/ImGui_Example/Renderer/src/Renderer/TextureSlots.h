@@ -0,0 +1,85 @@
+#pragma once
+#include <array>
+#include "UniformID.h"
+
+namespace K9
+{
+	class Texture;
+
+	/// <summary>
+	/// Table of textures, bound to consecutive texture units for a single draw call.
+	/// Sprites store the slot index of their texture and the fragment shader selects the sampler.
+	/// </summary>
+	class TextureSlots
+	{
+	public:
+		/// <summary>
+		/// Size of the sampler array in the sprite shaders.
+		/// OpenGL 3.3 guarantees at least 16 texture image units.
+		/// </summary>
+		static constexpr unsigned int MAX_SLOT_COUNT{ 16 };
+
+		/// <summary>
+		/// Sampler array uniform of the sprite shaders, set to GetSamplerUnits.
+		/// </summary>
+		static constexpr UniformID SAMPLERS_UNIFORM{ "u_Textures" };
+
+		TextureSlots();
+
+		/// <summary>
+		/// Query the number of texture image units, supported by the driver.
+		/// </summary>
+		void Init();
+
+		/// <summary>
+		/// Retrieve the slot of a texture, adding it to the table if needed.
+		/// </summary>
+		/// <param name="texture"> Texture to be looked up. </param>
+		/// <returns> Slot index of the texture or -1, if the table is full. </returns>
+		int GetSlot(const Texture& texture);
+
+		/// <summary>
+		/// Bind every texture in the table to the texture unit of its slot.
+		/// </summary>
+		void Bind() const;
+
+		/// <summary>
+		/// Remove all textures from the table.
+		/// </summary>
+		void Clear();
+
+		/// <summary>
+		/// Retrieve the number of used slots.
+		/// </summary>
+		/// <returns> m_unCount. </returns>
+		unsigned int GetCount() const { return m_unCount; }
+
+		/// <summary>
+		/// Retrieve the number of usable slots.
+		/// </summary>
+		/// <returns> m_unMaxCount. </returns>
+		unsigned int GetMaxCount() const { return m_unMaxCount; }
+
+		/// <summary>
+		/// Retrieve the texture units for the sampler array uniform: 0, 1, ..., MAX_SLOT_COUNT - 1.
+		/// </summary>
+		/// <returns> Array of MAX_SLOT_COUNT texture units. </returns>
+		static const int* GetSamplerUnits();
+
+	private:
+		/// <summary>
+		/// Textures in the table.
+		/// </summary>
+		std::array<const Texture*, MAX_SLOT_COUNT> m_arrTextures;
+
+		/// <summary>
+		/// Number of used slots.
+		/// </summary>
+		unsigned int m_unCount;
+
+		/// <summary>
+		/// Number of usable slots: min(GL_MAX_TEXTURE_IMAGE_UNITS, MAX_SLOT_COUNT).
+		/// </summary>
+		unsigned int m_unMaxCount;
+	};
+}
@@ -0,0 +1,392 @@
+#include "TextureStreamer.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <SDL.h>
+#include <SDL_image.h>
+#include <glad/glad.h>
+#include "Texture.h"
+
+namespace K9
+{
+	/* Bytes per decoded pixel. */
+	static constexpr size_t PIXEL_SIZE = 4;
+
+	/* Color of the placeholder. */
+	static constexpr unsigned char PLACEHOLDER_TEXEL[PIXEL_SIZE] = { 128, 128, 128, 255 };
+
+	StreamedTexture::StreamedTexture(const std::string& strFileName, const std::shared_ptr<Texture>& ptrPlaceholder, float fPriority)
+		: m_strFileName{ strFileName }, m_ptrPlaceholder{ ptrPlaceholder }, m_ptrTexture{ nullptr }, m_ptrSurface{ nullptr },
+		m_nUploadedRows{ 0 }, m_fPriority{ fPriority }, m_eState{ EState::eQueued }
+	{
+	}
+
+	StreamedTexture::~StreamedTexture()
+	{
+		SDL_FreeSurface(m_ptrSurface);
+	}
+
+	const std::shared_ptr<Texture>& StreamedTexture::GetTexture() const
+	{
+		return IsResident() ? m_ptrTexture : m_ptrPlaceholder;
+	}
+
+	void StreamedTexture::SetPriority(const SDL_Rect& destRect)
+	{
+		m_fPriority = static_cast<float>(std::abs(destRect.w)) * static_cast<float>(std::abs(destRect.h));
+	}
+
+	TextureStreamer::TextureStreamer()
+		: m_threadPool{}, m_decodedMutex{}, m_vecDecoded{}, m_vecQueued{}, m_vecDecoding{}, m_vecUploads{}, m_ptrPlaceholder{ nullptr },
+		m_arrBufferIDs{}, m_arrFences{}, m_unNextBuffer{ 0 }, m_unBufferSize{ 0 }, m_unUploadBudget{ DEFAULT_UPLOAD_BUDGET },
+		m_unMaxDecodeCount{ 1 }, m_stats{}
+	{
+	}
+
+	TextureStreamer::~TextureStreamer()
+	{
+		m_threadPool.Shutdown();
+		for (auto& result : m_vecDecoded)
+		{
+			SDL_FreeSurface(result.m_ptrSurface);
+		}
+	}
+
+	bool TextureStreamer::Init(unsigned int unWorkerCount, size_t unUploadBudget)
+	{
+		Shutdown();
+
+		m_ptrPlaceholder.reset(new Texture());
+		m_ptrPlaceholder->CreateForStreaming("Placeholder", 1, 1);
+		m_ptrPlaceholder->UpdateRows(0, 1, PLACEHOLDER_TEXEL);
+		m_ptrPlaceholder->FinishStreaming();
+
+		m_unUploadBudget = std::max<size_t>(unUploadBudget, 1);
+		m_unBufferSize = m_unUploadBudget;
+		glGenBuffers(BUFFER_COUNT, m_arrBufferIDs.data());
+		for (GLuint unBufferID : m_arrBufferIDs)
+		{
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, unBufferID);
+			glBufferData(GL_PIXEL_UNPACK_BUFFER, static_cast<GLsizeiptr>(m_unBufferSize), nullptr, GL_STREAM_DRAW);
+		}
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		m_unNextBuffer = 0;
+
+		m_threadPool.Init(unWorkerCount);
+		m_unMaxDecodeCount = std::max(unWorkerCount, 1u) * DECODES_PER_WORKER;
+		m_stats = SStats{};
+		return true;
+	}
+
+	void TextureStreamer::Shutdown()
+	{
+		/* Running decodes are finished, so nothing writes m_vecDecoded afterwards. Queued decodes are dropped. */
+		m_threadPool.Shutdown();
+		CollectDecoded();
+
+		for (auto& ptrStream : m_vecDecoding)
+		{
+			ptrStream->m_eState = StreamedTexture::EState::eFailed;
+		}
+
+		for (auto& ptrStream : m_vecUploads)
+		{
+			SDL_FreeSurface(ptrStream->m_ptrSurface);
+			ptrStream->m_ptrSurface = nullptr;
+			ptrStream->m_ptrTexture.reset();
+			ptrStream->m_eState = StreamedTexture::EState::eFailed;
+		}
+		for (auto& ptrStream : m_vecQueued)
+		{
+			ptrStream->m_eState = StreamedTexture::EState::eFailed;
+		}
+		m_vecUploads.clear();
+		m_vecDecoding.clear();
+		m_vecQueued.clear();
+		m_stats.m_unQueuedCount = 0;
+		m_stats.m_unDecodingCount = 0;
+		m_stats.m_unUploadingCount = 0;
+
+		if (!m_ptrPlaceholder)
+		{
+			return;
+		}
+
+		for (auto& fence : m_arrFences)
+		{
+			if (fence != nullptr)
+			{
+				glDeleteSync(fence);
+				fence = nullptr;
+			}
+		}
+		glDeleteBuffers(BUFFER_COUNT, m_arrBufferIDs.data());
+		m_arrBufferIDs.fill(0);
+		m_ptrPlaceholder.reset();
+	}
+
+	TextureHandle TextureStreamer::Load(const std::string& strFileName, float fPriority)
+	{
+		if (!m_ptrPlaceholder && !Init(DEFAULT_WORKER_COUNT, m_unUploadBudget))
+		{
+			std::cerr << "TextureStreamer::Load Failed to start, can't load " << strFileName << "!\n";
+			return nullptr;
+		}
+
+		TextureHandle ptrStream = std::make_shared<StreamedTexture>(strFileName, m_ptrPlaceholder, fPriority);
+		m_vecQueued.push_back(ptrStream);
+		m_stats.m_unQueuedCount++;
+		return ptrStream;
+	}
+
+	void TextureStreamer::Update()
+	{
+		if (!m_ptrPlaceholder)
+		{
+			return;
+		}
+
+		CollectDecoded();
+		SubmitDecodes();
+		UploadRows();
+	}
+
+	void TextureStreamer::Flush()
+	{
+		if (!m_ptrPlaceholder)
+		{
+			return;
+		}
+
+		size_t unUploadedBytes = 0;
+		while (true)
+		{
+			Update();
+			unUploadedBytes += m_stats.m_unUploadedBytes;
+			if (!HasPendingWork())
+			{
+				break;
+			}
+
+			/* Let the GPU release the buffers and the workers finish, instead of spinning on them. */
+			if (m_stats.m_unUploadedBytes == 0)
+			{
+				glFinish();
+				SDL_Delay(1);
+			}
+		}
+		m_stats.m_unUploadedBytes = unUploadedBytes;
+	}
+
+	void TextureStreamer::SetUploadBudget(size_t unUploadBudget)
+	{
+		m_unUploadBudget = std::max<size_t>(unUploadBudget, 1);
+	}
+
+	/* Private methods. */
+	void TextureStreamer::Decode(TextureHandle ptrStream)
+	{
+		/* Converting here keeps the uploads a plain copy of tightly packed RGBA rows. */
+		SDL_Surface* ptrSurface = IMG_Load(ptrStream->m_strFileName.c_str());
+		if (ptrSurface && ptrSurface->format->format != SDL_PIXELFORMAT_RGBA32)
+		{
+			SDL_Surface* ptrConverted = SDL_ConvertSurfaceFormat(ptrSurface, SDL_PIXELFORMAT_RGBA32, 0);
+			SDL_FreeSurface(ptrSurface);
+			ptrSurface = ptrConverted;
+		}
+
+		/* SDL keeps the error per thread, so it is reported here. */
+		if (!ptrSurface)
+		{
+			std::cerr << "TextureStreamer::Decode Failed to load texture " << ptrStream->m_strFileName << ": " << SDL_GetError() << "\n";
+		}
+
+		std::lock_guard<std::mutex> lock(m_decodedMutex);
+		m_vecDecoded.push_back(SDecodeResult{ std::move(ptrStream), ptrSurface });
+	}
+
+	void TextureStreamer::CollectDecoded()
+	{
+		std::vector<SDecodeResult> vecDecoded;
+		{
+			std::lock_guard<std::mutex> lock(m_decodedMutex);
+			vecDecoded.swap(m_vecDecoded);
+		}
+
+		for (auto& result : vecDecoded)
+		{
+			m_vecDecoding.erase(std::find(m_vecDecoding.begin(), m_vecDecoding.end(), result.m_ptrStream));
+			m_stats.m_unDecodingCount--;
+			StreamedTexture& stream = *result.m_ptrStream;
+			if (!result.m_ptrSurface)
+			{
+				stream.m_eState = StreamedTexture::EState::eFailed;
+				m_stats.m_unFailedCount++;
+				continue;
+			}
+
+			if (IsAbandoned(result.m_ptrStream))
+			{
+				SDL_FreeSurface(result.m_ptrSurface);
+				continue;
+			}
+
+			stream.m_ptrSurface = result.m_ptrSurface;
+			stream.m_eState = StreamedTexture::EState::eUploading;
+			m_vecUploads.push_back(std::move(result.m_ptrStream));
+			m_stats.m_unUploadingCount++;
+		}
+	}
+
+	void TextureStreamer::SubmitDecodes()
+	{
+		auto itAbandoned = std::remove_if(m_vecQueued.begin(), m_vecQueued.end(), &TextureStreamer::IsAbandoned);
+		m_stats.m_unQueuedCount -= static_cast<unsigned int>(m_vecQueued.end() - itAbandoned);
+		m_vecQueued.erase(itAbandoned, m_vecQueued.end());
+
+		while (!m_vecQueued.empty() && m_stats.m_unDecodingCount < m_unMaxDecodeCount)
+		{
+			auto it = std::max_element(m_vecQueued.begin(), m_vecQueued.end(),
+				[](const TextureHandle& ptrLeft, const TextureHandle& ptrRight)
+				{
+					return ptrLeft->m_fPriority < ptrRight->m_fPriority;
+				});
+			TextureHandle ptrStream = std::move(*it);
+			m_vecQueued.erase(it);
+			m_stats.m_unQueuedCount--;
+
+			ptrStream->m_eState = StreamedTexture::EState::eDecoding;
+			m_vecDecoding.push_back(ptrStream);
+			m_stats.m_unDecodingCount++;
+			m_threadPool.Submit([this, ptrStream]() { Decode(ptrStream); });
+		}
+	}
+
+	void TextureStreamer::UploadRows()
+	{
+		m_stats.m_unUploadedBytes = 0;
+		size_t unBudget = m_unUploadBudget;
+		while (!m_vecUploads.empty() && unBudget > 0)
+		{
+			auto it = std::max_element(m_vecUploads.begin(), m_vecUploads.end(),
+				[](const TextureHandle& ptrLeft, const TextureHandle& ptrRight)
+				{
+					return ptrLeft->m_fPriority < ptrRight->m_fPriority;
+				});
+			StreamedTexture& stream = **it;
+			if (IsAbandoned(*it))
+			{
+				m_vecUploads.erase(it);
+				m_stats.m_unUploadingCount--;
+				continue;
+			}
+
+			SDL_Surface* ptrSurface = stream.m_ptrSurface;
+			if (!stream.m_ptrTexture)
+			{
+				stream.m_ptrTexture = std::make_shared<Texture>();
+				stream.m_ptrTexture->CreateForStreaming(stream.m_strFileName, ptrSurface->w, ptrSurface->h);
+			}
+
+			/* A row, which exceeds the budget, is still uploaded, so every texture makes progress. */
+			size_t unRowSize = static_cast<size_t>(ptrSurface->w) * PIXEL_SIZE;
+			int nRemainingRows = ptrSurface->h - stream.m_nUploadedRows;
+			int nRowCount = static_cast<int>(std::min<size_t>(nRemainingRows,
+				std::max<size_t>(std::min(unBudget, m_unBufferSize) / unRowSize, 1)));
+			if (!UploadChunk(stream, nRowCount))
+			{
+				m_stats.m_unBufferBusyCount++;
+				return;
+			}
+
+			size_t unChunkSize = static_cast<size_t>(nRowCount) * unRowSize;
+			m_stats.m_unUploadedBytes += unChunkSize;
+			unBudget -= std::min(unBudget, unChunkSize);
+
+			stream.m_nUploadedRows += nRowCount;
+			if (stream.m_nUploadedRows == ptrSurface->h)
+			{
+				stream.m_ptrTexture->FinishStreaming();
+				SDL_FreeSurface(ptrSurface);
+				stream.m_ptrSurface = nullptr;
+				stream.m_eState = StreamedTexture::EState::eResident;
+				m_vecUploads.erase(it);
+				m_stats.m_unUploadingCount--;
+				m_stats.m_unResidentCount++;
+			}
+		}
+	}
+
+	bool TextureStreamer::UploadChunk(StreamedTexture& stream, int nRowCount)
+	{
+		SDL_Surface* ptrSurface = stream.m_ptrSurface;
+		size_t unRowSize = static_cast<size_t>(ptrSurface->w) * PIXEL_SIZE;
+		size_t unChunkSize = static_cast<size_t>(nRowCount) * unRowSize;
+		const unsigned char* ptrFirstRow = static_cast<const unsigned char*>(ptrSurface->pixels)
+			+ static_cast<size_t>(stream.m_nUploadedRows) * ptrSurface->pitch;
+
+		/* Rows are uploaded one by one, if the pitch is padded. SDL pads 4 byte pixels only for its own surfaces. */
+		if (unChunkSize > m_unBufferSize || static_cast<size_t>(ptrSurface->pitch) != unRowSize)
+		{
+			for (int nRow = 0; nRow < nRowCount; ++nRow)
+			{
+				stream.m_ptrTexture->UpdateRows(stream.m_nUploadedRows + nRow, 1, ptrFirstRow + nRow * ptrSurface->pitch);
+			}
+			return true;
+		}
+
+		if (!IsBufferFree())
+		{
+			return false;
+		}
+
+		/* The fence guarantees, that the GPU is done with the buffer, so the driver needn't synchronize. */
+		GLuint unBufferID = m_arrBufferIDs[m_unNextBuffer];
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, unBufferID);
+		void* ptrMapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, static_cast<GLsizeiptr>(unChunkSize),
+			GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+		if (ptrMapped == nullptr)
+		{
+			/* Client memory still works, it just copies on the calling thread. */
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+			stream.m_ptrTexture->UpdateRows(stream.m_nUploadedRows, nRowCount, ptrFirstRow);
+			return true;
+		}
+
+		std::memcpy(ptrMapped, ptrFirstRow, unChunkSize);
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+		stream.m_ptrTexture->UpdateRows(stream.m_nUploadedRows, nRowCount, nullptr);
+
+		/* Other uploads pass client memory, which a bound buffer would turn into an offset. */
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+		m_arrFences[m_unNextBuffer] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		m_unNextBuffer = (m_unNextBuffer + 1) % BUFFER_COUNT;
+		return true;
+	}
+
+	bool TextureStreamer::IsBufferFree()
+	{
+		GLsync& fence = m_arrFences[m_unNextBuffer];
+		if (fence == nullptr)
+		{
+			return true;
+		}
+
+		/* Poll only. The flush bit submits the fence, so it signals, even if nothing else is sent this frame. */
+		GLenum eResult = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+		if (eResult == GL_TIMEOUT_EXPIRED)
+		{
+			return false;
+		}
+
+		if (eResult == GL_WAIT_FAILED)
+		{
+			std::cerr << "TextureStreamer::IsBufferFree glClientWaitSync failed!\n";
+		}
+		glDeleteSync(fence);
+		fence = nullptr;
+		return true;
+	}
+}
@@ -0,0 +1,408 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <Threading/ThreadPool.h>
+
+using GLuint = unsigned int;
+using GLsync = struct __GLsync*;
+struct SDL_Rect;
+struct SDL_Surface;
+
+namespace K9
+{
+	class Texture;
+
+	/// <summary>
+	/// Texture, which is loaded by the TextureStreamer. Shows a placeholder, until every row is uploaded.
+	/// Must be used on the thread, which updates the streamer.
+	/// </summary>
+	class StreamedTexture
+	{
+	public:
+		/// <summary>
+		/// Progress of the texture.
+		/// </summary>
+		enum class EState
+		{
+			/* Waiting for a free decode slot. */
+			eQueued,
+			/* Being decoded by a worker thread. */
+			eDecoding,
+			/* Decoded, the rows are being uploaded. */
+			eUploading,
+			/* Uploaded, GetTexture returns the texture. */
+			eResident,
+			/* The file couldn't be decoded. GetTexture keeps returning the placeholder. */
+			eFailed
+		};
+
+		StreamedTexture(const std::string& strFileName, const std::shared_ptr<Texture>& ptrPlaceholder, float fPriority);
+		~StreamedTexture();
+
+		/** Delete the copy constructor, move constructor and assignment operators. */
+		StreamedTexture(const StreamedTexture&) = delete;
+		StreamedTexture(StreamedTexture&&) = delete;
+		StreamedTexture& operator=(const StreamedTexture&) = delete;
+		StreamedTexture& operator=(StreamedTexture&) = delete;
+
+		/// <summary>
+		/// Retrieve the texture to draw. Can be passed to Renderer2D::DrawTexture, which keeps it alive for the render thread.
+		/// The placeholder is a single texel, so any source rect covers it.
+		/// </summary>
+		/// <returns> The texture, once it is resident, the placeholder otherwise. </returns>
+		const std::shared_ptr<Texture>& GetTexture() const;
+
+		/// <summary>
+		/// Check, if the texture is uploaded.
+		/// </summary>
+		/// <returns> True, if m_eState is EState::eResident. </returns>
+		bool IsResident() const { return m_eState == EState::eResident; }
+
+		/// <summary>
+		/// Retrieve the progress of the texture.
+		/// </summary>
+		/// <returns> m_eState. </returns>
+		EState GetState() const { return m_eState; }
+
+		/// <summary>
+		/// Retrieve the path of the image.
+		/// </summary>
+		/// <returns> m_strFileName. </returns>
+		const std::string& GetFileName() const { return m_strFileName; }
+
+		/// <summary>
+		/// Set the priority. Textures with a higher priority are decoded and uploaded first.
+		/// </summary>
+		/// <param name="fPriority"> Priority to be set. </param>
+		void SetPriority(float fPriority) { m_fPriority = fPriority; }
+
+		/// <summary>
+		/// Set the priority to the area, the texture covers on screen, so large sprites become sharp first.
+		/// </summary>
+		/// <param name="destRect"> Destination rect of the largest sprite, which shows the texture. </param>
+		void SetPriority(const SDL_Rect& destRect);
+
+		/// <summary>
+		/// Retrieve the priority.
+		/// </summary>
+		/// <returns> m_fPriority. </returns>
+		float GetPriority() const { return m_fPriority; }
+
+	private:
+		friend class TextureStreamer;
+
+		/// <summary>
+		/// Path of the image.
+		/// </summary>
+		std::string m_strFileName;
+
+		/// <summary>
+		/// Shown, until the texture is resident.
+		/// </summary>
+		std::shared_ptr<Texture> m_ptrPlaceholder;
+
+		/// <summary>
+		/// Texture, created with the first uploaded rows.
+		/// </summary>
+		std::shared_ptr<Texture> m_ptrTexture;
+
+		/// <summary>
+		/// Decoded RGBA pixels. Freed, once every row is uploaded.
+		/// </summary>
+		SDL_Surface* m_ptrSurface;
+
+		/// <summary>
+		/// Number of rows, uploaded so far.
+		/// </summary>
+		int m_nUploadedRows;
+
+		/// <summary>
+		/// Textures with a higher priority are decoded and uploaded first.
+		/// </summary>
+		float m_fPriority;
+
+		/// <summary>
+		/// Progress of the texture.
+		/// </summary>
+		EState m_eState;
+	};
+
+	/// <summary>
+	/// Handle of a streamed texture. The streamer drops textures, whose handles were all released, before they're resident.
+	/// </summary>
+	using TextureHandle = std::shared_ptr<StreamedTexture>;
+
+	/// <summary>
+	/// Loads textures without stalling the frame.
+	/// Images are decoded into RGBA by worker threads of its own, so the renderer's loops never wait for a file.
+	/// Update uploads the decoded rows on the GL thread through a ring of BUFFER_COUNT pixel unpack buffers.
+	/// Every frame uploads at most the upload budget, so a large image is spread over several frames.
+	/// A fence is placed after every upload, and a buffer is reused only after the GPU is done with it.
+	/// If the next buffer is still in use, the remaining rows wait for the next frame instead of stalling.
+	/// </summary>
+	class TextureStreamer
+	{
+	public:
+		/// <summary>
+		/// Number of pixel unpack buffers in the ring.
+		/// </summary>
+		static constexpr unsigned int BUFFER_COUNT{ 3 };
+
+		/// <summary>
+		/// Default number of decoding threads.
+		/// </summary>
+		static constexpr unsigned int DEFAULT_WORKER_COUNT{ 2 };
+
+		/// <summary>
+		/// Default number of bytes, uploaded per frame. Also the size of every pixel unpack buffer.
+		/// </summary>
+		static constexpr size_t DEFAULT_UPLOAD_BUDGET{ 4 * 1024 * 1024 };
+
+		/// <summary>
+		/// Number of decodes per worker, which may be in flight, so the priorities still decide the order of the rest.
+		/// </summary>
+		static constexpr unsigned int DECODES_PER_WORKER{ 2 };
+
+		/// <summary>
+		/// Counts of the streamer.
+		/// </summary>
+		struct SStats
+		{
+			/// <summary>
+			/// Number of textures, waiting for a free decode slot.
+			/// </summary>
+			unsigned int m_unQueuedCount = 0;
+
+			/// <summary>
+			/// Number of textures, being decoded.
+			/// </summary>
+			unsigned int m_unDecodingCount = 0;
+
+			/// <summary>
+			/// Number of decoded textures, whose rows are being uploaded.
+			/// </summary>
+			unsigned int m_unUploadingCount = 0;
+
+			/// <summary>
+			/// Number of textures, which became resident since Init.
+			/// </summary>
+			unsigned int m_unResidentCount = 0;
+
+			/// <summary>
+			/// Number of images, which couldn't be decoded since Init.
+			/// </summary>
+			unsigned int m_unFailedCount = 0;
+
+			/// <summary>
+			/// Number of bytes, uploaded by the last Update.
+			/// </summary>
+			size_t m_unUploadedBytes = 0;
+
+			/// <summary>
+			/// Number of Updates since Init, which stopped early, since the next buffer was still read by the GPU.
+			/// </summary>
+			unsigned int m_unBufferBusyCount = 0;
+		};
+
+		TextureStreamer();
+		~TextureStreamer();
+
+		/** Delete the copy constructor, move constructor and assignment operators. */
+		TextureStreamer(const TextureStreamer&) = delete;
+		TextureStreamer(TextureStreamer&&) = delete;
+		TextureStreamer& operator=(const TextureStreamer&) = delete;
+		TextureStreamer& operator=(TextureStreamer&) = delete;
+
+		/// <summary>
+		/// Create the placeholder and the pixel unpack buffers and start the decoding threads. Requires a current OpenGL context.
+		/// The first Load calls it with the defaults and the current upload budget, so only apps, which stream, pay for them.
+		/// </summary>
+		/// <param name="unWorkerCount"> Number of decoding threads. 0 decodes on the thread, which calls Update. </param>
+		/// <param name="unUploadBudget"> Number of bytes, uploaded per frame. Also the size of every buffer. </param>
+		/// <returns> True, if the streamer is ready. </returns>
+		bool Init(unsigned int unWorkerCount = DEFAULT_WORKER_COUNT, size_t unUploadBudget = DEFAULT_UPLOAD_BUDGET);
+
+		/// <summary>
+		/// Stop the decoding threads and delete the buffers. Textures, which aren't resident yet, fail and keep their placeholder.
+		/// Requires the context of Init to be current.
+		/// </summary>
+		void Shutdown();
+
+		/// <summary>
+		/// Queue an image for streaming. Starts the streamer, if it isn't initialized, so a current OpenGL context is required.
+		/// </summary>
+		/// <param name="strFileName"> Path of the image. </param>
+		/// <param name="fPriority"> Textures with a higher priority are decoded and uploaded first. </param>
+		/// <returns> Handle, which shows the placeholder until the texture is resident. nullptr, if the streamer couldn't start. </returns>
+		TextureHandle Load(const std::string& strFileName, float fPriority = 0.0f);
+
+		/// <summary>
+		/// Start decodes and upload the decoded rows up to the budget. Called once per frame by Renderer2D::BeginFrame.
+		/// </summary>
+		void Update();
+
+		/// <summary>
+		/// Update, until every queued texture is resident or failed, e.g. for headless runs, which must not show placeholders.
+		/// </summary>
+		void Flush();
+
+		/// <summary>
+		/// Check, if textures are still queued, decoded or uploaded, so the frames, which finish them, must be drawn.
+		/// </summary>
+		/// <returns> True, if any texture isn't resident or failed yet. </returns>
+		bool HasPendingWork() const { return !m_vecQueued.empty() || !m_vecDecoding.empty() || !m_vecUploads.empty(); }
+
+		/// <summary>
+		/// Set the number of bytes, uploaded per frame. At least one row is uploaded per frame, while rows are pending.
+		/// </summary>
+		/// <param name="unUploadBudget"> Number of bytes. </param>
+		void SetUploadBudget(size_t unUploadBudget);
+
+		/// <summary>
+		/// Retrieve the number of bytes, uploaded per frame.
+		/// </summary>
+		/// <returns> m_unUploadBudget. </returns>
+		size_t GetUploadBudget() const { return m_unUploadBudget; }
+
+		/// <summary>
+		/// Retrieve the counts of the streamer.
+		/// </summary>
+		/// <returns> m_stats. </returns>
+		const SStats& GetStats() const { return m_stats; }
+
+	private:
+		/// <summary>
+		/// Decoded image of a worker thread.
+		/// </summary>
+		struct SDecodeResult
+		{
+			/// <summary>
+			/// Handle of the texture.
+			/// </summary>
+			TextureHandle m_ptrStream;
+
+			/// <summary>
+			/// RGBA pixels or nullptr, if the image couldn't be decoded.
+			/// </summary>
+			SDL_Surface* m_ptrSurface;
+		};
+
+		/// <summary>
+		/// Decode an image into RGBA. Runs on a worker thread.
+		/// </summary>
+		/// <param name="ptrStream"> Handle of the texture. </param>
+		void Decode(TextureHandle ptrStream);
+
+		/// <summary>
+		/// Move the images, decoded by the workers, to m_vecUploads.
+		/// </summary>
+		void CollectDecoded();
+
+		/// <summary>
+		/// Hand the queued textures with the highest priority to the workers, until all decode slots are taken.
+		/// </summary>
+		void SubmitDecodes();
+
+		/// <summary>
+		/// Upload the rows of the decoded textures with the highest priority, until the budget is spent.
+		/// </summary>
+		void UploadRows();
+
+		/// <summary>
+		/// Upload the next rows of a texture through the next buffer.
+		/// Rows, which don't fit into a buffer, are uploaded straight from the surface.
+		/// </summary>
+		/// <param name="stream"> Texture with decoded rows. </param>
+		/// <param name="nRowCount"> Number of rows to be uploaded. </param>
+		/// <returns> False, if the next buffer is still read by the GPU and nothing was uploaded. </returns>
+		bool UploadChunk(StreamedTexture& stream, int nRowCount);
+
+		/// <summary>
+		/// Check, if the GPU is done with the next buffer, without waiting.
+		/// </summary>
+		/// <returns> True, if the buffer can be written. </returns>
+		bool IsBufferFree();
+
+		/// <summary>
+		/// Check, if only the streamer holds a handle, so nobody waits for its texture.
+		/// </summary>
+		/// <param name="ptrStream"> Handle of the texture. </param>
+		/// <returns> True, if the texture can be dropped. </returns>
+		static bool IsAbandoned(const TextureHandle& ptrStream) { return ptrStream.use_count() == 1; }
+
+	private:
+		/// <summary>
+		/// Decoding threads. The renderer's pool runs loops of its own, which shouldn't wait for a file.
+		/// </summary>
+		ThreadPool m_threadPool;
+
+		/// <summary>
+		/// Guards m_vecDecoded.
+		/// </summary>
+		std::mutex m_decodedMutex;
+
+		/// <summary>
+		/// Images, decoded by the workers since the last Update.
+		/// </summary>
+		std::vector<SDecodeResult> m_vecDecoded;
+
+		/// <summary>
+		/// Textures, waiting for a free decode slot.
+		/// </summary>
+		std::vector<TextureHandle> m_vecQueued;
+
+		/// <summary>
+		/// Textures, handed to the workers. Shutdown fails the ones, whose decode was dropped.
+		/// </summary>
+		std::vector<TextureHandle> m_vecDecoding;
+
+		/// <summary>
+		/// Decoded textures, whose rows are being uploaded.
+		/// </summary>
+		std::vector<TextureHandle> m_vecUploads;
+
+		/// <summary>
+		/// Shown by every texture, which isn't resident.
+		/// </summary>
+		std::shared_ptr<Texture> m_ptrPlaceholder;
+
+		/// <summary>
+		/// Ring of pixel unpack buffers.
+		/// </summary>
+		std::array<GLuint, BUFFER_COUNT> m_arrBufferIDs;
+
+		/// <summary>
+		/// Fences after the last upload from every buffer.
+		/// </summary>
+		std::array<GLsync, BUFFER_COUNT> m_arrFences;
+
+		/// <summary>
+		/// Index of the next buffer to be written.
+		/// </summary>
+		unsigned int m_unNextBuffer;
+
+		/// <summary>
+		/// Size of every buffer in bytes.
+		/// </summary>
+		size_t m_unBufferSize;
+
+		/// <summary>
+		/// Number of bytes, uploaded per frame.
+		/// </summary>
+		size_t m_unUploadBudget;
+
+		/// <summary>
+		/// Maximum number of decodes in flight.
+		/// </summary>
+		unsigned int m_unMaxDecodeCount;
+
+		/// <summary>
+		/// Counts of the streamer.
+		/// </summary>
+		SStats m_stats;
+	};
+}
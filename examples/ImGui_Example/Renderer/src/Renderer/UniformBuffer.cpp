@@ -0,0 +1,52 @@
+#include "UniformBuffer.h"
+#include <iostream>
+#include <glad/glad.h>
+
+namespace K9
+{
+	UniformBuffer::UniformBuffer()
+		: m_unBufferID{ 0 }, m_unSize{ 0 }, m_unBindingPoint{ 0 }
+	{
+	}
+
+	UniformBuffer::~UniformBuffer()
+	{
+		glDeleteBuffers(1, &m_unBufferID);
+	}
+
+	bool UniformBuffer::Create(unsigned int unSize, unsigned int unBindingPoint)
+	{
+		GLint nMaxBindings = 0;
+		glGetIntegerv(GL_MAX_UNIFORM_BUFFER_BINDINGS, &nMaxBindings);
+		if (unBindingPoint >= static_cast<unsigned int>(nMaxBindings))
+		{
+			std::cerr << "UniformBuffer::Create unBindingPoint(" << unBindingPoint
+				<< ") exceeds GL_MAX_UNIFORM_BUFFER_BINDINGS(" << nMaxBindings << ")!\n";
+			return false;
+		}
+
+		m_unSize = unSize;
+		m_unBindingPoint = unBindingPoint;
+
+		/* Uniform buffer bindings aren't tracked by the GLStateCache and ImGUI doesn't touch them. */
+		glGenBuffers(1, &m_unBufferID);
+		glBindBuffer(GL_UNIFORM_BUFFER, m_unBufferID);
+		glBufferData(GL_UNIFORM_BUFFER, m_unSize, nullptr, GL_DYNAMIC_DRAW);
+		glBindBufferBase(GL_UNIFORM_BUFFER, m_unBindingPoint, m_unBufferID);
+		return true;
+	}
+
+	void UniformBuffer::SetData(const void* ptrData, unsigned int unSize)
+	{
+		if (unSize != m_unSize)
+		{
+			std::cerr << "UniformBuffer::SetData unSize(" << unSize << ") doesn't match the buffer size("
+				<< m_unSize << ")!\n";
+			return;
+		}
+
+		/* Respecify the whole storage, so the upload doesn't wait on draws, reading the old data. */
+		glBindBuffer(GL_UNIFORM_BUFFER, m_unBufferID);
+		glBufferData(GL_UNIFORM_BUFFER, m_unSize, ptrData, GL_DYNAMIC_DRAW);
+	}
+}
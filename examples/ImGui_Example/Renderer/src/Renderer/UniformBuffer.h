@@ -0,0 +1,61 @@
+#pragma once
+
+using GLuint = unsigned int;
+
+namespace K9
+{
+	/// <summary>
+	/// A uniform buffer object, bound to a fixed binding point.
+	/// Shaders pick it up through a uniform block, bound to the same point via Shader::RegisterUniformBlock.
+	/// The data must follow the std140 layout of the block.
+	/// </summary>
+	class UniformBuffer
+	{
+	public:
+		UniformBuffer();
+		~UniformBuffer();
+
+		/** Delete the copy constructor, move constructor and assignment operators. */
+		UniformBuffer(const UniformBuffer&) = delete;
+		UniformBuffer(UniformBuffer&&) = delete;
+		UniformBuffer& operator=(const UniformBuffer&) = delete;
+		UniformBuffer& operator=(UniformBuffer&) = delete;
+
+		/// <summary>
+		/// Create the buffer and bind it to the binding point.
+		/// </summary>
+		/// <param name="unSize"> Size of the block in bytes. </param>
+		/// <param name="unBindingPoint"> Index of the uniform buffer binding point. </param>
+		/// <returns> True, if the buffer was created. </returns>
+		bool Create(unsigned int unSize, unsigned int unBindingPoint);
+
+		/// <summary>
+		/// Replace the contents of the buffer.
+		/// </summary>
+		/// <param name="ptrData"> Data in std140 layout. </param>
+		/// <param name="unSize"> Size of the data in bytes. Must match the size of the buffer. </param>
+		void SetData(const void* ptrData, unsigned int unSize);
+
+		/// <summary>
+		/// Retrieve the binding point of the buffer.
+		/// </summary>
+		/// <returns> m_unBindingPoint. </returns>
+		unsigned int GetBindingPoint() const { return m_unBindingPoint; }
+
+	private:
+		/// <summary>
+		/// OpenGL ID of the buffer.
+		/// </summary>
+		GLuint m_unBufferID;
+
+		/// <summary>
+		/// Size of the buffer in bytes.
+		/// </summary>
+		unsigned int m_unSize;
+
+		/// <summary>
+		/// Index of the uniform buffer binding point.
+		/// </summary>
+		unsigned int m_unBindingPoint;
+	};
+}
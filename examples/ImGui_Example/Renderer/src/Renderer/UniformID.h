@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdint>
+
+namespace K9
+{
+	/// <summary>
+	/// Name of a uniform or uniform block with its 32 bit FNV-1a hash, used to look it up in the reflection table of a Shader.
+	/// Declare it constexpr, so the hash is computed at compile time and setting the uniform does no string work:
+	/// static constexpr UniformID COLOR_UNIFORM{ "u_Color" };
+	/// Arrays are named without the index, e.g. "u_Textures".
+	/// </summary>
+	struct UniformID
+	{
+		/// <summary>
+		/// Hash a name with FNV-1a.
+		/// </summary>
+		/// <param name="cstrName"> Null terminated name. </param>
+		/// <returns> 32 bit hash. </returns>
+		static constexpr uint32_t Hash(const char* cstrName)
+		{
+			uint32_t unHash = 2166136261u;
+			while (*cstrName != '\0')
+			{
+				unHash ^= static_cast<uint8_t>(*cstrName++);
+				unHash *= 16777619u;
+			}
+			return unHash;
+		}
+
+		constexpr explicit UniformID(const char* cstrName)
+			: m_unHash{ Hash(cstrName) }, m_cstrName{ cstrName }
+		{
+		}
+
+		/// <summary>
+		/// Hash of m_cstrName.
+		/// </summary>
+		uint32_t m_unHash;
+
+		/// <summary>
+		/// Name, used to report mismatches. Must outlive the ID, e.g. a string literal.
+		/// </summary>
+		const char* m_cstrName;
+	};
+}
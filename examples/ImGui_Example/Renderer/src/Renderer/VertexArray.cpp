@@ -1,5 +1,6 @@
 #include "VertexArray.h"
 #include <glad/glad.h>
+#include "GLStateCache.h"
 #include <iostream>
 
 namespace K9
@@ -22,56 +23,248 @@ namespace K9
 		SetVertexArray(rectParam);
 	}
 
+	VertexArray::VertexArray(unsigned int unMaxVertexCount, ELayout eLayout,
+		const unsigned int* arrIndices, unsigned int unIndexCount)
+	{
+		/* The vertex attributes are specified, once the first vertices are written. */
+		SetVertexArray(nullptr, 0, eLayout, arrIndices, unIndexCount);
+		m_unMaxVertexCount = unMaxVertexCount;
+
+		m_ptrVertexStream.reset(new StreamBuffer());
+		m_ptrVertexStream->Init(m_unMaxVertexCount * GetVertexSize(m_eLayout));
+	}
+
 	VertexArray::~VertexArray()
 	{
 		glDeleteBuffers(1, &m_unVertexBufferID);
 		glDeleteBuffers(1, &m_unIndexBufferID);
 		glDeleteVertexArrays(1, &m_unVertexArrayID);
+
+		GLStateCache& stateCache = GLStateCache::Ref();
+		stateCache.OnBufferDeleted(m_unVertexBufferID);
+		stateCache.OnVertexArrayDeleted(m_unVertexArrayID);
 	}
 
 	void VertexArray::SetActive()
 	{
-		glBindVertexArray(m_unVertexArrayID);
+		GLStateCache::Ref().BindVertexArray(m_unVertexArrayID);
+	}
+
+	void VertexArray::SetVertexData(const void* arrVertices, unsigned int unVertexCount)
+	{
+		if (unVertexCount > m_unMaxVertexCount)
+		{
+			std::cerr << "VertexArray::SetVertexData unVertexCount(" << unVertexCount
+				<< ") exceeds the buffer capacity(" << m_unMaxVertexCount << ")!\n";
+			return;
+		}
+
+		unsigned int unOffset = 0;
+		if (!m_ptrVertexStream->Write(arrVertices, unVertexCount * GetVertexSize(m_eLayout), unOffset))
+		{
+			return;
+		}
+		m_unVertexCount = unVertexCount;
+
+		/* The ring offset changes with every write, so the attributes are pointed at it. */
+		GLStateCache::Ref().BindVertexArray(m_unVertexArrayID);
+		m_ptrVertexStream->Bind();
+		SetVertexAttributes(m_eLayout, unOffset);
+	}
+
+	void* VertexArray::MapVertexData(unsigned int unVertexCount)
+	{
+		if (unVertexCount > m_unMaxVertexCount)
+		{
+			std::cerr << "VertexArray::MapVertexData unVertexCount(" << unVertexCount
+				<< ") exceeds the buffer capacity(" << m_unMaxVertexCount << ")!\n";
+			return nullptr;
+		}
+
+		void* ptrVertices = m_ptrVertexStream->Map(unVertexCount * GetVertexSize(m_eLayout), m_unMappedVertexOffset);
+		if (ptrVertices != nullptr)
+		{
+			m_unVertexCount = unVertexCount;
+		}
+		return ptrVertices;
+	}
+
+	void VertexArray::UnmapVertexData()
+	{
+		m_ptrVertexStream->Unmap();
+
+		GLStateCache::Ref().BindVertexArray(m_unVertexArrayID);
+		m_ptrVertexStream->Bind();
+		SetVertexAttributes(m_eLayout, m_unMappedVertexOffset);
+	}
+
+	void VertexArray::CreateInstanceBuffer(unsigned int unMaxInstanceCount, ELayout eInstanceLayout)
+	{
+		m_unMaxInstanceCount = unMaxInstanceCount;
+		m_eInstanceLayout = eInstanceLayout;
+
+		/* The instance attributes are specified, once the first instances are written. */
+		m_ptrInstanceStream.reset(new StreamBuffer());
+		m_ptrInstanceStream->Init(m_unMaxInstanceCount * GetVertexSize(m_eInstanceLayout));
+	}
+
+	void VertexArray::SetInstanceData(const void* arrInstances, unsigned int unInstanceCount)
+	{
+		if (unInstanceCount > m_unMaxInstanceCount)
+		{
+			std::cerr << "VertexArray::SetInstanceData unInstanceCount(" << unInstanceCount
+				<< ") exceeds the buffer capacity(" << m_unMaxInstanceCount << ")!\n";
+			return;
+		}
+
+		unsigned int unOffset = 0;
+		if (!m_ptrInstanceStream->Write(arrInstances, unInstanceCount * GetVertexSize(m_eInstanceLayout), unOffset))
+		{
+			return;
+		}
+
+		GLStateCache::Ref().BindVertexArray(m_unVertexArrayID);
+		m_ptrInstanceStream->Bind();
+		SetVertexAttributes(m_eInstanceLayout, unOffset);
+	}
+
+	void VertexArray::BeginFrame()
+	{
+		if (m_ptrVertexStream)
+		{
+			m_ptrVertexStream->NextSegment();
+		}
+		if (m_ptrInstanceStream)
+		{
+			m_ptrInstanceStream->NextSegment();
+		}
+	}
+
+	StreamBuffer::SStats VertexArray::PopStreamStats()
+	{
+		StreamBuffer::SStats stats;
+		for (StreamBuffer* ptrStream : { m_ptrVertexStream.get(), m_ptrInstanceStream.get() })
+		{
+			if (ptrStream)
+			{
+				stats.m_unStallCount += ptrStream->GetStats().m_unStallCount;
+				stats.m_fWaitTimeMS += ptrStream->GetStats().m_fWaitTimeMS;
+				stats.m_unBytesWritten += ptrStream->GetStats().m_unBytesWritten;
+				ptrStream->ResetStats();
+			}
+		}
+		return stats;
 	}
 
 	unsigned int VertexArray::GetVertexSize(VertexArray::ELayout eLayout)
 	{
-		constexpr unsigned int unVertexElementCount = 5;
-		unsigned int unVertexSize = (unVertexElementCount * sizeof(float));
+		unsigned int unVertexSize = 0;
+		switch (eLayout)
+		{
+		/* Position(3 floats) and texture coordinates(2 floats) */
+		case ELayout::ePosTex: unVertexSize = 5 * sizeof(float); break;
+		/* Position(2 floats), texture coordinates(2 floats), color(4 bytes) and texture slot(1 uint) */
+		case ELayout::ePosTexColorSlot: unVertexSize = 4 * sizeof(float) + 4 * sizeof(uint8_t) + sizeof(uint32_t); break;
+		/* Transform(6 floats), UV rect(4 shorts), color(4 bytes) and flags(1 uint) */
+		case ELayout::eSpriteInstance: unVertexSize = 6 * sizeof(float) + 4 * sizeof(uint16_t)
+			+ 4 * sizeof(uint8_t) + sizeof(uint32_t); break;
+		default: break;
+		}
 		return unVertexSize;
 	}
 
-	void VertexArray::SetVertexArray(const void* arrVertices, unsigned int unVertexCount, ELayout eLayout, const unsigned int* arrIndices, unsigned int unIndexCount)
+	void VertexArray::SetVertexArray(const void* arrVertices, unsigned int unVertexCount, ELayout eLayout,
+		const unsigned int* arrIndices, unsigned int unIndexCount)
 	{
 		/* Create vertex array */
 		m_unVertexCount = unVertexCount;
+		m_unMaxVertexCount = unVertexCount;
 		m_unIndexCount = unIndexCount;
+		m_eLayout = eLayout;
 
 		glGenVertexArrays(1, &m_unVertexArrayID);
-		glBindVertexArray(m_unVertexArrayID);
-		constexpr unsigned int unVertexElementCount = 8;
+		GLStateCache::Ref().BindVertexArray(m_unVertexArrayID);
 		unsigned int unVertexSize = GetVertexSize(eLayout);
 
-		/* Create vertex buffer */
-		glGenBuffers(1, &m_unVertexBufferID);
-		glBindBuffer(GL_ARRAY_BUFFER, m_unVertexBufferID);
-		glBufferData(GL_ARRAY_BUFFER, static_cast<uint64_t>(unVertexCount) * unVertexSize, arrVertices, GL_STATIC_DRAW);
-
 		/* Create index buffer */
 		glGenBuffers(1, &m_unIndexBufferID);
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_unIndexBufferID);
 		glBufferData(GL_ELEMENT_ARRAY_BUFFER, unIndexCount * sizeof(unsigned int), arrIndices, GL_STATIC_DRAW);
 
+		/* Create vertex buffer. Streamed vertices don't have one. */
+		if (arrVertices != nullptr)
+		{
+			glGenBuffers(1, &m_unVertexBufferID);
+			GLStateCache::Ref().BindArrayBuffer(m_unVertexBufferID);
+			glBufferData(GL_ARRAY_BUFFER, static_cast<uint64_t>(unVertexCount) * unVertexSize, arrVertices, GL_STATIC_DRAW);
+
+			SetVertexAttributes(eLayout);
+		}
+	}
+
+	void VertexArray::SetVertexAttributes(ELayout eLayout, uint64_t unBaseOffset)
+	{
+		unsigned int unVertexSize = GetVertexSize(eLayout);
+
 		/* Specify the vertex attributes */
 		if (eLayout == ELayout::ePosTex)
 		{
 			/* Position is 3 floats */
 			glEnableVertexAttribArray(0);
-			glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, unVertexSize, 0);
+			glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, unVertexSize,
+				reinterpret_cast<void*>(unBaseOffset));
 			/* Texture coordinates is 2 floats */
 			glEnableVertexAttribArray(1);
 			glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, unVertexSize,
-				reinterpret_cast<void*>(sizeof(float) * 3));
+				reinterpret_cast<void*>(unBaseOffset + sizeof(float) * 3));
+		}
+		else if (eLayout == ELayout::ePosTexColorSlot)
+		{
+			/* Position is 2 floats */
+			glEnableVertexAttribArray(0);
+			glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, unVertexSize,
+				reinterpret_cast<void*>(unBaseOffset));
+			/* Texture coordinates is 2 floats */
+			glEnableVertexAttribArray(1);
+			glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, unVertexSize,
+				reinterpret_cast<void*>(unBaseOffset + sizeof(float) * 2));
+			/* Color is 4 normalized bytes */
+			glEnableVertexAttribArray(2);
+			glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, unVertexSize,
+				reinterpret_cast<void*>(unBaseOffset + sizeof(float) * 4));
+			/* Texture slot is 1 unsigned integer */
+			glEnableVertexAttribArray(3);
+			glVertexAttribIPointer(3, 1, GL_UNSIGNED_INT, unVertexSize,
+				reinterpret_cast<void*>(unBaseOffset + sizeof(float) * 4 + sizeof(uint8_t) * 4));
+		}
+		else if (eLayout == ELayout::eSpriteInstance)
+		{
+			/* Attributes 0 and 1 belong to the per-vertex quad. */
+			uint64_t unOffset = unBaseOffset;
+			/* Two rows of the 2x3 affine transform are 3 floats each */
+			glEnableVertexAttribArray(2);
+			glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, unVertexSize, reinterpret_cast<void*>(unOffset));
+			unOffset += sizeof(float) * 3;
+			glEnableVertexAttribArray(3);
+			glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, unVertexSize, reinterpret_cast<void*>(unOffset));
+			unOffset += sizeof(float) * 3;
+			/* UV rect is 4 normalized shorts */
+			glEnableVertexAttribArray(4);
+			glVertexAttribPointer(4, 4, GL_UNSIGNED_SHORT, GL_TRUE, unVertexSize, reinterpret_cast<void*>(unOffset));
+			unOffset += sizeof(uint16_t) * 4;
+			/* Color is 4 normalized bytes */
+			glEnableVertexAttribArray(5);
+			glVertexAttribPointer(5, 4, GL_UNSIGNED_BYTE, GL_TRUE, unVertexSize, reinterpret_cast<void*>(unOffset));
+			unOffset += sizeof(uint8_t) * 4;
+			/* Flags(flip bits and texture slot) is 1 unsigned integer */
+			glEnableVertexAttribArray(6);
+			glVertexAttribIPointer(6, 1, GL_UNSIGNED_INT, unVertexSize, reinterpret_cast<void*>(unOffset));
+
+			/* Advance the attributes once per instance */
+			for (unsigned int unAttrib = 2; unAttrib <= 6; ++unAttrib)
+			{
+				glVertexAttribDivisor(unAttrib, 1);
+			}
 		}
 	}
 
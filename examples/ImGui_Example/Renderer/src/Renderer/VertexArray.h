@@ -1,7 +1,9 @@
 #pragma once
 #include <cstdint>
 #include <array>
+#include <memory>
 #include <glm/glm.hpp>
+#include "StreamBuffer.h"
 
 namespace K9
 {
@@ -15,6 +17,9 @@ namespace K9
 		enum class ELayout
 		{
 			ePosTex,
+			ePosTexColorSlot,
+			/* Per-instance sprite data: affine transform, UV rect, color and flags. */
+			eSpriteInstance,
 		};
 
 		/* Enumerate position types. */
@@ -160,6 +165,17 @@ namespace K9
 			const unsigned int* arrIndices, unsigned int unIndexCount);
 		VertexArray(const SPointParam& pointParam);
 		VertexArray(const SRectParam& rectParam);
+
+		/// <summary>
+		/// Create a vertex array with a streamed vertex buffer and a static index buffer.
+		/// The vertex data is written every frame via SetVertexData.
+		/// </summary>
+		/// <param name="unMaxVertexCount"> Capacity of the vertex buffer in vertices. </param>
+		/// <param name="eLayout"> Layout of the vertices. </param>
+		/// <param name="arrIndices"> Index data. </param>
+		/// <param name="unIndexCount"> Index count. </param>
+		VertexArray(unsigned int unMaxVertexCount, ELayout eLayout,
+			const unsigned int* arrIndices, unsigned int unIndexCount);
 		~VertexArray();
 
 		/// <summary>
@@ -167,6 +183,53 @@ namespace K9
 		/// </summary>
 		void SetActive();
 
+		/// <summary>
+		/// Write vertex data into the vertex StreamBuffer and point the vertex attributes at it.
+		/// The write doesn't wait on pending draws, unless the GPU is two frames behind.
+		/// </summary>
+		/// <param name="arrVertices"> Vertex data. </param>
+		/// <param name="unVertexCount"> Vertex count. Must not exceed the buffer capacity. </param>
+		void SetVertexData(const void* arrVertices, unsigned int unVertexCount);
+
+		/// <summary>
+		/// Reserve space for vertices in the vertex StreamBuffer, so they can be written in place, e.g. by several threads.
+		/// Must be followed by UnmapVertexData before drawing.
+		/// </summary>
+		/// <param name="unVertexCount"> Vertex count. Must not exceed the buffer capacity. </param>
+		/// <returns> Pointer to the first vertex or nullptr, if the vertices couldn't be mapped. </returns>
+		void* MapVertexData(unsigned int unVertexCount);
+
+		/// <summary>
+		/// Finish writing the vertices, returned by MapVertexData, and point the vertex attributes at them.
+		/// </summary>
+		void UnmapVertexData();
+
+		/// <summary>
+		/// Create a streamed per-instance buffer and attach it to this vertex array.
+		/// Its attributes follow the per-vertex ones and advance once per instance.
+		/// </summary>
+		/// <param name="unMaxInstanceCount"> Capacity of the instance buffer in instances. </param>
+		/// <param name="eInstanceLayout"> Layout of a single instance. </param>
+		void CreateInstanceBuffer(unsigned int unMaxInstanceCount, ELayout eInstanceLayout);
+
+		/// <summary>
+		/// Write per-instance data into the instance StreamBuffer and point the instance attributes at it.
+		/// </summary>
+		/// <param name="arrInstances"> Instance data. </param>
+		/// <param name="unInstanceCount"> Instance count. Must not exceed the buffer capacity. </param>
+		void SetInstanceData(const void* arrInstances, unsigned int unInstanceCount);
+
+		/// <summary>
+		/// Move the streamed buffers to their next segment. Called once at the start of a frame.
+		/// </summary>
+		void BeginFrame();
+
+		/// <summary>
+		/// Retrieve the combined synchronization statistics of the streamed buffers and reset them.
+		/// </summary>
+		/// <returns> Statistics since the last call. </returns>
+		StreamBuffer::SStats PopStreamStats();
+
 		/// <summary>
 		/// Retrieve the index count.
 		/// </summary>
@@ -198,6 +261,13 @@ namespace K9
 		void SetVertexArray(const void* arrVertices, unsigned int unVertexCount, ELayout eLayout,
 			const unsigned int* arrIndices, unsigned int unIndexCount);
 
+		/// <summary>
+		/// Specify the vertex attributes for the currently bound vertex buffer.
+		/// </summary>
+		/// <param name="eLayout"> Layout of the vertices. </param>
+		/// <param name="unBaseOffset"> Byte offset of the first vertex in the buffer. </param>
+		void SetVertexAttributes(ELayout eLayout, uint64_t unBaseOffset = 0);
+
 		/// <summary>
 		/// Set the vertex array data.
 		/// </summary>
@@ -220,16 +290,51 @@ namespace K9
 		/// How many indices in the index buffer.
 		/// </summary>
 		unsigned int m_unIndexCount = 0;
+
+		/// <summary>
+		/// Capacity of the vertex buffer in vertices.
+		/// </summary>
+		unsigned int m_unMaxVertexCount = 0;
+
+		/// <summary>
+		/// Layout of the vertices.
+		/// </summary>
+		ELayout m_eLayout = ELayout::ePosTex;
 	
 		/// <summary>
-		///  OpenGL ID of the vertex buffer.
+		///  OpenGL ID of the static vertex buffer. 0 if the vertices are streamed.
 		/// </summary>
 		unsigned int m_unVertexBufferID = 0;
+
+		/// <summary>
+		/// Ring buffer of the streamed vertices. nullptr if the vertices are static.
+		/// </summary>
+		std::unique_ptr<StreamBuffer> m_ptrVertexStream;
+
+		/// <summary>
+		/// Byte offset of the vertices, returned by MapVertexData.
+		/// </summary>
+		unsigned int m_unMappedVertexOffset = 0;
 	
 		/// <summary>
 		/// OpenGL ID of the index buffer.
 		/// </summary>
 		unsigned int m_unIndexBufferID = 0;
+
+		/// <summary>
+		/// Ring buffer of the streamed instances. nullptr if there's none.
+		/// </summary>
+		std::unique_ptr<StreamBuffer> m_ptrInstanceStream;
+
+		/// <summary>
+		/// Capacity of the instance buffer in instances.
+		/// </summary>
+		unsigned int m_unMaxInstanceCount = 0;
+
+		/// <summary>
+		/// Layout of a single instance.
+		/// </summary>
+		ELayout m_eInstanceLayout = ELayout::eSpriteInstance;
 	
 		/// <summary>
 		/// OpenGL ID of the vertex array object.
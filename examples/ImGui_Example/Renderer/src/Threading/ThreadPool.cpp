@@ -0,0 +1,165 @@
+#include "ThreadPool.h"
+#include <algorithm>
+
+namespace K9
+{
+	ThreadPool::ThreadPool()
+		: m_vecWorkers{}, m_dispatchMutex{}, m_mutex{}, m_workCondition{}, m_doneCondition{},
+		m_ptrFunction{ nullptr }, m_unCount{ 0 }, m_unBatchSize{ 1 }, m_unNextIndex{ 0 },
+		m_unGeneration{ 0 }, m_unBusyCount{ 0 }, m_queTasks{}, m_bStopping{ false }
+	{
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		Shutdown();
+	}
+
+	void ThreadPool::Init(unsigned int unWorkerCount)
+	{
+		Shutdown();
+
+		m_vecWorkers.reserve(unWorkerCount);
+		for (unsigned int unIndex = 0; unIndex < unWorkerCount; ++unIndex)
+		{
+			m_vecWorkers.emplace_back(&ThreadPool::WorkerMain, this, m_unGeneration);
+		}
+	}
+
+	void ThreadPool::Shutdown()
+	{
+		if (m_vecWorkers.empty())
+		{
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_bStopping = true;
+		}
+		m_workCondition.notify_all();
+
+		for (auto& worker : m_vecWorkers)
+		{
+			worker.join();
+		}
+		m_vecWorkers.clear();
+		m_queTasks.clear();
+		m_bStopping = false;
+	}
+
+	void ThreadPool::ParallelFor(size_t unCount, size_t unMinBatchSize, const RangeFunction& function)
+	{
+		if (unCount == 0)
+		{
+			return;
+		}
+
+		size_t unBatchSize = std::max<size_t>(unMinBatchSize, 1);
+		if (m_vecWorkers.empty() || unCount <= unBatchSize)
+		{
+			function(0, unCount);
+			return;
+		}
+
+		std::lock_guard<std::mutex> dispatchLock(m_dispatchMutex);
+
+		/* Larger batches than the minimum, as long as every thread still gets a few. */
+		size_t unBatchCount = (m_vecWorkers.size() + 1) * BATCHES_PER_THREAD;
+		unBatchSize = std::max(unBatchSize, (unCount + unBatchCount - 1) / unBatchCount);
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_ptrFunction = &function;
+			m_unCount = unCount;
+			m_unBatchSize = unBatchSize;
+			m_unNextIndex = 0;
+			m_unBusyCount = static_cast<unsigned int>(m_vecWorkers.size());
+			m_unGeneration++;
+		}
+		m_workCondition.notify_all();
+
+		/* The calling thread works too, instead of sleeping until the workers are done. */
+		RunBatches();
+
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_doneCondition.wait(lock, [this] { return m_unBusyCount == 0; });
+		m_ptrFunction = nullptr;
+	}
+
+	void ThreadPool::Submit(Task task)
+	{
+		if (m_vecWorkers.empty())
+		{
+			task();
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_queTasks.push_back(std::move(task));
+		}
+		m_workCondition.notify_one();
+	}
+
+	/* Private methods. */
+	void ThreadPool::WorkerMain(uint64_t unGeneration)
+	{
+		while (true)
+		{
+			Task task;
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_workCondition.wait(lock, [this, unGeneration]
+				{
+					return m_bStopping || m_unGeneration != unGeneration || !m_queTasks.empty();
+				});
+				if (m_bStopping)
+				{
+					return;
+				}
+
+				/* A loop holds up the thread, which dispatched it, so it goes before the tasks. */
+				if (m_unGeneration == unGeneration)
+				{
+					task = std::move(m_queTasks.front());
+					m_queTasks.pop_front();
+				}
+				else
+				{
+					unGeneration = m_unGeneration;
+				}
+			}
+
+			if (task)
+			{
+				task();
+				continue;
+			}
+
+			RunBatches();
+
+			bool bLast = false;
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				bLast = --m_unBusyCount == 0;
+			}
+			if (bLast)
+			{
+				m_doneCondition.notify_one();
+			}
+		}
+	}
+
+	void ThreadPool::RunBatches()
+	{
+		while (true)
+		{
+			size_t unBegin = m_unNextIndex.fetch_add(m_unBatchSize);
+			if (unBegin >= m_unCount)
+			{
+				return;
+			}
+			(*m_ptrFunction)(unBegin, std::min(unBegin + m_unBatchSize, m_unCount));
+		}
+	}
+}
@@ -0,0 +1,160 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace K9
+{
+	/// <summary>
+	/// Persistent worker threads, which split index ranges with the calling thread.
+	/// The workers sleep between calls, so a parallel loop costs a wake-up instead of a thread start.
+	/// Work is handed out in batches through an atomic counter, so faster threads take more batches.
+	/// Independent tasks can be queued with Submit. A worker, which runs a task, joins a loop only after the task,
+	/// so long tasks, e.g. file loading, should get a pool of their own.
+	/// </summary>
+	class ThreadPool
+	{
+	public:
+		/// <summary>
+		/// Work on the index range [unBegin, unEnd). Called from several threads at once.
+		/// </summary>
+		using RangeFunction = std::function<void(size_t unBegin, size_t unEnd)>;
+
+		/// <summary>
+		/// Task, run once on a worker thread.
+		/// </summary>
+		using Task = std::function<void()>;
+
+		/// <summary>
+		/// Number of batches per thread, so a thread, which is descheduled, doesn't hold up the others for long.
+		/// </summary>
+		static constexpr size_t BATCHES_PER_THREAD{ 4 };
+
+		ThreadPool();
+		~ThreadPool();
+
+		/** Delete the copy constructor, move constructor and assignment operators. */
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool(ThreadPool&&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+		ThreadPool& operator=(ThreadPool&) = delete;
+
+		/// <summary>
+		/// Start the worker threads. Running workers are stopped first. Must not be called during ParallelFor.
+		/// </summary>
+		/// <param name="unWorkerCount"> Number of workers. 0 runs every loop on the calling thread. </param>
+		void Init(unsigned int unWorkerCount);
+
+		/// <summary>
+		/// Stop and join the worker threads. Running tasks are finished, queued tasks are dropped.
+		/// </summary>
+		void Shutdown();
+
+		/// <summary>
+		/// Retrieve the number of worker threads.
+		/// </summary>
+		/// <returns> Size of m_vecWorkers. </returns>
+		unsigned int GetWorkerCount() const { return static_cast<unsigned int>(m_vecWorkers.size()); }
+
+		/// <summary>
+		/// Run a function over [0, unCount) on the workers and the calling thread and wait until it is done.
+		/// Small ranges run on the calling thread alone. Calls from several threads are serialized.
+		/// The function must not call ParallelFor.
+		/// </summary>
+		/// <param name="unCount"> Number of indices. </param>
+		/// <param name="unMinBatchSize"> Minimum number of indices per call of the function. </param>
+		/// <param name="function"> Function, called with disjoint ranges, which cover [0, unCount). </param>
+		void ParallelFor(size_t unCount, size_t unMinBatchSize, const RangeFunction& function);
+
+		/// <summary>
+		/// Queue a task for the next idle worker and return at once. Tasks start in submission order.
+		/// Without workers, the task runs on the calling thread before Submit returns.
+		/// </summary>
+		/// <param name="task"> Task to be run. It must not call ParallelFor on this pool. </param>
+		void Submit(Task task);
+
+	private:
+		/// <summary>
+		/// Loop of a worker thread: sleep until a new loop is dispatched or a task is queued.
+		/// Loops are served first. Batches are taken and reported back, tasks are run.
+		/// </summary>
+		/// <param name="unGeneration"> Generation at the start of the worker, so it doesn't miss the first loop. </param>
+		void WorkerMain(uint64_t unGeneration);
+
+		/// <summary>
+		/// Take batches of the current loop until none are left.
+		/// </summary>
+		void RunBatches();
+
+	private:
+		/// <summary>
+		/// Worker threads.
+		/// </summary>
+		std::vector<std::thread> m_vecWorkers;
+
+		/// <summary>
+		/// Held for the duration of ParallelFor, so only one loop runs at a time.
+		/// </summary>
+		std::mutex m_dispatchMutex;
+
+		/// <summary>
+		/// Guards the loop parameters, m_unGeneration, m_unBusyCount, m_queTasks and m_bStopping.
+		/// </summary>
+		std::mutex m_mutex;
+
+		/// <summary>
+		/// Signaled, when a loop is dispatched, a task is queued or the workers are stopped.
+		/// </summary>
+		std::condition_variable m_workCondition;
+
+		/// <summary>
+		/// Signaled, when the last worker has finished the current loop.
+		/// </summary>
+		std::condition_variable m_doneCondition;
+
+		/// <summary>
+		/// Function of the current loop.
+		/// </summary>
+		const RangeFunction* m_ptrFunction;
+
+		/// <summary>
+		/// Number of indices of the current loop.
+		/// </summary>
+		size_t m_unCount;
+
+		/// <summary>
+		/// Number of indices per batch of the current loop.
+		/// </summary>
+		size_t m_unBatchSize;
+
+		/// <summary>
+		/// Start of the next batch to be taken.
+		/// </summary>
+		std::atomic<size_t> m_unNextIndex;
+
+		/// <summary>
+		/// Incremented on every dispatched loop.
+		/// </summary>
+		uint64_t m_unGeneration;
+
+		/// <summary>
+		/// Number of workers, which haven't finished the current loop yet.
+		/// </summary>
+		unsigned int m_unBusyCount;
+
+		/// <summary>
+		/// Tasks, which haven't been taken by a worker yet.
+		/// </summary>
+		std::deque<Task> m_queTasks;
+
+		/// <summary>
+		/// True, while the workers are being stopped.
+		/// </summary>
+		bool m_bStopping;
+	};
+}
@@ -0,0 +1,48 @@
+#include "FixedTimestep.h"
+#include <algorithm>
+#include <SDL.h>
+
+namespace K9
+{
+	FixedTimestep::FixedTimestep(double dStepS, unsigned int unMaxStepsPerFrame, TimeSource timeSource)
+		: m_dStepS{ dStepS > 0.0 ? dStepS : DEFAULT_STEP_S }, m_unMaxStepsPerFrame{ std::max(1u, unMaxStepsPerFrame) },
+		m_timeSource{ timeSource ? std::move(timeSource) : TimeSource{ &FixedTimestep::GetPerformanceTime } },
+		m_dLastTimeS{ 0.0 }, m_bStarted{ false }, m_dAccumulatorS{ 0.0 }, m_unStepCount{ 0 }, m_unDroppedStepCount{ 0 }
+	{
+	}
+
+	unsigned int FixedTimestep::BeginFrame()
+	{
+		double dTimeS = m_timeSource();
+		if (!m_bStarted)
+		{
+			m_dLastTimeS = dTimeS;
+			m_bStarted = true;
+		}
+
+		/* A clock, which goes backwards, adds no time. */
+		m_dAccumulatorS += std::max(0.0, dTimeS - m_dLastTimeS);
+		m_dLastTimeS = dTimeS;
+
+		uint64_t unDueStepCount = static_cast<uint64_t>(m_dAccumulatorS / m_dStepS);
+		m_dAccumulatorS = std::max(0.0, m_dAccumulatorS - static_cast<double>(unDueStepCount) * m_dStepS);
+
+		/* Drop the steps beyond the cap, but keep the fraction for a smooth alpha. */
+		unsigned int unStepCount = static_cast<unsigned int>(std::min<uint64_t>(unDueStepCount, m_unMaxStepsPerFrame));
+		m_unDroppedStepCount += unDueStepCount - unStepCount;
+		m_unStepCount += unStepCount;
+		return unStepCount;
+	}
+
+	void FixedTimestep::Reset()
+	{
+		m_bStarted = false;
+		m_dAccumulatorS = 0.0;
+	}
+
+	double FixedTimestep::GetPerformanceTime()
+	{
+		static const double dPeriod = 1.0 / static_cast<double>(SDL_GetPerformanceFrequency());
+		return static_cast<double>(SDL_GetPerformanceCounter()) * dPeriod;
+	}
+}
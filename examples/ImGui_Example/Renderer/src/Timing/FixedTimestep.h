@@ -0,0 +1,123 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+
+namespace K9
+{
+	/// <summary>
+	/// Splits the elapsed time into fixed simulation steps, so the simulation speed doesn't depend on the frame rate.
+	/// Each frame, BeginFrame returns the number of steps to run. The remainder stays in the accumulator
+	/// and GetAlpha tells the renderer, how far the frame is between the last two simulation states.
+	/// At most m_unMaxStepsPerFrame steps run per frame. Time beyond that is dropped,
+	/// so a slow frame can't cause ever more steps in the next one.
+	/// </summary>
+	class FixedTimestep
+	{
+	public:
+		/// <summary>
+		/// Monotonic clock in seconds. Can be replaced, e.g. by a fake clock, which is advanced manually.
+		/// </summary>
+		using TimeSource = std::function<double()>;
+
+		/// <summary>
+		/// Default duration of a simulation step in seconds.
+		/// </summary>
+		static constexpr double DEFAULT_STEP_S{ 1.0 / 60.0 };
+
+		/// <summary>
+		/// Default maximum number of simulation steps per frame.
+		/// </summary>
+		static constexpr unsigned int DEFAULT_MAX_STEPS_PER_FRAME{ 5 };
+
+		/// <summary>
+		/// Create a fixed timestep. The clock starts on the first BeginFrame.
+		/// </summary>
+		/// <param name="dStepS"> Duration of a simulation step in seconds. </param>
+		/// <param name="unMaxStepsPerFrame"> Maximum number of simulation steps per frame. </param>
+		/// <param name="timeSource"> Clock. nullptr uses SDL_GetPerformanceCounter. </param>
+		explicit FixedTimestep(double dStepS = DEFAULT_STEP_S,
+			unsigned int unMaxStepsPerFrame = DEFAULT_MAX_STEPS_PER_FRAME, TimeSource timeSource = nullptr);
+
+		/// <summary>
+		/// Read the clock and add the elapsed time to the accumulator.
+		/// </summary>
+		/// <returns> Number of simulation steps to run in this frame. </returns>
+		unsigned int BeginFrame();
+
+		/// <summary>
+		/// Retrieve the duration of a simulation step.
+		/// </summary>
+		/// <returns> m_dStepS. </returns>
+		double GetStep() const { return m_dStepS; }
+
+		/// <summary>
+		/// Retrieve the interpolation factor between the previous and the current simulation state.
+		/// </summary>
+		/// <returns> Remaining accumulated time per step in the range [0, 1). </returns>
+		float GetAlpha() const { return static_cast<float>(m_dAccumulatorS / m_dStepS); }
+
+		/// <summary>
+		/// Retrieve the number of simulation steps since the start.
+		/// </summary>
+		/// <returns> m_unStepCount. </returns>
+		uint64_t GetStepCount() const { return m_unStepCount; }
+
+		/// <summary>
+		/// Retrieve the number of simulation steps, which were dropped by the per-frame cap.
+		/// </summary>
+		/// <returns> m_unDroppedStepCount. </returns>
+		uint64_t GetDroppedStepCount() const { return m_unDroppedStepCount; }
+
+		/// <summary>
+		/// Clear the accumulator and restart the clock on the next BeginFrame, e.g. after a pause.
+		/// </summary>
+		void Reset();
+
+		/// <summary>
+		/// Default clock, based on SDL_GetPerformanceCounter.
+		/// </summary>
+		/// <returns> Time in seconds. </returns>
+		static double GetPerformanceTime();
+
+	private:
+		/// <summary>
+		/// Duration of a simulation step in seconds.
+		/// </summary>
+		double m_dStepS;
+
+		/// <summary>
+		/// Maximum number of simulation steps per frame.
+		/// </summary>
+		unsigned int m_unMaxStepsPerFrame;
+
+		/// <summary>
+		/// Clock in seconds.
+		/// </summary>
+		TimeSource m_timeSource;
+
+		/// <summary>
+		/// Time of the last BeginFrame in seconds.
+		/// </summary>
+		double m_dLastTimeS;
+
+		/// <summary>
+		/// True, if m_dLastTimeS is valid.
+		/// </summary>
+		bool m_bStarted;
+
+		/// <summary>
+		/// Elapsed time, which wasn't simulated yet, in seconds.
+		/// </summary>
+		double m_dAccumulatorS;
+
+		/// <summary>
+		/// Number of simulation steps since the start.
+		/// </summary>
+		uint64_t m_unStepCount;
+
+		/// <summary>
+		/// Number of simulation steps, which were dropped by the per-frame cap.
+		/// </summary>
+		uint64_t m_unDroppedStepCount;
+	};
+}
@@ -0,0 +1,137 @@
+#include "FramePacer.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace K9
+{
+	FramePacer::FramePacer()
+		: m_eMode{ EMode::eVSync }, m_dTargetHz{ DEFAULT_TARGET_HZ }, m_unFrequency{ SDL_GetPerformanceFrequency() },
+		m_unNextDeadline{ 0 }, m_unLastFrameEnd{ 0 }, m_arrFrameTimesMS{}, m_unFrameTimeCount{ 0 }, m_unNextFrameTime{ 0 }
+	{
+	}
+
+	bool FramePacer::SetMode(EMode eMode, double dTargetHz)
+	{
+		m_eMode = eMode;
+		m_dTargetHz = std::max(1.0, dTargetHz);
+		Reset();
+
+		int nSwapInterval = 0;
+		switch (m_eMode)
+		{
+		case EMode::eVSync: nSwapInterval = 1; break;
+		case EMode::eAdaptiveVSync: nSwapInterval = -1; break;
+		case EMode::eUncapped: nSwapInterval = 0; break;
+		case EMode::eCapped: nSwapInterval = 0; break;
+		}
+
+		if (SDL_GL_SetSwapInterval(nSwapInterval) == 0)
+		{
+			return true;
+		}
+
+		std::cerr << "FramePacer::SetMode Swap interval " << nSwapInterval << " isn't supported. SDL error: "
+			<< SDL_GetError() << "\n";
+		if (m_eMode == EMode::eAdaptiveVSync)
+		{
+			m_eMode = EMode::eVSync;
+			SDL_GL_SetSwapInterval(1);
+		}
+		return false;
+	}
+
+	void FramePacer::EndFrame()
+	{
+		if (m_eMode == EMode::eCapped)
+		{
+			Uint64 unPeriod = static_cast<Uint64>(m_unFrequency / m_dTargetHz);
+			Uint64 unNow = SDL_GetPerformanceCounter();
+			if (m_unNextDeadline == 0)
+			{
+				m_unNextDeadline = unNow + unPeriod;
+			}
+
+			WaitUntil(m_unNextDeadline);
+
+			/* Advance by whole periods, so the cadence doesn't drift. A frame, which missed its deadline
+			 * by more than a period, restarts the cadence instead of rushing the following frames. */
+			m_unNextDeadline += unPeriod;
+			unNow = SDL_GetPerformanceCounter();
+			if (unNow > m_unNextDeadline)
+			{
+				m_unNextDeadline = unNow + unPeriod;
+			}
+		}
+
+		Uint64 unFrameEnd = SDL_GetPerformanceCounter();
+		if (m_unLastFrameEnd != 0)
+		{
+			m_arrFrameTimesMS[m_unNextFrameTime] = static_cast<float>(
+				static_cast<double>(unFrameEnd - m_unLastFrameEnd) * 1000.0 / m_unFrequency);
+			m_unNextFrameTime = (m_unNextFrameTime + 1) % FRAME_HISTORY_SIZE;
+			m_unFrameTimeCount = std::min(m_unFrameTimeCount + 1, FRAME_HISTORY_SIZE);
+		}
+		m_unLastFrameEnd = unFrameEnd;
+	}
+
+	FramePacer::SStats FramePacer::GetStats() const
+	{
+		SStats stats;
+		if (m_unFrameTimeCount == 0)
+		{
+			return stats;
+		}
+
+		double dSum = 0.0;
+		stats.m_fMinFrameTimeMS = m_arrFrameTimesMS[0];
+		stats.m_fMaxFrameTimeMS = m_arrFrameTimesMS[0];
+		for (unsigned int unIndex = 0; unIndex < m_unFrameTimeCount; ++unIndex)
+		{
+			float fFrameTimeMS = m_arrFrameTimesMS[unIndex];
+			dSum += fFrameTimeMS;
+			stats.m_fMinFrameTimeMS = std::min(stats.m_fMinFrameTimeMS, fFrameTimeMS);
+			stats.m_fMaxFrameTimeMS = std::max(stats.m_fMaxFrameTimeMS, fFrameTimeMS);
+		}
+		double dAverage = dSum / m_unFrameTimeCount;
+
+		double dVariance = 0.0;
+		for (unsigned int unIndex = 0; unIndex < m_unFrameTimeCount; ++unIndex)
+		{
+			double dDelta = m_arrFrameTimesMS[unIndex] - dAverage;
+			dVariance += dDelta * dDelta;
+		}
+		stats.m_fAverageFrameTimeMS = static_cast<float>(dAverage);
+		stats.m_fJitterMS = static_cast<float>(std::sqrt(dVariance / m_unFrameTimeCount));
+		return stats;
+	}
+
+	void FramePacer::Reset()
+	{
+		m_unNextDeadline = 0;
+		m_unLastFrameEnd = 0;
+		m_unFrameTimeCount = 0;
+		m_unNextFrameTime = 0;
+	}
+
+	/* Private methods. */
+	void FramePacer::WaitUntil(Uint64 unDeadline) const
+	{
+		Uint64 unSpinTicks = static_cast<Uint64>(SPIN_THRESHOLD_MS * m_unFrequency / 1000.0);
+		Uint64 unNow = SDL_GetPerformanceCounter();
+
+		/* Sleep in whole milliseconds, while the scheduler can't overshoot the deadline. */
+		while (unNow + unSpinTicks < unDeadline)
+		{
+			Uint64 unSleepMS = (unDeadline - unNow - unSpinTicks) * 1000 / m_unFrequency;
+			SDL_Delay(static_cast<Uint32>(std::max<Uint64>(unSleepMS, 1)));
+			unNow = SDL_GetPerformanceCounter();
+		}
+
+		/* Spin for the rest. */
+		while (unNow < unDeadline)
+		{
+			unNow = SDL_GetPerformanceCounter();
+		}
+	}
+}
@@ -0,0 +1,162 @@
+#pragma once
+#include <array>
+#include <SDL.h>
+
+namespace K9
+{
+	/// <summary>
+	/// Controls the swap interval and caps the frame rate in software.
+	/// Call EndFrame once per frame, after the buffers were swapped.
+	/// The software cap sleeps until shortly before the deadline and spins on SDL_GetPerformanceCounter for the rest,
+	/// since SDL_Delay alone overshoots by up to a scheduler tick.
+	/// The measured frame times are kept, so the mode with the lowest jitter can be picked per machine.
+	/// </summary>
+	class FramePacer
+	{
+	public:
+		/// <summary>
+		/// Default frame rate of EMode::eCapped.
+		/// </summary>
+		static constexpr double DEFAULT_TARGET_HZ{ 60.0 };
+
+		/// <summary>
+		/// Remaining time before a deadline, which is spun instead of slept, in milliseconds.
+		/// </summary>
+		static constexpr double SPIN_THRESHOLD_MS{ 2.0 };
+
+		/// <summary>
+		/// Number of frames, over which the statistics are computed.
+		/// </summary>
+		static constexpr unsigned int FRAME_HISTORY_SIZE{ 120 };
+
+		/// <summary>
+		/// How frames are paced.
+		/// </summary>
+		enum class EMode
+		{
+			/// <summary>
+			/// Swap interval 1. The swap waits for the vertical blank.
+			/// </summary>
+			eVSync,
+
+			/// <summary>
+			/// Swap interval -1. Like eVSync, but a late frame is swapped immediately instead of waiting a whole refresh.
+			/// </summary>
+			eAdaptiveVSync,
+
+			/// <summary>
+			/// Swap interval 0 without a cap.
+			/// </summary>
+			eUncapped,
+
+			/// <summary>
+			/// Swap interval 0 with a software cap at the target frame rate.
+			/// </summary>
+			eCapped
+		};
+
+		/// <summary>
+		/// Frame time statistics over the last FRAME_HISTORY_SIZE frames.
+		/// </summary>
+		struct SStats
+		{
+			/// <summary>
+			/// Average time between two frames in milliseconds.
+			/// </summary>
+			float m_fAverageFrameTimeMS = 0.0f;
+
+			/// <summary>
+			/// Standard deviation of the frame time in milliseconds.
+			/// </summary>
+			float m_fJitterMS = 0.0f;
+
+			/// <summary>
+			/// Shortest and longest frame time in milliseconds.
+			/// </summary>
+			float m_fMinFrameTimeMS = 0.0f;
+			float m_fMaxFrameTimeMS = 0.0f;
+		};
+
+		FramePacer();
+
+		/// <summary>
+		/// Set the pacing mode and apply its swap interval. Requires a current OpenGL context.
+		/// </summary>
+		/// <param name="eMode"> Mode to be set. </param>
+		/// <param name="dTargetHz"> Frame rate of EMode::eCapped. </param>
+		/// <returns> True, if the swap interval is supported. Adaptive vsync falls back to vsync, if it isn't. </returns>
+		bool SetMode(EMode eMode, double dTargetHz = DEFAULT_TARGET_HZ);
+
+		/// <summary>
+		/// Retrieve the pacing mode.
+		/// </summary>
+		/// <returns> m_eMode. </returns>
+		EMode GetMode() const { return m_eMode; }
+
+		/// <summary>
+		/// Retrieve the frame rate of EMode::eCapped.
+		/// </summary>
+		/// <returns> m_dTargetHz. </returns>
+		double GetTargetHz() const { return m_dTargetHz; }
+
+		/// <summary>
+		/// Wait for the deadline of the frame in EMode::eCapped and record the frame time.
+		/// </summary>
+		void EndFrame();
+
+		/// <summary>
+		/// Retrieve the frame time statistics.
+		/// </summary>
+		/// <returns> Statistics over the last FRAME_HISTORY_SIZE frames. </returns>
+		SStats GetStats() const;
+
+		/// <summary>
+		/// Forget the recorded frame times and restart the deadlines, e.g. after a long pause.
+		/// </summary>
+		void Reset();
+
+	private:
+		/// <summary>
+		/// Sleep and spin until the deadline.
+		/// </summary>
+		/// <param name="unDeadline"> Deadline in performance counter ticks. </param>
+		void WaitUntil(Uint64 unDeadline) const;
+
+	private:
+		/// <summary>
+		/// How frames are paced.
+		/// </summary>
+		EMode m_eMode;
+
+		/// <summary>
+		/// Frame rate of EMode::eCapped.
+		/// </summary>
+		double m_dTargetHz;
+
+		/// <summary>
+		/// Performance counter ticks per second.
+		/// </summary>
+		Uint64 m_unFrequency;
+
+		/// <summary>
+		/// Deadline of the current frame in performance counter ticks. 0, if there is none yet.
+		/// </summary>
+		Uint64 m_unNextDeadline;
+
+		/// <summary>
+		/// Performance counter at the end of the last frame. 0, if there is none yet.
+		/// </summary>
+		Uint64 m_unLastFrameEnd;
+
+		/// <summary>
+		/// Ring buffer of the last frame times in milliseconds.
+		/// </summary>
+		std::array<float, FRAME_HISTORY_SIZE> m_arrFrameTimesMS;
+
+		/// <summary>
+		/// Number of recorded frame times and index of the next one.
+		/// </summary>
+		unsigned int m_unFrameTimeCount;
+		unsigned int m_unNextFrameTime;
+	};
+}
@@ -0,0 +1,156 @@
+#include "IdleLoop.h"
+#include <ctime>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#endif
+
+namespace K9
+{
+	IdleLoop::IdleLoop()
+		: m_eMode{ EMode::eBusy }, m_unMaxLatencyMS{ DEFAULT_MAX_LATENCY_MS }, m_unPendingFrameCount{ 0 },
+		m_unLastCounter{ 0 }, m_dLastCPUTimeMS{ 0.0 }, m_interval{}, m_arrTotals{}, m_stats{}
+	{
+	}
+
+	void IdleLoop::SetMode(EMode eMode)
+	{
+		if (eMode == EMode::eCount)
+		{
+			return;
+		}
+		m_eMode = eMode;
+		m_unPendingFrameCount = FRAMES_AFTER_WAKEUP;
+	}
+
+	void IdleLoop::SetMaxLatency(Uint32 unMaxLatencyMS)
+	{
+		m_unMaxLatencyMS = unMaxLatencyMS > 0 ? unMaxLatencyMS : 1;
+	}
+
+	void IdleLoop::RequestRedraw()
+	{
+		/* Push a single event, until the loop picks up the request. */
+		if (!GetRedrawRequested().exchange(true))
+		{
+			SDL_Event event{};
+			event.type = GetRedrawEventType();
+			SDL_PushEvent(&event);
+		}
+	}
+
+	void IdleLoop::WaitForFrame()
+	{
+		/* The time since the last call belongs to the mode, in which the last frame was drawn. */
+		UpdateStats();
+
+		bool bRedrawRequested = GetRedrawRequested().exchange(false);
+		if (m_eMode == EMode::eBusy || bRedrawRequested)
+		{
+			return;
+		}
+		if (m_unPendingFrameCount > 0)
+		{
+			--m_unPendingFrameCount;
+			return;
+		}
+
+		/* Leave the event in the queue for the caller. Returns 0 on timeout. */
+		if (SDL_WaitEventTimeout(nullptr, static_cast<int>(m_unMaxLatencyMS)) == 1)
+		{
+			m_unPendingFrameCount = FRAMES_AFTER_WAKEUP;
+		}
+	}
+
+	IdleLoop::SStats IdleLoop::GetAverageStats(EMode eMode) const
+	{
+		if (eMode == EMode::eCount)
+		{
+			return SStats{};
+		}
+		return ToStats(m_arrTotals[static_cast<size_t>(eMode)]);
+	}
+
+	/* Private methods. */
+	void IdleLoop::UpdateStats()
+	{
+		Uint64 unCounter = SDL_GetPerformanceCounter();
+		double dCPUTimeMS = GetProcessCPUTimeMS();
+		if (m_unLastCounter == 0)
+		{
+			m_unLastCounter = unCounter;
+			m_dLastCPUTimeMS = dCPUTimeMS;
+			return;
+		}
+
+		SAccumulator delta;
+		delta.m_dWallTimeMS = static_cast<double>(unCounter - m_unLastCounter) * 1000.0 / SDL_GetPerformanceFrequency();
+		delta.m_dCPUTimeMS = dCPUTimeMS - m_dLastCPUTimeMS;
+		delta.m_unWakeupCount = 1;
+		m_unLastCounter = unCounter;
+		m_dLastCPUTimeMS = dCPUTimeMS;
+
+		for (SAccumulator* ptrAccumulator : { &m_interval, &m_arrTotals[static_cast<size_t>(m_eMode)] })
+		{
+			ptrAccumulator->m_dWallTimeMS += delta.m_dWallTimeMS;
+			ptrAccumulator->m_dCPUTimeMS += delta.m_dCPUTimeMS;
+			ptrAccumulator->m_unWakeupCount += delta.m_unWakeupCount;
+		}
+
+		if (m_interval.m_dWallTimeMS >= STATS_INTERVAL_MS)
+		{
+			m_stats = ToStats(m_interval);
+			m_interval = SAccumulator{};
+		}
+	}
+
+	IdleLoop::SStats IdleLoop::ToStats(const SAccumulator& accumulator)
+	{
+		SStats stats;
+		if (accumulator.m_dWallTimeMS > 0.0)
+		{
+			stats.m_fCPUUsage = static_cast<float>(100.0 * accumulator.m_dCPUTimeMS / accumulator.m_dWallTimeMS);
+			stats.m_fWakeupsPerSecond = static_cast<float>(1000.0 * accumulator.m_unWakeupCount / accumulator.m_dWallTimeMS);
+		}
+		return stats;
+	}
+
+	double IdleLoop::GetProcessCPUTimeMS()
+	{
+#ifdef _WIN32
+		/* clock() measures wall time on Windows. */
+		FILETIME creationTime, exitTime, kernelTime, userTime;
+		if (!GetProcessTimes(GetCurrentProcess(), &creationTime, &exitTime, &kernelTime, &userTime))
+		{
+			return 0.0;
+		}
+		auto toMS = [](const FILETIME& time)
+		{
+			ULARGE_INTEGER value;
+			value.LowPart = time.dwLowDateTime;
+			value.HighPart = time.dwHighDateTime;
+			return static_cast<double>(value.QuadPart) / 10000.0;
+		};
+		return toMS(kernelTime) + toMS(userTime);
+#else
+		return 1000.0 * static_cast<double>(std::clock()) / CLOCKS_PER_SEC;
+#endif
+	}
+
+	Uint32 IdleLoop::GetRedrawEventType()
+	{
+		static const Uint32 unEventType = []()
+		{
+			Uint32 unType = SDL_RegisterEvents(1);
+			return unType != static_cast<Uint32>(-1) ? unType : static_cast<Uint32>(SDL_USEREVENT);
+		}();
+		return unEventType;
+	}
+
+	std::atomic<bool>& IdleLoop::GetRedrawRequested()
+	{
+		static std::atomic<bool> bRedrawRequested{ false };
+		return bRedrawRequested;
+	}
+}
@@ -0,0 +1,195 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <SDL.h>
+
+namespace K9
+{
+	/// <summary>
+	/// Decides, when the main loop needs a frame, and blocks on OS events in between.
+	/// Call WaitForFrame once per loop iteration, before polling events.
+	/// In EMode::eBusy it returns immediately, so the loop runs as fast as the driver allows.
+	/// In EMode::eIdle it blocks in SDL_WaitEventTimeout until input arrives, a redraw is requested
+	/// or the maximum latency elapses. A few frames follow each wakeup, so ImGUI can settle hover and click states.
+	/// </summary>
+	class IdleLoop
+	{
+	public:
+		/// <summary>
+		/// Default maximum time between two frames in EMode::eIdle in milliseconds.
+		/// </summary>
+		static constexpr Uint32 DEFAULT_MAX_LATENCY_MS{ 250 };
+
+		/// <summary>
+		/// Number of frames, drawn without waiting after an event woke the loop.
+		/// </summary>
+		static constexpr unsigned int FRAMES_AFTER_WAKEUP{ 2 };
+
+		/// <summary>
+		/// Interval, over which GetStats is averaged, in milliseconds.
+		/// </summary>
+		static constexpr Uint32 STATS_INTERVAL_MS{ 1000 };
+
+		/// <summary>
+		/// How the loop waits for the next frame.
+		/// </summary>
+		enum class EMode
+		{
+			/// <summary>
+			/// Never wait.
+			/// </summary>
+			eBusy,
+
+			/// <summary>
+			/// Block on events, until a frame is needed.
+			/// </summary>
+			eIdle,
+
+			/// <summary>
+			/// Number of modes.
+			/// </summary>
+			eCount
+		};
+
+		/// <summary>
+		/// Load of the loop.
+		/// </summary>
+		struct SStats
+		{
+			/// <summary>
+			/// CPU time of the process per wall time in percent of a single core.
+			/// </summary>
+			float m_fCPUUsage = 0.0f;
+
+			/// <summary>
+			/// Number of loop iterations per second.
+			/// </summary>
+			float m_fWakeupsPerSecond = 0.0f;
+		};
+
+		IdleLoop();
+
+		/// <summary>
+		/// Set how the loop waits for the next frame.
+		/// </summary>
+		/// <param name="eMode"> Mode to be set. </param>
+		void SetMode(EMode eMode);
+
+		/// <summary>
+		/// Retrieve how the loop waits for the next frame.
+		/// </summary>
+		/// <returns> m_eMode. </returns>
+		EMode GetMode() const { return m_eMode; }
+
+		/// <summary>
+		/// Set the maximum time between two frames in EMode::eIdle.
+		/// Things, which don't request redraws, like a blinking text cursor, update at least this often.
+		/// </summary>
+		/// <param name="unMaxLatencyMS"> Maximum latency in milliseconds. </param>
+		void SetMaxLatency(Uint32 unMaxLatencyMS);
+
+		/// <summary>
+		/// Retrieve the maximum time between two frames in EMode::eIdle.
+		/// </summary>
+		/// <returns> m_unMaxLatencyMS. </returns>
+		Uint32 GetMaxLatency() const { return m_unMaxLatencyMS; }
+
+		/// <summary>
+		/// Request a frame from any subsystem, e.g. an animation, audio-driven UI or finished async work.
+		/// Wakes a waiting loop immediately. Can be called from any thread.
+		/// Animations must request a redraw every frame, while they run.
+		/// </summary>
+		static void RequestRedraw();
+
+		/// <summary>
+		/// Wait, until the next frame is needed.
+		/// </summary>
+		void WaitForFrame();
+
+		/// <summary>
+		/// Retrieve the load of the loop over the last STATS_INTERVAL_MS.
+		/// </summary>
+		/// <returns> m_stats. </returns>
+		const SStats& GetStats() const { return m_stats; }
+
+		/// <summary>
+		/// Retrieve the load of the loop over all the time, spent in a mode.
+		/// </summary>
+		/// <param name="eMode"> Mode of interest. </param>
+		/// <returns> Average load. Zero, if the mode was never used. </returns>
+		SStats GetAverageStats(EMode eMode) const;
+
+	private:
+		/// <summary>
+		/// Time, accumulated for the statistics.
+		/// </summary>
+		struct SAccumulator
+		{
+			double m_dWallTimeMS = 0.0;
+			double m_dCPUTimeMS = 0.0;
+			unsigned int m_unWakeupCount = 0;
+		};
+
+		/// <summary>
+		/// Count a loop iteration and update the statistics.
+		/// </summary>
+		void UpdateStats();
+
+		/// <summary>
+		/// Convert accumulated time into statistics.
+		/// </summary>
+		static SStats ToStats(const SAccumulator& accumulator);
+
+		/// <summary>
+		/// Retrieve the CPU time, used by the process, in milliseconds.
+		/// </summary>
+		static double GetProcessCPUTimeMS();
+
+		/// <summary>
+		/// Retrieve the SDL event type, used to wake a waiting loop.
+		/// </summary>
+		static Uint32 GetRedrawEventType();
+
+		/// <summary>
+		/// Retrieve the flag, which is set by RequestRedraw until the next frame starts.
+		/// </summary>
+		static std::atomic<bool>& GetRedrawRequested();
+
+	private:
+		/// <summary>
+		/// How the loop waits for the next frame.
+		/// </summary>
+		EMode m_eMode;
+
+		/// <summary>
+		/// Maximum time between two frames in EMode::eIdle in milliseconds.
+		/// </summary>
+		Uint32 m_unMaxLatencyMS;
+
+		/// <summary>
+		/// Number of frames, which are still drawn without waiting.
+		/// </summary>
+		unsigned int m_unPendingFrameCount;
+
+		/// <summary>
+		/// Wall and CPU time of the last UpdateStats.
+		/// </summary>
+		Uint64 m_unLastCounter;
+		double m_dLastCPUTimeMS;
+
+		/// <summary>
+		/// Time of the current stats interval.
+		/// </summary>
+		SAccumulator m_interval;
+
+		/// <summary>
+		/// Time, spent in each mode.
+		/// </summary>
+		std::array<SAccumulator, static_cast<size_t>(EMode::eCount)> m_arrTotals;
+
+		/// <summary>
+		/// Load over the last STATS_INTERVAL_MS.
+		/// </summary>
+		SStats m_stats;
+	};
+}
@@ -0,0 +1,126 @@
+#define SDL_MAIN_HANDLED
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+
+#include "Timing/FixedTimestep.h"
+
+/*
+ * Drives FixedTimestep from a fake clock and checks the steps per frame, the cap against the spiral of death
+ * and the interpolation alpha. Only uses the CPU, so it runs without a window.
+ * Returns EXIT_FAILURE and reports every failed check.
+ * Usage: K9_FixedTimestepCheck
+ */
+
+namespace
+{
+	/* Exactly representable, so the fake clock lands on step boundaries without rounding. */
+	constexpr double STEP_S = 1.0 / 64.0;
+	constexpr unsigned int MAX_STEPS = 5;
+
+	unsigned int g_unFailureCount = 0;
+
+	void Check(bool bCondition, const char* cstrWhat, double dTimeS)
+	{
+		if (!bCondition)
+		{
+			std::cerr << "FAILED: " << cstrWhat << " at t = " << dTimeS << " s\n";
+			g_unFailureCount++;
+		}
+	}
+
+	/* Fake clock, which only moves, when the check advances it. */
+	struct SFakeClock
+	{
+		double m_dTimeS = 0.0;
+		K9::FixedTimestep::TimeSource GetSource() { return [this]() { return m_dTimeS; }; }
+	};
+}
+
+int main()
+{
+	/* The first frame only starts the clock. */
+	{
+		SFakeClock clock;
+		clock.m_dTimeS = 100.0;
+		K9::FixedTimestep timestep(STEP_S, MAX_STEPS, clock.GetSource());
+		Check(timestep.BeginFrame() == 0, "the first frame runs no steps", clock.m_dTimeS);
+		Check(timestep.GetAlpha() == 0.0f, "the first frame has alpha 0", clock.m_dTimeS);
+	}
+
+	/* Whole and fractional steps per advance. */
+	{
+		SFakeClock clock;
+		K9::FixedTimestep timestep(STEP_S, MAX_STEPS, clock.GetSource());
+		timestep.BeginFrame();
+
+		clock.m_dTimeS += STEP_S;
+		Check(timestep.BeginFrame() == 1, "one step per step of time", clock.m_dTimeS);
+
+		clock.m_dTimeS += 3.0 * STEP_S;
+		Check(timestep.BeginFrame() == 3, "three steps per three steps of time", clock.m_dTimeS);
+
+		clock.m_dTimeS += 0.5 * STEP_S;
+		Check(timestep.BeginFrame() == 0, "no step for half a step of time", clock.m_dTimeS);
+		Check(std::fabs(timestep.GetAlpha() - 0.5f) < 1e-4f, "alpha is the remaining half step", clock.m_dTimeS);
+
+		clock.m_dTimeS += 0.5 * STEP_S;
+		Check(timestep.BeginFrame() == 1, "two half steps add up to one step", clock.m_dTimeS);
+		Check(timestep.GetStepCount() == 5, "every step is counted", clock.m_dTimeS);
+
+		/* A clock, which goes backwards, adds no time. */
+		clock.m_dTimeS -= 10.0 * STEP_S;
+		Check(timestep.BeginFrame() == 0, "a clock going backwards runs no steps", clock.m_dTimeS);
+	}
+
+	/* A long hitch runs at most MAX_STEPS steps and drops the rest, so the next frame doesn't fall behind further. */
+	{
+		SFakeClock clock;
+		K9::FixedTimestep timestep(STEP_S, MAX_STEPS, clock.GetSource());
+		timestep.BeginFrame();
+
+		clock.m_dTimeS += 100.25 * STEP_S;
+		Check(timestep.BeginFrame() == MAX_STEPS, "a hitch is capped at the maximum steps", clock.m_dTimeS);
+		Check(timestep.GetDroppedStepCount() == 100 - MAX_STEPS, "the steps beyond the cap are dropped", clock.m_dTimeS);
+		Check(std::fabs(timestep.GetAlpha() - 0.25f) < 1e-4f, "the fraction survives the cap", clock.m_dTimeS);
+
+		clock.m_dTimeS += STEP_S;
+		Check(timestep.BeginFrame() == 1, "the frame after a hitch runs a normal step", clock.m_dTimeS);
+	}
+
+	/* Random frame times: steps stay capped, alpha stays in [0, 1) and no time is lost or invented. */
+	{
+		SFakeClock clock;
+		K9::FixedTimestep timestep(STEP_S, MAX_STEPS, clock.GetSource());
+		timestep.BeginFrame();
+
+		std::mt19937 generator(1234);
+		std::uniform_real_distribution<double> frameTimeS(0.001, 0.2);
+		for (unsigned int unFrame = 0; unFrame < 100000; ++unFrame)
+		{
+			clock.m_dTimeS += frameTimeS(generator);
+			unsigned int unStepCount = timestep.BeginFrame();
+			float fAlpha = timestep.GetAlpha();
+			Check(unStepCount <= MAX_STEPS, "steps per frame stay capped", clock.m_dTimeS);
+			Check(fAlpha >= 0.0f && fAlpha < 1.0f, "alpha stays in [0, 1)", clock.m_dTimeS);
+			if (g_unFailureCount > 0)
+			{
+				break;
+			}
+		}
+
+		double dAccountedS = static_cast<double>(timestep.GetStepCount() + timestep.GetDroppedStepCount()) * STEP_S
+			+ static_cast<double>(timestep.GetAlpha()) * STEP_S;
+		Check(std::fabs(dAccountedS - clock.m_dTimeS) < 1e-6, "simulated, dropped and remaining time add up",
+			clock.m_dTimeS);
+	}
+
+	if (g_unFailureCount > 0)
+	{
+		std::cerr << "K9_FixedTimestepCheck " << g_unFailureCount << " checks failed!\n";
+		return EXIT_FAILURE;
+	}
+	std::cout << "K9_FixedTimestepCheck All checks passed.\n";
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,194 @@
+#define SDL_MAIN_HANDLED
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <SDL.h>
+
+#include "Renderer/CommandRecorder.h"
+#include "Renderer/SpriteBatch.h"
+#include "Renderer/Texture.h"
+#include "Threading/ThreadPool.h"
+
+/*
+ * Measures how the CPU side of Renderer2D::SubmitCommandRecorders scales with the number of threads:
+ * recording into per-thread CommandRecorders, merging and sorting them, and writing the quad vertices
+ * with SpriteBatch::WriteQuadVertices, as the batch does into the mapped vertex buffer.
+ * Usage: K9_RecorderBench [sprite count] [max thread count] [iterations]
+ */
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	/* Number of recorders, so the threads can take turns with a few recorders each. */
+	constexpr unsigned int RECORDERS_PER_THREAD{ 4 };
+
+	/* Number of textures, the sprites are spread over. */
+	constexpr unsigned int TEXTURE_COUNT{ 8 };
+
+	struct SBenchSprite
+	{
+		SDL_Rect m_destRect;
+		SDL_RendererFlip m_flipFormat;
+		unsigned int m_unTexture;
+		unsigned int m_unLayer;
+	};
+
+	struct STimings
+	{
+		double m_dRecordMS = 1e30;
+		double m_dSortMS = 1e30;
+		double m_dExpandMS = 1e30;
+	};
+
+	double ElapsedMS(Clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	unsigned int unSpriteCount = argc > 1 ? static_cast<unsigned int>(std::stoul(argv[1])) : 200000;
+	unsigned int unMaxThreadCount = argc > 2 ? static_cast<unsigned int>(std::stoul(argv[2])) :
+		std::max(1u, std::thread::hardware_concurrency());
+	unsigned int unIterations = argc > 3 ? static_cast<unsigned int>(std::stoul(argv[3])) : 10;
+	unMaxThreadCount = std::max(1u, unMaxThreadCount);
+
+	std::mt19937 rng{ 1234 };
+	std::uniform_int_distribution<int> posDist{ -64, 1920 };
+	std::uniform_int_distribution<int> sizeDist{ 8, 128 };
+	std::uniform_int_distribution<int> flipDist{ 0, 3 };
+	std::uniform_int_distribution<unsigned int> textureDist{ 0, TEXTURE_COUNT - 1 };
+	std::uniform_int_distribution<unsigned int> layerDist{ 0, 3 };
+
+	std::vector<SBenchSprite> vecSprites(unSpriteCount);
+	for (auto& sprite : vecSprites)
+	{
+		sprite.m_destRect = SDL_Rect{ posDist(rng), posDist(rng), sizeDist(rng), sizeDist(rng) };
+		sprite.m_flipFormat = static_cast<SDL_RendererFlip>(flipDist(rng));
+		sprite.m_unTexture = textureDist(rng);
+		sprite.m_unLayer = layerDist(rng);
+	}
+
+	/* The textures are never loaded, so only the overload without a source rect is used.
+	 * Deleting them needs a GL context, so they're left to the OS. */
+	std::vector<K9::Texture*> vecTextures;
+	for (unsigned int unIndex = 0; unIndex < TEXTURE_COUNT; ++unIndex)
+	{
+		vecTextures.push_back(new K9::Texture());
+	}
+
+	unsigned int unRecorderCount = unMaxThreadCount * RECORDERS_PER_THREAD;
+	std::vector<std::unique_ptr<K9::CommandRecorder>> vecRecorders;
+	for (unsigned int unIndex = 0; unIndex < unRecorderCount; ++unIndex)
+	{
+		vecRecorders.emplace_back(new K9::CommandRecorder());
+		vecRecorders.back()->SetViewport(SDL_Rect{ 0, 0, 1920, 1080 }, true);
+		vecRecorders.back()->Reserve(unSpriteCount / unRecorderCount + 1);
+	}
+
+	K9::RenderQueue mergedQueue;
+	mergedQueue.Reserve(unSpriteCount);
+	std::vector<const K9::SSpriteCommand*> vecCommands;
+	vecCommands.reserve(unSpriteCount);
+	std::vector<K9::SSpriteVertex> vecVertices(static_cast<size_t>(unSpriteCount) * 4);
+	std::vector<K9::SSpriteVertex> vecReferenceVertices;
+
+	std::cout << "sprites: " << unSpriteCount << ", recorders: " << unRecorderCount
+		<< ", iterations: " << unIterations << " (best of)\n"
+		<< "threads  record ms  merge+sort ms  expand ms  total ms  speedup\n";
+
+	K9::ThreadPool threadPool;
+	double dSingleThreadMS = 0.0;
+	bool bMatches = true;
+	for (unsigned int unThreadCount = 1; unThreadCount <= unMaxThreadCount; ++unThreadCount)
+	{
+		/* The calling thread works too. */
+		threadPool.Init(unThreadCount - 1);
+
+		STimings timings;
+		for (unsigned int unIteration = 0; unIteration < unIterations; ++unIteration)
+		{
+			/* Record: every recorder takes a contiguous slice of the sprites. */
+			auto start = Clock::now();
+			threadPool.ParallelFor(unRecorderCount, 1, [&](size_t unBegin, size_t unEnd)
+			{
+				for (size_t unRecorder = unBegin; unRecorder < unEnd; ++unRecorder)
+				{
+					K9::CommandRecorder& recorder = *vecRecorders[unRecorder];
+					recorder.Clear();
+					size_t unFirst = unSpriteCount * unRecorder / unRecorderCount;
+					size_t unLast = unSpriteCount * (unRecorder + 1) / unRecorderCount;
+					for (size_t unIndex = unFirst; unIndex < unLast; ++unIndex)
+					{
+						const SBenchSprite& sprite = vecSprites[unIndex];
+						recorder.SetLayer(sprite.m_unLayer, static_cast<unsigned int>(unIndex));
+						recorder.DrawTexture(*vecTextures[sprite.m_unTexture], sprite.m_destRect,
+							SDL_Color{ 255, 255, 255, 255 }, sprite.m_flipFormat);
+					}
+				}
+			});
+			timings.m_dRecordMS = std::min(timings.m_dRecordMS, ElapsedMS(start));
+
+			/* Merge and sort on the submitting thread, as SubmitCommandRecorders does. */
+			start = Clock::now();
+			mergedQueue.Clear();
+			for (const auto& ptrRecorder : vecRecorders)
+			{
+				mergedQueue.Append(ptrRecorder->GetQueue());
+			}
+			mergedQueue.Sort();
+			vecCommands.clear();
+			for (size_t unIndex = 0; unIndex < mergedQueue.GetCount(); ++unIndex)
+			{
+				vecCommands.push_back(&mergedQueue.GetSorted(unIndex));
+			}
+			timings.m_dSortMS = std::min(timings.m_dSortMS, ElapsedMS(start));
+
+			/* Expand: the same split as SpriteBatch::DrawCommands, into plain memory instead of a mapped buffer. */
+			start = Clock::now();
+			K9::SSpriteVertex* ptrVertices = vecVertices.data();
+			threadPool.ParallelFor(vecCommands.size(), K9::SpriteBatch::MIN_PARALLEL_BATCH_SIZE, [&](size_t unBegin, size_t unEnd)
+			{
+				for (size_t unIndex = unBegin; unIndex < unEnd; ++unIndex)
+				{
+					K9::SpriteBatch::WriteQuadVertices(*vecCommands[unIndex],
+						static_cast<uint32_t>(unIndex % TEXTURE_COUNT), ptrVertices + unIndex * 4);
+				}
+			});
+			timings.m_dExpandMS = std::min(timings.m_dExpandMS, ElapsedMS(start));
+		}
+
+		/* Every thread count must produce the same vertices. */
+		size_t unVertexBytes = vecCommands.size() * 4 * sizeof(K9::SSpriteVertex);
+		if (unThreadCount == 1)
+		{
+			vecReferenceVertices = vecVertices;
+		}
+		else if (std::memcmp(vecReferenceVertices.data(), vecVertices.data(), unVertexBytes) != 0)
+		{
+			bMatches = false;
+		}
+
+		double dTotalMS = timings.m_dRecordMS + timings.m_dSortMS + timings.m_dExpandMS;
+		if (unThreadCount == 1)
+		{
+			dSingleThreadMS = dTotalMS;
+		}
+		std::cout << unThreadCount << "        " << timings.m_dRecordMS << "  " << timings.m_dSortMS << "  "
+			<< timings.m_dExpandMS << "  " << dTotalMS << "  " << dSingleThreadMS / dTotalMS << "x\n";
+	}
+	threadPool.Shutdown();
+
+	std::cout << "visible sprites: " << vecCommands.size()
+		<< ", vertices match across thread counts: " << (bMatches ? "yes" : "no") << "\n";
+	return bMatches ? EXIT_SUCCESS : EXIT_FAILURE;
+}
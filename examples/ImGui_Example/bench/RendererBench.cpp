@@ -0,0 +1,1018 @@
+#define SDL_MAIN_HANDLED
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include <SDL.h>
+#include <glad/glad.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include "Renderer/Font.h"
+#include "Renderer/Renderer2D.h"
+#include "Renderer/RenderQueue.h"
+#include "Renderer/SpatialGrid.h"
+#include "Renderer/Texture.h"
+#include "Renderer/TextureStreamer.h"
+
+/*
+ * Renders stress scenes with Renderer2D and reports per run, as JSON:
+ * the CPU submission time from BeginFrame until EndFrame, the whole frame time including EndFrame,
+ * the swap and a glFinish, so the GPU time of software rasterizers like llvmpipe counts,
+ * their percentiles, the draw calls and GL state changes of a frame and the peak RSS of the process so far.
+ * Runs headless by default. On machines without a GPU, Mesa's llvmpipe is picked by SDL's offscreen driver.
+ * Must be started from the build directory, where the assets are copied, for the text scene.
+ * The world scenes pan over sprites, which cover many screens, and report the submitted and culled sprites,
+ * once culled by Renderer2D per sprite and once queried from a SpatialGrid, with the time of the query.
+ * The stream scene writes images next to the bench and streams them with the TextureStreamer of Renderer2D, while it runs.
+ * It reports the frame, in which the last one became resident, the most bytes uploaded in a frame against the budget
+ * and the number of image pairs, which became resident against their priority order.
+ * Afterwards sweeps RenderQueue::Sort against std::sort of the same keys on the CPU, once per frame of a run.
+ * Usage: K9_RendererBench [--scenes static,moving,mixed,subrect,text,world,worldgrid,stream] [--counts 1000,10000,100000,1000000]
+ *        [--sort-counts 10000,100000,1000000] [--frames 120] [--warmup 10] [--mode batched|instanced|immediate]
+ *        [--window] [--output K9_RendererBench.json]
+ */
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	constexpr int SCREEN_WIDTH{ 1280 };
+	constexpr int SCREEN_HEIGHT{ 720 };
+
+	/* Number of textures of the mixed scene. */
+	constexpr unsigned int TEXTURE_COUNT{ 16 };
+
+	/* Size of the atlas of the sub-rect scene and of its tiles. */
+	constexpr int ATLAS_SIZE{ 256 };
+	constexpr int ATLAS_TILE_SIZE{ 32 };
+
+	/* Size of the world of the world scenes in screens, the speed of the camera and the cell size of the grid. */
+	constexpr int WORLD_SCREENS{ 8 };
+	constexpr int CAMERA_SPEED{ 7 };
+	constexpr int GRID_CELL_SIZE{ K9::SpatialGrid::DEFAULT_CELL_SIZE };
+
+	/* Number of images of the stream scene, the range of their sizes and the range of the sizes of their sprites. */
+	constexpr unsigned int STREAM_IMAGE_COUNT{ 24 };
+	constexpr int STREAM_MIN_IMAGE_SIZE{ 256 };
+	constexpr int STREAM_MAX_IMAGE_SIZE{ 1024 };
+	constexpr int STREAM_MIN_SPRITE_SIZE{ 8 };
+	constexpr int STREAM_MAX_SPRITE_SIZE{ 64 };
+
+	/* Number of layers and the depth range of the keys of the sort sweep. */
+	constexpr unsigned int SORT_LAYER_COUNT{ 4 };
+	constexpr uint32_t SORT_MAX_DEPTH{ (1u << K9::RenderQueue::DEPTH_BITS) - 1 };
+
+	/* Number of distinct strings of the text scene and the number of them, rendered again every frame. */
+	constexpr unsigned int TEXT_COUNT{ 256 };
+	constexpr unsigned int TEXT_UPDATES_PER_FRAME{ 8 };
+	constexpr int TEXT_POINT_SIZE{ 16 };
+
+	enum class EScene
+	{
+		/* N sprites of one texture, which never move. */
+		eStatic,
+		/* N sprites of one texture, which bounce around the screen. */
+		eMoving,
+		/* N static sprites, spread over TEXTURE_COUNT textures. */
+		eMixed,
+		/* N rotated sprites, which show tiles of an atlas. */
+		eSubRect,
+		/* N text sprites, a few of which are rendered again every frame. */
+		eText,
+		/* N static sprites over WORLD_SCREENS x WORLD_SCREENS screens under a panning camera, culled by Renderer2D. */
+		eWorld,
+		/* The world scene, but only the sprites, which a SpatialGrid query finds, are drawn. */
+		eWorldGrid,
+		/* N static sprites over STREAM_IMAGE_COUNT images, which are streamed, while the scene runs. */
+		eStream
+	};
+
+	struct SSceneInfo
+	{
+		EScene m_eScene;
+		const char* m_ptrName;
+	};
+
+	constexpr SSceneInfo SCENES[]
+	{
+		{ EScene::eStatic, "static" },
+		{ EScene::eMoving, "moving" },
+		{ EScene::eMixed, "mixed" },
+		{ EScene::eSubRect, "subrect" },
+		{ EScene::eText, "text" },
+		{ EScene::eWorld, "world" },
+		{ EScene::eWorldGrid, "worldgrid" },
+		{ EScene::eStream, "stream" }
+	};
+
+	struct SBenchSprite
+	{
+		SDL_Rect m_destRect;
+		SDL_Rect m_srcRect;
+		float m_fX;
+		float m_fY;
+		float m_fVelocityX;
+		float m_fVelocityY;
+		float m_fAngle;
+		unsigned int m_unTexture;
+	};
+
+	struct SOptions
+	{
+		std::vector<EScene> m_vecScenes;
+		std::vector<unsigned int> m_vecCounts{ 1000, 10000, 100000, 1000000 };
+		std::vector<unsigned int> m_vecSortCounts{ 10000, 100000, 1000000 };
+		unsigned int m_unFrames = 120;
+		unsigned int m_unWarmupFrames = 10;
+		K9::Renderer2D::ERenderMode m_eRenderMode = K9::Renderer2D::ERenderMode::eBatched;
+		const char* m_ptrModeName = "batched";
+		bool m_bHeadless = true;
+		std::string m_strOutputPath = "K9_RendererBench.json";
+	};
+
+	struct SPercentiles
+	{
+		double m_dAverageMS = 0.0;
+		double m_dP50MS = 0.0;
+		double m_dP95MS = 0.0;
+		double m_dP99MS = 0.0;
+	};
+
+	/* Streaming of the stream scene. Empty for the other scenes. */
+	struct SStreamResult
+	{
+		unsigned int m_unImageCount = 0;
+		unsigned int m_unResidentCount = 0;
+		/* Frame, in which the last image became resident, counting the warmup. -1, if some never did. */
+		int m_nLastResidentFrame = -1;
+		size_t m_unMaxUploadedBytes = 0;
+		size_t m_unUploadBudget = 0;
+		unsigned int m_unPriorityInversionCount = 0;
+		unsigned int m_unBufferBusyCount = 0;
+	};
+
+	struct SRunResult
+	{
+		const char* m_ptrScene;
+		unsigned int m_unSpriteCount;
+		SPercentiles m_submit;
+		SPercentiles m_frame;
+		/* Time of the SpatialGrid query. Only measured in the worldgrid scene. */
+		SPercentiles m_cull;
+		K9::Renderer2D::SStats m_stats;
+		K9::SpatialGrid::SQueryStats m_queryStats;
+		SStreamResult m_stream;
+		uint64_t m_unPeakRSSKB;
+	};
+
+	struct SSortResult
+	{
+		unsigned int m_unCommandCount;
+		SPercentiles m_radix;
+		SPercentiles m_stdSort;
+		bool m_bSameOrder;
+	};
+
+	double ElapsedMS(Clock::time_point start, Clock::time_point end)
+	{
+		return std::chrono::duration<double, std::milli>(end - start).count();
+	}
+
+	/* Nearest-rank percentiles. Sorts vecSamples. */
+	SPercentiles ComputePercentiles(std::vector<double>& vecSamples)
+	{
+		SPercentiles percentiles;
+		if (vecSamples.empty())
+		{
+			return percentiles;
+		}
+
+		std::sort(vecSamples.begin(), vecSamples.end());
+		auto rank = [&vecSamples](double dPercent)
+		{
+			size_t unRank = static_cast<size_t>(std::ceil(dPercent / 100.0 * vecSamples.size()));
+			return vecSamples[std::max<size_t>(unRank, 1) - 1];
+		};
+		double dSumMS = 0.0;
+		for (double dSampleMS : vecSamples)
+		{
+			dSumMS += dSampleMS;
+		}
+		percentiles.m_dAverageMS = dSumMS / vecSamples.size();
+		percentiles.m_dP50MS = rank(50.0);
+		percentiles.m_dP95MS = rank(95.0);
+		percentiles.m_dP99MS = rank(99.0);
+		return percentiles;
+	}
+
+	uint64_t GetPeakRSSKB()
+	{
+#ifdef _WIN32
+		PROCESS_MEMORY_COUNTERS counters{};
+		if (K32GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		{
+			return static_cast<uint64_t>(counters.PeakWorkingSetSize) / 1024;
+		}
+		return 0;
+#else
+		rusage usage{};
+		getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+		return static_cast<uint64_t>(usage.ru_maxrss) / 1024;
+#else
+		return static_cast<uint64_t>(usage.ru_maxrss);
+#endif
+#endif
+	}
+
+	/* Checkerboard in the given color, so the sampling isn't trivially uniform. */
+	SDL_Surface* CreateCheckerboard(int nSize, const SDL_Color& color)
+	{
+		SDL_Surface* ptrSurface = SDL_CreateRGBSurfaceWithFormat(0, nSize, nSize, 32, SDL_PIXELFORMAT_RGBA32);
+		if (!ptrSurface)
+		{
+			return nullptr;
+		}
+		Uint32 unColor = SDL_MapRGBA(ptrSurface->format, color.r, color.g, color.b, color.a);
+		Uint32 unDark = SDL_MapRGBA(ptrSurface->format, color.r / 2, color.g / 2, color.b / 2, color.a);
+		for (int nY = 0; nY < nSize; ++nY)
+		{
+			Uint32* ptrRow = reinterpret_cast<Uint32*>(static_cast<uint8_t*>(ptrSurface->pixels) + nY * ptrSurface->pitch);
+			for (int nX = 0; nX < nSize; ++nX)
+			{
+				ptrRow[nX] = ((nX / 8 + nY / 8) % 2 == 0) ? unColor : unDark;
+			}
+		}
+		return ptrSurface;
+	}
+
+	std::unique_ptr<K9::Texture> CreateTexture(int nSize, const SDL_Color& color)
+	{
+		SDL_Surface* ptrSurface = CreateCheckerboard(nSize, color);
+		if (!ptrSurface)
+		{
+			return nullptr;
+		}
+
+		std::unique_ptr<K9::Texture> ptrTexture{ new K9::Texture() };
+		ptrTexture->CreateFromSurface(ptrSurface);
+		SDL_FreeSurface(ptrSurface);
+		return ptrTexture;
+	}
+
+	std::vector<std::string> Split(const std::string& strList)
+	{
+		std::vector<std::string> vecItems;
+		std::stringstream stream{ strList };
+		std::string strItem;
+		while (std::getline(stream, strItem, ','))
+		{
+			if (!strItem.empty())
+			{
+				vecItems.push_back(strItem);
+			}
+		}
+		return vecItems;
+	}
+
+	bool ParseOptions(int argc, char* argv[], SOptions& options)
+	{
+		for (int nArg = 1; nArg < argc; ++nArg)
+		{
+			std::string strArg = argv[nArg];
+			bool bHasValue = nArg + 1 < argc;
+			if (strArg == "--window")
+			{
+				options.m_bHeadless = false;
+			}
+			else if (strArg == "--scenes" && bHasValue)
+			{
+				for (const auto& strScene : Split(argv[++nArg]))
+				{
+					auto it = std::find_if(std::begin(SCENES), std::end(SCENES),
+						[&strScene](const SSceneInfo& info) { return strScene == info.m_ptrName; });
+					if (it == std::end(SCENES))
+					{
+						std::cerr << "K9_RendererBench Unknown scene " << strScene << "\n";
+						return false;
+					}
+					options.m_vecScenes.push_back(it->m_eScene);
+				}
+			}
+			else if (strArg == "--counts" && bHasValue)
+			{
+				options.m_vecCounts.clear();
+				for (const auto& strCount : Split(argv[++nArg]))
+				{
+					options.m_vecCounts.push_back(static_cast<unsigned int>(std::stoul(strCount)));
+				}
+			}
+			else if (strArg == "--sort-counts" && bHasValue)
+			{
+				options.m_vecSortCounts.clear();
+				for (const auto& strCount : Split(argv[++nArg]))
+				{
+					options.m_vecSortCounts.push_back(static_cast<unsigned int>(std::stoul(strCount)));
+				}
+			}
+			else if (strArg == "--frames" && bHasValue)
+			{
+				options.m_unFrames = std::max(1u, static_cast<unsigned int>(std::stoul(argv[++nArg])));
+			}
+			else if (strArg == "--warmup" && bHasValue)
+			{
+				options.m_unWarmupFrames = static_cast<unsigned int>(std::stoul(argv[++nArg]));
+			}
+			else if (strArg == "--mode" && bHasValue)
+			{
+				std::string strMode = argv[++nArg];
+				if (strMode == "batched")
+				{
+					options.m_eRenderMode = K9::Renderer2D::ERenderMode::eBatched;
+					options.m_ptrModeName = "batched";
+				}
+				else if (strMode == "instanced")
+				{
+					options.m_eRenderMode = K9::Renderer2D::ERenderMode::eInstanced;
+					options.m_ptrModeName = "instanced";
+				}
+				else if (strMode == "immediate")
+				{
+					options.m_eRenderMode = K9::Renderer2D::ERenderMode::eImmediate;
+					options.m_ptrModeName = "immediate";
+				}
+				else
+				{
+					std::cerr << "K9_RendererBench Unknown mode " << strMode << "\n";
+					return false;
+				}
+			}
+			else if (strArg == "--output" && bHasValue)
+			{
+				options.m_strOutputPath = argv[++nArg];
+			}
+			else
+			{
+				std::cerr << "K9_RendererBench Unknown argument " << strArg << "\n";
+				return false;
+			}
+		}
+
+		if (options.m_vecScenes.empty())
+		{
+			for (const auto& info : SCENES)
+			{
+				options.m_vecScenes.push_back(info.m_eScene);
+			}
+		}
+		return true;
+	}
+
+	std::string EscapeJSON(const std::string& strText)
+	{
+		std::string strEscaped;
+		for (char c : strText)
+		{
+			if (c == '"' || c == '\\')
+			{
+				strEscaped += '\\';
+			}
+			strEscaped += c;
+		}
+		return strEscaped;
+	}
+
+	void WritePercentiles(std::ostream& stream, const char* ptrName, const SPercentiles& percentiles)
+	{
+		stream << "\"" << ptrName << "\": { \"avg\": " << percentiles.m_dAverageMS << ", \"p50\": " << percentiles.m_dP50MS
+			<< ", \"p95\": " << percentiles.m_dP95MS << ", \"p99\": " << percentiles.m_dP99MS << " }";
+	}
+
+	/*
+	 * Sorts unCommandCount commands with RenderQueue::Sort and the same keys with std::sort, once per frame.
+	 * Keys spread over a few layers, TEXTURE_COUNT textures and random depths, so most radix passes run.
+	 * The queue is refilled in submission order before every sort, which isn't timed.
+	 * The index breaks ties for std::sort, so both give the same stable order, which is checked.
+	 */
+	SSortResult RunSortSweep(const SOptions& options, unsigned int unCommandCount, std::mt19937& rng)
+	{
+		std::uniform_int_distribution<uint32_t> layerDist{ 0, SORT_LAYER_COUNT - 1 };
+		std::uniform_int_distribution<uint32_t> textureDist{ 1, TEXTURE_COUNT };
+		std::uniform_int_distribution<uint32_t> depthDist{ 0, SORT_MAX_DEPTH };
+
+		/* The key and the submission index, as RenderQueue sorts them. */
+		using SortEntry = std::pair<uint64_t, uint32_t>;
+		std::vector<SortEntry> vecKeys(unCommandCount);
+		for (uint32_t unIndex = 0; unIndex < unCommandCount; ++unIndex)
+		{
+			vecKeys[unIndex] = SortEntry{ K9::RenderQueue::MakeSortKey(layerDist(rng), 0, 1, textureDist(rng), depthDist(rng)),
+				unIndex };
+		}
+
+		/* The x of the destination rect holds the submission index, so the sorted order can be compared. */
+		K9::SSpriteCommand command{};
+		K9::RenderQueue queue;
+		queue.Reserve(unCommandCount);
+		std::vector<SortEntry> vecSorted;
+		vecSorted.reserve(unCommandCount);
+
+		std::vector<double> vecRadixMS;
+		std::vector<double> vecStdSortMS;
+		vecRadixMS.reserve(options.m_unFrames);
+		vecStdSortMS.reserve(options.m_unFrames);
+		for (unsigned int unFrame = 0; unFrame < options.m_unWarmupFrames + options.m_unFrames; ++unFrame)
+		{
+			queue.Clear();
+			for (const auto& entry : vecKeys)
+			{
+				command.m_destRect.x = static_cast<int>(entry.second);
+				queue.Push(entry.first, command);
+			}
+			auto radixStart = Clock::now();
+			queue.Sort();
+			auto radixEnd = Clock::now();
+
+			vecSorted.assign(vecKeys.begin(), vecKeys.end());
+			auto stdSortStart = Clock::now();
+			std::sort(vecSorted.begin(), vecSorted.end());
+			auto stdSortEnd = Clock::now();
+
+			if (unFrame >= options.m_unWarmupFrames)
+			{
+				vecRadixMS.push_back(ElapsedMS(radixStart, radixEnd));
+				vecStdSortMS.push_back(ElapsedMS(stdSortStart, stdSortEnd));
+			}
+		}
+
+		SSortResult result;
+		result.m_unCommandCount = unCommandCount;
+		result.m_radix = ComputePercentiles(vecRadixMS);
+		result.m_stdSort = ComputePercentiles(vecStdSortMS);
+		result.m_bSameOrder = queue.GetCount() == vecSorted.size();
+		for (size_t unIndex = 0; result.m_bSameOrder && unIndex < vecSorted.size(); ++unIndex)
+		{
+			result.m_bSameOrder = queue.GetSorted(unIndex).m_destRect.x == static_cast<int>(vecSorted[unIndex].second);
+		}
+		return result;
+	}
+
+	/* Every run keeps the renderer and the textures, so only the sprites change. */
+	class Bench
+	{
+	public:
+		explicit Bench(const SOptions& options)
+			: m_options{ options }, m_rng{ 1234 }, m_vecTextures{}, m_ptrAtlas{ nullptr }, m_font{},
+			m_bFontLoaded{ false }, m_vecTexts{}, m_vecSprites{}, m_unTextUpdate{ 0 }, m_grid{ GRID_CELL_SIZE },
+			m_vecVisibleIDs{}, m_cameraRect{}, m_dCullMS{ 0.0 }, m_vecStreamFileNames{}, m_vecStreams{},
+			m_vecStreamResidentFrames{}, m_streamResult{}
+		{
+		}
+
+		bool Init()
+		{
+			for (unsigned int unIndex = 0; unIndex < TEXTURE_COUNT; ++unIndex)
+			{
+				SDL_Color color{ static_cast<Uint8>(64 + unIndex * 12), static_cast<Uint8>(255 - unIndex * 12), 128, 255 };
+				m_vecTextures.push_back(CreateTexture(32, color));
+				if (!m_vecTextures.back())
+				{
+					std::cerr << "K9_RendererBench Failed to create a texture! SDL error: " << SDL_GetError() << "\n";
+					return false;
+				}
+			}
+			m_ptrAtlas = CreateTexture(ATLAS_SIZE, SDL_Color{ 255, 200, 64, 255 });
+			if (!m_ptrAtlas)
+			{
+				std::cerr << "K9_RendererBench Failed to create the atlas! SDL error: " << SDL_GetError() << "\n";
+				return false;
+			}
+
+			/* Without the images, the stream scene is skipped. */
+			std::uniform_int_distribution<int> imageSizeDist{ STREAM_MIN_IMAGE_SIZE, STREAM_MAX_IMAGE_SIZE };
+			for (unsigned int unIndex = 0; unIndex < STREAM_IMAGE_COUNT; ++unIndex)
+			{
+				std::string strFileName = "K9_RendererBench_stream_" + std::to_string(unIndex) + ".bmp";
+				SDL_Color color{ 255, static_cast<Uint8>(unIndex * 10), static_cast<Uint8>(255 - unIndex * 10), 255 };
+				SDL_Surface* ptrSurface = CreateCheckerboard(imageSizeDist(m_rng), color);
+				bool bSaved = ptrSurface && SDL_SaveBMP(ptrSurface, strFileName.c_str()) == 0;
+				SDL_FreeSurface(ptrSurface);
+				if (!bSaved)
+				{
+					std::cerr << "K9_RendererBench Failed to write " << strFileName << "! SDL error: " << SDL_GetError() << "\n";
+					break;
+				}
+				m_vecStreamFileNames.push_back(strFileName);
+			}
+
+			/* Without the font, the text scene is skipped. */
+			m_bFontLoaded = m_font.Load("assets/fonts/BLKCHCRY.TTF");
+			if (m_bFontLoaded)
+			{
+				for (unsigned int unIndex = 0; unIndex < TEXT_COUNT; ++unIndex)
+				{
+					m_vecTexts.push_back(m_font.RenderText("Text " + std::to_string(unIndex), SDL_Color{ 255, 255, 255, 255 },
+						TEXT_POINT_SIZE));
+				}
+			}
+			return true;
+		}
+
+		void Shutdown()
+		{
+			/* The textures must be released while the context is alive. */
+			m_vecTexts.clear();
+			m_vecTextures.clear();
+			m_ptrAtlas.reset();
+			m_font.Unload();
+			m_vecStreams.clear();
+			for (const auto& strFileName : m_vecStreamFileNames)
+			{
+				std::remove(strFileName.c_str());
+			}
+			m_vecStreamFileNames.clear();
+		}
+
+		bool CanRun(EScene eScene) const
+		{
+			if (eScene == EScene::eStream)
+			{
+				return m_vecStreamFileNames.size() == STREAM_IMAGE_COUNT;
+			}
+			return eScene != EScene::eText || m_bFontLoaded;
+		}
+
+		SRunResult Run(const SSceneInfo& info, unsigned int unSpriteCount)
+		{
+			CreateSprites(info.m_eScene, unSpriteCount);
+
+			K9::Renderer2D& renderer = K9::Renderer2D::Ref();
+			std::vector<double> vecSubmitMS;
+			std::vector<double> vecFrameMS;
+			std::vector<double> vecCullMS;
+			vecSubmitMS.reserve(m_options.m_unFrames);
+			vecFrameMS.reserve(m_options.m_unFrames);
+			vecCullMS.reserve(m_options.m_unFrames);
+
+			for (unsigned int unFrame = 0; unFrame < m_options.m_unWarmupFrames + m_options.m_unFrames; ++unFrame)
+			{
+				SDL_PumpEvents();
+				if (info.m_eScene == EScene::eMoving)
+				{
+					MoveSprites();
+				}
+				else if (info.m_eScene == EScene::eWorld || info.m_eScene == EScene::eWorldGrid)
+				{
+					MoveCamera();
+				}
+
+				auto frameStart = Clock::now();
+				renderer.BeginFrame();
+				DrawSprites(info.m_eScene);
+				auto submitEnd = Clock::now();
+				renderer.EndFrame();
+				glFinish();
+				auto frameEnd = Clock::now();
+				if (info.m_eScene == EScene::eStream)
+				{
+					TrackStreams(static_cast<int>(unFrame));
+				}
+
+				if (unFrame >= m_options.m_unWarmupFrames)
+				{
+					vecSubmitMS.push_back(ElapsedMS(frameStart, submitEnd));
+					vecFrameMS.push_back(ElapsedMS(frameStart, frameEnd));
+					if (info.m_eScene == EScene::eWorldGrid)
+					{
+						vecCullMS.push_back(m_dCullMS);
+					}
+				}
+			}
+
+			SRunResult result;
+			result.m_ptrScene = info.m_ptrName;
+			result.m_unSpriteCount = unSpriteCount;
+			result.m_submit = ComputePercentiles(vecSubmitMS);
+			result.m_frame = ComputePercentiles(vecFrameMS);
+			result.m_cull = ComputePercentiles(vecCullMS);
+			result.m_stats = renderer.GetStats();
+			result.m_queryStats = info.m_eScene == EScene::eWorldGrid ? m_grid.GetQueryStats() : K9::SpatialGrid::SQueryStats{};
+			result.m_stream = info.m_eScene == EScene::eStream ? FinishStreams() : SStreamResult{};
+			result.m_unPeakRSSKB = GetPeakRSSKB();
+			return result;
+		}
+
+	private:
+		void CreateSprites(EScene eScene, unsigned int unSpriteCount)
+		{
+			/* The world scenes spread the sprites over many screens, of which the camera only sees one. */
+			bool bWorld = eScene == EScene::eWorld || eScene == EScene::eWorldGrid;
+			int nScreens = bWorld ? WORLD_SCREENS : 1;
+			std::uniform_real_distribution<float> xDist{ 0.0f, static_cast<float>(SCREEN_WIDTH * nScreens) };
+			std::uniform_real_distribution<float> yDist{ 0.0f, static_cast<float>(SCREEN_HEIGHT * nScreens) };
+			std::uniform_real_distribution<float> velocityDist{ -4.0f, 4.0f };
+			std::uniform_real_distribution<float> angleDist{ 0.0f, 360.0f };
+			std::uniform_int_distribution<int> sizeDist{ 8, 32 };
+			std::uniform_int_distribution<unsigned int> textureDist{ 0, TEXTURE_COUNT - 1 };
+			std::uniform_int_distribution<int> tileDist{ 0, ATLAS_SIZE / ATLAS_TILE_SIZE - 1 };
+			std::uniform_int_distribution<unsigned int> textDist{ 0, TEXT_COUNT - 1 };
+			std::uniform_int_distribution<unsigned int> streamDist{ 0, STREAM_IMAGE_COUNT - 1 };
+
+			m_vecSprites.resize(unSpriteCount);
+			for (auto& sprite : m_vecSprites)
+			{
+				sprite.m_fX = xDist(m_rng);
+				sprite.m_fY = yDist(m_rng);
+				sprite.m_fVelocityX = velocityDist(m_rng);
+				sprite.m_fVelocityY = velocityDist(m_rng);
+				sprite.m_fAngle = eScene == EScene::eSubRect ? angleDist(m_rng) : 0.0f;
+				int nSize = sizeDist(m_rng);
+				sprite.m_destRect = SDL_Rect{ static_cast<int>(sprite.m_fX), static_cast<int>(sprite.m_fY), nSize, nSize };
+				sprite.m_srcRect = SDL_Rect{ tileDist(m_rng) * ATLAS_TILE_SIZE, tileDist(m_rng) * ATLAS_TILE_SIZE,
+					ATLAS_TILE_SIZE, ATLAS_TILE_SIZE };
+				sprite.m_unTexture = 0;
+				if (eScene == EScene::eMixed)
+				{
+					sprite.m_unTexture = textureDist(m_rng);
+				}
+				else if (eScene == EScene::eText)
+				{
+					sprite.m_unTexture = textDist(m_rng);
+					const auto& ptrText = m_vecTexts[sprite.m_unTexture];
+					sprite.m_destRect.w = ptrText ? ptrText->GetWidth() : 0;
+					sprite.m_destRect.h = ptrText ? ptrText->GetHeight() : 0;
+				}
+				else if (eScene == EScene::eStream)
+				{
+					/* Later images get larger sprites, so their priorities differ. */
+					sprite.m_unTexture = streamDist(m_rng);
+					sprite.m_destRect.w = STREAM_MIN_SPRITE_SIZE + static_cast<int>(sprite.m_unTexture)
+						* (STREAM_MAX_SPRITE_SIZE - STREAM_MIN_SPRITE_SIZE) / static_cast<int>(STREAM_IMAGE_COUNT - 1);
+					sprite.m_destRect.h = sprite.m_destRect.w;
+				}
+			}
+
+			m_cameraRect = SDL_Rect{ 0, 0, SCREEN_WIDTH, SCREEN_HEIGHT };
+			m_grid.Clear();
+			if (eScene == EScene::eWorldGrid)
+			{
+				for (const auto& sprite : m_vecSprites)
+				{
+					m_grid.Insert(sprite.m_destRect);
+				}
+			}
+			if (eScene == EScene::eStream)
+			{
+				StartStreams();
+			}
+		}
+
+		/* Releasing the handles of the last run drops its textures, so every run streams all images again. */
+		void StartStreams()
+		{
+			K9::TextureStreamer& streamer = K9::Renderer2D::Ref().GetTextureStreamer();
+			m_vecStreams.clear();
+			for (const auto& strFileName : m_vecStreamFileNames)
+			{
+				m_vecStreams.push_back(streamer.Load(strFileName));
+			}
+
+			/* Images of larger sprites become sharp first. */
+			for (const auto& sprite : m_vecSprites)
+			{
+				const K9::TextureHandle& ptrStream = m_vecStreams[sprite.m_unTexture];
+				float fArea = static_cast<float>(sprite.m_destRect.w) * static_cast<float>(sprite.m_destRect.h);
+				if (ptrStream && fArea > ptrStream->GetPriority())
+				{
+					ptrStream->SetPriority(sprite.m_destRect);
+				}
+			}
+
+			m_vecStreamResidentFrames.assign(m_vecStreams.size(), -1);
+			m_streamResult = SStreamResult{};
+			m_streamResult.m_unImageCount = static_cast<unsigned int>(m_vecStreams.size());
+			m_streamResult.m_unUploadBudget = streamer.GetUploadBudget();
+			m_streamResult.m_unBufferBusyCount = streamer.GetStats().m_unBufferBusyCount;
+		}
+
+		/* Called after every frame of the stream scene, including the warmup. */
+		void TrackStreams(int nFrame)
+		{
+			const K9::TextureStreamer::SStats& stats = K9::Renderer2D::Ref().GetTextureStreamer().GetStats();
+			m_streamResult.m_unMaxUploadedBytes = std::max(m_streamResult.m_unMaxUploadedBytes, stats.m_unUploadedBytes);
+			for (size_t unIndex = 0; unIndex < m_vecStreams.size(); ++unIndex)
+			{
+				if (m_vecStreamResidentFrames[unIndex] < 0 && m_vecStreams[unIndex] && m_vecStreams[unIndex]->IsResident())
+				{
+					m_vecStreamResidentFrames[unIndex] = nFrame;
+				}
+			}
+		}
+
+		SStreamResult FinishStreams()
+		{
+			SStreamResult result = m_streamResult;
+			result.m_unBufferBusyCount = K9::Renderer2D::Ref().GetTextureStreamer().GetStats().m_unBufferBusyCount
+				- m_streamResult.m_unBufferBusyCount;
+
+			int nLastFrame = -1;
+			for (size_t unIndex = 0; unIndex < m_vecStreams.size(); ++unIndex)
+			{
+				int nFrame = m_vecStreamResidentFrames[unIndex];
+				if (nFrame < 0)
+				{
+					continue;
+				}
+				result.m_unResidentCount++;
+				nLastFrame = std::max(nLastFrame, nFrame);
+
+				/* An image with a higher priority, which became resident after one with a lower priority. */
+				for (size_t unOther = 0; unOther < m_vecStreams.size(); ++unOther)
+				{
+					int nOtherFrame = m_vecStreamResidentFrames[unOther];
+					if (nOtherFrame >= 0 && nOtherFrame < nFrame &&
+						m_vecStreams[unOther]->GetPriority() < m_vecStreams[unIndex]->GetPriority())
+					{
+						result.m_unPriorityInversionCount++;
+					}
+				}
+			}
+			result.m_nLastResidentFrame = result.m_unResidentCount == result.m_unImageCount ? nLastFrame : -1;
+			return result;
+		}
+
+		void MoveCamera()
+		{
+			/* Pan diagonally and wrap, so the camera stays inside the world. */
+			m_cameraRect.x = (m_cameraRect.x + CAMERA_SPEED) % (SCREEN_WIDTH * (WORLD_SCREENS - 1));
+			m_cameraRect.y = (m_cameraRect.y + CAMERA_SPEED) % (SCREEN_HEIGHT * (WORLD_SCREENS - 1));
+		}
+
+		void MoveSprites()
+		{
+			for (auto& sprite : m_vecSprites)
+			{
+				sprite.m_fX += sprite.m_fVelocityX;
+				sprite.m_fY += sprite.m_fVelocityY;
+				if (sprite.m_fX < 0.0f || sprite.m_fX > SCREEN_WIDTH)
+				{
+					sprite.m_fVelocityX = -sprite.m_fVelocityX;
+				}
+				if (sprite.m_fY < 0.0f || sprite.m_fY > SCREEN_HEIGHT)
+				{
+					sprite.m_fVelocityY = -sprite.m_fVelocityY;
+				}
+				sprite.m_destRect.x = static_cast<int>(sprite.m_fX);
+				sprite.m_destRect.y = static_cast<int>(sprite.m_fY);
+			}
+		}
+
+		void DrawSprites(EScene eScene)
+		{
+			K9::Renderer2D& renderer = K9::Renderer2D::Ref();
+			switch (eScene)
+			{
+			case EScene::eStatic:
+			case EScene::eMoving:
+			case EScene::eMixed:
+				for (const auto& sprite : m_vecSprites)
+				{
+					renderer.DrawTexture(*m_vecTextures[sprite.m_unTexture], sprite.m_destRect);
+				}
+				break;
+			case EScene::eSubRect:
+				for (const auto& sprite : m_vecSprites)
+				{
+					SDL_Point center{ sprite.m_destRect.w / 2, sprite.m_destRect.h / 2 };
+					renderer.DrawTexture(*m_ptrAtlas, sprite.m_srcRect, sprite.m_destRect, sprite.m_fAngle, center);
+				}
+				break;
+			case EScene::eWorld:
+				/* Every sprite is submitted and Renderer2D culls the ones outside of the viewport. */
+				for (const auto& sprite : m_vecSprites)
+				{
+					SDL_Rect destRect = sprite.m_destRect;
+					destRect.x -= m_cameraRect.x;
+					destRect.y -= m_cameraRect.y;
+					renderer.DrawTexture(*m_vecTextures[0], destRect);
+				}
+				break;
+			case EScene::eWorldGrid:
+			{
+				/* Only the sprites in the cells under the camera are tested and submitted. */
+				auto cullStart = Clock::now();
+				m_grid.Query(m_cameraRect, m_vecVisibleIDs);
+				m_dCullMS = ElapsedMS(cullStart, Clock::now());
+				for (uint32_t unID : m_vecVisibleIDs)
+				{
+					SDL_Rect destRect = m_grid.GetRect(unID);
+					destRect.x -= m_cameraRect.x;
+					destRect.y -= m_cameraRect.y;
+					renderer.DrawTexture(*m_vecTextures[0], destRect);
+				}
+				break;
+			}
+			case EScene::eStream:
+				/* Shows the placeholder, until the image of a sprite is resident. */
+				for (const auto& sprite : m_vecSprites)
+				{
+					const K9::TextureHandle& ptrStream = m_vecStreams[sprite.m_unTexture];
+					if (ptrStream)
+					{
+						renderer.DrawTexture(ptrStream->GetTexture(), sprite.m_destRect);
+					}
+				}
+				break;
+			case EScene::eText:
+				/* Changing text, like counters, is rendered again. The sprites keep their size. */
+				for (unsigned int unUpdate = 0; unUpdate < TEXT_UPDATES_PER_FRAME; ++unUpdate)
+				{
+					unsigned int unText = m_unTextUpdate++ % TEXT_COUNT;
+					m_vecTexts[unText] = m_font.RenderText("Text " + std::to_string(m_unTextUpdate % 1000),
+						SDL_Color{ 255, 255, 255, 255 }, TEXT_POINT_SIZE);
+				}
+				for (const auto& sprite : m_vecSprites)
+				{
+					const auto& ptrText = m_vecTexts[sprite.m_unTexture];
+					if (ptrText)
+					{
+						renderer.DrawTexture(ptrText, sprite.m_destRect);
+					}
+				}
+				break;
+			}
+		}
+
+	private:
+		const SOptions& m_options;
+		std::mt19937 m_rng;
+		std::vector<std::unique_ptr<K9::Texture>> m_vecTextures;
+		std::unique_ptr<K9::Texture> m_ptrAtlas;
+		K9::Font m_font;
+		bool m_bFontLoaded;
+		std::vector<std::shared_ptr<K9::Texture>> m_vecTexts;
+		std::vector<SBenchSprite> m_vecSprites;
+		unsigned int m_unTextUpdate;
+		K9::SpatialGrid m_grid;
+		std::vector<uint32_t> m_vecVisibleIDs;
+		SDL_Rect m_cameraRect;
+		double m_dCullMS;
+		std::vector<std::string> m_vecStreamFileNames;
+		std::vector<K9::TextureHandle> m_vecStreams;
+		std::vector<int> m_vecStreamResidentFrames;
+		SStreamResult m_streamResult;
+	};
+}
+
+int main(int argc, char* argv[])
+{
+	SOptions options;
+	if (!ParseOptions(argc, argv, options))
+	{
+		return EXIT_FAILURE;
+	}
+
+	K9::Renderer2D& renderer = K9::Renderer2D::Ref();
+	if (!renderer.Init("K9 RendererBench", SCREEN_WIDTH, SCREEN_HEIGHT, options.m_eRenderMode, options.m_bHeadless))
+	{
+		std::cerr << "K9_RendererBench Failed to init Renderer2D!\n";
+		renderer.Shutdown();
+		return EXIT_FAILURE;
+	}
+
+	/* Measure the renderer, not the refresh rate. */
+	SDL_GL_SetSwapInterval(0);
+	std::string strGLRenderer = reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+	std::string strGLVersion = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+
+	std::vector<SRunResult> vecResults;
+	{
+		Bench bench{ options };
+		if (!bench.Init())
+		{
+			bench.Shutdown();
+			renderer.Shutdown();
+			return EXIT_FAILURE;
+		}
+
+		std::cout << "GL renderer: " << strGLRenderer << ", mode: " << options.m_ptrModeName << "\n"
+			<< "scene     sprites  submit p50 ms  frame p50 ms  frame p99 ms  draw calls  state changes  submitted  culled  peak RSS KB\n";
+		for (EScene eScene : options.m_vecScenes)
+		{
+			const SSceneInfo& info = *std::find_if(std::begin(SCENES), std::end(SCENES),
+				[eScene](const SSceneInfo& sceneInfo) { return sceneInfo.m_eScene == eScene; });
+			if (!bench.CanRun(eScene))
+			{
+				std::cerr << "K9_RendererBench Skipped the " << info.m_ptrName << " scene, since "
+					<< (eScene == EScene::eText ? "the font wasn't found\n" : "its images couldn't be written\n");
+				continue;
+			}
+
+			for (unsigned int unSpriteCount : options.m_vecCounts)
+			{
+				SRunResult result = bench.Run(info, unSpriteCount);
+				std::cout << info.m_ptrName << "  " << unSpriteCount << "  " << result.m_submit.m_dP50MS << "  "
+					<< result.m_frame.m_dP50MS << "  " << result.m_frame.m_dP99MS << "  " << result.m_stats.m_unDrawCallCount
+					<< "  " << result.m_stats.m_unStateChangeCount << "  " << result.m_stats.m_unSubmittedSpriteCount << "  "
+					<< result.m_stats.m_unCulledSpriteCount << "  " << result.m_unPeakRSSKB << "\n";
+				if (result.m_stream.m_unImageCount > 0)
+				{
+					std::cout << "  streamed " << result.m_stream.m_unResidentCount << "/" << result.m_stream.m_unImageCount
+						<< " images, the last in frame " << result.m_stream.m_nLastResidentFrame << ", at most "
+						<< result.m_stream.m_unMaxUploadedBytes << " of " << result.m_stream.m_unUploadBudget
+						<< " bytes per frame, " << result.m_stream.m_unPriorityInversionCount << " priority inversions\n";
+				}
+				vecResults.push_back(result);
+			}
+		}
+		bench.Shutdown();
+	}
+	renderer.Shutdown();
+
+	std::vector<SSortResult> vecSortResults;
+	if (!options.m_vecSortCounts.empty())
+	{
+		std::mt19937 rng{ 1234 };
+		std::cout << "commands  radix p50 ms  std::sort p50 ms  speedup\n";
+		for (unsigned int unCommandCount : options.m_vecSortCounts)
+		{
+			SSortResult result = RunSortSweep(options, unCommandCount, rng);
+			if (!result.m_bSameOrder)
+			{
+				std::cerr << "K9_RendererBench RenderQueue::Sort and std::sort disagree for " << unCommandCount << " commands!\n";
+				return EXIT_FAILURE;
+			}
+			std::cout << unCommandCount << "  " << result.m_radix.m_dP50MS << "  " << result.m_stdSort.m_dP50MS << "  "
+				<< result.m_stdSort.m_dP50MS / std::max(result.m_radix.m_dP50MS, 1e-9) << "\n";
+			vecSortResults.push_back(result);
+		}
+	}
+
+	std::ofstream file{ options.m_strOutputPath };
+	if (!file)
+	{
+		std::cerr << "K9_RendererBench Failed to open " << options.m_strOutputPath << "!\n";
+		return EXIT_FAILURE;
+	}
+
+	file << "{\n  \"gl_renderer\": \"" << EscapeJSON(strGLRenderer) << "\",\n  \"gl_version\": \"" << EscapeJSON(strGLVersion)
+		<< "\",\n  \"mode\": \"" << options.m_ptrModeName << "\",\n  \"headless\": " << (options.m_bHeadless ? "true" : "false")
+		<< ",\n  \"width\": " << SCREEN_WIDTH << ",\n  \"height\": " << SCREEN_HEIGHT
+		<< ",\n  \"frames\": " << options.m_unFrames << ",\n  \"warmup_frames\": " << options.m_unWarmupFrames
+		<< ",\n  \"runs\": [\n";
+	for (size_t unIndex = 0; unIndex < vecResults.size(); ++unIndex)
+	{
+		const SRunResult& result = vecResults[unIndex];
+		file << "    { \"scene\": \"" << result.m_ptrScene << "\", \"sprites\": " << result.m_unSpriteCount << ", ";
+		WritePercentiles(file, "submit_ms", result.m_submit);
+		file << ", ";
+		WritePercentiles(file, "frame_ms", result.m_frame);
+		file << ", \"draw_calls\": " << result.m_stats.m_unDrawCallCount
+			<< ", \"state_changes\": " << result.m_stats.m_unStateChangeCount
+			<< ", \"drawn_sprites\": " << result.m_stats.m_unSpriteCount
+			<< ", \"submitted_sprites\": " << result.m_stats.m_unSubmittedSpriteCount
+			<< ", \"culled_sprites\": " << result.m_stats.m_unCulledSpriteCount
+			<< ", \"grid_tested_sprites\": " << result.m_queryStats.m_unTestedCount
+			<< ", \"grid_visible_sprites\": " << result.m_queryStats.m_unVisibleCount << ", ";
+		WritePercentiles(file, "cull_ms", result.m_cull);
+		if (result.m_stream.m_unImageCount > 0)
+		{
+			const SStreamResult& stream = result.m_stream;
+			file << ", \"stream\": { \"images\": " << stream.m_unImageCount << ", \"resident\": " << stream.m_unResidentCount
+				<< ", \"last_resident_frame\": " << stream.m_nLastResidentFrame
+				<< ", \"max_uploaded_bytes\": " << stream.m_unMaxUploadedBytes << ", \"upload_budget\": " << stream.m_unUploadBudget
+				<< ", \"priority_inversions\": " << stream.m_unPriorityInversionCount
+				<< ", \"buffer_busy\": " << stream.m_unBufferBusyCount << " }";
+		}
+		file << ", \"peak_rss_kb\": " << result.m_unPeakRSSKB << " }"
+			<< (unIndex + 1 < vecResults.size() ? ",\n" : "\n");
+	}
+	file << "  ],\n  \"sorts\": [\n";
+	for (size_t unIndex = 0; unIndex < vecSortResults.size(); ++unIndex)
+	{
+		const SSortResult& result = vecSortResults[unIndex];
+		file << "    { \"commands\": " << result.m_unCommandCount << ", ";
+		WritePercentiles(file, "radix_ms", result.m_radix);
+		file << ", ";
+		WritePercentiles(file, "std_sort_ms", result.m_stdSort);
+		file << " }" << (unIndex + 1 < vecSortResults.size() ? ",\n" : "\n");
+	}
+	file << "  ]\n}\n";
+	std::cout << "Results written to " << options.m_strOutputPath << "\n";
+	return EXIT_SUCCESS;
+}
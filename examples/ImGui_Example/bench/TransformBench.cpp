@@ -0,0 +1,139 @@
+#define SDL_MAIN_HANDLED
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <SDL.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Renderer/Affine2D.h"
+#include "Renderer/SpriteRects.h"
+
+/*
+ * Compares the ways of turning sprite dest rects into screen space quads:
+ * the glm::mat4 path of the immediate renderer, SAffine2D per sprite and the SpriteRects batch in scalar and SIMD form.
+ * Usage: K9_TransformBench [sprite count] [iterations]
+ */
+
+namespace
+{
+	/* Matches the position of K9::SSpriteVertex, followed by texture coordinates, color and slot. */
+	struct SBenchVertex
+	{
+		glm::vec2 m_pos;
+		float m_arrPadding[4];
+	};
+
+	using Clock = std::chrono::steady_clock;
+
+	template<typename Func>
+	double MeasureMS(unsigned int unIterations, Func func)
+	{
+		double dBestMS = 1e30;
+		for (unsigned int unIteration = 0; unIteration < unIterations; ++unIteration)
+		{
+			auto start = Clock::now();
+			func();
+			std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+			dBestMS = std::min(dBestMS, elapsed.count());
+		}
+		return dBestMS;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	unsigned int unSpriteCount = argc > 1 ? static_cast<unsigned int>(std::stoul(argv[1])) : 1000000;
+	unsigned int unIterations = argc > 2 ? static_cast<unsigned int>(std::stoul(argv[2])) : 10;
+
+	std::mt19937 rng{ 1234 };
+	std::uniform_int_distribution<int> posDist{ 0, 1920 };
+	std::uniform_int_distribution<int> sizeDist{ 8, 128 };
+	std::uniform_int_distribution<int> flipDist{ 0, 3 };
+
+	std::vector<SDL_Rect> vecRects(unSpriteCount);
+	std::vector<SDL_RendererFlip> vecFlips(unSpriteCount);
+	for (unsigned int unIndex = 0; unIndex < unSpriteCount; ++unIndex)
+	{
+		vecRects[unIndex] = SDL_Rect{ posDist(rng), posDist(rng), sizeDist(rng), sizeDist(rng) };
+		vecFlips[unIndex] = static_cast<SDL_RendererFlip>(flipDist(rng));
+	}
+
+	std::vector<SBenchVertex> vecVertices(static_cast<size_t>(unSpriteCount) * 4);
+	const glm::vec2 arrCorners[4] = { { 0.0f, 0.0f }, { 1.0f, 0.0f }, { 1.0f, 1.0f }, { 0.0f, 1.0f } };
+
+	/* Two translates and a scale on a glm::mat4, as Renderer2D did per sprite, then the 4 corners. */
+	double dGlmMS = MeasureMS(unIterations, [&]()
+	{
+		for (unsigned int unIndex = 0; unIndex < unSpriteCount; ++unIndex)
+		{
+			const SDL_Rect& rect = vecRects[unIndex];
+			glm::mat4 trans = glm::translate(glm::mat4(1.0f), glm::vec3(rect.x, rect.y, 0.0f));
+			trans = glm::translate(trans, glm::vec3(rect.w * 0.5f, rect.h * 0.5f, 0.0f));
+			glm::vec3 scale(rect.w, rect.h, 1.0f);
+			if (vecFlips[unIndex] & SDL_RendererFlip::SDL_FLIP_HORIZONTAL) scale.x *= -1.0f;
+			if (vecFlips[unIndex] & SDL_RendererFlip::SDL_FLIP_VERTICAL) scale.y *= -1.0f;
+			trans = glm::scale(trans, scale);
+			for (unsigned int unCorner = 0; unCorner < 4; ++unCorner)
+			{
+				glm::vec4 pos = trans * glm::vec4(arrCorners[unCorner] - 0.5f, 0.0f, 1.0f);
+				vecVertices[unIndex * 4 + unCorner].m_pos = glm::vec2(pos);
+			}
+		}
+	});
+
+	double dAffineMS = MeasureMS(unIterations, [&]()
+	{
+		for (unsigned int unIndex = 0; unIndex < unSpriteCount; ++unIndex)
+		{
+			K9::SAffine2D affine = K9::SAffine2D::FromSprite(vecRects[unIndex], vecFlips[unIndex]);
+			for (unsigned int unCorner = 0; unCorner < 4; ++unCorner)
+			{
+				vecVertices[unIndex * 4 + unCorner].m_pos = affine.Apply(arrCorners[unCorner]);
+			}
+		}
+	});
+
+	K9::SpriteRects spriteRects;
+	spriteRects.Reserve(unSpriteCount);
+	double dPushMS = MeasureMS(unIterations, [&]()
+	{
+		spriteRects.Clear();
+		for (unsigned int unIndex = 0; unIndex < unSpriteCount; ++unIndex)
+		{
+			spriteRects.Push(vecRects[unIndex], vecFlips[unIndex]);
+		}
+	});
+
+	double dScalarMS = MeasureMS(unIterations, [&]()
+	{
+		spriteRects.TransformQuadsScalar(vecVertices.data(), sizeof(SBenchVertex));
+	});
+
+	std::vector<SBenchVertex> vecScalarVertices = vecVertices;
+	double dSimdMS = MeasureMS(unIterations, [&]()
+	{
+		spriteRects.TransformQuads(vecVertices.data(), sizeof(SBenchVertex));
+	});
+
+	/* The SIMD and scalar paths must produce the same quads. */
+	float fMaxError = 0.0f;
+	for (size_t unIndex = 0; unIndex < vecVertices.size(); ++unIndex)
+	{
+		glm::vec2 diff = glm::abs(vecVertices[unIndex].m_pos - vecScalarVertices[unIndex].m_pos);
+		fMaxError = std::max(fMaxError, std::max(diff.x, diff.y));
+	}
+
+	std::cout << "sprites: " << unSpriteCount << ", iterations: " << unIterations << " (best of)\n"
+		<< "glm::mat4 per sprite:       " << dGlmMS << " ms\n"
+		<< "SAffine2D per sprite:       " << dAffineMS << " ms\n"
+		<< "SpriteRects::Push:          " << dPushMS << " ms\n"
+		<< "SpriteRects scalar expand:  " << dScalarMS << " ms\n"
+		<< "SpriteRects SIMD expand:    " << dSimdMS << " ms\n"
+		<< "max SIMD/scalar difference: " << fMaxError << "\n";
+
+	return fMaxError < 0.01f ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,199 @@
+#define SDL_MAIN_HANDLED
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <SDL.h>
+#include <glad/glad.h>
+
+#include "Renderer/Affine2D.h"
+#include "Renderer/Renderer2D.h"
+#include "Renderer/Shader.h"
+#include "Renderer/ShaderVariants.h"
+#include "Renderer/Texture.h"
+
+/*
+ * Counts the GL calls per sprite of the immediate renderer, whose uniforms are set through the reflection table of Shader,
+ * against the previous path, which looked every uniform up with glGetUniformLocation before setting it.
+ * The GL functions are counted by swapping the glad function pointers for counting wrappers.
+ * Runs headless and must be started from the build directory, where the shaders are copied.
+ * Usage: K9_UniformBench [sprite count] [iterations]
+ */
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	enum ECountedCall
+	{
+		eGetUniformLocation,
+		eUniformMatrix3x2fv,
+		eUniform4fv,
+		eBindTexture,
+		eDrawElements,
+		eCountedCallCount
+	};
+
+	constexpr const char* COUNTED_CALL_NAMES[eCountedCallCount]
+	{
+		"glGetUniformLocation", "glUniformMatrix3x2fv", "glUniform4fv", "glBindTexture", "glDrawElements"
+	};
+
+	std::array<unsigned long long, eCountedCallCount> g_arrCallCounts{};
+	std::array<void*, eCountedCallCount> g_arrOriginals{};
+
+	template<unsigned int unIndex, typename R, typename... Args>
+	R APIENTRY CountedCall(Args... args)
+	{
+		g_arrCallCounts[unIndex]++;
+		return reinterpret_cast<R(APIENTRY*)(Args...)>(g_arrOriginals[unIndex])(args...);
+	}
+
+	/* Replace a glad function pointer with a wrapper, which counts the calls. */
+	template<unsigned int unIndex, typename R, typename... Args>
+	void Hook(R(APIENTRY*& ptrFunction)(Args...))
+	{
+		g_arrOriginals[unIndex] = reinterpret_cast<void*>(ptrFunction);
+		ptrFunction = &CountedCall<unIndex, R, Args...>;
+	}
+
+	std::unique_ptr<K9::Texture> CreateTexture(int nSize)
+	{
+		SDL_Surface* ptrSurface = SDL_CreateRGBSurfaceWithFormat(0, nSize, nSize, 32, SDL_PIXELFORMAT_RGBA32);
+		if (!ptrSurface)
+		{
+			return nullptr;
+		}
+		SDL_FillRect(ptrSurface, nullptr, SDL_MapRGBA(ptrSurface->format, 255, 128, 64, 255));
+		std::unique_ptr<K9::Texture> ptrTexture{ new K9::Texture() };
+		ptrTexture->CreateFromSurface(ptrSurface);
+		SDL_FreeSurface(ptrSurface);
+		return ptrTexture;
+	}
+
+	struct SPathResult
+	{
+		std::array<double, eCountedCallCount> m_arrCallsPerDraw;
+		double m_dCallsPerDraw;
+		double m_dBestMS;
+	};
+
+	/* Runs drawSprites once per iteration within a frame and reports the counted calls per sprite and the best time. */
+	template<typename Func>
+	SPathResult MeasurePath(unsigned int unSpriteCount, unsigned int unIterations, Func drawSprites)
+	{
+		K9::Renderer2D& renderer = K9::Renderer2D::Ref();
+		SPathResult result{};
+		result.m_dBestMS = 1e30;
+		g_arrCallCounts.fill(0);
+		for (unsigned int unIteration = 0; unIteration < unIterations; ++unIteration)
+		{
+			renderer.BeginFrame();
+			auto start = Clock::now();
+			drawSprites();
+			glFinish();
+			double dElapsedMS = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+			result.m_dBestMS = std::min(result.m_dBestMS, dElapsedMS);
+			renderer.EndFrame();
+		}
+
+		/* EndFrame draws nothing in immediate mode, so every counted call belongs to the sprites. */
+		double dDrawCount = static_cast<double>(unSpriteCount) * unIterations;
+		for (unsigned int unIndex = 0; unIndex < eCountedCallCount; ++unIndex)
+		{
+			result.m_arrCallsPerDraw[unIndex] = g_arrCallCounts[unIndex] / dDrawCount;
+			result.m_dCallsPerDraw += result.m_arrCallsPerDraw[unIndex];
+		}
+		return result;
+	}
+
+	void PrintResult(const char* ptrPath, const SPathResult& result)
+	{
+		std::cout << ptrPath << ": " << result.m_dCallsPerDraw << " counted GL calls per sprite, best " << result.m_dBestMS << " ms\n";
+		for (unsigned int unIndex = 0; unIndex < eCountedCallCount; ++unIndex)
+		{
+			std::cout << "  " << COUNTED_CALL_NAMES[unIndex] << ": " << result.m_arrCallsPerDraw[unIndex] << "\n";
+		}
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	unsigned int unSpriteCount = argc > 1 ? static_cast<unsigned int>(std::stoul(argv[1])) : 10000;
+	unsigned int unIterations = argc > 2 ? static_cast<unsigned int>(std::stoul(argv[2])) : 20;
+
+	K9::Renderer2D& renderer = K9::Renderer2D::Ref();
+	if (!renderer.Init("K9 UniformBench", 1280, 720, K9::Renderer2D::ERenderMode::eImmediate, true))
+	{
+		std::cerr << "K9_UniformBench Failed to init Renderer2D!\n";
+		renderer.Shutdown();
+		return EXIT_FAILURE;
+	}
+	SDL_GL_SetSwapInterval(0);
+
+	int nStatus = EXIT_SUCCESS;
+	{
+		std::unique_ptr<K9::Texture> ptrTexture = CreateTexture(32);
+
+		/* The tinted variant is the previous program, which always multiplied u_Color, to replay its per-sprite calls. */
+		K9::ShaderVariants shaders;
+		K9::Shader* ptrShader = shaders.Load("assets/shaders/Sprite.vert", "assets/shaders/Sprite.frag") ?
+			shaders.Get(shaders.GetKeywordMask("TINT")) : nullptr;
+		if (!ptrTexture || !ptrShader)
+		{
+			std::cerr << "K9_UniformBench Failed to create the texture or load the sprite shader!\n";
+			nStatus = EXIT_FAILURE;
+		}
+		else
+		{
+			Hook<eGetUniformLocation>(glad_glGetUniformLocation);
+			Hook<eUniformMatrix3x2fv>(glad_glUniformMatrix3x2fv);
+			Hook<eUniform4fv>(glad_glUniform4fv);
+			Hook<eBindTexture>(glad_glBindTexture);
+			Hook<eDrawElements>(glad_glDrawElements);
+
+			SDL_Rect destRect{ 100, 100, 32, 32 };
+			SPathResult before = MeasurePath(unSpriteCount, unIterations, [&]()
+			{
+				/* The calls of the previous Shader setters: a location lookup before every uniform. */
+				ptrShader->SetActive();
+				GLuint unProgramID = ptrShader->GetProgramID();
+				for (unsigned int unSprite = 0; unSprite < unSpriteCount; ++unSprite)
+				{
+					K9::SAffine2D affine = K9::SAffine2D::FromSprite(destRect, SDL_FLIP_NONE, 0.0f, glm::vec2{ 0.0f, 0.0f })
+						.Translated(glm::vec2{ 0.5f, 0.5f });
+					const float arrValues[6] =
+					{
+						affine.m_row0.x, affine.m_row1.x,
+						affine.m_row0.y, affine.m_row1.y,
+						affine.m_row0.z, affine.m_row1.z
+					};
+					glUniformMatrix3x2fv(glGetUniformLocation(unProgramID, "u_WorldTransform"), 1, GL_FALSE, arrValues);
+					const float arrColor[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+					glUniform4fv(glGetUniformLocation(unProgramID, "u_Color"), 1, arrColor);
+					const float arrUVRect[4] = { 0.0f, 0.0f, 1.0f, 1.0f };
+					glUniform4fv(glGetUniformLocation(unProgramID, "u_UVRect"), 1, arrUVRect);
+					ptrTexture->SetActive();
+					glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
+				}
+			});
+
+			SPathResult after = MeasurePath(unSpriteCount, unIterations, [&]()
+			{
+				for (unsigned int unSprite = 0; unSprite < unSpriteCount; ++unSprite)
+				{
+					renderer.DrawTexture(*ptrTexture, destRect);
+				}
+			});
+
+			std::cout << "sprites: " << unSpriteCount << ", iterations: " << unIterations << " (best of)\n";
+			PrintResult("before (glGetUniformLocation per set)", before);
+			PrintResult("after (reflected UniformID)", after);
+		}
+		shaders.Unload();
+	}
+	renderer.Shutdown();
+	return nStatus;
+}
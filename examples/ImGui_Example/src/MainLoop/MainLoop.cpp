@@ -1,4 +1,6 @@
 #include "MainLoop.h"
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <imgui.h>
 
@@ -7,23 +9,57 @@
 
 namespace K9
 {
-	MainLoop::MainLoop() : m_event{}, m_isRunning{true}, m_imguiColor{},
+	MainLoop::MainLoop() : m_event{}, m_isRunning{true}, m_idleLoop{}, m_framePacer{}, m_fixedTimestep{},
+		m_bUseRenderThread{ false }, m_bCheckPacketHandoff{ false },
+		m_bHeadless{ false }, m_unFrameLimit{ 0 }, m_unFrameCount{ 0 }, m_strDumpPath{}, m_imguiColor{},
 		m_srcRect{}, m_destRect{}, m_flipFormat{ SDL_RendererFlip::SDL_FLIP_NONE },
+		m_bSpinFox{ false }, m_fFoxSpinSpeed{ 90.0f }, m_fFoxAngle{ 0.0f }, m_fPrevFoxAngle{ 0.0f },
 		m_nDrawIndex{ 0 }, m_nFlipFormatIndex{ 0 }, m_font{}, m_text{ nullptr },
 		m_strText{ "" }, m_textColor{ 255, 255, 255, 255 }, m_textRect{}
 	{
 	}
 
-	bool MainLoop::Init()
+	bool MainLoop::Init(int nArgCount, char* arrArgs[])
 	{
 		int nWidth = 1280;
 		int nHeight = 720;
 
-		if (!Renderer2D::Ref().Init("ImGUI Example", nWidth, nHeight))
+		for (int nArg = 1; nArg < nArgCount; ++nArg)
+		{
+			if (std::strcmp(arrArgs[nArg], "--headless") == 0)
+			{
+				m_bHeadless = true;
+			}
+			else if (std::strcmp(arrArgs[nArg], "--frames") == 0 && nArg + 1 < nArgCount)
+			{
+				m_unFrameLimit = static_cast<unsigned int>(std::strtoul(arrArgs[++nArg], nullptr, 10));
+			}
+			else if (std::strcmp(arrArgs[nArg], "--dump") == 0)
+			{
+				bool bHasPath = nArg + 1 < nArgCount && std::strncmp(arrArgs[nArg + 1], "--", 2) != 0;
+				m_strDumpPath = bHasPath ? arrArgs[++nArg] : "frame.bmp";
+			}
+			else
+			{
+				std::cerr << "MainLoop::Init: Unknown argument " << arrArgs[nArg] << "\n";
+			}
+		}
+		if (!m_strDumpPath.empty() && m_unFrameLimit == 0)
+		{
+			std::cerr << "MainLoop::Init: --dump needs --frames, to know the last frame\n";
+			m_strDumpPath.clear();
+		}
+
+		/* The shaders compile, while the audio, textures and fonts below are loaded. Captured frames need the sprites right away. */
+		Renderer2D::Ref().SetAsyncShaderLoading(!m_bHeadless);
+		if (!Renderer2D::Ref().Init("ImGUI Example", nWidth, nHeight, Renderer2D::ERenderMode::eBatched, m_bHeadless))
 		{
 			std::cerr << "MainLoop::Init: Failed to init Renderer2D\n";
 			return false;
 		}
+
+		/* Without a display, there is no vertical blank to wait for. */
+		m_framePacer.SetMode(m_bHeadless ? FramePacer::EMode::eUncapped : FramePacer::EMode::eVSync);
 		
 		if (!Music::Ref().Init("assets/sounds/music.csv"))
 		{
@@ -52,6 +88,14 @@ namespace K9
 
 	void MainLoop::Shutdown()
 	{
+		/* Report the load of both loop modes. */
+		for (auto eMode : { IdleLoop::EMode::eBusy, IdleLoop::EMode::eIdle })
+		{
+			IdleLoop::SStats stats = m_idleLoop.GetAverageStats(eMode);
+			std::cout << "MainLoop::Shutdown " << (eMode == IdleLoop::EMode::eBusy ? "Busy" : "Idle")
+				<< " mode: CPU " << stats.m_fCPUUsage << "%, " << stats.m_fWakeupsPerSecond << " wakeups/s\n";
+		}
+
 		m_font.Unload();
 		Renderer2D::Ref().Shutdown();
 		Music::Ref().Shutdown();
@@ -61,8 +105,44 @@ namespace K9
 	{
 		while (m_isRunning)
 		{
+			m_idleLoop.WaitForFrame();
 			HandleEvent();
-			Draw();
+
+			/* Simulate in fixed steps, so slow or fast frames don't change the simulation speed. */
+			unsigned int unStepCount = m_fixedTimestep.BeginFrame();
+			for (unsigned int unStep = 0; unStep < unStepCount; ++unStep)
+			{
+				Update(m_fixedTimestep.GetStep());
+			}
+
+			/* The last frame is saved before it is swapped. */
+			bool bLastFrame = m_unFrameLimit != 0 && m_unFrameCount + 1 >= m_unFrameLimit;
+			if (bLastFrame && !m_strDumpPath.empty())
+			{
+				Renderer2D::Ref().CaptureNextFrame(m_strDumpPath);
+			}
+
+			Draw(m_fixedTimestep.GetAlpha());
+			m_framePacer.EndFrame();
+			m_unFrameCount++;
+			if (bLastFrame)
+			{
+				m_isRunning = false;
+			}
+
+			/* The render thread can only be started or stopped between frames. */
+			Renderer2D& renderer = Renderer2D::Ref();
+			if (m_bUseRenderThread != renderer.IsRenderThreadRunning())
+			{
+				if (m_bUseRenderThread)
+				{
+					m_bUseRenderThread = renderer.StartRenderThread();
+				}
+				else
+				{
+					renderer.StopRenderThread();
+				}
+			}
 		}
 	}
 
@@ -78,18 +158,40 @@ namespace K9
 		}
 	}
 
-	void MainLoop::Draw()
+	void MainLoop::Update(double dStepS)
+	{
+		m_fPrevFoxAngle = m_fFoxAngle;
+		if (m_bSpinFox)
+		{
+			m_fFoxAngle += static_cast<float>(m_fFoxSpinSpeed * dStepS);
+
+			/* Wrap both angles, so the interpolation doesn't spin back. */
+			if (m_fFoxAngle >= 360.0f)
+			{
+				m_fFoxAngle -= 360.0f;
+				m_fPrevFoxAngle -= 360.0f;
+			}
+
+			/* The animation needs frames, even while the loop is idle. */
+			IdleLoop::RequestRedraw();
+		}
+	}
+
+	void MainLoop::Draw(float fAlpha)
 	{
 		Renderer2D::Ref().BeginFrame();
 
+		float fFoxAngle = m_fPrevFoxAngle + (m_fFoxAngle - m_fPrevFoxAngle) * fAlpha;
+		SDL_Point foxCenter{ m_destRect.w / 2, m_destRect.h / 2 };
 		if (m_nDrawIndex == 0)
 		{
-			Renderer2D::Ref().DrawTexture(m_texFox, m_destRect,
+			SDL_Rect fullRect{ 0, 0, m_texFox.GetWidth(), m_texFox.GetHeight() };
+			Renderer2D::Ref().DrawTexture(m_texFox, fullRect, m_destRect, fFoxAngle, foxCenter,
 				SDL_Color{ 255, 255, 255, 255 }, m_flipFormat);
 		}
 		else if (m_nDrawIndex == 1)
 		{
-			Renderer2D::Ref().DrawTexture(m_texFox, m_srcRect, m_destRect,
+			Renderer2D::Ref().DrawTexture(m_texFox, m_srcRect, m_destRect, fFoxAngle, foxCenter,
 				SDL_Color{ 255, 255, 255, 255 }, m_flipFormat);
 		}
 
@@ -107,6 +209,11 @@ namespace K9
 
 		DrawFoxWidgets();
 		DrawColorPickWidget();
+		DrawIdleLoopWidget();
+		DrawFramePacerWidget();
+		DrawRenderThreadWidget();
+		DrawGPUProfilerWidget();
+		DrawLoadingScreen();
 
 		Renderer2D::Ref().EndImGUIFrame();
 	}
@@ -166,6 +273,8 @@ namespace K9
 		ImGui::Separator();
 		DrawFlipFormatWidget();
 		ImGui::Separator();
+		DrawSpinWidget();
+		ImGui::Separator();
 		DrawSrcRectWidget();
 		ImGui::Separator();
 		DrawDestRectWidget();
@@ -179,6 +288,8 @@ namespace K9
 			m_srcRect = { 0, 0, m_texFox.GetWidth(), m_texFox.GetHeight() };
 			m_destRect = m_srcRect;
 			m_flipFormat = SDL_RendererFlip::SDL_FLIP_NONE;
+			m_fFoxAngle = 0.0f;
+			m_fPrevFoxAngle = 0.0f;
 			if (m_text)
 			{
 				m_textRect = { 0, 0, m_text->GetWidth(), m_text->GetHeight() };
@@ -196,6 +307,15 @@ namespace K9
 		}
 	}
 
+	void MainLoop::DrawSpinWidget()
+	{
+		ImGui::Checkbox("Spin fox", &m_bSpinFox);
+		ImGui::SliderFloat("##foxSpinSpeed", &m_fFoxSpinSpeed, 0.0f, 720.0f, "Spin speed %.0f deg/s");
+		ImGui::Text("Simulation steps: %llu (dropped %llu)",
+			static_cast<unsigned long long>(m_fixedTimestep.GetStepCount()),
+			static_cast<unsigned long long>(m_fixedTimestep.GetDroppedStepCount()));
+	}
+
 	void MainLoop::DrawSrcRectWidget()
 	{
 		ImGui::NewLine();
@@ -285,6 +405,120 @@ namespace K9
 		ImGui::SliderInt("##textDestH", &m_textRect.h, 0, screenSize.h, "m_textRect.h %d");
 	}
 
+	void MainLoop::DrawIdleLoopWidget()
+	{
+		ImGui::NewLine();
+		ImGui::Text("Idle Loop");
+		ImGui::Separator();
+		bool bIdle = m_idleLoop.GetMode() == IdleLoop::EMode::eIdle;
+		if (ImGui::Checkbox("Block on events while idle", &bIdle))
+		{
+			m_idleLoop.SetMode(bIdle ? IdleLoop::EMode::eIdle : IdleLoop::EMode::eBusy);
+		}
+
+		int nMaxLatencyMS = static_cast<int>(m_idleLoop.GetMaxLatency());
+		if (ImGui::SliderInt("##idleMaxLatency", &nMaxLatencyMS, 16, 1000, "Max latency %d ms"))
+		{
+			m_idleLoop.SetMaxLatency(static_cast<Uint32>(nMaxLatencyMS));
+		}
+
+		const IdleLoop::SStats& stats = m_idleLoop.GetStats();
+		ImGui::Text("CPU: %.1f%%\nWakeups: %.1f/s", stats.m_fCPUUsage, stats.m_fWakeupsPerSecond);
+	}
+
+	void MainLoop::DrawFramePacerWidget()
+	{
+		ImGui::NewLine();
+		ImGui::Text("Frame Pacing");
+		ImGui::Separator();
+		const char* items[] = { "VSync", "Adaptive VSync", "Uncapped", "Capped" };
+		int nMode = static_cast<int>(m_framePacer.GetMode());
+		float fTargetHz = static_cast<float>(m_framePacer.GetTargetHz());
+		bool bChanged = ImGui::Combo("Pacing Mode", &nMode, items, IM_ARRAYSIZE(items));
+		bChanged |= ImGui::SliderFloat("##frameCapHz", &fTargetHz, 10.0f, 240.0f, "Cap %.0f Hz");
+		if (bChanged)
+		{
+			m_framePacer.SetMode(static_cast<FramePacer::EMode>(nMode), fTargetHz);
+		}
+
+		/* Waiting for events stretches frames, so the jitter is only meaningful while busy. */
+		FramePacer::SStats stats = m_framePacer.GetStats();
+		ImGui::Text("Frame time: %.2f ms (min %.2f, max %.2f)\nJitter: %.3f ms",
+			stats.m_fAverageFrameTimeMS, stats.m_fMinFrameTimeMS, stats.m_fMaxFrameTimeMS, stats.m_fJitterMS);
+	}
+
+	void MainLoop::DrawRenderThreadWidget()
+	{
+		ImGui::NewLine();
+		ImGui::Text("Render Thread");
+		ImGui::Separator();
+		ImGui::Checkbox("Draw on a render thread", &m_bUseRenderThread);
+		if (ImGui::Checkbox("Check packet handoff", &m_bCheckPacketHandoff))
+		{
+			Renderer2D::Ref().SetPacketHandoffCheckEnabled(m_bCheckPacketHandoff);
+		}
+
+		/* A handoff violation means, the main thread waited longer than the render thread needed for a frame. */
+		Renderer2D::SStats stats = Renderer2D::Ref().GetStats();
+		ImGui::Text("Packet wait: %.2f ms\nHandoff violations: %u",
+			stats.m_fPacketWaitTimeMS, Renderer2D::Ref().GetPacketHandoffViolationCount());
+	}
+
+	void MainLoop::DrawGPUProfilerWidget()
+	{
+		ImGui::NewLine();
+		ImGui::Text("GPU Profiler");
+		ImGui::Separator();
+		GPUProfiler& gpuProfiler = Renderer2D::Ref().GetGPUProfiler();
+		bool bEnabled = gpuProfiler.IsEnabled();
+		if (ImGui::Checkbox("Measure GPU time", &bEnabled))
+		{
+			gpuProfiler.SetEnabled(bEnabled);
+		}
+
+		/* The times lag a few frames behind, since the queries are read back without waiting. */
+		ImGui::Columns(4, "##gpuScopes");
+		ImGui::Text("Scope");
+		ImGui::NextColumn();
+		ImGui::Text("Last ms");
+		ImGui::NextColumn();
+		ImGui::Text("Avg ms");
+		ImGui::NextColumn();
+		ImGui::Text("Max ms");
+		ImGui::NextColumn();
+		ImGui::Separator();
+		for (const auto& scopeStats : gpuProfiler.GetScopeStats())
+		{
+			ImGui::Text("%*s%s", static_cast<int>(scopeStats.m_unDepth * 2), "", scopeStats.m_strName.c_str());
+			ImGui::NextColumn();
+			ImGui::Text("%.3f", scopeStats.m_fLastMS);
+			ImGui::NextColumn();
+			ImGui::Text("%.3f", scopeStats.m_fAverageMS);
+			ImGui::NextColumn();
+			ImGui::Text("%.3f", scopeStats.m_fMaxMS);
+			ImGui::NextColumn();
+		}
+		ImGui::Columns(1);
+		ImGui::Text("Skipped frames: %u", gpuProfiler.GetSkippedFrameCount());
+	}
+
+	void MainLoop::DrawLoadingScreen()
+	{
+		/* Sprites are dropped, until the renderer's shaders are ready. ImGUI draws with its own. */
+		if (!Renderer2D::Ref().IsLoadingShaders())
+		{
+			return;
+		}
+
+		ImGuiViewport* ptrViewport = ImGui::GetMainViewport();
+		ImGui::SetNextWindowPos(ImVec2{ ptrViewport->Pos.x + ptrViewport->Size.x * 0.5f, ptrViewport->Pos.y + ptrViewport->Size.y * 0.5f },
+			ImGuiCond_Always, ImVec2{ 0.5f, 0.5f });
+		ImGui::Begin("Loading", nullptr, ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_AlwaysAutoResize |
+			ImGuiWindowFlags_NoSavedSettings | ImGuiWindowFlags_NoFocusOnAppearing | ImGuiWindowFlags_NoNav);
+		ImGui::Text("Compiling shaders...");
+		ImGui::End();
+	}
+
 	void MainLoop::UpdateText(bool bSetRect)
 	{
 		m_text = m_font.RenderText(m_strText, m_textColor);
@@ -6,6 +6,9 @@
 
 #include <Renderer/Texture.h>
 #include <Renderer/Font.h>
+#include <Timing/FixedTimestep.h>
+#include <Timing/FramePacer.h>
+#include <Timing/IdleLoop.h>
 
 namespace K9
 {
@@ -20,9 +23,13 @@ namespace K9
 
 		/// <summary>
 		/// Initialize member fields.
+		/// Supported arguments: --headless to render without a visible window,
+		/// --frames N to quit after N frames and --dump [path] to save the last of them as a BMP file, frame.bmp by default.
 		/// </summary>
+		/// <param name="nArgCount"> Number of command line arguments. </param>
+		/// <param name="arrArgs"> Command line arguments, starting with the program name. </param>
 		/// <returns> True, if the initialization was successful. </returns>
-		bool Init();
+		bool Init(int nArgCount = 0, char* arrArgs[] = nullptr);
 
 		/// <summary>
 		/// Shutdown the main loop and its fields.
@@ -40,10 +47,17 @@ namespace K9
 		/// </summary>
 		void HandleEvent();
 
+		/// <summary>
+		/// Advance the simulation by a fixed step.
+		/// </summary>
+		/// <param name="dStepS"> Duration of the step in seconds. </param>
+		void Update(double dStepS);
+
 		/// <summary>
 		/// Draw stuff onto the screen and update the window.
 		/// </summary>
-		void Draw();
+		/// <param name="fAlpha"> Interpolation factor between the previous and the current simulation state. </param>
+		void Draw(float fAlpha);
 
 		/// <summary>
 		/// Draw ImGUI elements.
@@ -58,6 +72,12 @@ namespace K9
 		void DrawDestRectWidget();
 		void DrawFlipFormatWidget();
 		void DrawTextWidget();
+		void DrawIdleLoopWidget();
+		void DrawFramePacerWidget();
+		void DrawSpinWidget();
+		void DrawRenderThreadWidget();
+		void DrawGPUProfilerWidget();
+		void DrawLoadingScreen();
 
 		void UpdateText(bool bSetRect = false);
 	private:
@@ -72,6 +92,51 @@ namespace K9
 		/// </summary>
 		bool m_isRunning; 
 
+		/// <summary>
+		/// Blocks the loop on events, while nothing needs a frame.
+		/// </summary>
+		IdleLoop m_idleLoop;
+
+		/// <summary>
+		/// Sets the swap interval and caps the frame rate.
+		/// </summary>
+		FramePacer m_framePacer;
+
+		/// <summary>
+		/// Runs Update at a fixed rate, independent of the frame rate.
+		/// </summary>
+		FixedTimestep m_fixedTimestep;
+
+		/// <summary>
+		/// True, if drawing should happen on the render thread. Applied between frames.
+		/// </summary>
+		bool m_bUseRenderThread;
+
+		/// <summary>
+		/// True, if the packet handoff to the render thread is checked.
+		/// </summary>
+		bool m_bCheckPacketHandoff;
+
+		/// <summary>
+		/// True, if the renderer has no visible window.
+		/// </summary>
+		bool m_bHeadless;
+
+		/// <summary>
+		/// Number of frames, after which the loop quits. 0, to run until the window is closed.
+		/// </summary>
+		unsigned int m_unFrameLimit;
+
+		/// <summary>
+		/// Number of frames drawn so far.
+		/// </summary>
+		unsigned int m_unFrameCount;
+
+		/// <summary>
+		/// Path, the last frame is saved to. Empty, if it isn't saved.
+		/// </summary>
+		std::string m_strDumpPath;
+
 		/// <summary>
 		/// ImGui color value for the window.
 		/// </summary>
@@ -82,6 +147,10 @@ namespace K9
 		SDL_Rect m_srcRect;
 		SDL_Rect m_destRect;
 		SDL_RendererFlip m_flipFormat;
+		bool m_bSpinFox;
+		float m_fFoxSpinSpeed;
+		float m_fFoxAngle;
+		float m_fPrevFoxAngle;
 		int m_nDrawIndex;
 		int m_nFlipFormatIndex;
 
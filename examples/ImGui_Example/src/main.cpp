@@ -5,7 +5,7 @@
 int main(int argc, char* args[])
 {
     K9::MainLoop mainLoop;
-    if (mainLoop.Init())
+    if (mainLoop.Init(argc, args))
     {
         mainLoop.Run();
     }